@@ -367,6 +367,57 @@ const char * WcharMbcsConvertor::wchar2char(const wchar_t * wcharStr2Convert, UI
 	return _multiByteStr;
 }
 
+const char * MbcsStreamConvertor::convert(const char *block, int len, int *pLenOut)
+{
+	const char *input = block;
+	int lenInput = len;
+	if (!_pending.empty())
+	{
+		_input.assign(_pending.begin(), _pending.end());
+		_input.insert(_input.end(), block, block + len);
+		input = &_input[0];
+		lenInput = int(_input.size());
+		_pending.clear();
+	}
+
+	// A UTF-8 block made of a single truncated character is kept whole: char2wchar would convert it
+	// anyway to make sure it always progresses, but here the next block can complete it.
+	if (_fromCodepage == CP_UTF8 && lenInput > 0 && lenInput < 4 &&
+		Utf8::isFirstOfMultibyte(input[0]) && lenInput < Utf8::continuationBytes(input[0]) + 1)
+	{
+		_pending.assign(input, input + lenInput);
+		*pLenOut = 0;
+		return "";
+	}
+
+	if (lenInput == 0)
+	{
+		*pLenOut = 0;
+		return "";
+	}
+
+	int bytesNotProcessed = 0;
+	const char *output = _convertor.encode(_fromCodepage, _toCodepage, input, lenInput, pLenOut, &bytesNotProcessed);
+	if (bytesNotProcessed > 0)
+		_pending.assign(input + lenInput - bytesNotProcessed, input + lenInput);
+	return output;
+}
+
+const char * MbcsStreamConvertor::flush(int *pLenOut)
+{
+	if (_pending.empty())
+	{
+		*pLenOut = 0;
+		return "";
+	}
+
+	_input.swap(_pending);
+	_pending.clear();
+	int lenWc = 0;
+	const wchar_t *strW = _convertor.char2wchar(&_input[0], _fromCodepage, int(_input.size()), &lenWc);
+	return _convertor.wchar2char(strW, _toCodepage, lenWc, pLenOut);
+}
+
 std::wstring string2wstring(const std::string & rString, UINT codepage)
 {
 	int len = MultiByteToWideChar(codepage, 0, rString.c_str(), -1, NULL, 0);
@@ -57,9 +57,17 @@ BOOL PathAppend(generic_string& path, const generic_string& more);
 BOOL PathCanonicalize(generic_string& path);
 BOOL PathCanonicalize(generic_string& path, generic_string& output);
 
+// Converts between wide char and multi-byte strings, in any code page.
+// The returned strings point into buffers owned by the convertor and stay valid until the
+// next call on the same convertor. The shared instance returned by getInstance() is meant for
+// the UI thread; code running on other threads, or keeping a result while calling code that may
+// convert something too, should own its WcharMbcsConvertor.
 class WcharMbcsConvertor
 {
 public:
+	WcharMbcsConvertor(){}
+	~WcharMbcsConvertor(){}
+
 	static WcharMbcsConvertor * getInstance();
 	static void destroyInstance();
 
@@ -86,6 +94,8 @@ public:
 			}
 		}
 
+		// Grows geometrically, so that converting strings of increasing length in a loop
+		// doesn't reallocate at each call.
 		void sizeTo(size_t size)
 		{
 			if(_allocLen < size)
@@ -94,7 +104,7 @@ public:
 				{
 					delete[] _str;
 				}
-				_allocLen = max(size, initSize);
+				_allocLen = max(max(size, _allocLen * 2), size_t(initSize));
 				_str = new T[_allocLen];
 			}
 		}
@@ -118,21 +128,52 @@ public:
 		static const int initSize = 1024;
 		size_t _allocLen;
 		T* _str;
+
+	private:
+		// The buffer is owned, copying it would end up in a double delete.
+		StringBuffer(const StringBuffer&);
+		const StringBuffer& operator= (const StringBuffer&);
 	};
 
 protected:
-	WcharMbcsConvertor(){}
-	~WcharMbcsConvertor(){}
 	static WcharMbcsConvertor * _pSelf;
 
 	StringBuffer<char> _multiByteStr;
 	StringBuffer<wchar_t> _wideCharStr;
 
 private:
-	// Since there's no public ctor, we need to void the default assignment operator.
+	// Results point into the buffers, a copy would have to duplicate them: void copy and assignment.
+	WcharMbcsConvertor(const WcharMbcsConvertor&);
 	const WcharMbcsConvertor& operator= (const WcharMbcsConvertor&);
 };
 
+// Converts a text from one code page to another, block by block, as it is read from or
+// written to a file. The bytes of a multi-byte character cut at the end of a block are
+// carried over and converted with the next block, so callers don't have to care about
+// where the blocks are split. Each instance owns its buffers and can be used on any thread.
+class MbcsStreamConvertor
+{
+public:
+	MbcsStreamConvertor(UINT fromCodepage, UINT toCodepage) : _fromCodepage(fromCodepage), _toCodepage(toCodepage) {};
+
+	// Returns the converted text, valid until the next call. Trailing bytes that may be the
+	// beginning of a character are not converted yet (*pLenOut can be 0).
+	const char * convert(const char *block, int len, int *pLenOut);
+
+	// Converts the bytes still carried over, at the end of the stream. Whatever is left
+	// there is not a valid character and is converted as the system sees fit.
+	const char * flush(int *pLenOut);
+
+	int pendingBytes() const { return int(_pending.size()); };
+
+private:
+	UINT _fromCodepage;
+	UINT _toCodepage;
+	std::vector<char> _pending;
+	std::vector<char> _input;
+	WcharMbcsConvertor _convertor;
+};
+
 #define MACRO_RECORDING_IN_PROGRESS 1
 #define MACRO_RECORDING_HAS_STOPPED 2
 
@@ -327,6 +327,21 @@ enum LangType {L_TEXT, L_PHP , L_C, L_CPP, L_CS, L_OBJC, L_JAVA, L_RC,\
     // Allocates a marker number to a plugin
     // Returns: TRUE if successful, FALSE otherwise. startNumber will also be set to 0 if unsuccessful
 
+	#define NPPM_SETNOTIFICATIONMASK  (NPPMSG + 83)
+	// BOOL NPPM_SETNOTIFICATIONMASK(HINSTANCE hPluginModule, NotificationMask *pMask)
+	// Restricts the notifications sent to beNotified of the plugin loaded from hPluginModule
+	// (the HINSTANCE given to its DllMain) to the codes (SCN_* and NPPN_*) listed in pMask.
+	// For SCN_MODIFIED, modificationTypes restricts further to some SC_MOD_* flags (0 for all).
+	// pMask == NULL or nbCodes == 0 restores the default: every notification is sent.
+	// NPPN_SHUTDOWN is always sent. The plugin must be loaded already: send it from
+	// beNotified(NPPN_READY) or later, not from setInfo.
+	// Returns: TRUE if successful, FALSE if hPluginModule is not a loaded plugin
+		struct NotificationMask {
+			int nbCodes;
+			const UINT *codes;
+			int modificationTypes;
+		};
+
 #define	RUNCOMMAND_USER    (WM_USER + 3000)
 	#define NPPM_GETFULLCURRENTPATH		(RUNCOMMAND_USER + FULL_CURRENT_PATH)
 	#define NPPM_GETCURRENTDIRECTORY	(RUNCOMMAND_USER + CURRENT_DIRECTORY)
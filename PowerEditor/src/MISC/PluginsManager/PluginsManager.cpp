@@ -36,7 +36,9 @@ PluginInfo::PluginInfo() :
 	_pMessageProc(NULL),
 	_pFuncIsUnicode(NULL),
 	_funcItems(NULL),
-	_nbFuncItem(0)
+	_nbFuncItem(0),
+	_isNotifiedOfAll(true),
+	_modificationTypes(0)
 {}
 
 PluginInfo::~PluginInfo()
@@ -52,7 +54,9 @@ PluginsManager::PluginsManager() :
 	_hPluginsMenu(NULL),
 	_isDisabled(false),
 	_dynamicIDAlloc(new IDAllocator(ID_PLUGINS_CMD_DYNAMIC, ID_PLUGINS_CMD_DYNAMIC_LIMIT)),
-	_markerAlloc(new IDAllocator(MARKER_PLUGINS, MARKER_PLUGINS_LIMIT))
+	_markerAlloc(new IDAllocator(MARKER_PLUGINS, MARKER_PLUGINS_LIMIT)),
+	_notifyDepth(0),
+	_areSubscribersOutdated(false)
 {
 }
 
@@ -87,7 +91,10 @@ bool PluginsManager::unloadPlugin(int index, HWND nppHandle)
     //_pluginInfos[index]->_pluginMenu = NULL;
 
     if (::FreeLibrary(_pluginInfos[index]->_hLib))
+    {
         _pluginInfos[index]->_hLib = NULL;
+        buildSubscriberLists();
+    }
     else
         printStr(TEXT("not ok"));
     //delete _pluginInfos[index];
@@ -235,6 +242,7 @@ int PluginsManager::loadPlugin(const generic_string& pluginFilePath, std::vector
 		}
 
 		_pluginInfos.push_back(pi);
+		buildSubscriberLists();
         return (_pluginInfos.size() - 1);
 	} catch(std::exception e) {
 		::MessageBoxA(NULL, e.what(), "Exception", MB_OK);
@@ -264,6 +272,7 @@ int PluginsManager::loadPlugin(const generic_string& pluginFilePath, std::vector
 
 bool PluginsManager::loadPlugins(const TCHAR *dir)
 {
+	profile_scope("PluginsManager::loadPlugins");
 	if (_isDisabled)
 		return false;
 
@@ -456,27 +465,112 @@ void PluginsManager::runPluginCommand(const TCHAR *pluginName, int commandID)
 	}
 }
 
-void PluginsManager::notify(SCNotification *notification)
+void PluginsManager::buildSubscriberLists()
 {
+	if (_notifyDepth)
+	{
+		// The lists are being walked through
+		_areSubscribersOutdated = true;
+		return;
+	}
+	_areSubscribersOutdated = false;
+
+	_subscribersByCode.clear();
+	_notifiedOfAll.clear();
 	for (size_t i = 0 ; i < _pluginInfos.size() ; i++)
 	{
-        if (_pluginInfos[i]->_hLib)
-        {
-			// To avoid the plugin change the data in SCNotification
-			// Each notification to pass to a plugin is a copy of SCNotification instance
-			SCNotification scNotif = *notification;
-			try {
-				_pluginInfos[i]->_pBeNotified(&scNotif);
-			} catch(std::exception e) {
-				::MessageBoxA(NULL, e.what(), "Exception", MB_OK);
-			} catch (...) {
-				TCHAR funcInfo[128];
-				generic_sprintf(funcInfo, 128, TEXT("notify(SCNotification *notification) : \r notification->nmhdr.code == %d\r notification->nmhdr.hwndFrom == %d\r notification->nmhdr.idFrom == %d"),\
-					scNotif.nmhdr.code, scNotif.nmhdr.hwndFrom, scNotif.nmhdr.idFrom);
-				pluginCrashAlert(_pluginsCommands[i]._pluginName.c_str(), funcInfo);
-			}
+		PluginInfo *pi = _pluginInfos[i];
+		if (!pi->_hLib)
+			continue;
+		if (pi->_isNotifiedOfAll)
+			_notifiedOfAll.push_back(pi);
+		else
+		{
+			for (size_t j = 0 ; j < pi->_notificationCodes.size() ; j++)
+				_subscribersByCode[pi->_notificationCodes[j]];
 		}
 	}
+
+	// Each list keeps the loading order, whoever subscribed to the code or to everything
+	for (std::map<UINT, std::vector<PluginInfo *> >::iterator it = _subscribersByCode.begin(); it != _subscribersByCode.end(); ++it)
+	{
+		for (size_t i = 0 ; i < _pluginInfos.size() ; i++)
+		{
+			PluginInfo *pi = _pluginInfos[i];
+			if (!pi->_hLib)
+				continue;
+			if (pi->_isNotifiedOfAll || std::find(pi->_notificationCodes.begin(), pi->_notificationCodes.end(), it->first) != pi->_notificationCodes.end())
+				it->second.push_back(pi);
+		}
+	}
+}
+
+bool PluginsManager::setNotificationMask(HINSTANCE hPluginModule, const NotificationMask *pMask)
+{
+	PluginInfo *pi = NULL;
+	for (size_t i = 0 ; i < _pluginInfos.size() ; i++)
+	{
+		if (_pluginInfos[i]->_hLib && _pluginInfos[i]->_hLib == hPluginModule)
+		{
+			pi = _pluginInfos[i];
+			break;
+		}
+	}
+	if (!pi)
+		return false;
+
+	pi->_notificationCodes.clear();
+	if (!pMask || pMask->nbCodes <= 0 || !pMask->codes)
+	{
+		pi->_isNotifiedOfAll = true;
+		pi->_modificationTypes = 0;
+	}
+	else
+	{
+		pi->_isNotifiedOfAll = false;
+		pi->_notificationCodes.assign(pMask->codes, pMask->codes + pMask->nbCodes);
+		pi->_notificationCodes.push_back(NPPN_SHUTDOWN);
+		pi->_modificationTypes = pMask->modificationTypes;
+	}
+	buildSubscriberLists();
+	return true;
+}
+
+void PluginsManager::notify(SCNotification *notification)
+{
+	std::map<UINT, std::vector<PluginInfo *> >::const_iterator it = _subscribersByCode.find(notification->nmhdr.code);
+	const std::vector<PluginInfo *> & subscribers = (it != _subscribersByCode.end())?it->second:_notifiedOfAll;
+	if (subscribers.empty())
+		return;
+
+	_notifyDepth++;
+	for (size_t i = 0 ; i < subscribers.size() ; i++)
+	{
+		PluginInfo *pi = subscribers[i];
+		if (!pi->_hLib)
+			continue;
+
+		if (notification->nmhdr.code == SCN_MODIFIED && pi->_modificationTypes && !(notification->modificationType & pi->_modificationTypes))
+			continue;
+
+		// To avoid the plugin change the data in SCNotification
+		// Each notification to pass to a plugin is a copy of SCNotification instance
+		SCNotification scNotif = *notification;
+		try {
+			pi->_pBeNotified(&scNotif);
+		} catch(std::exception e) {
+			::MessageBoxA(NULL, e.what(), "Exception", MB_OK);
+		} catch (...) {
+			TCHAR funcInfo[128];
+			generic_sprintf(funcInfo, 128, TEXT("notify(SCNotification *notification) : \r notification->nmhdr.code == %d\r notification->nmhdr.hwndFrom == %d\r notification->nmhdr.idFrom == %d"),\
+				scNotif.nmhdr.code, scNotif.nmhdr.hwndFrom, scNotif.nmhdr.idFrom);
+			pluginCrashAlert(pi->_moduleName.c_str(), funcInfo);
+		}
+	}
+	_notifyDepth--;
+
+	if (!_notifyDepth && _areSubscribersOutdated)
+		buildSubscriberLists();
 }
 
 void PluginsManager::relayNppMessages(UINT Message, WPARAM wParam, LPARAM lParam)
@@ -51,6 +51,11 @@ struct PluginInfo {
 	FuncItem *_funcItems;
 	int _nbFuncItem;
 	generic_string _moduleName;
+
+	// Set with NPPM_SETNOTIFICATIONMASK, the plugin gets every notification until then
+	bool _isNotifiedOfAll;
+	std::vector<UINT> _notificationCodes;
+	int _modificationTypes;		// SC_MOD_* flags of the SCN_MODIFIED it wants, 0 for all
 };
 
 class PluginsManager {
@@ -74,6 +79,7 @@ public:
 	bool getShortcutByCmdID(int cmdID, ShortcutKey *sk);
 
 	void notify(SCNotification *notification);
+	bool setNotificationMask(HINSTANCE hPluginModule, const NotificationMask *pMask);
 	void relayNppMessages(UINT Message, WPARAM wParam, LPARAM lParam);
 	bool relayPluginMessages(UINT Message, WPARAM wParam, LPARAM lParam);
 
@@ -99,6 +105,14 @@ private:
 	IDAllocator* _dynamicIDAlloc;
 	IDAllocator* _markerAlloc;
 
+	// Plugins to notify, in loading order, for each code some plugin asked for explicitly.
+	// Any other code goes to the plugins which didn't set a notification mask.
+	std::map<UINT, std::vector<PluginInfo *> > _subscribersByCode;
+	std::vector<PluginInfo *> _notifiedOfAll;
+	int _notifyDepth;				// notify can be reentered from a plugin
+	bool _areSubscribersOutdated;	// a mask changed while notifying, the lists are rebuilt afterward
+
+	void buildSubscriberLists();
 	void pluginCrashAlert(const TCHAR *pluginName, const TCHAR *funcSignature);
 };
 
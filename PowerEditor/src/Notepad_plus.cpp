@@ -198,6 +198,7 @@ Notepad_plus::Notepad_plus():
 {
 	ZeroMemory(&_prevSelectedRange, sizeof(_prevSelectedRange));
 
+	profile_scope("localization");
 	TiXmlDocumentA *nativeLangDocRootA = (NppParameters::getInstance())->getNativeLangA();
     _nativeLangSpeaker->init(nativeLangDocRootA);
 #ifdef UNICODE
@@ -239,6 +240,7 @@ Notepad_plus::~Notepad_plus()
 
 LRESULT Notepad_plus::init(HWND hwnd)
 {
+	profile_scope("Notepad_plus::init");
 	NppParameters *pNppParam = NppParameters::getInstance();
 	NppGUI & nppGUI = pNppParam->getNppGUI();
 
@@ -1327,6 +1329,7 @@ void Notepad_plus::doTrimTrailing()
 
 void Notepad_plus::loadLastSession()
 {
+	profile_scope("Notepad_plus::loadLastSession");
 	Session* lastSession = (NppParameters::getInstance())->getSession();
 	loadSession(lastSession);
 }
@@ -1593,6 +1596,12 @@ bool Notepad_plus::findInOpenedFiles()
 		for (int i = 0 ; i < _mainDocTab->nbItem() ; i++)
 	    {
 			pBuf = MainFileManager->getBufferByID(_mainDocTab->getBufferByIndex(i));
+			int nbFound = _findReplaceDlg->findAllInHugeFile(FindReplaceDlg::_env, pBuf);
+			if (nbFound != -1)
+			{
+				nbTotal += nbFound;
+				continue;
+			}
 			_invisibleEditView->execute(SCI_SETDOCPOINTER, 0, pBuf->getDocument());
 			int cp = _invisibleEditView->execute(SCI_GETCODEPAGE);
 			_invisibleEditView->execute(SCI_SETCODEPAGE, pBuf->getUnicodeMode() == uni8Bit ? cp : SC_CP_UTF8);
@@ -1606,6 +1615,12 @@ bool Notepad_plus::findInOpenedFiles()
 		for (int i = 0 ; i < _subDocTab->nbItem() ; i++)
 	    {
 			pBuf = MainFileManager->getBufferByID(_subDocTab->getBufferByIndex(i));
+			int nbFound = _findReplaceDlg->findAllInHugeFile(FindReplaceDlg::_env, pBuf);
+			if (nbFound != -1)
+			{
+				nbTotal += nbFound;
+				continue;
+			}
 			_invisibleEditView->execute(SCI_SETDOCPOINTER, 0, pBuf->getDocument());
 			int cp = _invisibleEditView->execute(SCI_GETCODEPAGE);
 			_invisibleEditView->execute(SCI_SETCODEPAGE, pBuf->getUnicodeMode() == uni8Bit ? cp : SC_CP_UTF8);
@@ -1640,10 +1655,15 @@ bool Notepad_plus::findInCurrentFile()
 
 	_findReplaceDlg->beginNewFilesSearch();
 
-	_invisibleEditView->execute(SCI_SETDOCPOINTER, 0, pBuf->getDocument());
-	int cp = _invisibleEditView->execute(SCI_GETCODEPAGE);
-	_invisibleEditView->execute(SCI_SETCODEPAGE, pBuf->getUnicodeMode() == uni8Bit ? cp : SC_CP_UTF8);
-	nbTotal += _findReplaceDlg->processAll(ProcessFindAll, FindReplaceDlg::_env, isEntireDoc, pBuf->getFullPathName());
+	// Huge files are searched on disk, not in their window
+	nbTotal = _findReplaceDlg->findAllInHugeFile(FindReplaceDlg::_env, pBuf);
+	if (nbTotal == -1)
+	{
+		_invisibleEditView->execute(SCI_SETDOCPOINTER, 0, pBuf->getDocument());
+		int cp = _invisibleEditView->execute(SCI_GETCODEPAGE);
+		_invisibleEditView->execute(SCI_SETCODEPAGE, pBuf->getUnicodeMode() == uni8Bit ? cp : SC_CP_UTF8);
+		nbTotal = _findReplaceDlg->processAll(ProcessFindAll, FindReplaceDlg::_env, isEntireDoc, pBuf->getFullPathName());
+	}
 
 	_findReplaceDlg->finishFilesSearch(nbTotal);
 
@@ -1783,6 +1803,8 @@ void Notepad_plus::checkDocState()
 		bool isUserReadOnly = curBuf->getUserReadOnly();
 		::CheckMenuItem(_mainMenuHandle, IDM_EDIT_SETREADONLY, MF_BYCOMMAND | (isUserReadOnly?MF_CHECKED:MF_UNCHECKED));
 	}
+	enableCommand(IDM_VIEW_MONITORING, !isCurrentUntitled, MENU);
+	::CheckMenuItem(_mainMenuHandle, IDM_VIEW_MONITORING, MF_BYCOMMAND | (curBuf->isFollowing()?MF_CHECKED:MF_UNCHECKED));
 	enableCommand(IDM_FILE_DELETE, isFileExisting, MENU);
 	enableCommand(IDM_FILE_RENAME, isFileExisting, MENU);
 
@@ -1888,50 +1910,17 @@ void Notepad_plus::setLangStatus(LangType langType){
 
 void Notepad_plus::copyMarkedLines()
 {
-	int lastLine = _pEditView->lastZeroBasedLineNumber();
-	generic_string globalStr = TEXT("");
-	for (int i = lastLine ; i >= 0 ; i--)
-	{
-		if (bookmarkPresent(i))
-		{
-			generic_string currentStr = getMarkedLine(i) + globalStr;
-			globalStr = currentStr;
-		}
-	}
-	str2Cliboard(globalStr.c_str());
+	processMarkedLines(true, false, NULL);
 }
 
 void Notepad_plus::cutMarkedLines()
 {
-	int lastLine = _pEditView->lastZeroBasedLineNumber();
-	generic_string globalStr = TEXT("");
-
-	_pEditView->execute(SCI_BEGINUNDOACTION);
-	for (int i = lastLine ; i >= 0 ; i--)
-	{
-		if (bookmarkPresent(i))
-		{
-			generic_string currentStr = getMarkedLine(i) + globalStr;
-			globalStr = currentStr;
-
-			deleteMarkedline(i);
-		}
-	}
-	_pEditView->execute(SCI_ENDUNDOACTION);
-	str2Cliboard(globalStr.c_str());
+	processMarkedLines(true, true, NULL);
 }
 
 void Notepad_plus::deleteMarkedLines()
 {
-	int lastLine = _pEditView->lastZeroBasedLineNumber();
-
-	_pEditView->execute(SCI_BEGINUNDOACTION);
-	for (int i = lastLine ; i >= 0 ; i--)
-	{
-		if (bookmarkPresent(i))
-			deleteMarkedline(i);
-	}
-	_pEditView->execute(SCI_ENDUNDOACTION);
+	processMarkedLines(false, true, NULL);
 }
 
 void Notepad_plus::pasteToMarkedLines()
@@ -1945,7 +1934,6 @@ void Notepad_plus::pasteToMarkedLines()
 	BOOL canPaste = ::IsClipboardFormatAvailable(clipFormat);
 	if (!canPaste)
 		return;
-	int lastLine = _pEditView->lastZeroBasedLineNumber();
 
 	::OpenClipboard(_pPublicInterface->getHSelf());
 	HANDLE clipboardData = ::GetClipboardData(clipFormat);
@@ -1957,35 +1945,114 @@ void Notepad_plus::pasteToMarkedLines()
 	::GlobalUnlock(clipboardData);
 	::CloseClipboard();
 
-	_pEditView->execute(SCI_BEGINUNDOACTION);
-	for (int i = lastLine ; i >= 0 ; i--)
-	{
-		if (bookmarkPresent(i))
-		{
-			replaceMarkedline(i, clipboardStr.c_str());
-		}
-	}
-	_pEditView->execute(SCI_ENDUNDOACTION);
+	processMarkedLines(false, false, clipboardStr.c_str());
 }
 
-void Notepad_plus::deleteMarkedline(int ln)
+// Every bookmark command goes through here, so that whatever the number of bookmarks the document
+// is read only once, straight from Scintilla's buffer, and modified by a single SCI_REPLACERANGES
+// touching nothing but the marked lines: the other lines keep their markers and indicators.
+// doCopy puts the marked lines on the clipboard, doRemove removes them, and if replacement is
+// not NULL, it becomes the content of each marked line (their EOL is kept).
+void Notepad_plus::processMarkedLines(bool doCopy, bool doRemove, const TCHAR *replacement)
 {
-	int lineLen = _pEditView->execute(SCI_LINELENGTH, ln);
-	int lineBegin = _pEditView->execute(SCI_POSITIONFROMLINE, ln);
+	std::vector<int> markedLines;
+	_pEditView->getMarkedLines(1 << MARK_BOOKMARK, markedLines);
+	if (markedLines.empty())
+	{
+		if (doCopy)
+			str2Cliboard(TEXT(""));
+		return;
+	}
+
+	const int firstLine = markedLines.front();
+	const int lastLine = markedLines.back();
+	const int spanStart = _pEditView->execute(SCI_POSITIONFROMLINE, firstLine);
+	const int spanLength = _pEditView->execute(SCI_POSITIONFROMLINE, lastLine) + _pEditView->execute(SCI_LINELENGTH, lastLine) - spanStart;
+	const char *span = (const char *)_pEditView->execute(SCI_GETRANGEPOINTER, spanStart, spanLength);
+	unsigned int cp = _pEditView->execute(SCI_GETCODEPAGE);
+
+	// Consecutive marked lines are contiguous in the buffer, they are handled as a single range
+	std::vector< std::pair<int, int> > markedRanges;
+	int markedLength = 0;
+	for (size_t i = 0 ; i < markedLines.size() ; )
+	{
+		size_t j = i + 1;
+		while (j < markedLines.size() && markedLines[j] == markedLines[j-1] + 1)
+			j++;
+		int rangeStart = _pEditView->execute(SCI_POSITIONFROMLINE, markedLines[i]) - spanStart;
+		int rangeEnd = _pEditView->execute(SCI_POSITIONFROMLINE, markedLines[j-1]) + _pEditView->execute(SCI_LINELENGTH, markedLines[j-1]) - spanStart;
+		markedRanges.push_back(std::make_pair(rangeStart, rangeEnd));
+		markedLength += rangeEnd - rangeStart;
+		i = j;
+	}
+
+	if (doCopy)
+	{
+		std::string copiedText;
+		copiedText.reserve(markedLength);
+		for (size_t i = 0 ; i < markedRanges.size() ; i++)
+			copiedText.append(span + markedRanges[i].first, markedRanges[i].second - markedRanges[i].first);
+#ifdef UNICODE
+		str2Cliboard(WcharMbcsConvertor::getInstance()->char2wchar(copiedText.c_str(), cp));
+#else
+		str2Cliboard(copiedText.c_str());
+#endif
+	}
 
-	bookmarkDelete(ln);
-	TCHAR emptyString[2] = TEXT("");
-	_pEditView->replaceTarget(emptyString, lineBegin, lineBegin + lineLen);
+	if (!doRemove && !replacement)
+		return;
+
+	// The marked lines are removed a run of consecutive lines at a time, EOL included,
+	// or their content is replaced one line at a time, EOL excluded
+	std::vector<Sci_RangeReplacement> ranges;
+	std::vector<std::string> texts;
+	if (replacement)
+	{
+#ifdef UNICODE
+		std::string replacementA = WcharMbcsConvertor::getInstance()->wchar2char(replacement, cp);
+#else
+		std::string replacementA = replacement;
+#endif
+		ranges.reserve(markedLines.size());
+		texts.assign(markedLines.size(), replacementA);
+		for (size_t i = 0 ; i < markedLines.size() ; i++)
+		{
+			int lineStart = _pEditView->execute(SCI_POSITIONFROMLINE, markedLines[i]);
+			int lineEnd = _pEditView->execute(SCI_GETLINEENDPOSITION, markedLines[i]);
+			Sci_RangeReplacement range = {lineStart, lineEnd - lineStart, NULL, long(replacementA.length())};
+			ranges.push_back(range);
+		}
+	}
+	else
+	{
+		// As before, the bookmarks go with their lines instead of being merged into the next ones
+		for (size_t i = 0 ; i < markedLines.size() ; i++)
+			bookmarkDelete(markedLines[i]);
+		ranges.reserve(markedRanges.size());
+		texts.resize(markedRanges.size());
+		for (size_t i = 0 ; i < markedRanges.size() ; i++)
+		{
+			Sci_RangeReplacement range = {spanStart + markedRanges[i].first, markedRanges[i].second - markedRanges[i].first, NULL, 0};
+			ranges.push_back(range);
+		}
+	}
+	_pEditView->replaceRanges(ranges, texts);
 }
 
 void Notepad_plus::inverseMarks()
 {
 	int lastLine = _pEditView->lastZeroBasedLineNumber();
+	std::vector<int> markedLines;
+	_pEditView->getMarkedLines(1 << MARK_BOOKMARK, markedLines);
+
+	// Walk the marked lines and the gaps between them, instead of asking for the markers of each line
+	size_t nextMarked = 0;
 	for (int i = 0 ; i <= lastLine  ; i++)
 	{
-		if (bookmarkPresent(i))
+		if (nextMarked < markedLines.size() && markedLines[nextMarked] == i)
 		{
 			bookmarkDelete(i);
+			nextMarked++;
 		}
 		else
 		{
@@ -1994,27 +2061,6 @@ void Notepad_plus::inverseMarks()
 	}
 }
 
-void Notepad_plus::replaceMarkedline(int ln, const TCHAR *str)
-{
-	int lineBegin = _pEditView->execute(SCI_POSITIONFROMLINE, ln);
-	int lineEnd = _pEditView->execute(SCI_GETLINEENDPOSITION, ln);
-
-	_pEditView->replaceTarget(str, lineBegin, lineEnd);
-}
-
-generic_string Notepad_plus::getMarkedLine(int ln)
-{
-	int lineLen = _pEditView->execute(SCI_LINELENGTH, ln);
-	int lineBegin = _pEditView->execute(SCI_POSITIONFROMLINE, ln);
-
-	TCHAR * buf = new TCHAR[lineLen+1];
-	_pEditView->getGenericText(buf, lineBegin, lineBegin + lineLen);
-	generic_string line = buf;
-	delete [] buf;
-
-	return line;
-}
-
 void Notepad_plus::findMatchingBracePos(int & braceAtCaret, int & braceOpposite)
 {
 	int caretPos = int(_pEditView->execute(SCI_GETCURRENTPOS));
@@ -2075,6 +2121,67 @@ bool Notepad_plus::braceMatch()
     return (braceAtCaret != -1);
 }
 
+// Holding an arrow key sends a SCN_UPDATEUI every 30 ms or so: the deferred stages run only
+// once the caret stayed still for longer than that.
+const UINT deferredUIUpdateDelay = 100;
+
+// Time after which the remaining stages are left for the next timer tick
+const DWORD deferredUIUpdateBudget = 30;
+
+void Notepad_plus::scheduleUIUpdate(int stages, ScintillaEditView *pView)
+{
+	// Whatever was pending was for a previous position: it is replaced, and the delay restarts
+	_deferredUIUpdate._stages = stages;
+	_deferredUIUpdate._pView = pView;
+	if (stages)
+		::SetTimer(_pPublicInterface->getHSelf(), IDT_DEFERREDUIUPDATE, deferredUIUpdateDelay, NULL);
+	else
+		::KillTimer(_pPublicInterface->getHSelf(), IDT_DEFERREDUIUPDATE);
+}
+
+void Notepad_plus::runDeferredUIUpdate()
+{
+	NppParameters *nppParam = NppParameters::getInstance();
+	NppGUI & nppGui = nppParam->getNppGUI();
+
+	// The view was switched meanwhile, it got its own SCN_UPDATEUI
+	if (_deferredUIUpdate._pView != _pEditView)
+		_deferredUIUpdate._stages = 0;
+
+	DWORD startTime = ::GetTickCount();
+	while (_deferredUIUpdate._stages && !nppParam->_isFindReplacing)
+	{
+		// First, the other stages work on the text of the window
+		if (_deferredUIUpdate._stages & DeferredFileWindow)
+		{
+			_deferredUIUpdate._stages &= ~DeferredFileWindow;
+			_pEditView->slideFileWindow();
+		}
+		else if (_deferredUIUpdate._stages & DeferredTagMatch)
+		{
+			_deferredUIUpdate._stages &= ~DeferredTagMatch;
+			if (nppGui._enableTagsMatchHilite)
+			{
+				XmlMatchedTagsHighlighter xmlTagMatchHiliter(_pEditView);
+				xmlTagMatchHiliter.tagMatch(nppGui._enableTagAttrsHilite);
+			}
+		}
+		else if (_deferredUIUpdate._stages & DeferredSmartHilite)
+		{
+			_deferredUIUpdate._stages &= ~DeferredSmartHilite;
+			if (nppGui._enableSmartHilite)
+				_smartHighlighter->highlightView(_pEditView);
+		}
+
+		// Let a pending key or click go first: it will most likely schedule new stages anyway
+		if (::GetTickCount() - startTime >= deferredUIUpdateBudget || HIWORD(::GetQueueStatus(QS_KEY | QS_MOUSEBUTTON)))
+			break;
+	}
+
+	if (!_deferredUIUpdate._stages)
+		::KillTimer(_pPublicInterface->getHSelf(), IDT_DEFERREDUIUPDATE);
+}
+
 
 void Notepad_plus::setDisplayFormat(formatType f)
 {
@@ -2836,15 +2943,28 @@ void Notepad_plus::updateStatusBar()
 	else
 		wsprintf(strSel, TEXT("Sel : %s"), TEXT("N/A"));
 
-    wsprintf(strLnCol, TEXT("Ln : %d    Col : %d    %s"),\
-        (_pEditView->getCurrentLineNumber() + 1), \
-        (_pEditView->getCurrentColumnNumber() + 1),\
-        strSel);
+    TCHAR strDocLen[256];
+	HugeFileView *pHugeFile = _pEditView->getCurrentBuffer()->getHugeFileView();
+	if (pHugeFile)
+	{
+		// Lines of the whole file, as far as they are indexed
+		__int64 line = _pEditView->getCurrentFileLine();
+		if (line != -1)
+			wsprintf(strLnCol, TEXT("Ln : %I64d    Col : %d    %s"), line + 1, (_pEditView->getCurrentColumnNumber() + 1), strSel);
+		else
+			wsprintf(strLnCol, TEXT("Ln : ?    Col : %d    %s"), (_pEditView->getCurrentColumnNumber() + 1), strSel);
+		wsprintf(strDocLen, TEXT("length : %I64d    lines : %I64d%s"), pHugeFile->getTextLength(), pHugeFile->getLineCount(), pHugeFile->isIndexComplete() ? TEXT("") : TEXT("+"));
+	}
+	else
+	{
+		wsprintf(strLnCol, TEXT("Ln : %d    Col : %d    %s"),\
+			(_pEditView->getCurrentLineNumber() + 1), \
+			(_pEditView->getCurrentColumnNumber() + 1),\
+			strSel);
+		wsprintf(strDocLen, TEXT("length : %d    lines : %d"), _pEditView->getCurrentDocLen(), _pEditView->execute(SCI_GETLINECOUNT));
+	}
 
     _statusBar->setText(strLnCol, STATUSBAR_CUR_POS);
-
-    TCHAR strDocLen[256];
-	wsprintf(strDocLen, TEXT("length : %d    lines : %d"), _pEditView->getCurrentDocLen(), _pEditView->execute(SCI_GETLINECOUNT));
     _statusBar->setText(strDocLen, STATUSBAR_DOC_SIZE);
     _statusBar->setText(_pEditView->execute(SCI_GETOVERTYPE) ? TEXT("OVR") : TEXT("INS"), STATUSBAR_TYPING_MODE);
 }
@@ -2872,6 +2992,16 @@ void Notepad_plus::dropFiles(HDROP hdrop)
 		}
 
 		int filesDropped = ::DragQueryFile(hdrop, 0xffffffff, NULL, 0);
+		if (filesDropped > 1)
+		{
+			for (int i = 0 ; i < filesDropped ; ++i)
+			{
+				TCHAR pathDropped[MAX_PATH];
+				::DragQueryFile(hdrop, i, pathDropped, MAX_PATH);
+				prefetchFile(pathDropped);
+			}
+		}
+
 		BufferID lastOpened = BUFFER_INVALID;
 		for (int i = 0 ; i < filesDropped ; ++i)
 		{
@@ -2882,6 +3012,7 @@ void Notepad_plus::dropFiles(HDROP hdrop)
 				lastOpened = test;
             //setLangStatus(_pEditView->getCurrentDocType());
 		}
+		MainFileManager->discardPrefetchedFiles();
 		if (lastOpened != BUFFER_INVALID) {
 			switchToFile(lastOpened);
 		}
@@ -4307,15 +4438,9 @@ void Notepad_plus::getCurrentOpenedFiles(Session & in_session)
 
 			//_mainEditView->activateBuffer(buf->getID());
 			_invisibleEditView->execute(SCI_SETDOCPOINTER, 0, buf->getDocument());
-			int maxLine = _invisibleEditView->execute(SCI_GETLINECOUNT);
-
-			for (int j = 0 ; j < maxLine ; j++)
-			{
-				if ((_invisibleEditView->execute(SCI_MARKERGET, j)&(1 << MARK_BOOKMARK)) != 0)
-				{
-					sfi.marks.push_back(j);
-				}
-			}
+			std::vector<int> markedLines;
+			_invisibleEditView->getMarkedLines(1 << MARK_BOOKMARK, markedLines);
+			sfi.marks.assign(markedLines.begin(), markedLines.end());
 			in_session._mainViewFiles.push_back(sfi);
 		}
 	}
@@ -4332,14 +4457,9 @@ void Notepad_plus::getCurrentOpenedFiles(Session & in_session)
 			sessionFileInfo sfi(buf->getFullPathName(), langName, buf->getEncoding(), buf->getPosition(_subEditView));
 
 			_invisibleEditView->execute(SCI_SETDOCPOINTER, 0, buf->getDocument());
-			int maxLine = _invisibleEditView->execute(SCI_GETLINECOUNT);
-			for (int j = 0 ; j < maxLine ; j++)
-			{
-				if ((_invisibleEditView->execute(SCI_MARKERGET, j)&(1 << MARK_BOOKMARK)) != 0)
-				{
-					sfi.marks.push_back(j);
-				}
-			}
+			std::vector<int> markedLines;
+			_invisibleEditView->getMarkedLines(1 << MARK_BOOKMARK, markedLines);
+			sfi.marks.assign(markedLines.begin(), markedLines.end());
 			in_session._subViewFiles.push_back(sfi);
 		}
 	}
@@ -4536,6 +4656,15 @@ void Notepad_plus::notifyBufferChanged(Buffer * buffer, int mask)
 		return;
 	}
 
+	if (mask & (BufferChangeAppended))
+	{
+		// Follow mode: a view whose caret was at the end of the text keeps showing the end
+		if (mainActive && _mainEditView->execute(SCI_GETCURRENTPOS) >= buffer->getAppendPosition())
+			_mainEditView->execute(SCI_DOCUMENTEND);
+		if (subActive && _subEditView->execute(SCI_GETCURRENTPOS) >= buffer->getAppendPosition())
+			_subEditView->execute(SCI_DOCUMENTEND);
+	}
+
 	if (mask & (BufferChangeLanguage))
 	{
 		assert(_autoCompleteMain);
@@ -4647,6 +4776,12 @@ void Notepad_plus::loadCommandlineParams(const TCHAR * commandLine, CmdLineParam
 
 	bool readOnly = pCmdParams->_isReadOnly;
 
+	if (fnss.size() > 1)
+	{
+		for (int i = 0 ; i < fnss.size() ; i++)
+			prefetchFile(fnss.getFileName(i));
+	}
+
 	BufferID lastOpened = BUFFER_INVALID;
 	for (int i = 0 ; i < fnss.size() ; i++)
 	{
@@ -4678,6 +4813,7 @@ void Notepad_plus::loadCommandlineParams(const TCHAR * commandLine, CmdLineParam
 			switchEditViewTo(iView);	//restore view
 		}
 	}
+	MainFileManager->discardPrefetchedFiles();
 	if (lastOpened != BUFFER_INVALID)
     {
 		switchToFile(lastOpened);
@@ -48,6 +48,9 @@
 
 #define URL_REG_EXPR "[A-Za-z]+://[A-Za-z0-9_\\-\\+~.:?&@=/%#,;\\{\\}\\(\\)\\[\\]\\|\\*\\!\\\\]+"
 
+// Timer of the main window running the SCN_UPDATEUI work deferred until the caret stops moving
+#define IDT_DEFERREDUIUPDATE 1
+
 enum FileTransferMode {
 	TransferClone		= 0x01,
 	TransferMove		= 0x02
@@ -169,6 +172,7 @@ public:
 // fileOperations
 	//The doXXX functions apply to a single buffer and dont need to worry about views, with the excpetion of doClose, since closing one view doesnt have to mean the document is gone
     BufferID doOpen(const TCHAR *fileName, bool isReadOnly = false, int encoding = -1);
+	void prefetchFile(const TCHAR *fileName, int encoding = -1);	//lets the next doOpen of that file skip the disk read and decoding
 	bool doReload(BufferID id, bool alert = true);
 	bool doSave(BufferID, const TCHAR * filename, bool isSaveCopy = false);
 	void doClose(BufferID, int whichOne);
@@ -329,6 +333,19 @@ private:
 		bool doSync() const {return (_isSynScollV || _isSynScollH); }
 	} _syncInfo;
 
+	// What SCN_UPDATEUI triggers and is too slow to be done at each caret move
+	enum DeferredUIStage {
+		DeferredTagMatch	= 0x01,
+		DeferredSmartHilite	= 0x02,
+		DeferredFileWindow	= 0x04		// huge files: the window of the file follows the view
+	};
+
+	struct DeferredUIUpdate {
+		int _stages;				// DeferredUIStage bits still to run
+		ScintillaEditView *_pView;	// view which the stages were scheduled for
+		DeferredUIUpdate():_stages(0), _pView(NULL){}
+	} _deferredUIUpdate;
+
 	bool _isUDDocked;
 
 	trayIconControler *_pTrayIco;
@@ -447,14 +464,15 @@ private:
 	void cutMarkedLines();
 	void deleteMarkedLines();
 	void pasteToMarkedLines();
-	void deleteMarkedline(int ln);
+	void processMarkedLines(bool doCopy, bool doRemove, const TCHAR *replacement);
 	void inverseMarks();
-	void replaceMarkedline(int ln, const TCHAR *str);
-	generic_string getMarkedLine(int ln);
 
     void findMatchingBracePos(int & braceAtCaret, int & braceOpposite);
     bool braceMatch();
 
+	void scheduleUIUpdate(int stages, ScintillaEditView *pView);
+	void runDeferredUIUpdate();
+
     void activateNextDoc(bool direction);
 	void activateDoc(int pos);
 
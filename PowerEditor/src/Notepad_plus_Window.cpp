@@ -47,6 +47,8 @@ Notepad_plus_Window::~Notepad_plus_Window()
 
 void Notepad_plus_Window::init(HINSTANCE hInst, HWND parent, const TCHAR *cmdLine, CmdLineParams *cmdLineParams)
 {
+	profile_scope("Notepad_plus_Window::init");
+	profile_phases("create window");
 	time_t timestampBegin = 0;
 	if (cmdLineParams->_showLoadingTime)
 		timestampBegin = time(NULL);
@@ -145,12 +147,14 @@ void Notepad_plus_Window::init(HINSTANCE hInst, HWND parent, const TCHAR *cmdLin
 		::SendMessage(_hSelf, NPPM_HIDETABBAR, 0, TRUE);
 	}
 
+	profile_next_phase("last session");
     _notepad_plus_plus_core->_rememberThisSession = !cmdLineParams->_isNoSession;
 	if (nppGUI._rememberLastSession && !cmdLineParams->_isNoSession)
 	{
 		_notepad_plus_plus_core->loadLastSession();
 	}
 
+	profile_next_phase("show window");
 	if (!cmdLineParams->_isPreLaunch)
 	{
 		if (cmdLineParams->isPointValid())
@@ -164,11 +168,13 @@ void Notepad_plus_Window::init(HINSTANCE hInst, HWND parent, const TCHAR *cmdLin
 		_notepad_plus_plus_core->_pTrayIco->doTrayIcon(TRAYICON_ADD);
 	}
 
+	profile_next_phase("command line files");
     if (cmdLine)
     {
 		_notepad_plus_plus_core->loadCommandlineParams(cmdLine, cmdLineParams);
     }
 
+	profile_next_phase("localizations and themes");
 	std::vector<generic_string> fileNames;
 	std::vector<generic_string> patterns;
 	patterns.push_back(TEXT("*.xml"));
@@ -218,6 +224,7 @@ void Notepad_plus_Window::init(HINSTANCE hInst, HWND parent, const TCHAR *cmdLin
 	}
 
 	// Notify plugins that Notepad++ is ready
+	profile_next_phase("NPPN_READY");
 	SCNotification scnN;
 	scnN.nmhdr.code = NPPN_READY;
 	scnN.nmhdr.hwndFrom = _hSelf;
@@ -926,10 +926,14 @@ LRESULT Notepad_plus::process(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lPa
 			pSci->execute(SCI_GETTEXT, length, (LPARAM)buffer);
 
 			length = UnicodeConvertor.convert(buffer, length-1);
+			std::string text(UnicodeConvertor.getNewBuf(), length);
+			// An empty block flushes what the convertor kept for a character cut at the end
+			length = UnicodeConvertor.convert(buffer, 0);
+			text.append(UnicodeConvertor.getNewBuf(), length);
 
 			// set text in target
 			pSci->execute(SCI_CLEARALL);
-			pSci->addText(length, UnicodeConvertor.getNewBuf());
+			pSci->addText(int(text.length()), text.c_str());
 
 
 
@@ -1339,6 +1343,20 @@ LRESULT Notepad_plus::process(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lPa
 			break;
 		}
 
+		case NPPM_INTERNAL_FILESCHANGED :
+		{
+			// Posted by the FileWatcher of MainFileManager. The files are checked now if the user is
+			// working in Notepad++, otherwise when it is activated again. Followed files are appended
+			// to in the background, as long as they only grow
+			MainFileManager->takeFileChanges();
+			const NppGUI & nppgui = pNppParam->getNppGUI();
+			if (nppgui._fileAutoDetection != cdDisabled && ::GetForegroundWindow() == hwnd)
+				checkModifiedDocument();
+			else
+				MainFileManager->followFileChanges();
+			return TRUE;
+		}
+
 		case NPPM_INTERNAL_GETCHECKDOCOPT :
 		{
 			return (LRESULT)(pNppParam->getNppGUI())._fileAutoDetection;
@@ -1397,6 +1415,16 @@ LRESULT Notepad_plus::process(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lPa
 			_pEditView->getFocus();
 			return TRUE;
 
+		case WM_TIMER:
+		{
+			if (wParam == IDT_DEFERREDUIUPDATE)
+			{
+				runDeferredUIUpdate();
+				return TRUE;
+			}
+			return ::DefWindowProc(hwnd, Message, wParam, lParam);
+		}
+
 		case WM_DROPFILES:
 		{
 			dropFiles(reinterpret_cast<HDROP>(wParam));
@@ -1702,6 +1730,9 @@ LRESULT Notepad_plus::process(HWND hwnd, UINT Message, WPARAM wParam, LPARAM lPa
 		case NPPM_ALLOCATEMARKER:
 			return _pluginsManager->allocateMarker(wParam, reinterpret_cast<int *>(lParam));
 
+		case NPPM_SETNOTIFICATIONMASK:
+			return _pluginsManager->setNotificationMask(reinterpret_cast<HINSTANCE>(wParam), reinterpret_cast<const NotificationMask *>(lParam));
+
 		case NPPM_HIDETABBAR :
 		{
 			bool hide = (lParam != 0);
@@ -695,6 +695,16 @@ void Notepad_plus::command(int id)
 		}
 		break;
 
+		case IDM_VIEW_MONITORING:
+		{
+			Buffer * buf = _pEditView->getCurrentBuffer();
+			buf->setFollowing(!buf->isFollowing());
+			checkDocState();
+			if (buf->isFollowing())
+				buf->checkFileState();	//catch up with what was written since the last check
+		}
+		break;
+
 		case IDM_EDIT_CLEARREADONLY:
 		{
 			Buffer * buf = _pEditView->getCurrentBuffer();
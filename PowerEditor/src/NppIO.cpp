@@ -21,10 +21,12 @@
 #include "MISC/PluginsManager/PluginsManager.h"
 
 #include "WinControls/OpenSaveFileDialog/FileDialog.h"
+#include "WinControls/StatusBar/StatusBar.h"
 #include "WinControls/TrayIcon/trayIconControler.h"
 
 #include "ScintillaComponent/Buffer.h"
 #include "ScintillaComponent/DocTabView.h"
+#include "ScintillaComponent/FileSaver.h"
 #include "ScintillaComponent/ScintillaEditView.h"
 
 #include "lastRecentFileList.h"
@@ -34,6 +36,29 @@
 #include "Notepad_plus_Window.h"
 #include "Notepad_plus.h"
 
+// Queues the file to be read and decoded by the FileManager's loader threads.
+// It has to resolve the file name and the encoding exactly as doOpen does,
+// otherwise doOpen won't find the prefetched data and will load the file itself.
+void Notepad_plus::prefetchFile(const TCHAR *fileName, int encoding)
+{
+	TCHAR longFileName[MAX_PATH];
+
+	::GetFullPathName(fileName, MAX_PATH, longFileName, NULL);
+	::GetLongPathName(longFileName, longFileName, MAX_PATH);
+
+	if (MainFileManager->getBufferFromName(longFileName) != BUFFER_INVALID)
+		return;
+
+	if (!PathFileExists(longFileName) || ::PathIsDirectory(longFileName) || isFileSession(longFileName))
+		return;
+
+	if (encoding == -1)
+	{
+		encoding = getHtmlXmlEncoding(longFileName);
+	}
+	MainFileManager->prefetchFile(longFileName, encoding);
+}
+
 BufferID Notepad_plus::doOpen(const TCHAR *fileName, bool isReadOnly, int encoding)
 {
 	TCHAR longFileName[MAX_PATH];
@@ -237,6 +262,35 @@ bool Notepad_plus::doReload(BufferID id, bool alert)
 	return res;
 }
 
+// Shows in the status bar how far a long save went; Escape cancels it.
+class SaveProgressIndicator : public SaveProgressHandler
+{
+public:
+	SaveProgressIndicator(HWND hNpp, StatusBar *pStatusBar) : _hNpp(hNpp), _pStatusBar(pStatusBar), _isShown(false), _isCancelled(false) {};
+
+	virtual bool onSaveProgress(size_t bytesDone, size_t bytesTotal) {
+		int percent = bytesTotal?int(double(bytesDone) * 100 / bytesTotal):100;
+		TCHAR str[64];
+		wsprintf(str, TEXT("Saving: %d%% (Esc to cancel)"), percent);
+		_pStatusBar->setText(str, STATUSBAR_DOC_TYPE);
+		::UpdateWindow(_pStatusBar->getHSelf());
+		_isShown = true;
+
+		if (::GetForegroundWindow() == _hNpp && (::GetAsyncKeyState(VK_ESCAPE) & 0x8000))
+			_isCancelled = true;
+		return !_isCancelled;
+	};
+
+	bool isShown() const { return _isShown; };
+	bool isCancelled() const { return _isCancelled; };
+
+private:
+	HWND _hNpp;
+	StatusBar *_pStatusBar;
+	bool _isShown;
+	bool _isCancelled;
+};
+
 bool Notepad_plus::doSave(BufferID id, const TCHAR * filename, bool isCopy)
 {
 	SCNotification scnN;
@@ -250,7 +304,10 @@ bool Notepad_plus::doSave(BufferID id, const TCHAR * filename, bool isCopy)
 		_pluginsManager->notify(&scnN);
 	}
 
-	bool res = MainFileManager->saveBuffer(id, filename, isCopy);
+	SaveProgressIndicator progressIndicator(_pPublicInterface->getHSelf(), _statusBar);
+	bool res = MainFileManager->saveBuffer(id, filename, isCopy, &progressIndicator);
+	if (progressIndicator.isShown())
+		setLangStatus(_pEditView->getCurrentBuffer()->getLangType());
 
 	if (!isCopy)
 	{
@@ -258,7 +315,7 @@ bool Notepad_plus::doSave(BufferID id, const TCHAR * filename, bool isCopy)
 		_pluginsManager->notify(&scnN);
 	}
 
-	if (!res)
+	if (!res && !progressIndicator.isCancelled())
 		::MessageBox(_pPublicInterface->getHSelf(), TEXT("Please check whether if this file is opened in another program"), TEXT("Save failed"), MB_OK);
 	return res;
 }
@@ -837,11 +894,17 @@ void Notepad_plus::fileOpen()
 	if (stringVector *pfns = fDlg.doOpenMultiFilesDlg())
 	{
 		size_t sz = pfns->size();
+		if (sz > 1)
+		{
+			for (size_t i = 0 ; i < sz ; i++)
+				prefetchFile(pfns->at(i).c_str());
+		}
 		for (size_t i = 0 ; i < sz ; i++) {
 			BufferID test = doOpen(pfns->at(i).c_str(), fDlg.isReadOnly());
 			if (test != BUFFER_INVALID)
 				lastOpened = test;
 		}
+		MainFileManager->discardPrefetchedFiles();
 	}
 	if (lastOpened != BUFFER_INVALID) {
 		switchToFile(lastOpened);
@@ -884,6 +947,13 @@ bool Notepad_plus::loadSession(Session* session)
 
 	bool allSessionFilesLoaded = true;
 	BufferID lastOpened = BUFFER_INVALID;
+
+	// Read every file of the session in the background while the views are being filled
+	for (size_t j = 0 ; j < session->nbMainFiles() ; j++)
+		prefetchFile(session->_mainViewFiles[j]._fileName.c_str(), session->_mainViewFiles[j]._encoding);
+	for (size_t j = 0 ; j < session->nbSubFiles() ; j++)
+		prefetchFile(session->_subViewFiles[j]._fileName.c_str(), session->_subViewFiles[j]._encoding);
+
 	size_t i = 0;
 	showView(MAIN_VIEW);
 	switchEditViewTo(MAIN_VIEW);	//open files in main
@@ -998,6 +1068,7 @@ bool Notepad_plus::loadSession(Session* session)
 			allSessionFilesLoaded = false;
 		}
 	}
+	MainFileManager->discardPrefetchedFiles();
 
 	_mainEditView->restoreCurrentPos();
 	_subEditView->restoreCurrentPos();
@@ -28,7 +28,6 @@
 #include "ScintillaComponent/GoToLineDlg.h"
 #include "ScintillaComponent/ScintillaEditView.h"
 #include "ScintillaComponent/SmartHighlighter.h"
-#include "ScintillaComponent/xmlMatchedTagsHighlighter.h"
 
 #include "localization.h"
 #include "MenuCmdID.h"
@@ -57,7 +56,24 @@ BOOL Notepad_plus::notify(SCNotification *notification)
 				prevWasEdit = true;
 				_linkTriggered = true;
 				_isDocModifing = true;
-				::InvalidateRect(notifyView->getHSelf(), NULL, TRUE);
+
+				// Scintilla repaints the text it changed; the lines below only move if lines were added or removed
+				if (isFromPrimary || isFromSecondary)
+				{
+					int line = int(notifyView->execute(SCI_LINEFROMPOSITION, notification->position));
+					notifyView->invalidateLines(line, notification->linesAdded?-1:line);
+				}
+
+				// Edits can come from any view, including the invisible ones, so the buffer is found from the document
+				HWND hwndFrom = notification->nmhdr.hwndFrom;
+				Document doc = ::SendMessage(hwndFrom, SCI_GETDOCPOINTER, 0, 0);
+				BufferID id = MainFileManager->getBufferFromDocument(doc);
+				if (id != BUFFER_INVALID)
+				{
+					bool isInsertion = (notification->modificationType & SC_MOD_INSERTTEXT) != 0;
+					int docLen = int(::SendMessage(hwndFrom, SCI_GETLENGTH, 0, 0));
+					MainFileManager->getBufferByID(id)->getXmlTagIndex().textModified(notification->position, notification->length, isInsertion, docLen);
+				}
 			}
 
 			if (notification->modificationType & SC_MOD_CHANGEFOLD)
@@ -563,24 +579,28 @@ BOOL Notepad_plus::notify(SCNotification *notification)
 			if (notification->nmhdr.hwndFrom != _pEditView->getHSelf())
 				break;
 
+			// Only what depends on the caret neighbourhood is done right away,
+			// tag matching and smart highlighting wait for the caret to stop moving
 			braceMatch();
 
 			NppGUI & nppGui = nppParam->getNppGUI();
+			int deferredStages = 0;
 
 			if (nppGui._enableTagsMatchHilite)
-			{
-				XmlMatchedTagsHighlighter xmlTagMatchHiliter(_pEditView);
-				xmlTagMatchHiliter.tagMatch(nppGui._enableTagAttrsHilite);
-			}
+				deferredStages |= DeferredTagMatch;
 
 			if (nppGui._enableSmartHilite)
 			{
 				if (nppGui._disableSmartHiliteTmp)
 					nppGui._disableSmartHiliteTmp = false;
 				else
-					_smartHighlighter->highlightView(notifyView);
+					deferredStages |= DeferredSmartHilite;
 			}
 
+			if (notifyView->getCurrentBuffer()->getHugeFileView())
+				deferredStages |= DeferredFileWindow;
+			scheduleUIUpdate(deferredStages, notifyView);
+
 			updateStatusBar();
 			AutoCompletion * autoC = isFromPrimary?_autoCompleteMain:_autoCompleteSub;
 			autoC->update(0);
@@ -592,6 +612,10 @@ BOOL Notepad_plus::notify(SCNotification *notification)
 			const NppGUI & nppGUI = (NppParameters::getInstance())->getNppGUI();
 			if (nppGUI._enableSmartHilite && _smartHighlighter)
 				_smartHighlighter->highlightView(notifyView);
+
+			// Scrolling does not move the caret, so there may be no SCN_UPDATEUI to do it
+			if (notifyView == _pEditView && notifyView->getCurrentBuffer()->getHugeFileView())
+				scheduleUIUpdate(_deferredUIUpdate._stages | DeferredFileWindow, notifyView);
 			break;
 		}
 
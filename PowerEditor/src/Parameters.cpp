@@ -187,6 +187,7 @@ WinMenuKeyDefinition winKeyDefs[] = {
 	{VK_NULL,	IDM_VIEW_CLONE_TO_ANOTHER_VIEW,		false, false, false, NULL},
 	{VK_NULL,	IDM_VIEW_SYNSCROLLV,				false, false, false, NULL},
 	{VK_NULL,	IDM_VIEW_SYNSCROLLH,				false, false, false, NULL},
+	{VK_NULL,	IDM_VIEW_MONITORING,				false, false, false, NULL},
 	{VK_F8,		IDM_VIEW_SWITCHTO_OTHER_VIEW,		false, false, false, NULL},
 
 	{VK_NULL, 	IDM_FORMAT_TODOS,					false, false, false, NULL},
@@ -699,6 +700,8 @@ bool NppParameters::reloadLang()
 
 bool NppParameters::load()
 {
+	profile_scope("NppParameters::load");
+	profile_phases("user path");
 	L_END = L_EXTERNAL;
 	bool isAllLaoded = true;
 	assert(getNbLang() == 0);
@@ -748,6 +751,7 @@ bool NppParameters::load()
 	//---------------------------------------//
 	// langs.xml : for every user statically //
 	//---------------------------------------//
+	profile_next_phase("langs.xml");
 	generic_string langs_xml_path(_nppPath);
 	PathAppend(langs_xml_path, TEXT("langs.xml"));
 
@@ -785,6 +789,7 @@ bool NppParameters::load()
 	//---------------------------//
 	// config.xml : for per user //
 	//---------------------------//
+	profile_next_phase("config.xml");
 	generic_string configPath(_userPath);
 	PathAppend(configPath, TEXT("config.xml"));
 
@@ -827,6 +832,7 @@ bool NppParameters::load()
 	//----------------------------//
 	// stylers.xml : for per user //
 	//----------------------------//
+	profile_next_phase("stylers.xml");
 
 	_stylerPath = _userPath;
 	PathAppend(_stylerPath, TEXT("stylers.xml"));
@@ -864,6 +870,7 @@ bool NppParameters::load()
 	//-----------------------------------//
 	// userDefineLang.xml : for per user //
 	//-----------------------------------//
+	profile_next_phase("userDefineLang.xml");
 	_userDefineLangPath = _userPath;
 	PathAppend(_userDefineLangPath, TEXT("userDefineLang.xml"));
 
@@ -883,6 +890,7 @@ bool NppParameters::load()
 	// In case of absence of user's nativeLang.xml, //
 	// We'll look in the Notepad++ Dir.             //
 	//----------------------------------------------//
+	profile_next_phase("nativeLang.xml");
 	generic_string nativeLangPath(_userPath);
 	PathAppend(nativeLangPath, TEXT("nativeLang.xml"));
 
@@ -907,6 +915,7 @@ bool NppParameters::load()
 	//---------------------------------//
 	// toolbarIcons.xml : for per user //
 	//---------------------------------//
+	profile_next_phase("toolbarIcons.xml");
 	generic_string toolbarIconsPath(_userPath);
 	PathAppend(toolbarIconsPath, TEXT("toolbarIcons.xml"));
 
@@ -922,6 +931,7 @@ bool NppParameters::load()
 	//------------------------------//
 	// shortcuts.xml : for per user //
 	//------------------------------//
+	profile_next_phase("shortcuts.xml");
 	_shortcutsPath = _userPath;
 	PathAppend(_shortcutsPath, TEXT("shortcuts.xml"));
 
@@ -955,6 +965,7 @@ bool NppParameters::load()
 	//---------------------------------//
 	// contextMenu.xml : for per user //
 	//---------------------------------//
+	profile_next_phase("contextMenu.xml");
 	_contextMenuPath = _userPath;
 	PathAppend(_contextMenuPath, TEXT("contextMenu.xml"));
 
@@ -980,6 +991,7 @@ bool NppParameters::load()
 	//----------------------------//
 	// session.xml : for per user //
 	//----------------------------//
+	profile_next_phase("session.xml");
 	_sessionPath = _userPath;
 	PathAppend(_sessionPath, TEXT("session.xml"));
 
@@ -1006,6 +1018,7 @@ bool NppParameters::load()
     //------------------------------//
 	// blacklist.xml : for per user //
 	//------------------------------//
+	profile_next_phase("blacklist.xml");
 	_blacklistPath = _userPath;
 	PathAppend(_blacklistPath, TEXT("blacklist.xml"));
 
@@ -2387,6 +2400,7 @@ bool UserLangContainer::feedUserStyles(TiXmlNode *node)
 
 bool NppParameters::feedStylerArray(TiXmlNode *node)
 {
+	profile_scope("NppParameters::feedStylerArray");
     TiXmlNode *styleRoot = node->FirstChildElement(TEXT("LexerStyles"));
     if (!styleRoot) return false;
 
@@ -2544,6 +2558,7 @@ LangType NppParameters::getLangIDFromStr(const TCHAR *langName)
 
 void NppParameters::feedKeyWordsParameters(TiXmlNode *node)
 {
+	profile_scope("NppParameters::feedKeyWordsParameters");
 
 	TiXmlNode *langRoot = node->FirstChildElement(TEXT("Languages"));
 	if (!langRoot) return;
@@ -2588,6 +2603,7 @@ void NppParameters::feedKeyWordsParameters(TiXmlNode *node)
 
 void NppParameters::feedGUIParameters(TiXmlNode *node)
 {
+	profile_scope("NppParameters::feedGUIParameters");
 	TiXmlNode *GUIRoot = node->FirstChildElement(TEXT("GUIConfigs"));
 	if (!GUIRoot) return;
 
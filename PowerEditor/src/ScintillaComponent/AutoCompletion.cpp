@@ -77,6 +77,7 @@ bool AutoCompletion::showAutoComplete() {
 		offset--;
 
 	}
+	delete [] lineBuffer;
 	int startWordPos = curPos-nrChars;
 
 	_pEditView->execute(SCI_AUTOCSETSEPARATOR, WPARAM('\n'));
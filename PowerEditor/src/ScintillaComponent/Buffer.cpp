@@ -22,6 +22,9 @@
 #include "ScintillaComponent/ScintillaEditView.h"
 #include "Parameters.h"
 #include "Utf8_16.h"
+#include "ScintillaComponent/FileSaver.h"
+#include "ScintillaComponent/FileWatcher.h"
+#include "resource.h"
 
 #include "MISC/Common/npp_session.h"
 
@@ -37,12 +40,28 @@ const int blockSize = 128 * 1024 + 4;
 const int CR = 0x0D;
 const int LF = 0x0A;
 
+// What Scintilla is asked to allocate to load a file whole.
+// size/6 is the normal room Scintilla keeps for editing, but here we limit it to 1MiB when loading (maybe we want to load big files without editing them too much)
+static unsigned __int64 getLoadingBufferSize(unsigned __int64 fileSize)
+{
+	return fileSize + min(1<<20,fileSize/6);
+}
+
+// Tells why a file which has just been opened as a HugeFileView cannot be edited
+static void showHugeFileNotice(const TCHAR * fullpath)
+{
+	generic_string msg = fullpath;
+	msg += TEXT("\r\rThis file is too big to be loaded whole. It is opened read only, and only the part of it you are looking at is loaded.");
+	::MessageBox(NULL, msg.c_str(), TEXT("Huge file"), MB_OK|MB_APPLMODAL);
+}
+
 Buffer::Buffer( FileManager * pManager, BufferID id, Document doc, DocFileStatus type, const TCHAR *fileName ) :
 _pManager(pManager), _canNotify(false), _references(0), _id(id),
 _doc(doc), _lang(L_TEXT), _isDirty(false), _encoding(-1),
 _isUserReadOnly(false), _needLexer(false), //new buffers do not need lexing, Scintilla takes care of that
 _currentStatus(type), _timeStamp(0), _isFileReadOnly(false),
-_fileName(NULL), _needReloading(false), _recentTag(-1)
+_fileName(NULL), _needReloading(false), _isFileChanged(false), _isFollowing(false),
+_followedFileSize(-1), _appendPosition(0), _pHugeFile(NULL), _recentTag(-1)
 {
 	NppParameters *pNppParamInst = NppParameters::getInstance();
 	const NewDocDefaultSettings & ndds = (pNppParamInst->getNppGUI()).getNewDocDefaultSettings();
@@ -57,6 +76,11 @@ _fileName(NULL), _needReloading(false), _recentTag(-1)
 	_canNotify = true;
 }
 
+Buffer::~Buffer()
+{
+	delete _pHugeFile;
+}
+
 
 void Buffer::setLangType(LangType lang, const TCHAR * userLangName)
 {
@@ -95,8 +119,10 @@ void Buffer::setFileName(const TCHAR *fn, LangType defaultLang)
 		doNotify(BufferChangeTimestamp);
 		return;
 	}
+	generic_string oldFullPathName = _fullPathName;
 	_fullPathName = fn;
 	_fileName = PathFindFileName(_fullPathName.c_str());
+	_pManager->bufferRenamed(this, oldFullPathName);
 
 	// for _lang
 	LangType newLang = defaultLang;
@@ -177,7 +203,11 @@ bool Buffer::checkFileState() {	//returns true if the status has been changed (i
 			mask |= BufferChangeReadonly;
 		}
 
-		if (_timeStamp != buf.st_mtime) {
+		if (_isFollowing && followFile())
+		{
+			//the text caught up with the file, followFile has notified
+		}
+		else if (_timeStamp != buf.st_mtime) {
 			_timeStamp = buf.st_mtime;
 			mask |= BufferChangeTimestamp;
 			_currentStatus = DOC_MODIFIED;
@@ -193,6 +223,30 @@ bool Buffer::checkFileState() {	//returns true if the status has been changed (i
 	return false;
 }
 
+// Returns false if the file has to be reloaded: it was truncated or replaced, the text was modified, or
+// it is in an encoding that cannot be decoded from the middle of the file. Huge files are not followed,
+// their document does not end where the file did.
+bool Buffer::followFile()
+{
+	if (!_isFollowing || _isDirty || _pHugeFile || _currentStatus == DOC_UNNAMED || _currentStatus == DOC_DELETED)
+		return false;
+
+	struct _stat buf;
+	if (generic_stat(_fullPathName.c_str(), &buf))
+		return false;
+
+	//The size is checked too, the time stamp only changes once a second
+	if (buf.st_mtime == _timeStamp && buf.st_size == _followedFileSize)
+		return true;
+
+	if (!_pManager->appendFileTail(this))
+		return false;
+
+	_timeStamp = buf.st_mtime;
+	doNotify(BufferChangeTimestamp | BufferChangeAppended);
+	return true;
+}
+
 int Buffer::getFileLength()
 {
 	if (_currentStatus == DOC_UNNAMED)
@@ -412,6 +466,7 @@ FileManager::~FileManager()
 	{
 		delete (*it);
 	}
+	delete _pWatcher;
 }
 
 void FileManager::init(Notepad_plus * pNotepadPlus, ScintillaEditView * pscratchTilla)
@@ -421,12 +476,16 @@ void FileManager::init(Notepad_plus * pNotepadPlus, ScintillaEditView * pscratch
 	_pscratchTilla->execute(SCI_SETUNDOCOLLECTION, false);	//dont store any undo information
 	_scratchDocDefault = (Document)_pscratchTilla->execute(SCI_GETDOCPOINTER);
 	_pscratchTilla->execute(SCI_ADDREFDOCUMENT, 0, _scratchDocDefault);
+	_pWatcher = FileWatcher::create(_pscratchTilla->getHParent(), NPPM_INTERNAL_FILESCHANGED);
 }
 
 // Strange things are happening to the loop index variable, but I'm not touching this parsing code with a 10 foot pole.
 //lint -e850
 void FileManager::checkFilesystemChanges()
 {
+	// A watch is not told when its directory, or one above it, is renamed or moved away:
+	// the buffers of a watched directory which is gone are polled as well
+	std::map<generic_string, bool> directoryExists;
 	for(int i = int(_nrBufs -1) ; i >= 0 ; i--)
     {
         if (i >= int(_nrBufs))
@@ -436,17 +495,98 @@ void FileManager::checkFilesystemChanges()
 
             i = _nrBufs - 1;
         }
-        _buffers[i]->checkFileState();	//something has changed. Triggers update automatically
+		Buffer * buf = _buffers[i];
+		bool mustCheck = buf->_isFileChanged || !isWatched(buf);
+		if (!mustCheck)
+		{
+			generic_string directory = buf->getFullPathName();
+			PathRemoveFileSpec(directory);
+			std::map<generic_string, bool>::const_iterator it = directoryExists.find(directory);
+			if (it == directoryExists.end())
+				it = directoryExists.insert(std::make_pair(directory, PathFileExists(directory.c_str()) != FALSE)).first;
+			mustCheck = !it->second;
+		}
+		if (mustCheck)
+		{
+			buf->_isFileChanged = false;
+			buf->checkFileState();	//something has changed. Triggers update automatically
+		}
 	}
 }
 //lint +e850
 
-int FileManager::getBufferIndexByID(BufferID id) {
-	for(size_t i = 0; i < _nrBufs; i++) {
-		if (_buffers[i]->_id == id)
-			return (int)i;
+void FileManager::followFileChanges()
+{
+	for (size_t i = 0; i < _buffers.size(); i++)
+	{
+		Buffer * buf = _buffers[i];
+		if (buf->_isFileChanged && buf->_isFollowing && buf->followFile())
+			buf->_isFileChanged = false;
+	}
+}
+
+void FileManager::takeFileChanges()
+{
+	if (!_pWatcher)
+		return;
+
+	DirectoryChangesMap changes;
+	_pWatcher->takeChanges(changes);
+	for (DirectoryChangesMap::const_iterator it = changes.begin(); it != changes.end(); ++it)
+	{
+		const DirectoryChanges & dirChanges = it->second;
+		if (dirChanges._allFiles)
+		{
+			for (size_t i = 0; i < _buffers.size(); i++)
+			{
+				generic_string directory = _buffers[i]->getFullPathName();
+				PathRemoveFileSpec(directory);
+				if (FileWatcher::directoryKey(directory.c_str()) == it->first)
+					_buffers[i]->_isFileChanged = true;
+			}
+			continue;
+		}
+
+		generic_string prefix = it->first;
+		if (!prefix.empty() && prefix[prefix.length() - 1] != TEXT('\\'))
+			prefix += TEXT('\\');
+		for (size_t i = 0; i < dirChanges._fileNames.size(); i++)
+		{
+			//names from the watcher are lower case already, like the keys of the index
+			std::pair<BufferNameIndex::const_iterator, BufferNameIndex::const_iterator> range = _buffersByName.equal_range(prefix + dirChanges._fileNames[i]);
+			for (BufferNameIndex::const_iterator itBuf = range.first; itBuf != range.second; ++itBuf)
+				itBuf->second->_isFileChanged = true;
+		}
 	}
-	return -1;
+}
+
+// Untitled buffers have a relative name, and nothing to watch
+void FileManager::watchDirectoryOf(const TCHAR * fullpath, bool watch)
+{
+	if (!_pWatcher || PathIsRelative(fullpath))
+		return;
+	generic_string directory = fullpath;
+	PathRemoveFileSpec(directory);
+	if (watch)
+		_pWatcher->addDirectory(directory.c_str());
+	else
+		_pWatcher->removeDirectory(directory.c_str());
+}
+
+bool FileManager::isWatched(const Buffer * buf) const
+{
+	if (!_pWatcher || PathIsRelative(buf->getFullPathName()))
+		return false;
+	generic_string directory = buf->getFullPathName();
+	PathRemoveFileSpec(directory);
+	return _pWatcher->isWatching(directory.c_str());
+}
+
+int FileManager::getBufferIndexByID(BufferID id) {
+	std::map<BufferID, size_t>::const_iterator it = _bufferIndices.find(id);
+	if (it == _bufferIndices.end())
+		return -1;
+	return (int)it->second;
 }
 
 Buffer * FileManager::getBufferByIndex(int index) {
@@ -470,9 +610,8 @@ void FileManager::closeBuffer(BufferID id, ScintillaEditView * identifier) {
 
 	if (!refs) {	//buffer can be deallocated
 		_pscratchTilla->execute(SCI_RELEASEDOCUMENT, 0, buf->_doc);	//release for FileManager, Document is now gone
-		_buffers.erase(_buffers.begin() + index);
+		removeBuffer(index);
 		delete buf;
-		_nrBufs--;
 	}
 }
 
@@ -491,31 +630,55 @@ BufferID FileManager::loadFile(const TCHAR * filename, Document doc, int encodin
 	Utf8_16_Read UnicodeConvertor;	//declare here so we can get information after loading is done
 
 	formatType format;
-	bool res = loadFileData(doc, fullpath, &UnicodeConvertor, L_TEXT, encoding, &format);
+	int eolFormat = -1;
+	UniMode um = uni8Bit;
+	bool res = false;
+	LoadedFileData prefetchedData;
+	HugeFileView * pHugeFile = openHugeFile(fullpath, encoding);
+	if (pHugeFile)
+	{
+		res = loadFileWindow(doc, pHugeFile, 0, L_TEXT, encoding);
+		eolFormat = pHugeFile->getFormat();
+		format = (eolFormat == -1)?WIN_FORMAT:(formatType)eolFormat;
+		um = pHugeFile->getUnicodeMode();
+		if (!res)
+		{
+			delete pHugeFile;
+			pHugeFile = NULL;
+		}
+	}
+	else if (_loaderPool.take(fullpath, encoding, prefetchedData))
+	{
+		res = loadPrefetchedData(doc, prefetchedData, L_TEXT);
+		encoding = prefetchedData._encoding;
+		eolFormat = prefetchedData._format;
+		format = (eolFormat == -1)?WIN_FORMAT:(formatType)eolFormat;
+		um = prefetchedData._unicodeMode;
+	}
+	else
+	{
+		res = loadFileData(doc, fullpath, &UnicodeConvertor, L_TEXT, encoding, &format);
+		if (UnicodeConvertor.getNewBuf())
+			eolFormat = getEOLFormatForm(UnicodeConvertor.getNewBuf());
+		um = UnicodeConvertor.getEncoding();
+	}
+
 	if (res)
 	{
 		Buffer * newBuf = new Buffer(this, _nextBufferID, doc, DOC_REGULAR, fullpath);
 		BufferID id = (BufferID) newBuf;
 		newBuf->_id = id;
-		_buffers.push_back(newBuf);
-		_nrBufs++;
+		newBuf->_pHugeFile = pHugeFile;
+		addBuffer(newBuf);
+		if (pHugeFile)
+			showHugeFileNotice(fullpath);
 		Buffer * buf = _buffers.at(_nrBufs - 1);
 
 		if (encoding == -1)
 		{
 			// 3 formats : WIN_FORMAT, UNIX_FORMAT and MAC_FORMAT
-			if (UnicodeConvertor.getNewBuf())
-			{
-				int format = getEOLFormatForm(UnicodeConvertor.getNewBuf());
-				buf->setFormat(format == -1?WIN_FORMAT:(formatType)format);
-
-			}
-			else
-			{
-				buf->setFormat(WIN_FORMAT);
-			}
+			buf->setFormat(eolFormat == -1?WIN_FORMAT:(formatType)eolFormat);
 
-			UniMode um = UnicodeConvertor.getEncoding();
 			if (um == uni7Bit)
 			{
 				NppParameters *pNppParamInst = NppParameters::getInstance();
@@ -548,6 +711,16 @@ BufferID FileManager::loadFile(const TCHAR * filename, Document doc, int encodin
 	}
 }
 
+void FileManager::prefetchFile(const TCHAR * fullpath, int encoding)
+{
+	_loaderPool.queue(fullpath, encoding);
+}
+
+void FileManager::discardPrefetchedFiles()
+{
+	_loaderPool.discardAll();
+}
+
 bool FileManager::reloadBuffer(BufferID id)
 {
 	Buffer * buf = getBufferByID(id);
@@ -556,11 +729,32 @@ bool FileManager::reloadBuffer(BufferID id)
 	buf->_canNotify = false;	//disable notify during file load, we dont want dirty to be triggered
 	int encoding = buf->getEncoding();
 	formatType format;
-	bool res = loadFileData(doc, buf->getFullPathName(), &UnicodeConvertor, buf->getLangType(), encoding, &format);
+
+	// The file may have grown past the limit or shrunk under it since it was opened
+	bool wasHugeFile = (buf->_pHugeFile != NULL);
+	delete buf->_pHugeFile;
+	buf->_pHugeFile = openHugeFile(buf->getFullPathName(), encoding);
+
+	bool res = false;
+	if (buf->_pHugeFile)
+		res = loadFileWindow(doc, buf->_pHugeFile, 0, buf->getLangType(), encoding);
+	else
+		res = loadFileData(doc, buf->getFullPathName(), &UnicodeConvertor, buf->getLangType(), encoding, &format);
 	buf->_canNotify = true;
+	if (wasHugeFile || buf->_pHugeFile)
+		buf->doNotify(BufferChangeReadonly);
+	if (res && !wasHugeFile && buf->_pHugeFile)
+		showHugeFileNotice(buf->getFullPathName());
 	if (res)
 	{
-		if (encoding == -1)
+		if (buf->_pHugeFile)
+		{
+			int format = buf->_pHugeFile->getFormat();
+			buf->setFormat(format == -1?WIN_FORMAT:(formatType)format);
+			if (encoding == -1)
+				buf->setUnicodeMode(buf->_pHugeFile->getUnicodeMode());
+		}
+		else if (encoding == -1)
 		{
 			if (UnicodeConvertor.getNewBuf())
 			{
@@ -584,6 +778,70 @@ bool FileManager::reloadBuffer(BufferID id)
 	return res;
 }
 
+// Only the encodings whose bytes go unchanged into the document can be read from the middle of the file.
+// The end of the text has to be found where it was in the file, or the file was truncated or replaced (rotated logs).
+bool FileManager::appendFileTail(Buffer * buf)
+{
+	UniMode mode = buf->getUnicodeMode();
+	if (buf->getEncoding() != -1 || (mode != uni8Bit && mode != uni7Bit && mode != uniCookie && mode != uniUTF8))
+		return false;
+
+	FILE *fp = NULL;
+	generic_fopen(fp, buf->getFullPathName(), TEXT("rb"));
+	if (!fp)
+		return false;
+	_fseeki64(fp, 0, SEEK_END);
+	__int64 fileSize = _ftelli64(fp);
+
+	_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, buf->_doc);
+	int docLength = _pscratchTilla->getCurrentDocLen();
+	__int64 offset = docLength + (mode == uniUTF8 ? 3 : 0);	//the BOM is not in the document
+
+	bool hasGrown = (fileSize >= offset) && (fileSize - offset < INT_MAX - docLength);
+	if (hasGrown)
+	{
+		const int tailCheckLength = 256;
+		char tail[tailCheckLength];
+		int lenCheck = min(docLength, tailCheckLength);
+		const char *docTail = (const char *)_pscratchTilla->execute(SCI_GETRANGEPOINTER, docLength - lenCheck, lenCheck);
+		_fseeki64(fp, offset - lenCheck, SEEK_SET);
+		hasGrown = (fread(tail, 1, lenCheck, fp) == size_t(lenCheck)) && (memcmp(tail, docTail, lenCheck) == 0);
+	}
+
+	if (hasGrown)
+	{
+		bool ro = _pscratchTilla->execute(SCI_GETREADONLY) != 0;
+		if (ro)
+			_pscratchTilla->execute(SCI_SETREADONLY, false);
+		bool collectsUndo = _pscratchTilla->execute(SCI_GETUNDOCOLLECTION) != 0;
+		_pscratchTilla->execute(SCI_SETUNDOCOLLECTION, false);	//nothing to undo, and the buffer stays clean
+
+		// Up to the size seen above: what is written meanwhile is for the next time
+		const int blockSize = 64 * 1024;
+		char data[blockSize];
+		__int64 lenLeft = fileSize - offset;
+		while (lenLeft > 0)
+		{
+			size_t lenRead = fread(data, 1, size_t(min(lenLeft, __int64(blockSize))), fp);
+			if (lenRead == 0)
+				break;
+			// Only the new lines are styled, Scintilla restyles from where the text changed
+			_pscratchTilla->execute(SCI_APPENDTEXT, lenRead, (LPARAM)data);
+			lenLeft -= lenRead;
+		}
+
+		_pscratchTilla->execute(SCI_SETUNDOCOLLECTION, collectsUndo);
+		if (ro)
+			_pscratchTilla->execute(SCI_SETREADONLY, true);
+		buf->_appendPosition = docLength;
+		buf->_followedFileSize = fileSize - lenLeft;
+	}
+
+	fclose(fp);
+	_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, _scratchDocDefault);
+	return hasGrown;
+}
+
 bool FileManager::reloadBufferDeferred(BufferID id)
 {
 	Buffer * buf = getBufferByID(id);
@@ -614,8 +872,10 @@ bool FileManager::moveFile(BufferID id, const TCHAR * newFileName)
 	return true;
 }
 
-bool FileManager::saveBuffer(BufferID id, const TCHAR * filename, bool isCopy) {
+bool FileManager::saveBuffer(BufferID id, const TCHAR * filename, bool isCopy, SaveProgressHandler *pProgress) {
 	Buffer * buffer = getBufferByID(id);
+	if (buffer->_pHugeFile)	//the document only holds a window of the file
+		return false;
 	bool isHidden = false;
 	bool isSys = false;
 	DWORD attrib = 0;
@@ -643,63 +903,39 @@ bool FileManager::saveBuffer(BufferID id, const TCHAR * filename, bool isCopy) {
 	if (mode == uniCookie)
 		mode = uni8Bit;	//set the mode to ANSI to prevent converter from adding BOM and performing conversions, Scintilla's data can be copied directly
 
-	Utf8_16_Write UnicodeConvertor;
-	UnicodeConvertor.setEncoding(mode);
-
 	int encoding = buffer->getEncoding();
 
-	FILE *fp = UnicodeConvertor.fopen(fullpath, TEXT("wb"));
-	if (fp)
-	{
-		_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, buffer->_doc);	//generate new document
+	_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, buffer->_doc);	//generate new document
 
-		int lengthDoc = _pscratchTilla->getCurrentDocLen();
-		char* buf = (char*)_pscratchTilla->execute(SCI_GETCHARACTERPOINTER);	//to get characters directly from Scintilla buffer
-		if (encoding == -1) //no special encoding; can be handled directly by Utf8_16_Write
-		{
-			UnicodeConvertor.fwrite(buf, lengthDoc);
-		}
-		else
-		{
-			WcharMbcsConvertor *wmc = WcharMbcsConvertor::getInstance();
-			int grabSize;
-			for (int i = 0; i < lengthDoc; i += grabSize)
-			{
-				grabSize = lengthDoc - i;
-				if (grabSize > blockSize)
-					grabSize = blockSize;
-
-				int newDataLen = 0;
-				int incompleteMultibyteChar = 0;
-				const char *newData = wmc->encode(SC_CP_UTF8, encoding, buf+i, grabSize, &newDataLen, &incompleteMultibyteChar);
-				grabSize -= incompleteMultibyteChar;
-				UnicodeConvertor.fwrite(newData, newDataLen);
-			}
-		}
-		UnicodeConvertor.fclose();
+	// Both sides of the gap are read where they are, asking for the whole text at once would move it
+	int lengthDoc = _pscratchTilla->getCurrentDocLen();
+	int gapPosition = _pscratchTilla->execute(SCI_GETGAPPOSITION);
+	const char *part1 = (const char *)_pscratchTilla->execute(SCI_GETRANGEPOINTER, 0, gapPosition);
+	const char *part2 = (const char *)_pscratchTilla->execute(SCI_GETRANGEPOINTER, gapPosition, lengthDoc - gapPosition);
 
-		if (isHidden)
-			::SetFileAttributes(fullpath, attrib | FILE_ATTRIBUTE_HIDDEN);
+	FileSaver saver(fullpath, mode, encoding);
+	bool isSaved = saver.save(part1, gapPosition, part2, lengthDoc - gapPosition, pProgress);
 
-		if (isSys)
-			::SetFileAttributes(fullpath, attrib | FILE_ATTRIBUTE_SYSTEM);
+	if (isHidden)
+		::SetFileAttributes(fullpath, attrib | FILE_ATTRIBUTE_HIDDEN);
 
-		if (isCopy) {
-			_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, _scratchDocDefault);
-			return true;	//all done
-		}
+	if (isSys)
+		::SetFileAttributes(fullpath, attrib | FILE_ATTRIBUTE_SYSTEM);
 
-		buffer->setFileName(fullpath);
-		buffer->setDirty(false);
-		buffer->setStatus(DOC_REGULAR);
-		buffer->checkFileState();
-		_pscratchTilla->execute(SCI_SETSAVEPOINT);
-		//_pscratchTilla->markSavedLines();
+	if (!isSaved || isCopy) {
 		_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, _scratchDocDefault);
-
-		return true;
+		return isSaved;	//all done
 	}
-	return false;
+
+	buffer->setFileName(fullpath);
+	buffer->setDirty(false);
+	buffer->setStatus(DOC_REGULAR);
+	buffer->checkFileState();
+	_pscratchTilla->execute(SCI_SETSAVEPOINT);
+	//_pscratchTilla->markSavedLines();
+	_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, _scratchDocDefault);
+
+	return true;
 }
 
 BufferID FileManager::newEmptyDocument()
@@ -714,8 +950,7 @@ BufferID FileManager::newEmptyDocument()
 	Buffer * newBuf = new Buffer(this, _nextBufferID, doc, DOC_UNNAMED, newTitle.c_str());
 	BufferID id = (BufferID)newBuf;
 	newBuf->_id = id;
-	_buffers.push_back(newBuf);
-	_nrBufs++;
+	addBuffer(newBuf);
 	_nextBufferID++;
 	return id;
 }
@@ -732,8 +967,7 @@ BufferID FileManager::bufferFromDocument(Document doc, bool dontIncrease, bool d
 	Buffer * newBuf = new Buffer(this, _nextBufferID, doc, DOC_UNNAMED, newTitle.c_str());
 	BufferID id = (BufferID)newBuf;
 	newBuf->_id = id;
-	_buffers.push_back(newBuf);
-	_nrBufs++;
+	addBuffer(newBuf);
 	_nextBufferID;
 	if (!dontIncrease)
 		_nextBufferID++;
@@ -753,8 +987,7 @@ bool FileManager::loadFileData(Document doc, const TCHAR * filename, Utf8_16_Rea
 	_fseeki64 (fp , 0 , SEEK_END);
 	unsigned __int64 fileSize =_ftelli64(fp);
 	rewind(fp);
-	// size/6 is the normal room Scintilla keeps for editing, but here we limit it to 1MiB when loading (maybe we want to load big files without editing them too much)
-	unsigned __int64 bufferSizeRequested = fileSize + min(1<<20,fileSize/6);
+	unsigned __int64 bufferSizeRequested = getLoadingBufferSize(fileSize);
 	// As a 32bit application, we cannot allocate 2 buffer of more than INT_MAX size (it takes the whole address space)
 	if(bufferSizeRequested > INT_MAX)
 	{
@@ -763,38 +996,7 @@ bool FileManager::loadFileData(Document doc, const TCHAR * filename, Utf8_16_Rea
 		return false;
 	}
 
-	//Setup scratchtilla for new filedata
-	_pscratchTilla->execute(SCI_SETSTATUS, SC_STATUS_OK); // reset error status
-	_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, doc);
-	bool ro = _pscratchTilla->execute(SCI_GETREADONLY) != 0;
-	if (ro)
-	{
-		_pscratchTilla->execute(SCI_SETREADONLY, false);
-	}
-	_pscratchTilla->execute(SCI_CLEARALL);
-#ifdef UNICODE
-	WcharMbcsConvertor *wmc = WcharMbcsConvertor::getInstance();
-#endif
-	if (language < L_EXTERNAL)
-	{
-		_pscratchTilla->execute(SCI_SETLEXER, ScintillaEditView::langNames[language].lexerID);
-	}
-	else
-	{
-		int id = language - L_EXTERNAL;
-		TCHAR * name = NppParameters::getInstance()->getELCFromIndex(id)._name;
-#ifdef UNICODE
-		const char *pName = wmc->wchar2char(name, CP_ACP);
-#else
-		const char *pName = name;
-#endif
-		_pscratchTilla->execute(SCI_SETLEXERLANGUAGE, 0, (LPARAM)pName);
-	}
-
-	if (encoding != -1)
-	{
-		_pscratchTilla->execute(SCI_SETCODEPAGE, SC_CP_UTF8);
-	}
+	bool ro = prepareScratchForLoading(doc, language, encoding);
 
 	bool success = true;
 	int format = -1;
@@ -860,7 +1062,7 @@ bool FileManager::loadFileData(Document doc, const TCHAR * filename, Utf8_16_Rea
 			if(incompleteMultibyteChar != 0)
 			{
 				// copy bytes to next buffer
-				memcpy(data, data+blockSize-incompleteMultibyteChar, incompleteMultibyteChar);
+				memcpy(data, data+lenFile-incompleteMultibyteChar, incompleteMultibyteChar);
 			}
 
 		} while (lenFile > 0);
@@ -875,32 +1077,231 @@ bool FileManager::loadFileData(Document doc, const TCHAR * filename, Utf8_16_Rea
 	{
 		*pFormat = (format == -1)?WIN_FORMAT:(formatType)format;
 	}
+	releaseScratchAfterLoading(ro);
+	return success;
+}
+
+bool FileManager::loadPrefetchedData(Document doc, const LoadedFileData & loadedData, LangType language)
+{
+	// Same limit as loadFileData: room for editing, capped to 1MiB
+	size_t lenText = loadedData._text.size();
+	size_t bufferSizeRequested = lenText + min(size_t(1<<20), lenText/6);
+
+	bool ro = prepareScratchForLoading(doc, language, loadedData._encoding);
+
+	bool success = true;
+	__try
+	{
+		_pscratchTilla->execute(SCI_ALLOCATE, WPARAM(bufferSizeRequested));
+		if(_pscratchTilla->execute(SCI_GETSTATUS) != SC_STATUS_OK)
+		{
+			throw;
+		}
+
+		// The text is already decoded, a single append does it
+		_pscratchTilla->execute(SCI_APPENDTEXT, lenText, (LPARAM)loadedData._text.c_str());
+		if(_pscratchTilla->execute(SCI_GETSTATUS) != SC_STATUS_OK)
+		{
+			throw;
+		}
+	} __except(EXCEPTION_EXECUTE_HANDLER) {
+		::MessageBox(NULL, TEXT("File is too big to be opened by Notepad++"), TEXT("File open problem"), MB_OK|MB_APPLMODAL);
+		success = false;
+	}
+
+	releaseScratchAfterLoading(ro);
+	return success;
+}
+
+// Returns NULL if the file is to be loaded whole: loadFileData can load it, or it cannot be shown a window at a time
+HugeFileView * FileManager::openHugeFile(const TCHAR * fullpath, int encoding)
+{
+	if (encoding != -1 && encoding != SC_CP_UTF8)	//the other encodings are converted while loading
+		return NULL;
+
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!::GetFileAttributesEx(fullpath, GetFileExInfoStandard, &attributes))
+		return NULL;
+	unsigned __int64 fileSize = (((unsigned __int64)attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	if (getLoadingBufferSize(fileSize) <= INT_MAX)
+		return NULL;
+
+	HugeFileView * pHugeFile = new HugeFileView(fullpath);
+	if (!pHugeFile->open())
+	{
+		delete pHugeFile;
+		return NULL;
+	}
+	return pHugeFile;
+}
+
+// Replaces the text of doc by the window of the file around position
+bool FileManager::loadFileWindow(Document doc, HugeFileView * pHugeFile, __int64 position, LangType language, int encoding)
+{
+	std::string text;
+	if (!pHugeFile->readWindow(position, text))
+		return false;
+
+	bool ro = prepareScratchForLoading(doc, language, encoding);
+	_pscratchTilla->execute(SCI_APPENDTEXT, text.length(), (LPARAM)text.c_str());
+	releaseScratchAfterLoading(ro);
+	return true;
+}
+
+bool FileManager::moveFileWindow(Buffer * buf, __int64 position)
+{
+	if (!buf->_pHugeFile)
+		return false;
+	return loadFileWindow(buf->_doc, buf->_pHugeFile, position, buf->getLangType(), -1);
+}
+
+// Returns true if the document was read only (it is temporarily made writable)
+bool FileManager::prepareScratchForLoading(Document doc, LangType language, int encoding)
+{
+	//Setup scratchtilla for new filedata
+	_pscratchTilla->execute(SCI_SETSTATUS, SC_STATUS_OK); // reset error status
+	_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, doc);
+	bool ro = _pscratchTilla->execute(SCI_GETREADONLY) != 0;
+	if (ro)
+	{
+		_pscratchTilla->execute(SCI_SETREADONLY, false);
+	}
+	_pscratchTilla->execute(SCI_CLEARALL);
+#ifdef UNICODE
+	WcharMbcsConvertor *wmc = WcharMbcsConvertor::getInstance();
+#endif
+	if (language < L_EXTERNAL)
+	{
+		_pscratchTilla->execute(SCI_SETLEXER, ScintillaEditView::langNames[language].lexerID);
+	}
+	else
+	{
+		int id = language - L_EXTERNAL;
+		TCHAR * name = NppParameters::getInstance()->getELCFromIndex(id)._name;
+#ifdef UNICODE
+		const char *pName = wmc->wchar2char(name, CP_ACP);
+#else
+		const char *pName = name;
+#endif
+		_pscratchTilla->execute(SCI_SETLEXERLANGUAGE, 0, (LPARAM)pName);
+	}
+
+	if (encoding != -1)
+	{
+		_pscratchTilla->execute(SCI_SETCODEPAGE, SC_CP_UTF8);
+	}
+
+	return ro;
+}
+
+void FileManager::releaseScratchAfterLoading(bool wasReadOnly)
+{
 	_pscratchTilla->execute(SCI_EMPTYUNDOBUFFER);
 	_pscratchTilla->execute(SCI_SETSAVEPOINT);
-	if (ro) {
+	if (wasReadOnly) {
 		_pscratchTilla->execute(SCI_SETREADONLY, true);
 	}
 	_pscratchTilla->execute(SCI_SETDOCPOINTER, 0, _scratchDocDefault);
-	return success;
 }
 
 BufferID FileManager::getBufferFromName(const TCHAR * name) {
-	TCHAR fullpath[MAX_PATH];
-	::GetFullPathName(name, MAX_PATH, fullpath, NULL);
-	::GetLongPathName(fullpath, fullpath, MAX_PATH);
-	for(size_t i = 0; i < _buffers.size(); i++) {
-		if (!lstrcmpi(name, _buffers.at(i)->getFullPathName()))
-			return _buffers.at(i)->getID();
+	Buffer * buf = findBufferByName(name);
+	if (!buf)
+	{
+		// A relative or short name is looked for again under the name a loaded file would have
+		TCHAR fullpath[MAX_PATH];
+		::GetFullPathName(name, MAX_PATH, fullpath, NULL);
+		// Only short names have a '~' and GetLongPathName has to go to the disk
+		if (generic_strchr(fullpath, '~'))
+			::GetLongPathName(fullpath, fullpath, MAX_PATH);
+		if (lstrcmpi(name, fullpath))
+			buf = findBufferByName(fullpath);
 	}
-	return BUFFER_INVALID;
+	return buf?buf->getID():BUFFER_INVALID;
 }
 
 BufferID FileManager::getBufferFromDocument(Document doc) {
-	for(size_t i = 0; i < _nrBufs; i++) {
-		if (_buffers[i]->_doc == doc)
-			return _buffers[i]->_id;
+	std::pair<BufferDocumentIndex::const_iterator, BufferDocumentIndex::const_iterator> range = _buffersByDocument.equal_range(doc);
+	Buffer * first = NULL;
+	for (BufferDocumentIndex::const_iterator it = range.first; it != range.second; ++it)
+	{
+		if (!first || _bufferIndices.find(it->second)->second < _bufferIndices.find(first)->second)
+			first = it->second;
+	}
+	return first?first->_id:BUFFER_INVALID;
+}
+
+Buffer * FileManager::findBufferByName(const TCHAR * fullpath) const {
+	std::pair<BufferNameIndex::const_iterator, BufferNameIndex::const_iterator> range = _buffersByName.equal_range(nameKey(fullpath));
+	Buffer * first = NULL;
+	for (BufferNameIndex::const_iterator it = range.first; it != range.second; ++it)
+	{
+		if (!first || _bufferIndices.find(it->second)->second < _bufferIndices.find(first)->second)
+			first = it->second;
+	}
+	return first;
+}
+
+// Names are compared without case, as lstrcmpi did
+generic_string FileManager::nameKey(const TCHAR * fullpath) {
+	generic_string key(fullpath);
+	if (!key.empty())
+		::CharLowerBuff(&key[0], DWORD(key.length()));
+	return key;
+}
+
+void FileManager::addBuffer(Buffer * buf) {
+	_bufferIndices[buf] = _buffers.size();
+	_buffers.push_back(buf);
+	_nrBufs++;
+	_buffersByName.insert(BufferNameIndex::value_type(nameKey(buf->getFullPathName()), buf));
+	_buffersByDocument.insert(BufferDocumentIndex::value_type(buf->_doc, buf));
+	watchDirectoryOf(buf->getFullPathName(), true);
+}
+
+void FileManager::removeBuffer(size_t index) {
+	Buffer * buf = _buffers[index];
+	std::pair<BufferNameIndex::iterator, BufferNameIndex::iterator> names = _buffersByName.equal_range(nameKey(buf->getFullPathName()));
+	for (BufferNameIndex::iterator it = names.first; it != names.second; ++it)
+	{
+		if (it->second == buf)
+		{
+			_buffersByName.erase(it);
+			break;
+		}
+	}
+	std::pair<BufferDocumentIndex::iterator, BufferDocumentIndex::iterator> docs = _buffersByDocument.equal_range(buf->_doc);
+	for (BufferDocumentIndex::iterator it = docs.first; it != docs.second; ++it)
+	{
+		if (it->second == buf)
+		{
+			_buffersByDocument.erase(it);
+			break;
+		}
+	}
+	watchDirectoryOf(buf->getFullPathName(), false);
+	_bufferIndices.erase(buf);
+	_buffers.erase(_buffers.begin() + index);
+	_nrBufs--;
+	for (size_t i = index; i < _buffers.size(); i++)
+		_bufferIndices[_buffers[i]] = i;
+}
+
+void FileManager::bufferRenamed(Buffer * buf, const generic_string & oldName) {
+	if (_bufferIndices.find(buf) == _bufferIndices.end())
+		return;	//not added yet, Buffer's constructor sets the first name
+	std::pair<BufferNameIndex::iterator, BufferNameIndex::iterator> names = _buffersByName.equal_range(nameKey(oldName.c_str()));
+	for (BufferNameIndex::iterator it = names.first; it != names.second; ++it)
+	{
+		if (it->second == buf)
+		{
+			_buffersByName.erase(it);
+			break;
+		}
 	}
-	return BUFFER_INVALID;
+	_buffersByName.insert(BufferNameIndex::value_type(nameKey(buf->getFullPathName()), buf));
+	watchDirectoryOf(buf->getFullPathName(), true);	//before the removal, a rename in the same directory keeps its watch
+	watchDirectoryOf(oldName.c_str(), false);
 }
 
 bool FileManager::createEmptyFile(const TCHAR * path) {
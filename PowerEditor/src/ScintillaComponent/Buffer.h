@@ -30,8 +30,22 @@
 #include "Parameters_def.h"
 #endif
 
+#ifndef SCINTILLACOMPONENT_FILELOADER_H
+#include "ScintillaComponent/FileLoader.h"
+#endif
+
+#ifndef SCINTILLACOMPONENT_XMLTAGINDEX_H
+#include "ScintillaComponent/XmlTagIndex.h"
+#endif
+
+#ifndef SCINTILLACOMPONENT_HUGEFILEVIEW_H
+#include "ScintillaComponent/HugeFileView.h"
+#endif
+
 struct Position;
 struct Lang;
+class SaveProgressHandler;
+class FileWatcher;
 class ScintillaEditView;
 class Notepad_plus;
 
@@ -57,7 +71,8 @@ enum BufferStatusInfo {
 	BufferChangeFilename	= 0x080,	//Filename was changed
 	BufferChangeRecentTag	= 0x100,	//Recent tag has changed
 	BufferChangeLexing		= 0x200,	//Document needs lexing
-	BufferChangeMask		= 0x3FF		//Mask: covers all changes
+	BufferChangeAppended	= 0x400,	//Text was appended from the file, in follow mode
+	BufferChangeMask		= 0x7FF		//Mask: covers all changes
 };
 
 struct HeaderLineState {
@@ -76,7 +91,12 @@ public:
 	void init(Notepad_plus * pNotepadPlus, ScintillaEditView * pscratchTilla);
 
 	//void activateBuffer(int index);
+	//Checks the buffers whose files the watcher saw change, the ones it cannot watch, and those whose directory is gone
 	void checkFilesystemChanges();
+	//Marks the buffers whose files changed since the last call, without checking them yet
+	void takeFileChanges();
+	//Appends to the followed buffers among the marked ones, without asking anything: can be done in the background
+	void followFileChanges();
 
 	int getNrBuffers() { return _nrBufs; };
 	int getBufferIndexByID(BufferID id);
@@ -84,12 +104,21 @@ public:
 	Buffer * getBufferByID(BufferID id) {return (Buffer*)id;}
 
 	void beNotifiedOfBufferChange(Buffer * theBuf, int mask);
+	void bufferRenamed(Buffer * buf, const generic_string & oldName);	//called by Buffer::setFileName
+	//Follow mode, called by Buffer: appends what was written after the end of the text. False if the file did not only grow
+	bool appendFileTail(Buffer * buf);
+	//Huge files: loads the window of the file around position in the document. False if buf is not a huge file
+	bool moveFileWindow(Buffer * buf, __int64 position);
 
 	void closeBuffer(BufferID, ScintillaEditView * identifer);		//called by Notepad++
 
 	void addBufferReference(BufferID id, ScintillaEditView * identifer);	//called by Scintilla etc indirectly
 
 	BufferID loadFile(const TCHAR * filename, Document doc = NULL, int encoding = -1);	//ID == BUFFER_INVALID on failure. If Doc == NULL, a new file is created, otherwise data is loaded in given document
+	//Start reading and decoding a file in the background. A later loadFile with the same full path and encoding
+	//only has to append the decoded text. Call discardPrefetchedFiles once the batch of loadFile calls is done
+	void prefetchFile(const TCHAR * fullpath, int encoding = -1);
+	void discardPrefetchedFiles();
 	BufferID newEmptyDocument();
 	//create Buffer from existing Scintilla, used from new Scintillas. If dontIncrease = true, then the new document number isnt increased afterwards.
 	//usefull for temporary but neccesary docs
@@ -101,7 +130,8 @@ public:
 
 	bool reloadBuffer(BufferID id);
 	bool reloadBufferDeferred(BufferID id);
-	bool saveBuffer(BufferID id, const TCHAR * filename, bool isCopy = false);
+	//With a progress handler, the file is written by a worker thread and the handler can cancel the save
+	bool saveBuffer(BufferID id, const TCHAR * filename, bool isCopy = false, SaveProgressHandler *pProgress = NULL);
 	bool deleteFile(BufferID id);
 	bool moveFile(BufferID id, const TCHAR * newFilename);
 
@@ -119,7 +149,7 @@ public:
 	int getEOLFormatForm(const char *data) const;
 
 private:
-	FileManager() : _nextNewNumber(1), _nextBufferID(0), _pNotepadPlus(NULL), _nrBufs(0), _pscratchTilla(NULL){};
+	FileManager() : _nextNewNumber(1), _nextBufferID(0), _pNotepadPlus(NULL), _nrBufs(0), _pscratchTilla(NULL), _pWatcher(NULL){};
 	~FileManager();
 	static FileManager *_pSelf;
 
@@ -133,7 +163,30 @@ private:
 	BufferID _nextBufferID;
 	size_t _nrBufs;
 
+	FileLoaderPool _loaderPool;
+	FileWatcher * _pWatcher;	//watches the directory of each buffer with an absolute path
+
+	// Indices of _buffers, kept in step with it by addBuffer, removeBuffer and bufferRenamed.
+	// Several buffers may share a name or a document, lookups return the first one of _buffers
+	typedef std::multimap<generic_string, Buffer *> BufferNameIndex;
+	typedef std::multimap<Document, Buffer *> BufferDocumentIndex;
+	BufferNameIndex _buffersByName;			//keyed on the case folded full path
+	BufferDocumentIndex _buffersByDocument;
+	std::map<BufferID, size_t> _bufferIndices;
+
+	void addBuffer(Buffer * buf);
+	void removeBuffer(size_t index);
+	Buffer * findBufferByName(const TCHAR * fullpath) const;
+	static generic_string nameKey(const TCHAR * fullpath);
+	void watchDirectoryOf(const TCHAR * fullpath, bool watch);
+	bool isWatched(const Buffer * buf) const;
+
 	bool loadFileData(Document doc, const TCHAR * filename, Utf8_16_Read * UnicodeConvertor, LangType language, int & encoding, formatType *pFormat = NULL);
+	bool loadPrefetchedData(Document doc, const LoadedFileData & loadedData, LangType language);
+	HugeFileView * openHugeFile(const TCHAR * fullpath, int encoding);
+	bool loadFileWindow(Document doc, HugeFileView * pHugeFile, __int64 position, LangType language, int encoding);
+	bool prepareScratchForLoading(Document doc, LangType language, int encoding);
+	void releaseScratchAfterLoading(bool wasReadOnly);
 };
 
 #define MainFileManager FileManager::getInstance()
@@ -150,6 +203,7 @@ public :
 	//The entire lifetime if the buffer, the Document has reference count of _atleast_ one
 	//Destructor makes sure its purged
 	Buffer(FileManager * pManager, BufferID id, Document doc, DocFileStatus type, const TCHAR *fileName);	//type must be either DOC_REGULAR or DOC_UNNAMED
+	~Buffer();
 
 	// this method 1. copies the file name
 	//             2. determinates the language from the ext of file name
@@ -177,14 +231,34 @@ public :
 
 	bool checkFileState();
 
+	//Follow mode (tail -f): as long as the file only grows, what was written is appended to the text instead of
+	//reloading the whole file
+	bool isFollowing() const {
+		return _isFollowing;
+	};
+
+	void setFollowing(bool follow) {
+		_isFollowing = follow;
+	};
+
+	//Start of the text appended last in follow mode
+	int getAppendPosition() const {
+		return _appendPosition;
+	};
+
     bool isDirty() const {
         return _isDirty;
     };
 
     bool isReadOnly() const {
-        return (_isUserReadOnly || _isFileReadOnly);
+        return (_isUserReadOnly || _isFileReadOnly || _pHugeFile != NULL);
     };
 
+	//Not NULL if the file is too big to be loaded: the document only holds a window of it, and cannot be edited
+	HugeFileView * getHugeFileView() const {
+		return _pHugeFile;
+	};
+
 	bool isUntitled() const {
 		return (_currentStatus == DOC_UNNAMED);
 	};
@@ -313,6 +387,11 @@ public :
 	generic_string getFileTime(fileTimeType ftt) const;
 
     Lang * getCurrentLang() const;
+
+	// Tags of the document, kept for XmlMatchedTagsHighlighter. Built on first use.
+	XmlTagIndex & getXmlTagIndex() {
+		return _xmlTagIndex;
+	};
 private :
 	FileManager * _pManager;
 	bool _canNotify;
@@ -344,11 +423,19 @@ private :
 	generic_string _fullPathName;
 	TCHAR * _fileName;	//points to filename part in _fullPathName
 	bool _needReloading;	//True if Buffer needs to be reloaded on activation
+	bool _isFileChanged;	//True if the FileWatcher saw the file change since the last checkFileState
+	bool _isFollowing;
+	__int64 _followedFileSize;	//size of the file when it was last appended, -1 if unknown
+	int _appendPosition;
+	HugeFileView * _pHugeFile;
+
+	XmlTagIndex _xmlTagIndex;
 
 	long _recentTag;
 	static long _recentTagCtr;
 
 	void updateTimeStamp();
+	bool followFile();
 
 	int indexOfReference(ScintillaEditView * identifier) const;
 
@@ -0,0 +1,323 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "precompiled_headers.h"
+#include "ScintillaComponent/FileLoader.h"
+
+#include "Utf8_16.h"
+
+// Loading is mostly bound by the disk, more threads than that would only fight for it.
+const int maxLoaderThreads = 4;
+
+// Same block size as FileManager::loadFileData, so that encoding detection sees the same data.
+const size_t loaderBlockSize = 128 * 1024;
+
+static int getEOLFormat(const char *data, size_t len)
+{
+	for (size_t i = 0 ; i < len ; i++)
+	{
+		if (data[i] == '\r')
+		{
+			if (i+1 < len && data[i+1] == '\n')
+				return int(WIN_FORMAT);
+			else
+				return int(MAC_FORMAT);
+		}
+		if (data[i] == '\n')
+			return int(UNIX_FORMAT);
+	}
+	return -1;
+}
+
+FileLoaderPool::FileLoaderPool() : _isStopping(false)
+{
+	::InitializeCriticalSection(&_lock);
+	_hJobQueued = ::CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+	_hJobDone = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+FileLoaderPool::~FileLoaderPool()
+{
+	stopWorkers();
+	discardAll();
+	::CloseHandle(_hJobQueued);
+	::CloseHandle(_hJobDone);
+	::DeleteCriticalSection(&_lock);
+}
+
+void FileLoaderPool::startWorkers()
+{
+	if (!_workers.empty())
+		return;
+
+	SYSTEM_INFO si;
+	::GetSystemInfo(&si);
+	int nbThreads = min(max(int(si.dwNumberOfProcessors), 1), maxLoaderThreads);
+	for (int i = 0 ; i < nbThreads ; i++)
+	{
+		HANDLE hThread = ::CreateThread(NULL, 0, workerProc, this, 0, NULL);
+		if (hThread)
+			_workers.push_back(hThread);
+	}
+}
+
+void FileLoaderPool::stopWorkers()
+{
+	if (_workers.empty())
+		return;
+
+	::EnterCriticalSection(&_lock);
+	_isStopping = true;
+	::LeaveCriticalSection(&_lock);
+
+	::ReleaseSemaphore(_hJobQueued, LONG(_workers.size()), NULL);
+	::WaitForMultipleObjects(DWORD(_workers.size()), &_workers[0], TRUE, INFINITE);
+	for (size_t i = 0 ; i < _workers.size() ; i++)
+		::CloseHandle(_workers[i]);
+	_workers.clear();
+}
+
+std::deque<FileLoaderPool::Job *>::iterator FileLoaderPool::findJob(const TCHAR *fullPath)
+{
+	for (std::deque<Job *>::iterator it = _jobs.begin(), end = _jobs.end(); it != end; ++it)
+	{
+		if ((*it)->_state != jobDiscarded && !lstrcmpi((*it)->_data._fullPath.c_str(), fullPath))
+			return it;
+	}
+	return _jobs.end();
+}
+
+void FileLoaderPool::queue(const TCHAR *fullPath, int encoding)
+{
+	::EnterCriticalSection(&_lock);
+	if (findJob(fullPath) != _jobs.end())
+	{
+		::LeaveCriticalSection(&_lock);
+		return;
+	}
+	_jobs.push_back(new Job(fullPath, encoding));
+	::LeaveCriticalSection(&_lock);
+
+	startWorkers();
+	::ReleaseSemaphore(_hJobQueued, 1, NULL);
+}
+
+bool FileLoaderPool::take(const TCHAR *fullPath, int encoding, LoadedFileData & result)
+{
+	::EnterCriticalSection(&_lock);
+	std::deque<Job *>::iterator it = findJob(fullPath);
+	if (it == _jobs.end())
+	{
+		::LeaveCriticalSection(&_lock);
+		return false;
+	}
+
+	Job *job = *it;
+	if (job->_requestedEncoding != encoding)
+	{
+		// Queued with a different encoding, the result could not be used anyway
+		if (job->_state == jobRunning)
+			job->_state = jobDiscarded;	// the worker deletes it
+		else
+		{
+			_jobs.erase(it);
+			delete job;
+		}
+		::LeaveCriticalSection(&_lock);
+		return false;
+	}
+
+	if (job->_state == jobQueued)
+	{
+		// No worker got to it yet, no need to wait for the ones queued before
+		_jobs.erase(it);
+		::LeaveCriticalSection(&_lock);
+		bool isLoaded = loadAndDecode(job->_data._fullPath.c_str(), job->_requestedEncoding, job->_data);
+		if (isLoaded)
+			result.swap(job->_data);
+		delete job;
+		return isLoaded;
+	}
+
+	while (job->_state == jobRunning)
+	{
+		::LeaveCriticalSection(&_lock);
+		::WaitForSingleObject(_hJobDone, INFINITE);
+		::EnterCriticalSection(&_lock);
+	}
+
+	// Workers never erase jobs they did not discard themselves, so it is still there.
+	_jobs.erase(std::find(_jobs.begin(), _jobs.end(), job));
+	::LeaveCriticalSection(&_lock);
+
+	bool isLoaded = job->_data._success;
+	if (isLoaded)
+		result.swap(job->_data);
+	delete job;
+	return isLoaded;
+}
+
+void FileLoaderPool::discardAll()
+{
+	::EnterCriticalSection(&_lock);
+	for (std::deque<Job *>::iterator it = _jobs.begin(); it != _jobs.end(); )
+	{
+		if ((*it)->_state == jobRunning || (*it)->_state == jobDiscarded)
+		{
+			(*it)->_state = jobDiscarded;
+			++it;
+		}
+		else
+		{
+			delete (*it);
+			it = _jobs.erase(it);
+		}
+	}
+	::LeaveCriticalSection(&_lock);
+}
+
+void FileLoaderPool::runNextJob()
+{
+	::EnterCriticalSection(&_lock);
+	Job *job = NULL;
+	for (size_t i = 0 ; i < _jobs.size() ; i++)
+	{
+		if (_jobs[i]->_state == jobQueued)
+		{
+			job = _jobs[i];
+			break;
+		}
+	}
+	if (!job)
+	{
+		// Already taken by the UI thread
+		::LeaveCriticalSection(&_lock);
+		return;
+	}
+	job->_state = jobRunning;
+	generic_string fullPath = job->_data._fullPath;
+	int encoding = job->_requestedEncoding;
+	::LeaveCriticalSection(&_lock);
+
+	// The job cannot be deleted while running, but its data can be read by take() only
+	// once the state says it is done; so we fill a local copy and move it in afterward.
+	LoadedFileData data;
+	loadAndDecode(fullPath.c_str(), encoding, data);
+
+	::EnterCriticalSection(&_lock);
+	if (job->_state == jobDiscarded)
+	{
+		_jobs.erase(std::find(_jobs.begin(), _jobs.end(), job));
+		delete job;
+	}
+	else
+	{
+		job->_data.swap(data);
+		job->_state = jobDone;
+	}
+	::LeaveCriticalSection(&_lock);
+	::SetEvent(_hJobDone);
+}
+
+DWORD WINAPI FileLoaderPool::workerProc(LPVOID param)
+{
+	FileLoaderPool *pool = static_cast<FileLoaderPool *>(param);
+	for (;;)
+	{
+		::WaitForSingleObject(pool->_hJobQueued, INFINITE);
+
+		::EnterCriticalSection(&pool->_lock);
+		bool isStopping = pool->_isStopping;
+		::LeaveCriticalSection(&pool->_lock);
+		if (isStopping)
+			break;
+
+		pool->runNextJob();
+	}
+	return 0;
+}
+
+bool FileLoaderPool::loadAndDecode(const TCHAR *fullPath, int encoding, LoadedFileData & result)
+{
+	result._fullPath = fullPath;
+	result._success = false;
+	result._text.clear();
+
+	FILE *fp = NULL;
+	generic_fopen(fp, fullPath, TEXT("rb"));
+	if (!fp)
+		return false;
+
+	_fseeki64(fp, 0, SEEK_END);
+	unsigned __int64 fileSize = _ftelli64(fp);
+	rewind(fp);
+	if (fileSize > maxPrefetchFileSize)
+	{
+		fclose(fp);
+		return false;
+	}
+
+	std::vector<char> data(size_t(fileSize) + 1);
+	size_t lenFile = fread(&data[0], 1, size_t(fileSize), fp);
+	fclose(fp);
+	data[lenFile] = '\0';
+
+	// Same rule as FileManager::loadFileData: a BOM wins over the requested encoding
+	if (encoding != -1 && Utf8_16_Read::determineEncoding((unsigned char *)&data[0], int(min(lenFile, loaderBlockSize))) != uni8Bit)
+		encoding = -1;
+
+	if (encoding == -1)
+	{
+		// Fed by blocks, so that the encoding is detected on the same data as with a direct load
+		Utf8_16_Read unicodeConvertor;
+		result._text.reserve(lenFile);
+		size_t firstConvertedBlock = 0;
+		for (size_t i = 0 ; i < lenFile ; i += loaderBlockSize)
+		{
+			size_t lenBlock = min(loaderBlockSize, lenFile - i);
+			size_t lenConvert = unicodeConvertor.convert(&data[i], lenBlock);
+			result._text.append(unicodeConvertor.getNewBuf(), lenConvert);
+			if (i == 0)
+				firstConvertedBlock = result._text.size();
+		}
+		// An empty block flushes what the convertor kept for a character cut between two blocks
+		size_t lenConvert = unicodeConvertor.convert(&data[0], 0);
+		result._text.append(unicodeConvertor.getNewBuf(), lenConvert);
+		result._unicodeMode = unicodeConvertor.getEncoding();
+		result._format = getEOLFormat(result._text.c_str(), firstConvertedBlock);
+	}
+	else if (encoding == SC_CP_UTF8)
+	{
+		result._text.assign(&data[0], lenFile);
+		result._format = getEOLFormat(result._text.c_str(), min(lenFile, loaderBlockSize));
+	}
+	else
+	{
+		// The whole file is in memory: convert it at once, flushing what may be a truncated last character
+		MbcsStreamConvertor streamConvertor(encoding, SC_CP_UTF8);
+		int lenUtf8 = 0;
+		const char *utf8Text = streamConvertor.convert(&data[0], int(lenFile), &lenUtf8);
+		result._text.assign(utf8Text, lenUtf8);
+		utf8Text = streamConvertor.flush(&lenUtf8);
+		result._text.append(utf8Text, lenUtf8);
+		result._format = getEOLFormat(&data[0], min(lenFile, loaderBlockSize));
+	}
+
+	result._encoding = encoding;
+	result._success = true;
+	return true;
+}
@@ -0,0 +1,112 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef SCINTILLACOMPONENT_FILELOADER_H
+#define SCINTILLACOMPONENT_FILELOADER_H
+
+#ifndef PARAMETERS_DEF_H
+#include "Parameters_def.h"
+#endif
+
+// Files bigger than this are not prefetched: the decoded copy would double the
+// memory needed to open them, so they keep going through FileManager::loadFileData.
+const unsigned __int64 maxPrefetchFileSize = 64 * 1024 * 1024;
+
+// Content of a file, read from disk and converted to what Scintilla expects
+// (UTF-8, or the raw bytes for ANSI files), without touching any Scintilla view.
+struct LoadedFileData
+{
+	LoadedFileData() : _encoding(-1), _unicodeMode(uni8Bit), _format(-1), _success(false) {};
+
+	// Avoids copying the text around when handing the result from one thread to the other
+	void swap(LoadedFileData & other) {
+		_fullPath.swap(other._fullPath);
+		std::swap(_encoding, other._encoding);
+		std::swap(_unicodeMode, other._unicodeMode);
+		std::swap(_format, other._format);
+		_text.swap(other._text);
+		std::swap(_success, other._success);
+	};
+
+	generic_string _fullPath;
+	int _encoding;				// -1 if the file was decoded by Utf8_16_Read (a BOM overrides any requested encoding)
+	UniMode _unicodeMode;		// as detected by Utf8_16_Read, meaningful only if _encoding == -1
+	int _format;				// formatType of the first EOL found, -1 if there is none
+	std::string _text;
+	bool _success;
+};
+
+// Reads and decodes files on worker threads, so that opening many files at once
+// (drag and drop, multiple selection in the open dialog, session restore) is not
+// serialized on disk latency. The UI thread queues every file first, then picks
+// up the results one by one from FileManager::loadFile and only has to append
+// the decoded text to the new document.
+class FileLoaderPool
+{
+public:
+	FileLoaderPool();
+	~FileLoaderPool();
+
+	// fullPath must already be normalized (GetFullPathName + GetLongPathName).
+	// encoding is the one that will be passed to FileManager::loadFile.
+	void queue(const TCHAR *fullPath, int encoding);
+
+	// Returns false if the file was not queued with this encoding, or if it could not be
+	// loaded in the background; the caller should then fall back to the synchronous load.
+	// Waits if the file is being read right now, and loads it on the calling thread if
+	// no worker picked it up yet.
+	bool take(const TCHAR *fullPath, int encoding, LoadedFileData & result);
+
+	// Drops every job that was not taken. Jobs being processed are dropped when they finish.
+	void discardAll();
+
+	// Does the actual work. Thread safe: only uses local buffers.
+	static bool loadAndDecode(const TCHAR *fullPath, int encoding, LoadedFileData & result);
+
+private:
+	enum JobState {jobQueued, jobRunning, jobDone, jobDiscarded};
+
+	struct Job
+	{
+		Job(const TCHAR *fullPath, int encoding) : _requestedEncoding(encoding), _state(jobQueued) {
+			_data._fullPath = fullPath;
+		};
+		int _requestedEncoding;
+		JobState _state;
+		LoadedFileData _data;
+	};
+
+	CRITICAL_SECTION _lock;
+	HANDLE _hJobQueued;			// semaphore, counts the jobs waiting for a worker
+	HANDLE _hJobDone;			// auto-reset event, signaled each time a worker finishes a job
+	std::vector<HANDLE> _workers;
+	std::deque<Job *> _jobs;
+	bool _isStopping;
+
+	void startWorkers();
+	void stopWorkers();
+	std::deque<Job *>::iterator findJob(const TCHAR *fullPath);
+	void runNextJob();
+
+	static DWORD WINAPI workerProc(LPVOID param);
+
+	// Private so FileLoaderPool objects can not be copied
+	FileLoaderPool(const FileLoaderPool&);
+	const FileLoaderPool& operator= (const FileLoaderPool&);
+};
+
+#endif //SCINTILLACOMPONENT_FILELOADER_H
@@ -0,0 +1,176 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include "ScintillaComponent/FileSaver.h"
+
+#include "Utf8_16.h"
+
+// Text converted and written at a time
+const size_t saveChunkSize = 128 * 1024;
+
+// How often the progress handler is called, in ms
+const DWORD saveProgressInterval = 100;
+
+FileSaver::FileSaver(const TCHAR *fullPath, UniMode mode, int encoding)
+	: _fullPath(fullPath), _mode(mode), _encoding(encoding), _isWritten(false), _bytesDone(0), _cancelRequested(0)
+{
+	_parts[0] = _parts[1] = NULL;
+	_lengths[0] = _lengths[1] = 0;
+}
+
+FileSaver::~FileSaver()
+{
+	// Whatever happened, the temporary file must not stay around
+	if (!_tempPath.empty() && _tempPath != _fullPath)
+		::DeleteFile(_tempPath.c_str());
+}
+
+bool FileSaver::createTempFile()
+{
+	TCHAR dir[MAX_PATH];
+	lstrcpyn(dir, _fullPath.c_str(), MAX_PATH);
+	::PathRemoveFileSpec(dir);
+
+	TCHAR tempPath[MAX_PATH];
+	if (!::GetTempFileName(dir, TEXT("npp"), 0, tempPath))
+		return false;
+	_tempPath = tempPath;
+	return true;
+}
+
+bool FileSaver::writeFile()
+{
+	Utf8_16_Write writer;
+	writer.setEncoding(_mode);
+	if (!writer.fopen(_tempPath.c_str(), TEXT("wb")))
+		return false;
+
+	// Writes the BOM, even if the document is empty
+	writer.fwrite(_parts[0], 0);
+
+	MbcsStreamConvertor streamConvertor(SC_CP_UTF8, _encoding);
+	bool isWritten = true;
+	for (int i = 0 ; i < 2 && isWritten ; i++)
+	{
+		for (size_t pos = 0 ; pos < _lengths[i] ; pos += saveChunkSize)
+		{
+			// Cancelling a direct write would leave the file truncated, so it goes on
+			if (_cancelRequested && _tempPath != _fullPath)
+			{
+				isWritten = false;
+				break;
+			}
+
+			size_t chunkSize = min(_lengths[i] - pos, saveChunkSize);
+			if (_encoding == -1)	// no special encoding; can be handled directly by Utf8_16_Write
+			{
+				isWritten = writer.fwrite(_parts[i] + pos, chunkSize) != 0;
+			}
+			else
+			{
+				int newDataLen = 0;
+				const char *newData = streamConvertor.convert(_parts[i] + pos, int(chunkSize), &newDataLen);
+				isWritten = !newDataLen || writer.fwrite(newData, newDataLen) != 0;
+			}
+			if (!isWritten)
+				break;
+			::InterlockedExchangeAdd(&_bytesDone, LONG(chunkSize));
+		}
+	}
+
+	if (isWritten && _encoding != -1)
+	{
+		int newDataLen = 0;
+		const char *newData = streamConvertor.flush(&newDataLen);
+		isWritten = !newDataLen || writer.fwrite(newData, newDataLen) != 0;
+	}
+
+	// Closing flushes what is left in the buffers, that can fail too (disk full)
+	if (!writer.fclose())
+		isWritten = false;
+	return isWritten;
+}
+
+bool FileSaver::replaceDestination()
+{
+	if (_tempPath == _fullPath)
+		return true;
+
+	// ReplaceFile keeps the attributes, the ACLs and the creation time of the file it replaces
+	if (::PathFileExists(_fullPath.c_str()) &&
+		::ReplaceFile(_fullPath.c_str(), _tempPath.c_str(), NULL, REPLACEFILE_IGNORE_MERGE_ERRORS, NULL, NULL))
+		return true;
+
+	return ::MoveFileEx(_tempPath.c_str(), _fullPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+DWORD WINAPI FileSaver::workerProc(LPVOID param)
+{
+	FileSaver *saver = static_cast<FileSaver *>(param);
+	saver->_isWritten = saver->writeFile();
+	return 0;
+}
+
+bool FileSaver::save(const char *part1, size_t len1, const char *part2, size_t len2, SaveProgressHandler *pProgress)
+{
+	_parts[0] = part1;
+	_lengths[0] = len1;
+	_parts[1] = part2;
+	_lengths[1] = len2;
+	_bytesDone = 0;
+	_cancelRequested = 0;
+	_isWritten = false;
+
+	// Without the right to create a file next to it (but with the right to overwrite it),
+	// the file is written in place as it always was
+	if (!createTempFile())
+		_tempPath = _fullPath;
+
+	HANDLE hThread = pProgress?::CreateThread(NULL, 0, workerProc, this, 0, NULL):NULL;
+	if (hThread)
+	{
+		// Only paint messages are dispatched meanwhile: the windows are redrawn and are not taken
+		// for hung, but no input can reach the text being written, nor start another save
+		DWORD lastProgress = ::GetTickCount();
+		while (::MsgWaitForMultipleObjects(1, &hThread, FALSE, saveProgressInterval, QS_PAINT) != WAIT_OBJECT_0)
+		{
+			MSG msg;
+			while (::PeekMessage(&msg, NULL, WM_PAINT, WM_PAINT, PM_REMOVE))
+				::DispatchMessage(&msg);
+
+			if (::GetTickCount() - lastProgress >= saveProgressInterval)
+			{
+				lastProgress = ::GetTickCount();
+				if (!pProgress->onSaveProgress(size_t(_bytesDone), len1 + len2))
+					::InterlockedExchange(&_cancelRequested, 1);
+			}
+		}
+		::CloseHandle(hThread);
+	}
+	else
+	{
+		_isWritten = writeFile();
+	}
+
+	if (!_isWritten || !replaceDestination())
+		return false;
+
+	_tempPath.clear();	// nothing left to clean up
+	return true;
+}
@@ -0,0 +1,81 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#ifndef SCINTILLACOMPONENT_FILESAVER_H
+#define SCINTILLACOMPONENT_FILESAVER_H
+
+#ifndef PARAMETERS_DEF_H
+#include "Parameters_def.h"
+#endif
+
+// Told about the progress of a save, on the thread that started it.
+class SaveProgressHandler
+{
+public:
+	virtual ~SaveProgressHandler() {};
+
+	// Called regularly while the text is being written. Returning false cancels the save:
+	// the file on disk is then left as it was.
+	virtual bool onSaveProgress(size_t bytesDone, size_t bytesTotal) = 0;
+};
+
+// Writes the text of a document to a file without gathering it first: Scintilla keeps
+// the text in two parts, before and after its gap, and both are streamed as they are.
+// The text is converted and written to a temporary file in the destination directory,
+// which then replaces the destination, so that a failed or interrupted save never
+// leaves a truncated file behind.
+class FileSaver
+{
+public:
+	// mode and encoding as given by Buffer::getUnicodeMode and Buffer::getEncoding
+	FileSaver(const TCHAR *fullPath, UniMode mode, int encoding);
+	~FileSaver();
+
+	// The parts must stay untouched until save returns.
+	// With a progress handler, the text is written by a worker thread while the calling
+	// thread calls the handler and dispatches its paint messages (only those, input waits
+	// for the end of the save); without, everything is done on the calling thread.
+	bool save(const char *part1, size_t len1, const char *part2, size_t len2, SaveProgressHandler *pProgress = NULL);
+
+	bool isCancelled() const { return _cancelRequested != 0; };
+
+private:
+	generic_string _fullPath;
+	generic_string _tempPath;	// same as _fullPath if no temporary file could be created
+	UniMode _mode;
+	int _encoding;
+
+	const char *_parts[2];
+	size_t _lengths[2];
+	bool _isWritten;
+
+	volatile LONG _bytesDone;
+	volatile LONG _cancelRequested;
+
+	bool createTempFile();
+	bool writeFile();
+	bool replaceDestination();
+
+	static DWORD WINAPI workerProc(LPVOID param);
+
+	// Private so FileSaver objects can not be copied
+	FileSaver(const FileSaver&);
+	const FileSaver& operator= (const FileSaver&);
+};
+
+#endif //SCINTILLACOMPONENT_FILESAVER_H
@@ -0,0 +1,346 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "precompiled_headers.h"
+#include "ScintillaComponent/FileWatcher.h"
+
+// Enough for a few hundred names. When it overflows, the directory is reported as a whole.
+const DWORD watchBufferSize = 16 * 1024;
+
+const DWORD watchFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_ATTRIBUTES;
+
+// Watches with ReadDirectoryChangesW. A single thread waits on a completion port for the
+// reads of every directory. The UI thread opens the directories, the worker does all the
+// I/O on them: it is told to start or to stop through the same port.
+class DirectoryChangeWatcher : public FileWatcher
+{
+public:
+	DirectoryChangeWatcher(HWND hNotify, UINT notifyMessage);
+	~DirectoryChangeWatcher();
+
+	bool addDirectory(const TCHAR *directory);
+	void removeDirectory(const TCHAR *directory);
+	bool isWatching(const TCHAR *directory);
+	void takeChanges(DirectoryChangesMap & changes);
+
+private:
+	// Completion keys of the commands, the reads complete with their Watch as key
+	enum Command {commandStart = 1, commandClose, commandStop};
+
+	struct Watch
+	{
+		Watch(const generic_string & key, HANDLE hDirectory) : _key(key), _hDirectory(hDirectory), _references(1), _isReading(false), _isFailed(false) {
+			::ZeroMemory(&_overlapped, sizeof(_overlapped));
+		};
+		generic_string _key;
+		HANDLE _hDirectory;		// only touched by the worker once the watch is started
+		int _references;
+		bool _isReading;
+		bool _isFailed;
+		OVERLAPPED _overlapped;
+		DWORD _buffer[watchBufferSize / sizeof(DWORD)];	// ReadDirectoryChangesW wants it DWORD aligned
+	};
+
+	HWND _hNotify;
+	UINT _notifyMessage;
+	CRITICAL_SECTION _lock;		// protects _watches, the Watch::_references and _isFailed, and _changes
+	HANDLE _hPort;
+	HANDLE _hWorker;
+	std::map<generic_string, Watch *> _watches;
+	DirectoryChangesMap _changes;
+	bool _isNotified;
+	int _nbLiveWatches;			// worker side: watches not deleted yet, including the ones removed from _watches
+
+	void post(Command command, Watch *watch);
+	void startReading(Watch *watch);
+	void readCompleted(Watch *watch, DWORD nbBytes);
+	void watchFailed(Watch *watch);
+	void changed(const generic_string & directory, const generic_string *fileName);
+	void run();
+
+	static DWORD WINAPI workerProc(LPVOID param);
+
+	DirectoryChangeWatcher(const DirectoryChangeWatcher&);
+	const DirectoryChangeWatcher& operator= (const DirectoryChangeWatcher&);
+};
+
+FileWatcher * FileWatcher::create(HWND hNotify, UINT notifyMessage)
+{
+	return new DirectoryChangeWatcher(hNotify, notifyMessage);
+}
+
+generic_string FileWatcher::directoryKey(const TCHAR *directory)
+{
+	generic_string key(directory);
+	while (key.length() > 3 && key[key.length() - 1] == TEXT('\\'))
+		key.erase(key.length() - 1);
+	if (!key.empty())
+		::CharLowerBuff(&key[0], DWORD(key.length()));
+	return key;
+}
+
+DirectoryChangeWatcher::DirectoryChangeWatcher(HWND hNotify, UINT notifyMessage) :
+	_hNotify(hNotify), _notifyMessage(notifyMessage), _hWorker(NULL), _isNotified(false), _nbLiveWatches(0)
+{
+	::InitializeCriticalSection(&_lock);
+	_hPort = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (_hPort)
+		_hWorker = ::CreateThread(NULL, 0, workerProc, this, 0, NULL);
+}
+
+DirectoryChangeWatcher::~DirectoryChangeWatcher()
+{
+	if (_hWorker)
+	{
+		// The worker closes every directory and waits for their reads to be aborted before it stops
+		::EnterCriticalSection(&_lock);
+		for (std::map<generic_string, Watch *>::iterator it = _watches.begin(); it != _watches.end(); ++it)
+			post(commandClose, it->second);
+		_watches.clear();
+		::LeaveCriticalSection(&_lock);
+		post(commandStop, NULL);
+		::WaitForSingleObject(_hWorker, INFINITE);
+		::CloseHandle(_hWorker);
+	}
+	if (_hPort)
+		::CloseHandle(_hPort);
+	::DeleteCriticalSection(&_lock);
+}
+
+bool DirectoryChangeWatcher::addDirectory(const TCHAR *directory)
+{
+	generic_string key = directoryKey(directory);
+	::EnterCriticalSection(&_lock);
+	std::map<generic_string, Watch *>::iterator it = _watches.find(key);
+	if (it != _watches.end())
+	{
+		it->second->_references++;
+		bool isWatching = !it->second->_isFailed;
+		::LeaveCriticalSection(&_lock);
+		return isWatching;
+	}
+	::LeaveCriticalSection(&_lock);
+
+	if (!_hWorker)
+		return false;
+
+	HANDLE hDirectory = ::CreateFile(directory, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	Watch *watch = new Watch(key, hDirectory);
+	if (hDirectory == INVALID_HANDLE_VALUE)
+		watch->_isFailed = true;
+	else if (!::CreateIoCompletionPort(hDirectory, _hPort, ULONG_PTR(watch), 0))
+	{
+		::CloseHandle(hDirectory);
+		watch->_hDirectory = INVALID_HANDLE_VALUE;
+		watch->_isFailed = true;
+	}
+
+	// Only the UI thread adds and removes watches, nobody could have added this one meanwhile
+	::EnterCriticalSection(&_lock);
+	_watches[key] = watch;
+	::LeaveCriticalSection(&_lock);
+
+	// Failed watches are kept too, for the reference count, and deleted by the worker all the same
+	bool isWatching = !watch->_isFailed;
+	post(commandStart, watch);
+	return isWatching;
+}
+
+void DirectoryChangeWatcher::removeDirectory(const TCHAR *directory)
+{
+	::EnterCriticalSection(&_lock);
+	std::map<generic_string, Watch *>::iterator it = _watches.find(directoryKey(directory));
+	if (it != _watches.end() && --it->second->_references == 0)
+	{
+		post(commandClose, it->second);
+		_watches.erase(it);
+	}
+	::LeaveCriticalSection(&_lock);
+}
+
+bool DirectoryChangeWatcher::isWatching(const TCHAR *directory)
+{
+	::EnterCriticalSection(&_lock);
+	std::map<generic_string, Watch *>::const_iterator it = _watches.find(directoryKey(directory));
+	bool isWatching = (it != _watches.end() && !it->second->_isFailed);
+	::LeaveCriticalSection(&_lock);
+	return isWatching;
+}
+
+void DirectoryChangeWatcher::takeChanges(DirectoryChangesMap & changes)
+{
+	changes.clear();
+	::EnterCriticalSection(&_lock);
+	changes.swap(_changes);
+	_isNotified = false;
+	::LeaveCriticalSection(&_lock);
+}
+
+void DirectoryChangeWatcher::post(Command command, Watch *watch)
+{
+	::PostQueuedCompletionStatus(_hPort, 0, ULONG_PTR(command), (LPOVERLAPPED)watch);
+}
+
+// Worker thread from here on
+
+void DirectoryChangeWatcher::startReading(Watch *watch)
+{
+	::ZeroMemory(&watch->_overlapped, sizeof(watch->_overlapped));
+	if (::ReadDirectoryChangesW(watch->_hDirectory, watch->_buffer, watchBufferSize, FALSE, watchFilter, NULL, &watch->_overlapped, NULL))
+		watch->_isReading = true;
+	else
+		watchFailed(watch);
+}
+
+void DirectoryChangeWatcher::readCompleted(Watch *watch, DWORD nbBytes)
+{
+	if (nbBytes == 0)	// the buffer overflowed, the names are lost
+	{
+		changed(watch->_key, NULL);
+		return;
+	}
+
+	const BYTE *pos = reinterpret_cast<const BYTE *>(watch->_buffer);
+	for (;;)
+	{
+		const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(pos);
+		int nameLength = int(info->FileNameLength / sizeof(WCHAR));
+#ifdef UNICODE
+		generic_string name(info->FileName, nameLength);
+#else
+		generic_string name;
+		int len = ::WideCharToMultiByte(CP_ACP, 0, info->FileName, nameLength, NULL, 0, NULL, NULL);
+		if (len > 0)
+		{
+			name.resize(len);
+			::WideCharToMultiByte(CP_ACP, 0, info->FileName, nameLength, &name[0], len, NULL, NULL);
+		}
+#endif
+		if (!name.empty())
+		{
+			::CharLowerBuff(&name[0], DWORD(name.length()));
+			changed(watch->_key, &name);
+		}
+		if (!info->NextEntryOffset)
+			break;
+		pos += info->NextEntryOffset;
+	}
+}
+
+// The directory was deleted, or its volume went away: report everything in it one last time,
+// from now on FileManager polls its files again
+void DirectoryChangeWatcher::watchFailed(Watch *watch)
+{
+	if (watch->_hDirectory != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(watch->_hDirectory);
+		watch->_hDirectory = INVALID_HANDLE_VALUE;
+	}
+	::EnterCriticalSection(&_lock);
+	watch->_isFailed = true;
+	::LeaveCriticalSection(&_lock);
+	changed(watch->_key, NULL);
+}
+
+// fileName is NULL for all the files of the directory
+void DirectoryChangeWatcher::changed(const generic_string & directory, const generic_string *fileName)
+{
+	::EnterCriticalSection(&_lock);
+	DirectoryChanges & changes = _changes[directory];
+	if (fileName)
+		changes.addFile(*fileName);
+	else
+		changes.setAllFiles();
+	bool mustNotify = !_isNotified && _hNotify;
+	_isNotified = true;
+	::LeaveCriticalSection(&_lock);
+
+	if (mustNotify)
+		::PostMessage(_hNotify, _notifyMessage, 0, 0);
+}
+
+void DirectoryChangeWatcher::run()
+{
+	bool isStopping = false;
+	while (!isStopping || _nbLiveWatches > 0)
+	{
+		DWORD nbBytes = 0;
+		ULONG_PTR key = 0;
+		LPOVERLAPPED pOverlapped = NULL;
+		BOOL isOK = ::GetQueuedCompletionStatus(_hPort, &nbBytes, &key, &pOverlapped, INFINITE);
+		if (!isOK && !pOverlapped)
+			return;	// the port itself is broken
+
+		if (key == commandStop)
+		{
+			isStopping = true;
+		}
+		else if (key == commandStart)
+		{
+			Watch *watch = reinterpret_cast<Watch *>(pOverlapped);
+			_nbLiveWatches++;
+			if (watch->_hDirectory != INVALID_HANDLE_VALUE)
+				startReading(watch);
+		}
+		else if (key == commandClose)
+		{
+			// A pending read completes as aborted, the watch is deleted then
+			Watch *watch = reinterpret_cast<Watch *>(pOverlapped);
+			if (watch->_hDirectory != INVALID_HANDLE_VALUE)
+			{
+				::CloseHandle(watch->_hDirectory);
+				watch->_hDirectory = INVALID_HANDLE_VALUE;
+			}
+			if (!watch->_isReading)
+			{
+				delete watch;
+				_nbLiveWatches--;
+			}
+		}
+		else
+		{
+			Watch *watch = reinterpret_cast<Watch *>(key);
+			watch->_isReading = false;
+			if (watch->_hDirectory == INVALID_HANDLE_VALUE)
+			{
+				delete watch;	// closed while reading
+				_nbLiveWatches--;
+			}
+			else if (!isOK && ::GetLastError() == ERROR_NOTIFY_ENUM_DIR)
+			{
+				readCompleted(watch, 0);
+				startReading(watch);
+			}
+			else if (!isOK)
+			{
+				watchFailed(watch);
+			}
+			else
+			{
+				readCompleted(watch, nbBytes);
+				startReading(watch);
+			}
+		}
+	}
+}
+
+DWORD WINAPI DirectoryChangeWatcher::workerProc(LPVOID param)
+{
+	static_cast<DirectoryChangeWatcher *>(param)->run();
+	return 0;
+}
@@ -0,0 +1,73 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef SCINTILLACOMPONENT_FILEWATCHER_H
+#define SCINTILLACOMPONENT_FILEWATCHER_H
+
+// What happened in one watched directory since the changes were last taken.
+// Names are lower case, like the keys of FileManager's name index.
+struct DirectoryChanges
+{
+	DirectoryChanges() : _allFiles(false) {};
+
+	void addFile(const generic_string & name) {
+		if (!_allFiles && std::find(_fileNames.begin(), _fileNames.end(), name) == _fileNames.end())
+			_fileNames.push_back(name);
+	};
+
+	// Too many changes to be listed, or the directory is not watched any more
+	void setAllFiles() {
+		_allFiles = true;
+		_fileNames.clear();
+	};
+
+	std::vector<generic_string> _fileNames;	// files created, deleted, renamed or written
+	bool _allFiles;
+};
+
+// Keyed on the lower case directory, without trailing backslash except for roots ("c:\")
+typedef std::map<generic_string, DirectoryChanges> DirectoryChangesMap;
+
+// Watches the directories of the open files, so that FileManager only has to look at
+// the files that actually changed instead of polling every one of them.
+// Changes are gathered in the background and coalesced per directory until the UI
+// thread takes them.
+class FileWatcher
+{
+public:
+	virtual ~FileWatcher() {};
+
+	// Each addDirectory must be matched by a removeDirectory.
+	// Returns false if the directory cannot be watched: its files have to be polled.
+	virtual bool addDirectory(const TCHAR *directory) = 0;
+	virtual void removeDirectory(const TCHAR *directory) = 0;
+
+	// False for directories that were not added, or whose watch failed since. A failing
+	// watch reports all the files of its directory as changed one last time.
+	virtual bool isWatching(const TCHAR *directory) = 0;
+
+	// Moves the changes gathered so far into changes, which is cleared first
+	virtual void takeChanges(DirectoryChangesMap & changes) = 0;
+
+	// The watcher of this platform. Once changes are waiting to be taken, notifyMessage is
+	// posted to hNotify (if not NULL), and not again until takeChanges has been called.
+	static FileWatcher * create(HWND hNotify, UINT notifyMessage);
+
+	static generic_string directoryKey(const TCHAR *directory);
+};
+
+#endif //SCINTILLACOMPONENT_FILEWATCHER_H
@@ -38,10 +38,11 @@ LONG FindReplaceDlg::originalFinderProc = NULL;
 
 struct FoundInfo {
 	FoundInfo(int start, int end, const TCHAR *fullPath)
-		: _start(start), _end(end), _fullPath(fullPath) {};
+		: _start(start), _end(end), _fullPath(fullPath), _filePosition(-1) {};
 	int _start;
 	int _end;
 	generic_string _fullPath;
+	__int64 _filePosition;	// huge files: where the match is in the file, _start and _end being 0 and its length
 };
 
 //This class contains generic search functions as static functions for easy access
@@ -200,6 +201,28 @@ void Searching::displaySectionCentered(int posStart, int posEnd, ScintillaEditVi
 	pEditView->execute(SCI_SETANCHOR, posStart);
 }
 
+// Regular expressions cannot be streamed: huge files are then only searched in their window
+static bool canSearchHugeFile(const FindOption *pOptions)
+{
+	return pOptions->_searchType != FindRegex;
+}
+
+// The text to find in the bytes of the file, codepage being the one of its document
+static HugeFileSearch makeHugeFileSearch(const TCHAR *txt2find, const FindOption *pOptions, UINT codepage)
+{
+	generic_string text = txt2find;
+	int length = int(text.length());
+	if (pOptions->_searchType == FindExtended && length)
+		length = Searching::convertExtendedToString(text.c_str(), &text[0], length);
+#ifdef UNICODE
+	int lenPattern = 0;
+	const char *pattern = WcharMbcsConvertor::getInstance()->wchar2char(text.c_str(), codepage, length, &lenPattern);
+	return HugeFileSearch(pattern, lenPattern, pOptions->_isMatchCase, pOptions->_isWholeWord);
+#else
+	return HugeFileSearch(text.c_str(), length, pOptions->_isMatchCase, pOptions->_isWholeWord);
+#endif
+}
+
 //Finder: Dockable window that contains search results
 class Finder : public DockingDlgInterface {
 	friend class FindReplaceDlg;
@@ -276,6 +299,51 @@ private:
 FoundInfo Finder::EmptyFoundInfo(0, 0, TEXT(""));
 SearchResultMarking Finder::EmptySearchResultMarking;
 
+// Adds the matches of a huge file to the Finder as they are found, the same way processRange does
+class FinderHugeFileHandler : public HugeFileSearchHandler
+{
+public:
+	FinderHugeFileHandler(Finder *pFinder, const TCHAR *fileName, UINT codepage, int lenMatch)
+		: _pFinder(pFinder), _fileName(fileName), _codepage(codepage), _lenMatch(lenMatch), _nbMatches(0) {};
+
+	virtual bool onMatch(const HugeFileMatch & match) {
+		if (!_nbMatches++)
+			_pFinder->addFileNameTitle(_fileName);
+
+		int start_mark = match._startInLine;
+		int end_mark = match._startInLine + _lenMatch;
+#ifdef UNICODE
+		generic_string line = WcharMbcsConvertor::getInstance()->char2wchar(match._lineText.c_str(), _codepage, &start_mark, &end_mark);
+#else
+		generic_string line = match._lineText;
+#endif
+		line += TEXT("\r\n");
+		SearchResultMarking srm;
+		srm._start = start_mark;
+		srm._end = end_mark;
+		FoundInfo fi(0, _lenMatch, _fileName);
+		fi._filePosition = match._position;
+		_pFinder->add(fi, srm, line.c_str(), int(match._line + 1));
+		return true;
+	};
+
+private:
+	Finder *_pFinder;
+	const TCHAR *_fileName;
+	UINT _codepage;
+	int _lenMatch;
+	int _nbMatches;
+};
+
+// Nothing to do with the matches of a huge file when they are only counted, findAll returns their number
+class CountHugeFileHandler : public HugeFileSearchHandler
+{
+public:
+	virtual bool onMatch(const HugeFileMatch &) {
+		return true;
+	};
+};
+
 bool Finder::notify(SCNotification *notification)
 {
 	static bool isDoubleClicked = false;
@@ -335,7 +403,14 @@ void Finder::GotoFoundLine()
 
 	// Switch to another document
 	::SendMessage(::GetParent(_hParent), WM_DOOPEN, 0, (LPARAM)fInfo._fullPath.c_str());
-	Searching::displaySectionCentered(fInfo._start, fInfo._end, *_ppEditView);
+	if (fInfo._filePosition != -1)
+	{
+		int start = (*_ppEditView)->loadFileRange(fInfo._filePosition, fInfo._end - fInfo._start);
+		if (start != -1)
+			Searching::displaySectionCentered(start, start + fInfo._end - fInfo._start, *_ppEditView);
+	}
+	else
+		Searching::displaySectionCentered(fInfo._start, fInfo._end, *_ppEditView);
 
 	// Then we colourise the double clicked line
 	setFinderStyle();
@@ -1244,6 +1319,12 @@ bool FindReplaceDlg::processFindNext(const TCHAR *txt2find, const FindOption *op
 		Searching::convertExtendedToString(txt2find, pText, stringSizeFind);
 	}
 
+	if ((*_ppEditView)->getCurrentBuffer()->getHugeFileView() && canSearchHugeFile(pOptions))
+	{
+		delete [] pText;
+		return processFindNextInHugeFile(txt2find, pOptions, oFindStatus);
+	}
+
 	int docLength = int((*_ppEditView)->execute(SCI_GETLENGTH));
 	CharacterRange cr;
 	(*_ppEditView)->getSelection(cr);
@@ -1311,22 +1392,7 @@ bool FindReplaceDlg::processFindNext(const TCHAR *txt2find, const FindOption *op
 			if (oFindStatus)
 				*oFindStatus = FSNotFound;
 			//failed, or failed twice with wrap
-			if (NotIncremental==pOptions->_incrementalType) //incremental search doesnt trigger messages
-			{
-				generic_string msg = TEXT("Can't find the text:\r\n\"");
-				msg += txt2find;
-				msg += TEXT("\"");
-				::MessageBox(_hMsgParent, msg.c_str(), TEXT("Find"), MB_OK);
-				// if the dialog is not shown, pass the focus to his parent(ie. Notepad++)
-				if (!::IsWindowVisible(_hSelf))
-				{
-					::SetFocus((*_ppEditView)->getHSelf());
-				}
-				else
-				{
-					::SetFocus(::GetDlgItem(_hSelf, IDFINDWHAT));
-				}
-			}
+			showTextNotFound(txt2find, pOptions);
 			delete [] pText;
 			return false;
 		}
@@ -1346,6 +1412,78 @@ bool FindReplaceDlg::processFindNext(const TCHAR *txt2find, const FindOption *op
 	return true;
 }
 
+void FindReplaceDlg::showTextNotFound(const TCHAR *txt2find, const FindOption *pOptions)
+{
+	if (NotIncremental!=pOptions->_incrementalType) //incremental search doesnt trigger messages
+		return;
+
+	generic_string msg = TEXT("Can't find the text:\r\n\"");
+	msg += txt2find;
+	msg += TEXT("\"");
+	::MessageBox(_hMsgParent, msg.c_str(), TEXT("Find"), MB_OK);
+	// if the dialog is not shown, pass the focus to his parent(ie. Notepad++)
+	if (!::IsWindowVisible(_hSelf))
+	{
+		::SetFocus((*_ppEditView)->getHSelf());
+	}
+	else
+	{
+		::SetFocus(::GetDlgItem(_hSelf, IDFINDWHAT));
+	}
+}
+
+// Same starting points as processFindNext, but in the whole file
+bool FindReplaceDlg::processFindNextInHugeFile(const TCHAR *txt2find, const FindOption *pOptions, FindStatus *oFindStatus)
+{
+	HugeFileView *pHugeFile = (*_ppEditView)->getCurrentBuffer()->getHugeFileView();
+	HugeFileSearch search = makeHugeFileSearch(txt2find, pOptions, UINT((*_ppEditView)->execute(SCI_GETCODEPAGE)));
+	if (search._pattern.empty())
+		return false;
+
+	CharacterRange cr;
+	(*_ppEditView)->getSelection(cr);
+	__int64 windowStart = pHugeFile->getWindowStart();
+	bool isDownwards = (pOptions->_whichDirection == DIR_DOWN);
+	__int64 from = windowStart + (isDownwards ? cr.cpMax : cr.cpMin);
+	if (FirstIncremental==pOptions->_incrementalType)
+	{
+		from = windowStart + cr.cpMin;
+		isDownwards = true;
+	}
+	else if (NextIncremental==pOptions->_incrementalType)
+	{
+		from = windowStart + (isDownwards ? cr.cpMin + 1 : cr.cpMax - 1);
+	}
+
+	__int64 found = pHugeFile->find(search, from, isDownwards);
+	if (found == -1 && pOptions->_isWrapAround)
+	{
+		found = pHugeFile->find(search, isDownwards ? 0 : pHugeFile->getTextLength(), isDownwards);
+		if (oFindStatus)
+			*oFindStatus = isDownwards ? FSEndReached : FSTopReached;
+	}
+	if (found == -1)
+	{
+		if (oFindStatus)
+			*oFindStatus = FSNotFound;
+		showTextNotFound(txt2find, pOptions);
+		return false;
+	}
+
+	int length = int(search._pattern.length());
+	int start = (*_ppEditView)->loadFileRange(found, length);
+	if (start == -1)
+		return false;
+
+	// to make sure the found result is visible:
+	// prevent recording of absolute positioning commands issued in the process
+	(*_ppEditView)->execute(SCI_STOPRECORD);
+	Searching::displaySectionCentered(start, start + length, *_ppEditView, isDownwards);
+	if (::SendMessage(_hParent, WM_GETCURRENTMACROSTATUS,0,0) == MACRO_RECORDING_IN_PROGRESS)
+		(*_ppEditView)->execute(SCI_STARTRECORD);
+	return true;
+}
+
 // return value :
 // true  : the text is replaced, and find the next occurrence
 // false : the text2find is not found, so the text is NOT replace
@@ -1441,6 +1579,15 @@ int FindReplaceDlg::processAll(ProcessOperation op, const FindOption *opt, bool
 	const TCHAR *txt2find = pOptions->_str2Search.c_str();
 	const TCHAR *txt2replace = pOptions->_str4Replace.c_str();
 
+	// The document of a huge file only holds a window of it, its matches are counted on disk
+	HugeFileView *pHugeFile = (*_ppEditView)->getCurrentBuffer()->getHugeFileView();
+	if (op == ProcessCountAll && pHugeFile && canSearchHugeFile(pOptions))
+	{
+		HugeFileSearch search = makeHugeFileSearch(txt2find, pOptions, UINT((*_ppEditView)->execute(SCI_GETCODEPAGE)));
+		CountHugeFileHandler handler;
+		return pHugeFile->findAll(search, handler);
+	}
+
 	CharacterRange cr;
 	(*_ppEditView)->getSelection(cr);
 	int docLength = int((*_ppEditView)->execute(SCI_GETLENGTH));
@@ -1575,6 +1722,18 @@ int FindReplaceDlg::processRange(ProcessOperation op, const TCHAR *txt2find, con
 		}
 	}
 
+	// Found ranges to mark are gathered and filled at once, marking them one by one costs a redraw each
+	int markIndicator = -1;
+	if (op == ProcessMarkAll && _env->_doStyleFoundToken)
+		markIndicator = SCE_UNIVERSAL_FOUND_STYLE;
+	else if (op == ProcessMarkAllExt)
+		markIndicator = colourStyleID;
+	else if (op == ProcessMarkAll_2)
+		markIndicator = SCE_UNIVERSAL_FOUND_STYLE_SMART;
+	else if (op == ProcessMarkAll_IncSearch)
+		markIndicator = SCE_UNIVERSAL_FOUND_STYLE_INC;
+	std::vector<int> markRanges;
+
 	//Initial range for searching
 	(*_ppEditView)->execute(SCI_SETSEARCHFLAGS, flags);
 	int targetStart = (*_ppEditView)->searchInTarget(pTextFind, stringSizeFind, startRange, endRange);
@@ -1596,6 +1755,7 @@ int FindReplaceDlg::processRange(ProcessOperation op, const TCHAR *txt2find, con
 
 		// Search resulted in empty token, possible with RE
 		if (!foundTextLen) {
+			(*_ppEditView)->fillIndicatorRanges(markIndicator, markRanges);
 			delete [] pTextFind;
 			delete [] pTextReplace;
 			return -1;
@@ -1647,8 +1807,8 @@ int FindReplaceDlg::processRange(ProcessOperation op, const TCHAR *txt2find, con
 			{
 				if (_env->_doStyleFoundToken)
 				{
-					(*_ppEditView)->execute(SCI_SETINDICATORCURRENT, SCE_UNIVERSAL_FOUND_STYLE);
-					(*_ppEditView)->execute(SCI_INDICATORFILLRANGE,  targetStart, foundTextLen);
+					markRanges.push_back(targetStart);
+					markRanges.push_back(foundTextLen);
 				}
 
 				if (_env->_doMarkLine)
@@ -1664,22 +1824,22 @@ int FindReplaceDlg::processRange(ProcessOperation op, const TCHAR *txt2find, con
 
 			case ProcessMarkAllExt:
 			{
-				(*_ppEditView)->execute(SCI_SETINDICATORCURRENT,  colourStyleID);
-				(*_ppEditView)->execute(SCI_INDICATORFILLRANGE,  targetStart, foundTextLen);
+				markRanges.push_back(targetStart);
+				markRanges.push_back(foundTextLen);
 				break;
 			}
 
 			case ProcessMarkAll_2:
 			{
-				(*_ppEditView)->execute(SCI_SETINDICATORCURRENT,  SCE_UNIVERSAL_FOUND_STYLE_SMART);
-				(*_ppEditView)->execute(SCI_INDICATORFILLRANGE,  targetStart, foundTextLen);
+				markRanges.push_back(targetStart);
+				markRanges.push_back(foundTextLen);
 				break;
 			}
 
 			case ProcessMarkAll_IncSearch:
 			{
-				(*_ppEditView)->execute(SCI_SETINDICATORCURRENT,  SCE_UNIVERSAL_FOUND_STYLE_INC);
-				(*_ppEditView)->execute(SCI_INDICATORFILLRANGE,  targetStart, foundTextLen);
+				markRanges.push_back(targetStart);
+				markRanges.push_back(foundTextLen);
 				break;
 			}
 
@@ -1706,6 +1866,7 @@ int FindReplaceDlg::processRange(ProcessOperation op, const TCHAR *txt2find, con
 		//::SendMessageA(_hParent, WM_SETTEXT, 0, (LPARAM)pTextFind);
 		targetStart = (*_ppEditView)->searchInTarget(pTextFind, stringSizeFind, startRange, endRange);
 	}
+	(*_ppEditView)->fillIndicatorRanges(markIndicator, markRanges);
 	delete [] pTextFind;
 	delete [] pTextReplace;
 
@@ -1715,6 +1876,26 @@ int FindReplaceDlg::processRange(ProcessOperation op, const TCHAR *txt2find, con
 	return nbProcessed;
 }
 
+int FindReplaceDlg::findAllInHugeFile(const FindOption *opt, Buffer *pBuffer)
+{
+	const FindOption *pOptions = opt?opt:_env;
+	HugeFileView *pHugeFile = pBuffer->getHugeFileView();
+	if (!pHugeFile || !canSearchHugeFile(pOptions))
+		return -1;
+
+	// Same code page as the document, see Notepad_plus::findInCurrentFile
+	UINT codepage = (pBuffer->getUnicodeMode() == uni8Bit) ? CP_ACP : CP_UTF8;
+	HugeFileSearch search = makeHugeFileSearch(pOptions->_str2Search.c_str(), pOptions, codepage);
+	if (search._pattern.empty())
+		return 0;
+
+	FinderHugeFileHandler handler(_pFinder, pBuffer->getFullPathName(), codepage, int(search._pattern.length()));
+	int nbFound = pHugeFile->findAll(search, handler);
+	if (nbFound > 0)
+		_pFinder->addFileHitCount(nbFound);
+	return nbFound;
+}
+
 void FindReplaceDlg::replaceAllInOpenedDocs()
 {
 	::SendMessage(_hParent, WM_REPLACEALL_INOPENEDDOC, 0, 0);
@@ -31,6 +31,7 @@ class Finder;
 class Searching;
 
 class ScintillaEditView;
+class Buffer;
 class TabBar;
 class ReBar;
 
@@ -122,6 +123,9 @@ public :
 	int processAll(ProcessOperation op, const FindOption *opt, bool isEntire = false, const TCHAR *fileName = NULL, int colourStyleID = -1);
 //	int processAll(ProcessOperation op, const TCHAR *txt2find, const TCHAR *txt2replace, bool isEntire = false, const TCHAR *fileName = NULL, const FindOption *opt = NULL, int colourStyleID = -1);
 	int processRange(ProcessOperation op, const TCHAR *txt2find, const TCHAR *txt2replace, int startRange, int endRange, const TCHAR *fileName = NULL, const FindOption *opt = NULL, int colourStyleID = -1);
+	// Huge files are searched on disk, their document only holds a window of them. Returns -1 if the
+	// search cannot be streamed (regular expressions): the caller then searches the window with processAll.
+	int findAllInHugeFile(const FindOption *opt, Buffer *pBuffer);
 	void replaceAllInOpenedDocs();
 	void findAllIn(InWhat op);
 	void setSearchText(TCHAR * txt2find);
@@ -197,6 +201,9 @@ private :
 
 	void gotoCorrectTab();
 
+	bool processFindNextInHugeFile(const TCHAR *txt2find, const FindOption *pOptions, FindStatus *oFindStatus);
+	void showTextNotFound(const TCHAR *txt2find, const FindOption *pOptions);
+
 	bool isCheckedOrNot(int checkControlID) const {
 		return (BST_CHECKED == ::SendMessage(::GetDlgItem(_hSelf, checkControlID), BM_GETCHECK, 0, 0));
 	};
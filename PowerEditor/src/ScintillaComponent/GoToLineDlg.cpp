@@ -18,6 +18,7 @@
 #include "precompiled_headers.h"
 #include "ScintillaComponent/GoToLineDlg.h"
 #include "ScintillaComponent/ScintillaEditView.h"
+#include "ScintillaComponent/Buffer.h"
 #include "resource.h"
 
 BOOL CALLBACK GoToLineDlg::run_dlgProc(UINT message, WPARAM wParam, LPARAM /*lParam*/)
@@ -41,6 +42,13 @@ BOOL CALLBACK GoToLineDlg::run_dlgProc(UINT message, WPARAM wParam, LPARAM /*lPa
 
 				case IDOK :
                 {
+					if ((*_ppEditView)->getCurrentBuffer()->getHugeFileView())
+					{
+						goToInHugeFile();
+						(*_ppEditView)->getFocus();
+						return TRUE;
+					}
+
                     int line = getLine();
                     if (line != -1)
                     {
@@ -112,6 +120,27 @@ void GoToLineDlg::init( HINSTANCE hInst, HWND hParent, ScintillaEditView **ppEdi
 
 void GoToLineDlg::updateLinesNumbers() const
 {
+	HugeFileView *pHugeFile = (*_ppEditView)->getCurrentBuffer()->getHugeFileView();
+	if (pHugeFile)
+	{
+		// Lines and offsets of the whole file. Lines can only be reached once they are indexed.
+		__int64 current = 0;
+		__int64 limit = 0;
+		if (_mode == go2line)
+		{
+			current = (*_ppEditView)->getCurrentFileLine() + 1;
+			limit = pHugeFile->getLineCount();
+		}
+		else
+		{
+			current = pHugeFile->getWindowStart() + (*_ppEditView)->execute(SCI_GETCURRENTPOS);
+			limit = pHugeFile->getTextLength() - 1;
+		}
+		setNumber(ID_CURRLINE, current);
+		setNumber(ID_LASTLINE, limit);
+		return;
+	}
+
 	unsigned int current = 0;
 	unsigned int limit = 0;
 
@@ -159,3 +188,53 @@ int GoToLineDlg::getLine() const
 	int line = ::GetDlgItemInt(_hSelf, ID_GOLINE_EDIT, &isSuccessful, FALSE);
 	return (isSuccessful?line:-1);
 }
+
+// Huge files go beyond what GetDlgItemInt can read
+__int64 GoToLineDlg::getNumber() const
+{
+	TCHAR text[32];
+	::GetDlgItemText(_hSelf, ID_GOLINE_EDIT, text, 32);
+	if (!text[0])
+		return -1;
+	for (int i = 0 ; text[i] ; i++)
+	{
+		if (text[i] < '0' || text[i] > '9')
+			return -1;
+	}
+	return _ttoi64(text);
+}
+
+void GoToLineDlg::setNumber(int id, __int64 number) const
+{
+	TCHAR text[32] = TEXT("?");
+	if (number >= 0)
+		wsprintf(text, TEXT("%I64d"), number);
+	::SetDlgItemText(_hSelf, id, text);
+}
+
+void GoToLineDlg::goToInHugeFile()
+{
+	__int64 number = getNumber();
+	if (number == -1)
+		return;
+
+	if (_mode == go2line)
+	{
+		// The dialog stays open on a line which is not indexed yet
+		if (!(*_ppEditView)->gotoFileLine(number - 1))
+		{
+			updateLinesNumbers();
+			return;
+		}
+	}
+	else
+	{
+		int pos = (*_ppEditView)->loadFileRange(number, 0);
+		if (pos == -1)
+			return;
+		(*_ppEditView)->execute(SCI_ENSUREVISIBLE, (*_ppEditView)->execute(SCI_LINEFROMPOSITION, pos));
+		(*_ppEditView)->execute(SCI_GOTOPOS, pos);
+	}
+	display(false);
+	cleanLineEdit();
+}
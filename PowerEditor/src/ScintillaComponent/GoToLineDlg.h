@@ -51,6 +51,10 @@ private :
     void cleanLineEdit() const;
 
     int getLine() const;
+
+	__int64 getNumber() const;
+	void setNumber(int id, __int64 number) const;
+	void goToInHugeFile();
 };
 
 #endif //SCINTILLACOMPONENT_GOTILINEDLG_H
@@ -0,0 +1,510 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "precompiled_headers.h"
+#include "ScintillaComponent/HugeFileView.h"
+
+#include "Utf8_16.h"
+
+// Same block size as FileManager::loadFileData, so that the encoding is detected on the same data
+const size_t detectionBlockSize = 128 * 1024;
+
+const size_t indexBlockSize = 1024 * 1024;
+const size_t searchBlockSize = 1024 * 1024;
+const size_t countBlockSize = 64 * 1024;
+
+// Longest part of a line reported with a match of findAll, the Finder cuts them shorter anyway
+const size_t maxMatchLineText = 1024;
+
+static char foldCase(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+// Same word characters as Scintilla by default
+static bool isWordChar(char c)
+{
+	unsigned char ch = (unsigned char)c;
+	return (ch >= 0x80) || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || (ch == '_');
+}
+
+static bool isUtf8Continuation(char c)
+{
+	return (((unsigned char)c) & 0xC0) == 0x80;
+}
+
+HugeFileView::HugeFileView(const TCHAR *fullPath, int windowSize)
+	: _fullPath(fullPath), _windowSize(windowSize), _unicodeMode(uni8Bit), _format(-1), _eolChar('\n'),
+	_dataOffset(0), _textLength(0), _windowStart(0), _windowEnd(0), _windowFirstLine(-1),
+	_indexedLength(0), _indexedLines(0), _isIndexComplete(false), _hIndexer(NULL), _isStopping(0)
+{
+	::InitializeCriticalSection(&_lock);
+	_checkpoints.push_back(0);
+}
+
+HugeFileView::~HugeFileView()
+{
+	if (_hIndexer)
+	{
+		::InterlockedExchange(&_isStopping, 1);
+		::WaitForSingleObject(_hIndexer, INFINITE);
+		::CloseHandle(_hIndexer);
+	}
+	::DeleteCriticalSection(&_lock);
+}
+
+bool HugeFileView::open()
+{
+	FILE *fp = openFile();
+	if (!fp)
+		return false;
+
+	_fseeki64(fp, 0, SEEK_END);
+	__int64 fileSize = _ftelli64(fp);
+	rewind(fp);
+	std::vector<char> data(detectionBlockSize);
+	size_t lenRead = fread(&data[0], 1, detectionBlockSize, fp);
+	fclose(fp);
+
+	// Only the encodings whose bytes go unchanged into the document can be shown a window at a time
+	Utf8_16_Read unicodeConvertor;
+	unicodeConvertor.convert(&data[0], lenRead);
+	_unicodeMode = unicodeConvertor.getEncoding();
+	if (_unicodeMode != uni8Bit && _unicodeMode != uni7Bit && _unicodeMode != uniCookie && _unicodeMode != uniUTF8)
+		return false;
+
+	_dataOffset = (_unicodeMode == uniUTF8) ? 3 : 0;
+	_textLength = max(fileSize - _dataOffset, __int64(0));
+
+	for (size_t i = size_t(_dataOffset) ; i < lenRead ; i++)
+	{
+		if (data[i] == '\r')
+		{
+			_format = (i+1 < lenRead && data[i+1] == '\n') ? int(WIN_FORMAT) : int(MAC_FORMAT);
+			break;
+		}
+		if (data[i] == '\n')
+		{
+			_format = int(UNIX_FORMAT);
+			break;
+		}
+	}
+	_eolChar = (_format == MAC_FORMAT) ? '\r' : '\n';
+
+	_hIndexer = ::CreateThread(NULL, 0, indexerProc, this, 0, NULL);
+	if (_hIndexer)
+		::SetThreadPriority(_hIndexer, THREAD_PRIORITY_BELOW_NORMAL);
+	return true;
+}
+
+FILE * HugeFileView::openFile() const
+{
+	FILE *fp = NULL;
+	generic_fopen(fp, _fullPath.c_str(), TEXT("rb"));
+	return fp;
+}
+
+// Reads are limited to the length the file had when it was opened: what is written after is ignored
+size_t HugeFileView::readAt(FILE *fp, __int64 position, char *data, size_t length) const
+{
+	if (position >= _textLength)
+		return 0;
+	length = size_t(min(__int64(length), _textLength - position));
+	if (_fseeki64(fp, _dataOffset + position, SEEK_SET) != 0)
+		return 0;
+	return fread(data, 1, length, fp);
+}
+
+bool HugeFileView::readWindow(__int64 position, std::string & text)
+{
+	__int64 start = max(position - _windowSize / 2, __int64(0));
+	__int64 end = min(start + _windowSize, _textLength);
+	start = max(end - _windowSize, __int64(0));
+
+	// The bytes around the window tell whether it starts a line, and whether it cuts a character
+	__int64 readStart = (start > 0) ? start - 1 : 0;
+	__int64 readEnd = min(end + 1, _textLength);
+	text.resize(size_t(readEnd - readStart));
+	if (!text.empty())
+	{
+		FILE *fp = openFile();
+		if (!fp)
+			return false;
+		text.resize(readAt(fp, readStart, &text[0], text.size()));
+		fclose(fp);
+	}
+
+	// The window is cut at line boundaries, unless a line is longer than half of it.
+	// Then the cut is only kept out of the UTF-8 characters.
+	bool isUtf8 = (_unicodeMode == uniUTF8 || _unicodeMode == uniCookie);
+	size_t first = 0;
+	if (readStart < start)
+	{
+		size_t eol = text.find(_eolChar);
+		if (eol != std::string::npos && eol <= text.size() / 2)
+			first = eol + 1;
+		else
+		{
+			first = 1;
+			while (isUtf8 && first < text.size() && isUtf8Continuation(text[first]))
+				first++;
+		}
+	}
+	size_t last = size_t(min(end - readStart, __int64(text.size())));
+	if (last > first && last < text.size())
+	{
+		size_t eol = text.rfind(_eolChar, last - 1);
+		if (eol != std::string::npos && eol >= first && eol - first >= (last - first) / 2)
+			last = eol + 1;
+		else
+		{
+			while (isUtf8 && last > first && isUtf8Continuation(text[last]))
+				last--;
+		}
+	}
+	first = min(first, last);
+	text.erase(last);
+	text.erase(0, first);
+
+	_windowStart = readStart + first;
+	_windowEnd = readStart + last;
+	_windowFirstLine = -1;
+	return true;
+}
+
+__int64 HugeFileView::getWindowFirstLine()
+{
+	if (_windowFirstLine == -1)
+		_windowFirstLine = lineFromPosition(_windowStart);
+	return _windowFirstLine;
+}
+
+__int64 HugeFileView::countLines(FILE *fp, __int64 from, __int64 to) const
+{
+	std::vector<char> data(countBlockSize);
+	__int64 nbLines = 0;
+	for (__int64 position = from ; position < to ; )
+	{
+		size_t lenRead = readAt(fp, position, &data[0], size_t(min(to - position, __int64(countBlockSize))));
+		if (!lenRead)
+			break;
+		nbLines += std::count(data.begin(), data.begin() + lenRead, _eolChar);
+		position += lenRead;
+	}
+	return nbLines;
+}
+
+// Returns the start of the line nbLines lines after the one starting at from, -1 if the text ends before
+__int64 HugeFileView::skipLines(FILE *fp, __int64 from, __int64 nbLines) const
+{
+	if (nbLines == 0)
+		return from;
+
+	std::vector<char> data(countBlockSize);
+	for (__int64 position = from ; ; )
+	{
+		size_t lenRead = readAt(fp, position, &data[0], countBlockSize);
+		if (!lenRead)
+			return -1;
+		for (size_t i = 0 ; i < lenRead ; i++)
+		{
+			if (data[i] == _eolChar && --nbLines == 0)
+				return position + i + 1;
+		}
+		position += lenRead;
+	}
+}
+
+__int64 HugeFileView::lineFromPosition(__int64 position)
+{
+	if (position < 0 || position > _textLength)
+		return -1;
+
+	::EnterCriticalSection(&_lock);
+	bool isIndexed = (position <= _indexedLength);
+	size_t checkpoint = 0;
+	__int64 checkpointStart = 0;
+	if (isIndexed)
+	{
+		checkpoint = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), position) - _checkpoints.begin() - 1;
+		checkpointStart = _checkpoints[checkpoint];
+	}
+	::LeaveCriticalSection(&_lock);
+	if (!isIndexed)
+		return -1;
+
+	FILE *fp = openFile();
+	if (!fp)
+		return -1;
+	__int64 line = __int64(checkpoint) * linesPerCheckpoint + countLines(fp, checkpointStart, position);
+	fclose(fp);
+	return line;
+}
+
+__int64 HugeFileView::positionFromLine(__int64 line)
+{
+	if (line < 0)
+		return -1;
+
+	::EnterCriticalSection(&_lock);
+	bool isIndexed = (line <= _indexedLines);
+	__int64 checkpointStart = isIndexed ? _checkpoints[size_t(line / linesPerCheckpoint)] : 0;
+	::LeaveCriticalSection(&_lock);
+	if (!isIndexed)
+		return -1;
+
+	FILE *fp = openFile();
+	if (!fp)
+		return -1;
+	__int64 position = skipLines(fp, checkpointStart, line % linesPerCheckpoint);
+	fclose(fp);
+	return position;
+}
+
+__int64 HugeFileView::getLineCount()
+{
+	::EnterCriticalSection(&_lock);
+	__int64 nbLines = _isIndexComplete ? _indexedLines + 1 : _indexedLines;
+	::LeaveCriticalSection(&_lock);
+	return nbLines;
+}
+
+bool HugeFileView::isIndexComplete()
+{
+	::EnterCriticalSection(&_lock);
+	bool isComplete = _isIndexComplete;
+	::LeaveCriticalSection(&_lock);
+	return isComplete;
+}
+
+void HugeFileView::buildIndex()
+{
+	FILE *fp = openFile();
+	if (!fp)
+		return;
+
+	std::vector<char> data(indexBlockSize);
+	std::vector<__int64> checkpoints;
+	__int64 position = 0;
+	__int64 nbLines = 0;
+	while (!_isStopping && position < _textLength)
+	{
+		size_t lenRead = readAt(fp, position, &data[0], indexBlockSize);
+		if (!lenRead)
+			break;
+
+		checkpoints.clear();
+		const char *begin = &data[0];
+		const char *end = begin + lenRead;
+		for (const char *p = begin ; (p = (const char *)memchr(p, _eolChar, end - p)) != NULL ; )
+		{
+			++p;
+			if (++nbLines % linesPerCheckpoint == 0)
+				checkpoints.push_back(position + (p - begin));
+		}
+		position += lenRead;
+
+		::EnterCriticalSection(&_lock);
+		_checkpoints.insert(_checkpoints.end(), checkpoints.begin(), checkpoints.end());
+		_indexedLength = position;
+		_indexedLines = nbLines;
+		::LeaveCriticalSection(&_lock);
+	}
+	fclose(fp);
+
+	::EnterCriticalSection(&_lock);
+	_isIndexComplete = (position == _textLength);
+	::LeaveCriticalSection(&_lock);
+}
+
+DWORD WINAPI HugeFileView::indexerProc(LPVOID param)
+{
+	static_cast<HugeFileView *>(param)->buildIndex();
+	return 0;
+}
+
+// data[i - 1] and data[i + pattern length] are the characters around the match, unless they are
+// out of data: the callers make sure that only happens at the start and the end of the text.
+bool HugeFileView::isMatchAt(const HugeFileSearch & search, const char *data, size_t length, size_t i) const
+{
+	const std::string & pattern = search._pattern;
+	size_t lenPattern = pattern.length();
+	if (i + lenPattern > length)
+		return false;
+
+	if (search._isMatchCase)
+	{
+		if (data[i] != pattern[0] || memcmp(data + i, pattern.c_str(), lenPattern) != 0)
+			return false;
+	}
+	else
+	{
+		for (size_t j = 0 ; j < lenPattern ; j++)
+		{
+			if (foldCase(data[i + j]) != foldCase(pattern[j]))
+				return false;
+		}
+	}
+
+	if (search._isWholeWord)
+	{
+		if (i > 0 && isWordChar(data[i - 1]))
+			return false;
+		if (i + lenPattern < length && isWordChar(data[i + lenPattern]))
+			return false;
+	}
+	return true;
+}
+
+__int64 HugeFileView::find(const HugeFileSearch & search, __int64 from, bool isDownwards)
+{
+	__int64 lenPattern = __int64(search._pattern.length());
+	if (!lenPattern || from < 0 || from > _textLength)
+		return -1;
+
+	FILE *fp = openFile();
+	if (!fp)
+		return -1;
+
+	// Each block is read with the byte before its first candidate and the pattern length after its
+	// last one, for the whole word check and the matches crossing into the next block
+	std::vector<char> data(searchBlockSize + size_t(lenPattern) + 2);
+	__int64 found = -1;
+	if (isDownwards)
+	{
+		for (__int64 start = from ; found == -1 && start + lenPattern <= _textLength ; start += searchBlockSize)
+		{
+			__int64 readStart = (start > 0) ? start - 1 : 0;
+			size_t first = size_t(start - readStart);
+			size_t lenRead = readAt(fp, readStart, &data[0], first + searchBlockSize + size_t(lenPattern) + 1);
+			size_t last = min(first + searchBlockSize, lenRead);
+			for (size_t i = first ; i < last ; i++)
+			{
+				if (isMatchAt(search, &data[0], lenRead, i))
+				{
+					found = readStart + i;
+					break;
+				}
+			}
+		}
+	}
+	else
+	{
+		// The matches have to end at or before from
+		for (__int64 end = from - lenPattern + 1 ; found == -1 && end > 0 ; end -= searchBlockSize)
+		{
+			__int64 start = max(end - __int64(searchBlockSize), __int64(0));
+			__int64 readStart = (start > 0) ? start - 1 : 0;
+			size_t first = size_t(start - readStart);
+			size_t lenRead = readAt(fp, readStart, &data[0], size_t(end - readStart) + size_t(lenPattern) + 1);
+			for (size_t i = size_t(end - readStart) ; i > first ; i--)
+			{
+				if (isMatchAt(search, &data[0], lenRead, i - 1))
+				{
+					found = readStart + i - 1;
+					break;
+				}
+			}
+		}
+	}
+	fclose(fp);
+	return found;
+}
+
+int HugeFileView::findAll(const HugeFileSearch & search, HugeFileSearchHandler & handler)
+{
+	__int64 lenPattern = __int64(search._pattern.length());
+	if (!lenPattern)
+		return 0;
+
+	FILE *fp = openFile();
+	if (!fp)
+		return 0;
+
+	bool isUtf8 = (_unicodeMode == uniUTF8 || _unicodeMode == uniCookie);
+	std::vector<char> data(searchBlockSize + size_t(lenPattern) + 2);
+	std::vector<char> lineData(maxMatchLineText);
+	HugeFileMatch match;
+	match._line = 0;
+	__int64 lineStart = 0;
+	__int64 counted = 0;	// lines are counted up to there
+	__int64 next = 0;		// matches do not overlap
+	int nbFound = 0;
+	bool isStopped = false;
+	for (__int64 start = 0 ; !isStopped && start + lenPattern <= _textLength ; start += searchBlockSize)
+	{
+		__int64 readStart = (start > 0) ? start - 1 : 0;
+		size_t first = size_t(start - readStart);
+		size_t lenRead = readAt(fp, readStart, &data[0], first + searchBlockSize + size_t(lenPattern) + 1);
+		size_t last = min(first + searchBlockSize, lenRead);
+		for (size_t i = size_t(max(next, start) - readStart) ; i < last ; i++)
+		{
+			if (!isMatchAt(search, &data[0], lenRead, i))
+				continue;
+
+			match._position = readStart + i;
+			for (size_t j = size_t(counted - readStart) ; j < i ; j++)
+			{
+				if (data[j] == _eolChar)
+				{
+					match._line++;
+					lineStart = readStart + j + 1;
+				}
+			}
+			counted = match._position;
+			next = match._position + lenPattern;
+
+			// The line is read again, it may have started in a previous block
+			__int64 textStart = lineStart;
+			if (match._position - lineStart > __int64(maxMatchLineText / 2))
+				textStart = match._position - maxMatchLineText / 4;
+			size_t lenLine = readAt(fp, textStart, &lineData[0], maxMatchLineText);
+			size_t lineFirst = 0;
+			while (isUtf8 && textStart > lineStart && lineFirst < lenLine && isUtf8Continuation(lineData[lineFirst]))
+				lineFirst++;
+			match._startInLine = int(match._position - textStart) - int(lineFirst);
+			size_t lineEnd = lineFirst + match._startInLine;
+			while (lineEnd < lenLine && lineData[lineEnd] != '\r' && lineData[lineEnd] != '\n')
+				lineEnd++;
+			match._lineText.assign(&lineData[lineFirst], lineEnd - lineFirst);
+
+			nbFound++;
+			if (!handler.onMatch(match))
+			{
+				isStopped = true;
+				break;
+			}
+			i = size_t(next - readStart) - 1;
+		}
+
+		if (!isStopped)
+		{
+			// The rest of the block is counted before the next one is read
+			for (size_t j = size_t(counted - readStart) ; j < last ; j++)
+			{
+				if (data[j] == _eolChar)
+				{
+					match._line++;
+					lineStart = readStart + j + 1;
+				}
+			}
+			counted = max(counted, readStart + __int64(last));
+		}
+	}
+	fclose(fp);
+	return nbFound;
+}
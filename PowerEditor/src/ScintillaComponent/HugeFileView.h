@@ -0,0 +1,138 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef SCINTILLACOMPONENT_HUGEFILEVIEW_H
+#define SCINTILLACOMPONENT_HUGEFILEVIEW_H
+
+#ifndef PARAMETERS_DEF_H
+#include "Parameters_def.h"
+#endif
+
+// Size of the part of a huge file which is loaded in its document
+const int hugeFileWindowSize = 4 * 1024 * 1024;
+
+// What to look for in a huge file. The pattern is in the bytes of the file (UTF-8 or ANSI).
+// Case is folded for ASCII letters only.
+struct HugeFileSearch
+{
+	HugeFileSearch(const char *pattern, size_t length, bool isMatchCase, bool isWholeWord)
+		: _pattern(pattern, length), _isMatchCase(isMatchCase), _isWholeWord(isWholeWord) {};
+
+	std::string _pattern;
+	bool _isMatchCase;
+	bool _isWholeWord;
+};
+
+struct HugeFileMatch
+{
+	__int64 _position;		// in the text, which does not include the BOM
+	__int64 _line;			// 0 based
+	std::string _lineText;	// the line of the match, or the part of it around the match if it is too long
+	int _startInLine;		// of the match in _lineText
+};
+
+// Told about the matches of HugeFileView::findAll, in the order of the file
+class HugeFileSearchHandler
+{
+public:
+	virtual ~HugeFileSearchHandler() {};
+
+	// Returning false stops the search
+	virtual bool onMatch(const HugeFileMatch & match) = 0;
+};
+
+// Read only view of a file too big to be loaded in a document. Only a window of the file,
+// a few MB starting and ending at line boundaries, is given to the document at a time, and
+// the file stays on disk otherwise: memory does not grow with the size of the file.
+// A background thread indexes the start of every linesPerCheckpoint-th line, so that lines and
+// positions can be converted into each other once the index got that far.
+// Positions are offsets in the text of the file, the BOM excluded. Lines are counted on LF, or on
+// CR for files whose first EOL is a Macintosh one.
+class HugeFileView
+{
+public:
+	HugeFileView(const TCHAR *fullPath, int windowSize = hugeFileWindowSize);
+	~HugeFileView();
+
+	// Detects the encoding and starts the indexing. False if the file cannot be read, or if its
+	// encoding has to be converted to be displayed (UTF-16).
+	bool open();
+
+	UniMode getUnicodeMode() const { return _unicodeMode; };
+	int getFormat() const { return _format; };	// formatType of the first EOL, -1 if there is none
+	__int64 getTextLength() const { return _textLength; };
+
+	// Reads the window around position into text and makes it the current window
+	bool readWindow(__int64 position, std::string & text);
+	__int64 getWindowStart() const { return _windowStart; };
+	__int64 getWindowEnd() const { return _windowEnd; };
+	// Line of the window start, -1 if the index does not get there yet
+	__int64 getWindowFirstLine();
+
+	// -1 if the index does not get there yet
+	__int64 lineFromPosition(__int64 position);
+	__int64 positionFromLine(__int64 line);
+
+	// Number of lines indexed so far, all of them once isIndexComplete
+	__int64 getLineCount();
+	bool isIndexComplete();
+
+	// Streams through the file: returns the position of the first match starting at or after from
+	// when searching downwards, or of the last match ending at or before from otherwise. -1 if none.
+	__int64 find(const HugeFileSearch & search, __int64 from, bool isDownwards);
+
+	// Returns the number of matches, all of them reported to handler
+	int findAll(const HugeFileSearch & search, HugeFileSearchHandler & handler);
+
+	static const int linesPerCheckpoint = 1024;
+
+private:
+	generic_string _fullPath;
+	int _windowSize;
+	UniMode _unicodeMode;
+	int _format;
+	char _eolChar;
+	__int64 _dataOffset;	// length of the BOM
+	__int64 _textLength;
+
+	__int64 _windowStart;
+	__int64 _windowEnd;
+	__int64 _windowFirstLine;
+
+	CRITICAL_SECTION _lock;
+	std::vector<__int64> _checkpoints;	// start of the lines 0, linesPerCheckpoint, 2*linesPerCheckpoint...
+	__int64 _indexedLength;
+	__int64 _indexedLines;				// number of EOL in the first _indexedLength bytes
+	bool _isIndexComplete;
+	HANDLE _hIndexer;
+	volatile LONG _isStopping;
+
+	FILE * openFile() const;
+	size_t readAt(FILE *fp, __int64 position, char *data, size_t length) const;
+	__int64 countLines(FILE *fp, __int64 from, __int64 to) const;
+	__int64 skipLines(FILE *fp, __int64 from, __int64 nbLines) const;
+	bool isMatchAt(const HugeFileSearch & search, const char *data, size_t length, size_t i) const;
+	void buildIndex();
+
+	static DWORD WINAPI indexerProc(LPVOID param);
+
+	// Private so HugeFileView objects can not be copied
+	HugeFileView(const HugeFileView&);
+	const HugeFileView& operator= (const HugeFileView&);
+};
+
+#endif //SCINTILLACOMPONENT_HUGEFILEVIEW_H
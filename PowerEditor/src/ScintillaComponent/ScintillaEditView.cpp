@@ -54,6 +54,9 @@ const int ScintillaEditView::_SC_MARGIN_FOLDER = 2;
 //const int ScintillaEditView::_SC_MARGIN_MODIFMARKER = 3;
 
 WNDPROC ScintillaEditView::_scintillaDefaultProc = NULL;
+
+long ScintillaEditView::_nbFullRedraws = 0;
+DWORD ScintillaEditView::_fullRedrawsCountStart = 0;
 /*
 SC_MARKNUM_*     | Arrow               Plus/minus           Circle tree                 Box tree
 -------------------------------------------------------------------------------------------------------------
@@ -2469,55 +2472,8 @@ ColumnModeInfos ScintillaEditView::getColumnModeSelectInfo()
 
 void ScintillaEditView::columnReplace(ColumnModeInfos & cmi, const TCHAR *str)
 {
-	int totalDiff = 0;
-	for (size_t i = 0 ; i < cmi.size() ; i++)
-	{
-		if (cmi[i].isValid())
-		{
-			int len2beReplace = cmi[i]._selRpos - cmi[i]._selLpos;
-			int diff = lstrlen(str) - len2beReplace;
-
-			cmi[i]._selLpos += totalDiff;
-			cmi[i]._selRpos += totalDiff;
-			bool hasVirtualSpc = cmi[i]._nbVirtualAnchorSpc > 0;
-
-			if (hasVirtualSpc) // if virtual space is present, then insert space
-			{
-				for (int j = 0, k = cmi[i]._selLpos; j < cmi[i]._nbVirtualCaretSpc ; j++, k++)
-				{
-					execute(SCI_INSERTTEXT, k, (LPARAM)" ");
-				}
-				cmi[i]._selLpos += cmi[i]._nbVirtualAnchorSpc;
-				cmi[i]._selRpos += cmi[i]._nbVirtualCaretSpc;
-			}
-
-			execute(SCI_SETTARGETSTART, cmi[i]._selLpos);
-			execute(SCI_SETTARGETEND, cmi[i]._selRpos);
-
-#ifdef UNICODE
-			WcharMbcsConvertor *wmc = WcharMbcsConvertor::getInstance();
-			unsigned int cp = execute(SCI_GETCODEPAGE);
-			const char *strA = wmc->wchar2char(str, cp);
-			execute(SCI_REPLACETARGET, (WPARAM)-1, (LPARAM)strA);
-#else
-			execute(SCI_REPLACETARGET, (WPARAM)-1, (LPARAM)str);
-#endif
-
-			if (hasVirtualSpc)
-			{
-				totalDiff += cmi[i]._nbVirtualAnchorSpc + lstrlen(str);
-
-				// Now there's no more virtual space
-				cmi[i]._nbVirtualAnchorSpc = 0;
-				cmi[i]._nbVirtualCaretSpc = 0;
-			}
-			else
-			{
-				totalDiff += diff;
-			}
-			cmi[i]._selRpos += diff;
-		}
-	}
+	std::vector<generic_string> strs(cmi.size(), str);
+	columnReplace(cmi, strs);
 }
 
 void ScintillaEditView::columnReplace(ColumnModeInfos & cmi, int initial, int incr, UCHAR format)
@@ -2552,54 +2508,103 @@ void ScintillaEditView::columnReplace(ColumnModeInfos & cmi, int initial, int in
 	const int stringSize = 512;
 	TCHAR str[stringSize];
 
-	int totalDiff = 0;
+	std::vector<generic_string> strs(cmi.size());
+	for (size_t i = 0 ; i < cmi.size() ; i++)
+	{
+		if (cmi[i].isValid())
+		{
+			int2str(str, stringSize, initial, base, nb, isZeroLeading);
+			strs[i] = str;
+			initial += incr;
+		}
+	}
+	columnReplace(cmi, strs);
+}
+
+// Replaces the selection of each valid cmi by its string of strs, all in one go.
+// A selection in virtual space gets the spaces up to its left column before the string.
+void ScintillaEditView::columnReplace(ColumnModeInfos & cmi, const std::vector<generic_string> & strs)
+{
+	std::vector<Sci_RangeReplacement> ranges;
+	std::vector<std::string> texts;
+	ranges.reserve(cmi.size());
+	texts.reserve(cmi.size());
 	for (size_t i = 0 ; i < cmi.size() ; i++)
 	{
 		if (cmi[i].isValid())
 		{
-			int len2beReplace = cmi[i]._selRpos - cmi[i]._selLpos;
-			int diff = nb - len2beReplace;
+			int nbSpace = min(cmi[i]._nbVirtualAnchorSpc, cmi[i]._nbVirtualCaretSpc);
+			texts.push_back(std::string(nbSpace, ' ') + documentText(strs[i].c_str()));
+			Sci_RangeReplacement range = {cmi[i]._selLpos, cmi[i]._selRpos - cmi[i]._selLpos, NULL, long(texts.back().length())};
+			ranges.push_back(range);
+		}
+	}
+	replaceRanges(ranges, texts);
 
-			cmi[i]._selLpos += totalDiff;
-			cmi[i]._selRpos += totalDiff;
+	// Select the strings where they are now
+	int totalDiff = 0;
+	size_t j = 0;
+	for (size_t i = 0 ; i < cmi.size() ; i++)
+	{
+		if (cmi[i].isValid())
+		{
+			int nbSpace = min(cmi[i]._nbVirtualAnchorSpc, cmi[i]._nbVirtualCaretSpc);
+			cmi[i]._selLpos += totalDiff + nbSpace;
+			cmi[i]._selRpos = cmi[i]._selLpos + int(texts[j].length()) - nbSpace;
+			totalDiff += int(ranges[j].lengthText - ranges[j].lengthDelete);
+
+			// Now there's no more virtual space
+			cmi[i]._nbVirtualAnchorSpc = 0;
+			cmi[i]._nbVirtualCaretSpc = 0;
+			j++;
+		}
+	}
+}
 
-			int2str(str, stringSize, initial, base, nb, isZeroLeading);
+void ScintillaEditView::columnInsert(int firstLine, int column, const std::vector<generic_string> & strs)
+{
+	std::vector<Sci_RangeReplacement> ranges(strs.size());
+	std::vector<std::string> texts(strs.size());
+	for (size_t i = 0 ; i < strs.size() ; i++)
+	{
+		int line = firstLine + int(i);
+		int lineEnd = execute(SCI_GETLINEENDPOSITION, line);
+		int lineEndCol = execute(SCI_GETCOLUMN, lineEnd);
+		if (lineEndCol < column)
+		{
+			texts[i].assign(column - lineEndCol, ' ');
+			ranges[i].position = lineEnd;
+		}
+		else
+		{
+			ranges[i].position = execute(SCI_FINDCOLUMN, line, column);
+		}
+		texts[i] += documentText(strs[i].c_str());
+		ranges[i].lengthDelete = 0;
+		ranges[i].lengthText = long(texts[i].length());
+	}
+	replaceRanges(ranges, texts);
+}
 
-			bool hasVirtualSpc = cmi[i]._nbVirtualAnchorSpc > 0;
-			if (hasVirtualSpc) // if virtual space is present, then insert space
-			{
-				for (int j = 0, k = cmi[i]._selLpos; j < cmi[i]._nbVirtualCaretSpc ; j++, k++)
-				{
-					execute(SCI_INSERTTEXT, k, (LPARAM)" ");
-				}
-				cmi[i]._selLpos += cmi[i]._nbVirtualAnchorSpc;
-				cmi[i]._selRpos += cmi[i]._nbVirtualCaretSpc;
-			}
-			execute(SCI_SETTARGETSTART, cmi[i]._selLpos);
-			execute(SCI_SETTARGETEND, cmi[i]._selRpos);
+std::string ScintillaEditView::documentText(const TCHAR *str) const
+{
 #ifdef UNICODE
-			WcharMbcsConvertor *wmc = WcharMbcsConvertor::getInstance();
-			unsigned int cp = execute(SCI_GETCODEPAGE);
-			const char *strA = wmc->wchar2char(str, cp);
-			execute(SCI_REPLACETARGET, (WPARAM)-1, (LPARAM)strA);
+	WcharMbcsConvertor *wmc = WcharMbcsConvertor::getInstance();
+	unsigned int cp = execute(SCI_GETCODEPAGE);
+	return wmc->wchar2char(str, cp);
 #else
-			execute(SCI_REPLACETARGET, (WPARAM)-1, (LPARAM)str);
+	return str;
 #endif
-			initial += incr;
-			if (hasVirtualSpc)
-			{
-				totalDiff += cmi[i]._nbVirtualAnchorSpc + lstrlen(str);
-				// Now there's no more virtual space
-				cmi[i]._nbVirtualAnchorSpc = 0;
-				cmi[i]._nbVirtualCaretSpc = 0;
-			}
-			else
-			{
-				totalDiff += diff;
-			}
-			cmi[i]._selRpos += diff;
-		}
-	}
+}
+
+// texts[i] is the text of ranges[i], given apart so that it lives until the ranges are replaced
+int ScintillaEditView::replaceRanges(std::vector<Sci_RangeReplacement> & ranges, const std::vector<std::string> & texts) const
+{
+	if (ranges.empty())
+		return 0;
+	for (size_t i = 0 ; i < ranges.size() ; i++)
+		ranges[i].text = texts[i].c_str();
+	return execute(SCI_REPLACERANGES, ranges.size(), (LPARAM)&ranges[0]);
 }
 
 
@@ -2756,10 +2761,12 @@ void ScintillaEditView::runMarkers(bool doHide, int searchStart, bool endOfDoc,
 				Set last start to lastchild
 	*/
 	int maxLines = execute(SCI_GETLINECOUNT);
+	const int hideLinesMask = (1 << MARK_HIDELINESBEGIN) | (1 << MARK_HIDELINESEND);
 	if (doHide) {
 		int startHiding = searchStart;
 		bool isInSection = false;
-		for(int i = searchStart; i < maxLines; i++) {
+		// Only the lines holding a marker matter here, Scintilla finds them without scanning the document
+		for(int i = execute(SCI_MARKERNEXT, searchStart, hideLinesMask); i != -1; i = execute(SCI_MARKERNEXT, i+1, hideLinesMask)) {
 			int state = execute(SCI_MARKERGET, i);
 			if ( ((state & (1 << MARK_HIDELINESEND)) != 0) ) {
 				if (isInSection) {
@@ -2780,6 +2787,12 @@ void ScintillaEditView::runMarkers(bool doHide, int searchStart, bool endOfDoc,
 		int startShowing = searchStart;
 		bool isInSection = false;
 		for(int i = searchStart; i < maxLines; i++) {
+			if (!isInSection) {
+				// Fold headers only matter inside a section, jump to the next marker
+				i = execute(SCI_MARKERNEXT, i, hideLinesMask);
+				if (i == -1)
+					break;
+			}
 			int state = execute(SCI_MARKERGET, i);
 			if ( ((state & (1 << MARK_HIDELINESEND)) != 0) ) {
 				if (doDelete)
@@ -3161,6 +3174,13 @@ long ScintillaEditView::lastZeroBasedLineNumber() const
 	return execute(SCI_LINEFROMPOSITION, endPos);
 }
 
+void ScintillaEditView::getMarkedLines(int markerMask, std::vector<int> & lines) const
+{
+	lines.resize(execute(SCI_MARKERGETLINES, markerMask));
+	if (!lines.empty())
+		execute(SCI_MARKERGETLINES, markerMask, reinterpret_cast<LPARAM>(&lines[0]));
+}
+
 long ScintillaEditView::getCurrentXOffset() const
 {
 	return long(execute(SCI_GETXOFFSET));
@@ -3191,12 +3211,125 @@ long ScintillaEditView::getTextHeight() const
 	return long(execute(SCI_TEXTHEIGHT));
 }
 
+bool ScintillaEditView::getLinesRect(int firstLine, int lastLine, RECT & rc) const
+{
+	getClientRect(rc);
+	int top = int(execute(SCI_POINTYFROMPOSITION, 0, execute(SCI_POSITIONFROMLINE, firstLine)));
+	rc.top = max(rc.top, long(top));
+	if (lastLine != -1)
+	{
+		// The end of the line is on its last display line when it is wrapped
+		int bottom = int(execute(SCI_POINTYFROMPOSITION, 0, execute(SCI_GETLINEENDPOSITION, lastLine)) + execute(SCI_TEXTHEIGHT, lastLine));
+		rc.bottom = min(rc.bottom, long(bottom));
+	}
+	return rc.top < rc.bottom;
+}
+
+void ScintillaEditView::invalidateLines(int firstLine, int lastLine) const
+{
+	RECT rc;
+	if (getLinesRect(firstLine, lastLine, rc))
+		::InvalidateRect(_hSelf, &rc, FALSE);
+}
+
+void ScintillaEditView::redraw() const
+{
+	_nbFullRedraws++;
+	DWORD now = ::GetTickCount();
+	if (now - _fullRedrawsCountStart >= 1000)
+	{
+		debugf(TEXT("ScintillaEditView: %ld full redraws in %lu ms\n"), _nbFullRedraws, now - _fullRedrawsCountStart);
+		_nbFullRedraws = 0;
+		_fullRedrawsCountStart = now;
+	}
+	Window::redraw();
+}
+
 void ScintillaEditView::gotoLine( int line )
 {
 	if (line < execute(SCI_GETLINECOUNT))
 		execute(SCI_GOTOLINE,line);
 }
 
+int ScintillaEditView::loadFileRange(__int64 position, int length)
+{
+	HugeFileView *pHugeFile = _currentBuffer->getHugeFileView();
+	if (!pHugeFile)
+		return -1;
+
+	if (position < pHugeFile->getWindowStart() || position + length > pHugeFile->getWindowEnd())
+		MainFileManager->moveFileWindow(_currentBuffer, position);
+	if (position < pHugeFile->getWindowStart() || position > pHugeFile->getWindowEnd())
+		return -1;
+	return int(position - pHugeFile->getWindowStart());
+}
+
+bool ScintillaEditView::gotoFileLine(__int64 line)
+{
+	HugeFileView *pHugeFile = _currentBuffer->getHugeFileView();
+	if (!pHugeFile)
+		return false;
+
+	__int64 position = pHugeFile->positionFromLine(line);
+	if (position == -1)
+		return false;
+	int pos = loadFileRange(position, 0);
+	if (pos == -1)
+		return false;
+	int docLine = int(execute(SCI_LINEFROMPOSITION, pos));
+	execute(SCI_ENSUREVISIBLE, docLine);
+	execute(SCI_GOTOLINE, docLine);
+	return true;
+}
+
+__int64 ScintillaEditView::getCurrentFileLine()
+{
+	HugeFileView *pHugeFile = _currentBuffer->getHugeFileView();
+	if (!pHugeFile)
+		return getCurrentLineNumber();
+
+	__int64 windowFirstLine = pHugeFile->getWindowFirstLine();
+	if (windowFirstLine == -1)
+		return -1;
+	return windowFirstLine + getCurrentLineNumber();
+}
+
+void ScintillaEditView::slideFileWindow()
+{
+	HugeFileView *pHugeFile = _currentBuffer->getHugeFileView();
+	if (!pHugeFile)
+		return;
+
+	int docLength = getCurrentDocLen();
+	int firstVisibleLine = int(execute(SCI_GETFIRSTVISIBLELINE));
+	int firstDocLine = int(execute(SCI_DOCLINEFROMVISIBLE, firstVisibleLine));
+	int lastDocLine = int(execute(SCI_DOCLINEFROMVISIBLE, firstVisibleLine + execute(SCI_LINESONSCREEN)));
+	int firstVisible = int(execute(SCI_POSITIONFROMLINE, firstDocLine));
+	int lastVisible = int(execute(SCI_GETLINEENDPOSITION, lastDocLine));
+
+	// Within the last eighth of the window on either side, as long as the file goes on
+	int edge = docLength / 8;
+	bool isNearStart = (firstVisible < edge) && (pHugeFile->getWindowStart() > 0);
+	bool isNearEnd = (lastVisible > docLength - edge) && (pHugeFile->getWindowEnd() < pHugeFile->getTextLength());
+	if (!isNearStart && !isNearEnd)
+		return;
+
+	__int64 windowStart = pHugeFile->getWindowStart();
+	__int64 firstPosition = windowStart + firstVisible;
+	__int64 caret = windowStart + execute(SCI_GETCURRENTPOS);
+	__int64 anchor = windowStart + execute(SCI_GETANCHOR);
+	if (!MainFileManager->moveFileWindow(_currentBuffer, windowStart + (firstVisible + lastVisible) / 2))
+		return;
+
+	// The selection is kept if it is still in the window
+	windowStart = pHugeFile->getWindowStart();
+	__int64 windowEnd = pHugeFile->getWindowEnd();
+	if (caret >= windowStart && caret <= windowEnd && anchor >= windowStart && anchor <= windowEnd)
+		execute(SCI_SETSEL, int(anchor - windowStart), int(caret - windowStart));
+	int firstLine = int(execute(SCI_LINEFROMPOSITION, int(max(firstPosition - windowStart, __int64(0)))));
+	execute(SCI_SETFIRSTVISIBLELINE, execute(SCI_VISIBLEFROMDOCLINE, firstLine));
+}
+
 long ScintillaEditView::getCurrentColumnNumber() const
 {
 	return long(execute(SCI_GETCOLUMN, execute(SCI_GETCURRENTPOS)));
@@ -3301,6 +3434,14 @@ void ScintillaEditView::clearIndicator( int indicatorNumber )
 	execute(SCI_INDICATORCLEARRANGE, docStart, docEnd-docStart);
 }
 
+void ScintillaEditView::fillIndicatorRanges(int indicatorNumber, const std::vector<int> & ranges) const
+{
+	if (ranges.empty())
+		return;
+	execute(SCI_SETINDICATORCURRENT, indicatorNumber);
+	execute(SCI_INDICATORFILLRANGES, ranges.size() / 2, (LPARAM)&ranges[0]);
+}
+
 bool ScintillaEditView::isSelecting() const
 {
 	static CharacterRange previousSelRange;
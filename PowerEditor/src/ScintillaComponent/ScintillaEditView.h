@@ -265,6 +265,9 @@ public:
 	long getCurrentLineNumber()const;
 	long lastZeroBasedLineNumber() const;
 
+	// Lines holding at least one of the markers in markerMask, in increasing order
+	void getMarkedLines(int markerMask, std::vector<int> & lines) const;
+
 	long getCurrentXOffset()const;
 	void setCurrentXOffset(long xOffset);
 
@@ -275,8 +278,25 @@ public:
 
 	long getTextHeight()const;
 
+	// Repaint only the band of the view showing these lines, lastLine == -1 going down to the bottom
+	void invalidateLines(int firstLine, int lastLine) const;
+
+	// Repaints the whole window. Counted, and the rate sent to the debug output, since edits should not need it.
+	virtual void redraw() const;
+
 	void gotoLine(int line);
 
+	// Huge files, whose document only holds a window of the file (see HugeFileView).
+	// Moves the window if the text range of the file is not in it, and returns where the range starts
+	// in the document. -1 if the current buffer is not a huge file.
+	int loadFileRange(__int64 position, int length);
+	// False if the line is not indexed yet
+	bool gotoFileLine(__int64 line);
+	// Line of the caret in the whole file, -1 if it is not known yet
+	__int64 getCurrentFileLine();
+	// Moves the window once the view gets close to one of its ends, the same text staying in view
+	void slideFileWindow();
+
 	long getCurrentColumnNumber() const;
 
 	long getSelectedByteNumber() const;
@@ -321,9 +341,13 @@ public:
 
 	void columnReplace(ColumnModeInfos & cmi, const TCHAR *str);
 	void columnReplace(ColumnModeInfos & cmi, int initial, int incr, UCHAR format);
+	// Inserts strs[i] at column of line firstLine+i, padding the shorter lines with spaces
+	void columnInsert(int firstLine, int column, const std::vector<generic_string> & strs);
 
 	void foldChanged(int line, int levelNow, int levelPrev);
 	void clearIndicator(int indicatorNumber);
+	// ranges holds (start, length) pairs, filled at once with a single redraw
+	void fillIndicatorRanges(int indicatorNumber, const std::vector<int> & ranges) const;
 
 	static LanguageName ScintillaEditView::langNames[L_EXTERNAL+1];
 
@@ -455,10 +479,16 @@ protected:
 	void setTabSettings(Lang *lang);
 	std::pair<int, int> getWordRange();
 	bool expandWordSelection();
+	int replaceRanges(std::vector<Sci_RangeReplacement> & ranges, const std::vector<std::string> & texts) const;
 
 private:
+	static long _nbFullRedraws;
+	static DWORD _fullRedrawsCountStart;
 
 	void reapplyHotspotStyles();
+	bool getLinesRect(int firstLine, int lastLine, RECT & rc) const;
+	void columnReplace(ColumnModeInfos & cmi, const std::vector<generic_string> & strs);
+	std::string documentText(const TCHAR *str) const;
 };
 
 #endif //SCINTILLACOMPONENT_SCINTILLAEDITVIEW_H
@@ -93,9 +93,8 @@ void SmartHighlighter::highlightView(ScintillaEditView * pHighlightView)
 	fo._isMatchCase = false;
 	fo._isWholeWord = true;
 
-	WcharMbcsConvertor *wmc = WcharMbcsConvertor::getInstance();
 	unsigned int cp = pHighlightView->execute(SCI_GETCODEPAGE);
-	const TCHAR * text2FindW = wmc->char2wchar(text2Find, cp);
+	const TCHAR * text2FindW = _wmc.char2wchar(text2Find, cp);
 	const TCHAR * searchText = text2FindW;
 
 	delete [] text2Find;
@@ -28,6 +28,7 @@ public:
 	void highlightView(ScintillaEditView * pHighlightView);
 private:
 	FindReplaceDlg * _pFRDlg;
+	WcharMbcsConvertor _wmc;	// own convertor: the searched text must survive the conversions done while searching
 
 	bool isQualifiedWord(const char *str) const;
 	bool isWordChar(char ch) const;
@@ -0,0 +1,319 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include "ScintillaComponent/XmlTagIndex.h"
+
+// Big enough for the window to cross the gap of Scintilla's buffer only once in a while
+const int readerWindowSize = 64 * 1024;
+
+// Reads the document through a window moving forward, reloaded when a position out of it is asked
+class TextReader
+{
+public:
+	TextReader(XmlTagIndex::TextSource & text, int docLen) : _text(text), _docLen(docLen), _window(NULL), _windowStart(0), _windowEnd(0) {};
+
+	// pos must be less than the length of the document
+	char charAt(int pos) {
+		if (pos < _windowStart || pos >= _windowEnd)
+			load(pos);
+		return _window[pos - _windowStart];
+	};
+
+	int find(char c, int pos) {
+		while (pos < _docLen)
+		{
+			if (pos < _windowStart || pos >= _windowEnd)
+				load(pos);
+			const char *found = (const char *)memchr(_window + (pos - _windowStart), c, _windowEnd - pos);
+			if (found)
+				return _windowStart + int(found - _window);
+			pos = _windowEnd;
+		}
+		return -1;
+	};
+
+private:
+	XmlTagIndex::TextSource & _text;
+	int _docLen;
+	const char *_window;
+	int _windowStart;
+	int _windowEnd;
+
+	void load(int pos) {
+		_windowStart = pos;
+		_windowEnd = min(_docLen, pos + readerWindowSize);
+		_window = _text.rangePointer(_windowStart, _windowEnd - _windowStart);
+	};
+
+	TextReader(const TextReader&);
+	const TextReader& operator= (const TextReader&);
+};
+
+static bool isTagNameChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '_' || c == ':';
+}
+
+// Looks for the next tag from pos. Returns where to go on looking for the following one, -1 if there
+// are no more tags; name is left empty if what was found from pos is not a tag.
+static int scanTag(TextReader & reader, int docLen, int pos, XmlTagIndex::Tag & tag, std::string & name)
+{
+	name.clear();
+	int ltPos = reader.find('<', pos);
+	if (ltPos == -1)
+		return -1;
+
+	int i = ltPos + 1;
+	bool isClose = (i < docLen && reader.charAt(i) == '/');
+	if (isClose)
+		i++;
+
+	int nameStart = i;
+	for (; i < docLen && isTagNameChar(reader.charAt(i)) ; i++)
+	{
+		char c = reader.charAt(i);
+		name += (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+	}
+	int nameEnd = i;
+
+	for (; i < docLen ; i++)
+	{
+		char c = reader.charAt(i);
+		if (c == '<')
+		{
+			// Not a tag, but maybe the next one
+			name.clear();
+			return i;
+		}
+		if (c == '>')
+			break;
+	}
+	if (i == docLen)
+	{
+		// Neither '<' nor '>' up to the end
+		name.clear();
+		return -1;
+	}
+
+	if (nameEnd == nameStart)
+		return i + 1;
+
+	tag._start = ltPos;
+	tag._nameEnd = nameEnd;
+	tag._end = i + 1;
+	if (isClose)
+		tag._kind = XmlTagIndex::closeTag;
+	else if (i - 1 >= nameEnd && reader.charAt(i - 1) == '/')
+		tag._kind = XmlTagIndex::singleTag;
+	else
+		tag._kind = XmlTagIndex::openTag;
+	return i + 1;
+}
+
+void XmlTagIndex::textModified(int pos, int len, bool isInsertion, int docLenAfter)
+{
+	if (!_isBuilt)
+		return;
+
+	// Whatever comes after the modified text is unchanged, and at the same distance from the end
+	int cleanSuffixLen = docLenAfter - (isInsertion ? pos + len : pos);
+	if (!_isDirty)
+	{
+		_isDirty = true;
+		_dirtyStart = pos;
+		_cleanSuffixLen = cleanSuffixLen;
+	}
+	else
+	{
+		_dirtyStart = min(_dirtyStart, pos);
+		_cleanSuffixLen = min(_cleanSuffixLen, cleanSuffixLen);
+	}
+}
+
+void XmlTagIndex::sync(TextSource & text)
+{
+	int docLen = text.length();
+	if (_isBuilt && !_isDirty)
+	{
+		if (docLen == _docLen)
+			return;
+		// A modification was not reported, nothing can be trusted
+		_isBuilt = false;
+	}
+	if (!_isBuilt)
+	{
+		_tags.clear();
+		_rankInName.clear();
+		_tagsByName.clear();
+	}
+
+	size_t lower = 0;
+	int pos = 0;
+	int cleanSuffixStart = docLen;
+	int delta = docLen - _docLen;
+
+	if (_isBuilt)
+	{
+		// Keep the tags ending before the first modification, and start again from the last one
+		size_t upper = _tags.size();
+		while (lower < upper)
+		{
+			size_t middle = (lower + upper) / 2;
+			if (_tags[middle]._end <= _dirtyStart)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+		if (lower)
+			pos = _tags[lower - 1]._end;
+		cleanSuffixStart = docLen - _cleanSuffixLen;
+	}
+
+	// The tags from lower to oldTag are replaced by the ones tokenized again, those after are kept
+	std::vector<Tag> tags;
+	size_t oldTag = lower;
+	bool isSuffixKept = false;
+	TextReader reader(text, docLen);
+	std::string name;
+	while (pos != -1 && pos < docLen)
+	{
+		if (_isBuilt && pos >= cleanSuffixStart)
+		{
+			// The text from here is the same as from oldPos before. If oldPos was not in the middle
+			// of a tag, tokenizing it again would give the old tags back, only moved.
+			int oldPos = pos - delta;
+			while (oldTag < _tags.size() && _tags[oldTag]._end <= oldPos)
+				oldTag++;
+			if (oldTag == _tags.size() || _tags[oldTag]._start >= oldPos)
+			{
+				isSuffixKept = true;
+				break;
+			}
+		}
+
+		Tag tag;
+		pos = scanTag(reader, docLen, pos, tag, name);
+		if (!name.empty())
+		{
+			tag._nameId = nameId(name);
+			tags.push_back(tag);
+		}
+	}
+
+	if (!isSuffixKept)
+		oldTag = _tags.size();
+
+	spliceTags(lower, oldTag, tags, delta);
+	_docLen = docLen;
+	_isBuilt = true;
+	_isDirty = false;
+}
+
+int XmlTagIndex::findTag(int pos) const
+{
+	// Last tag starting before pos
+	size_t lower = 0;
+	size_t upper = _tags.size();
+	while (lower < upper)
+	{
+		size_t middle = (lower + upper) / 2;
+		if (_tags[middle]._start < pos)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	if (lower == 0 || pos >= _tags[lower - 1]._end)
+		return -1;
+	return int(lower - 1);
+}
+
+int XmlTagIndex::nameId(const std::string & name)
+{
+	std::map<std::string, int>::const_iterator it = _nameIds.find(name);
+	if (it != _nameIds.end())
+		return it->second;
+
+	int id = int(_nameIds.size());
+	_nameIds[name] = id;
+	return id;
+}
+
+// The tags before first and after last stay where they are in _tags, the ones after are only moved
+// by delta. Only the name lists of the tags removed or added are rebuilt past them: the others just
+// get the indexes after last shifted, their ranks stay the same.
+void XmlTagIndex::spliceTags(size_t first, size_t last, const std::vector<Tag> & newTags, int delta)
+{
+	std::vector<int> changedNames;
+	std::vector< std::pair<int, int> > added;	// name id and index of each new tag
+	for (size_t i = first ; i < last ; i++)
+		changedNames.push_back(_tags[i]._nameId);
+	for (size_t i = 0 ; i < newTags.size() ; i++)
+	{
+		changedNames.push_back(newTags[i]._nameId);
+		added.push_back(std::make_pair(newTags[i]._nameId, int(first + i)));
+	}
+	std::sort(changedNames.begin(), changedNames.end());
+	changedNames.erase(std::unique(changedNames.begin(), changedNames.end()), changedNames.end());
+	std::sort(added.begin(), added.end());
+
+	_tags.erase(_tags.begin() + first, _tags.begin() + last);
+	_tags.insert(_tags.begin() + first, newTags.begin(), newTags.end());
+	if (delta)
+	{
+		for (size_t i = first + newTags.size() ; i < _tags.size() ; i++)
+		{
+			_tags[i]._start += delta;
+			_tags[i]._nameEnd += delta;
+			_tags[i]._end += delta;
+		}
+	}
+	_rankInName.erase(_rankInName.begin() + first, _rankInName.begin() + last);
+	_rankInName.insert(_rankInName.begin() + first, newTags.size(), 0);
+
+	int shift = int(newTags.size()) - int(last - first);
+	_tagsByName.resize(_nameIds.size());
+	size_t nextChanged = 0;
+	std::vector< std::pair<int, int> >::const_iterator nextAdded = added.begin();
+	for (size_t id = 0 ; id < _tagsByName.size() ; id++)
+	{
+		bool isChanged = (nextChanged < changedNames.size() && changedNames[nextChanged] == int(id));
+		if (!isChanged && !shift)
+			continue;
+
+		std::vector<int> & sameName = _tagsByName[id];
+		size_t rank = std::lower_bound(sameName.begin(), sameName.end(), int(first)) - sameName.begin();
+		if (isChanged)
+			sameName.erase(sameName.begin() + rank, std::lower_bound(sameName.begin() + rank, sameName.end(), int(last)));
+		if (shift)
+		{
+			for (size_t i = rank ; i < sameName.size() ; i++)
+				sameName[i] += shift;
+		}
+		if (!isChanged)
+			continue;
+
+		nextChanged++;
+		std::vector<int> indexes;
+		for (; nextAdded != added.end() && nextAdded->first == int(id) ; ++nextAdded)
+			indexes.push_back(nextAdded->second);
+		sameName.insert(sameName.begin() + rank, indexes.begin(), indexes.end());
+		for (size_t i = rank ; i < sameName.size() ; i++)
+			_rankInName[sameName[i]] = int(i);
+	}
+}
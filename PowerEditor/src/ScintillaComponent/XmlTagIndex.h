@@ -0,0 +1,101 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef SCINTILLACOMPONENT_XMLTAGINDEX_H
+#define SCINTILLACOMPONENT_XMLTAGINDEX_H
+
+// Positions of all the tags of a document, so that matching tags can be found
+// without searching the text each time the caret moves.
+// Tags are recognized the way XmlMatchedTagsHighlighter always did: '<' or "</"
+// directly followed by a name, up to the first '>'; a '<' met before the '>' means
+// there is no tag there. Comments and script zones are not told apart here, since
+// their styles are only known where the lexer went: that is checked at lookup.
+//
+// The index is brought up to date lazily by sync(). In between, textModified() only
+// narrows down the part of the document which changed, so that sync() only has to
+// tokenize again from the last tag before the first modification up to the point
+// where the text and the tags are the same as before, just moved. The tags around are
+// kept in place, and the name lists are only rebuilt for the names of the tags which changed.
+class XmlTagIndex
+{
+public:
+	enum TagKind {openTag, closeTag, singleTag};
+
+	struct Tag {
+		int _start;		// position of '<'
+		int _nameEnd;
+		int _end;		// position after '>'
+		int _nameId;	// tags with the same name (case insensitive) have the same id
+		TagKind _kind;
+	};
+
+	// Gives access to the document by ranges, so that it can be read straight from
+	// Scintilla's buffer. A pointer returned may be invalidated by the next call.
+	class TextSource {
+	public:
+		virtual ~TextSource() {};
+		virtual int length() = 0;
+		virtual const char * rangePointer(int start, int len) = 0;
+	};
+
+	XmlTagIndex() : _isBuilt(false), _isDirty(false), _docLen(0), _dirtyStart(0), _cleanSuffixLen(0) {};
+
+	// To be called for each insertion or deletion, docLenAfter being the length of the document
+	// once it is done. Reporting the same modification several times (once per view showing the
+	// document) makes no difference.
+	void textModified(int pos, int len, bool isInsertion, int docLenAfter);
+
+	void sync(TextSource & text);
+
+	int nbTags() const {
+		return int(_tags.size());
+	};
+
+	const Tag & tagAt(int index) const {
+		return _tags[index];
+	};
+
+	// Index of the tag containing pos (strictly after its '<' and before its end), -1 if none
+	int findTag(int pos) const;
+
+	// Indexes of the tags named nameId, in the document order
+	const std::vector<int> & tagsNamed(int nameId) const {
+		return _tagsByName[nameId];
+	};
+
+	// Position of the tag in tagsNamed(tagAt(index)._nameId)
+	int rankInName(int index) const {
+		return _rankInName[index];
+	};
+
+private:
+	std::vector<Tag> _tags;
+	std::vector<int> _rankInName;
+	std::vector< std::vector<int> > _tagsByName;
+	std::map<std::string, int> _nameIds;
+
+	bool _isBuilt;
+	bool _isDirty;
+	int _docLen;			// length of the document when the index was last synced
+	int _dirtyStart;		// text before is unchanged since the last sync
+	int _cleanSuffixLen;	// so many characters at the end are unchanged since the last sync
+
+	int nameId(const std::string & name);
+	void spliceTags(size_t first, size_t last, const std::vector<Tag> & newTags, int delta);
+};
+
+#endif //SCINTILLACOMPONENT_XMLTAGINDEX_H
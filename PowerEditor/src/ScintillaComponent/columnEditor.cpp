@@ -119,40 +119,8 @@ BOOL CALLBACK ColumnEditorDlg::run_dlgProc(UINT message, WPARAM wParam, LPARAM)
 							int endPos = (*_ppEditView)->execute(SCI_GETLENGTH);
 							int endLine = (*_ppEditView)->execute(SCI_LINEFROMPOSITION, endPos);
 
-							int lineAllocatedLen = 1024;
-							TCHAR *line = new TCHAR[lineAllocatedLen];
-
-							for (int i = cursorLine ; i <= endLine ; i++)
-							{
-								int lineBegin = (*_ppEditView)->execute(SCI_POSITIONFROMLINE, i);
-								int lineEnd = (*_ppEditView)->execute(SCI_GETLINEENDPOSITION, i);
-
-								int lineEndCol = (*_ppEditView)->execute(SCI_GETCOLUMN, lineEnd);
-								int lineLen = lineEnd - lineBegin + 1;
-
-								if (lineLen > lineAllocatedLen)
-								{
-									delete [] line;
-									line = new TCHAR[lineLen];
-								}
-								(*_ppEditView)->getGenericText(line, lineBegin, lineEnd);
-								generic_string s2r(line);
-
-								if (lineEndCol < cursorCol)
-								{
-									generic_string s_space(cursorCol - lineEndCol, ' ');
-									s2r.append(s_space);
-									s2r.append(str);
-								}
-								else
-								{
-									int posAbs2Start = (*_ppEditView)->execute(SCI_FINDCOLUMN, i, cursorCol);
-									int posRelative2Start = posAbs2Start - lineBegin;
-									s2r.insert(posRelative2Start, str);
-								}
-								(*_ppEditView)->replaceTarget(s2r.c_str(), lineBegin, lineEnd);
-							}
-							delete [] line;
+							std::vector<generic_string> strs(endLine - cursorLine + 1, str);
+							(*_ppEditView)->columnInsert(cursorLine, cursorCol, strs);
 						}
 					}
 					else
@@ -181,10 +149,6 @@ BOOL CALLBACK ColumnEditorDlg::run_dlgProc(UINT message, WPARAM wParam, LPARAM)
 							int endPos = (*_ppEditView)->execute(SCI_GETLENGTH);
 							int endLine = (*_ppEditView)->execute(SCI_LINEFROMPOSITION, endPos);
 
-							int lineAllocatedLen = 1024;
-							TCHAR *line = new TCHAR[lineAllocatedLen];
-
-
 							UCHAR f = format & MASK_FORMAT;
 							bool isZeroLeading = (MASK_ZERO_LEADING & format) != 0;
 
@@ -203,44 +167,14 @@ BOOL CALLBACK ColumnEditorDlg::run_dlgProc(UINT message, WPARAM wParam, LPARAM)
 							int nb = max(nbInit, nbEnd);
 
 
+							std::vector<generic_string> strs;
 							for (int i = cursorLine ; i <= endLine ; i++)
 							{
-								int lineBegin = (*_ppEditView)->execute(SCI_POSITIONFROMLINE, i);
-								int lineEnd = (*_ppEditView)->execute(SCI_GETLINEENDPOSITION, i);
-
-								int lineEndCol = (*_ppEditView)->execute(SCI_GETCOLUMN, lineEnd);
-								int lineLen = lineEnd - lineBegin + 1;
-
-								if (lineLen > lineAllocatedLen)
-								{
-									delete [] line;
-									line = new TCHAR[lineLen];
-								}
-								(*_ppEditView)->getGenericText(line, lineBegin, lineEnd);
-								generic_string s2r(line);
-
-								//
-								// Calcule generic_string
-								//
 								int2str(str, stringSize, initialNumber, base, nb, isZeroLeading);
 								initialNumber += increaseNumber;
-
-								if (lineEndCol < cursorCol)
-								{
-									generic_string s_space(cursorCol - lineEndCol, ' ');
-									s2r.append(s_space);
-									s2r.append(str);
-								}
-								else
-								{
-									int posAbs2Start = (*_ppEditView)->execute(SCI_FINDCOLUMN, i, cursorCol);
-									int posRelative2Start = posAbs2Start - lineBegin;
-									s2r.insert(posRelative2Start, str);
-								}
-
-								(*_ppEditView)->replaceTarget(s2r.c_str(), lineBegin, lineEnd);
+								strs.push_back(str);
 							}
-							delete [] line;
+							(*_ppEditView)->columnInsert(cursorLine, cursorCol, strs);
 						}
 					}
 					(*_ppEditView)->execute(SCI_ENDUNDOACTION);
@@ -21,340 +21,103 @@
 #include "ScintillaComponent/Buffer.h"
 #include "Parameters.h"
 
-int XmlMatchedTagsHighlighter::getFirstTokenPosFrom(int targetStart, int targetEnd, const char *token, std::pair<int, int> & foundPos)
+// Lets the tag index read the document straight from Scintilla's buffer
+class ScintillaTextSource : public XmlTagIndex::TextSource
 {
-	//int start = currentPos;
-	//int end = (direction == DIR_LEFT)?0:_pEditView->getCurrentDocLen();
-
-	_pEditView->execute(SCI_SETTARGETSTART, targetStart);
-	_pEditView->execute(SCI_SETTARGETEND, targetEnd);
-	_pEditView->execute(SCI_SETSEARCHFLAGS, SCFIND_REGEXP|SCFIND_POSIX);
-	int posFind = _pEditView->execute(SCI_SEARCHINTARGET, (WPARAM)strlen(token), (LPARAM)token);
-	if (posFind != -1)
-	{
-		foundPos.first = _pEditView->execute(SCI_GETTARGETSTART);
-		foundPos.second = _pEditView->execute(SCI_GETTARGETEND);
-	}
-	return posFind;
-}
-
-TagCateg XmlMatchedTagsHighlighter::getTagCategory(XmlMatchedTagsPos & tagsPos, int curPos)
-{
-	std::pair<int, int> foundPos;
-
-	int docLen = _pEditView->getCurrentDocLen();
-
-	int gtPos = getFirstTokenPosFrom(curPos, 0, ">", foundPos);
-	int ltPos = getFirstTokenPosFrom(curPos, 0, "<", foundPos);
-	if (ltPos != -1)
-	{
-		if ((gtPos != -1) && (ltPos < gtPos))
-			return outOfTag;
-
-		// Now we are sure about that we are inside of tag
-		// We'll try to determinate the tag category :
-		// tagOpen : <Tag>, <Tag Attr="1" >
-		// tagClose : </Tag>
-		// tagSigle : <Tag/>, <Tag Attr="0" />
-		int charAfterLt = _pEditView->execute(SCI_GETCHARAT, ltPos+1);
-		if (!charAfterLt)
-			return unknownPb;
-
-		if ((char)charAfterLt == ' ')
-			return invalidTag;
-
-		// so now we are sure we have tag sign '<'
-		// We'll see on the right
-		int gtPosOnR = getFirstTokenPosFrom(curPos, docLen, ">", foundPos);
-		int ltPosOnR = getFirstTokenPosFrom(curPos, docLen, "<", foundPos);
+public:
+	ScintillaTextSource(ScintillaEditView *pEditView) : _pEditView(pEditView) {};
 
-		if (gtPosOnR == -1)
-			return invalidTag;
-
-		if ((ltPosOnR != -1) && (ltPosOnR < gtPosOnR))
-			return invalidTag;
-
-		if ((char)charAfterLt == '/')
-		{
-			int char2AfterLt = _pEditView->execute(SCI_GETCHARAT, ltPos+1+1);
+	int length() {
+		return _pEditView->getCurrentDocLen();
+	};
 
-			if (!char2AfterLt)
-				return unknownPb;
+	const char * rangePointer(int start, int len) {
+		return (const char *)_pEditView->execute(SCI_GETRANGEPOINTER, start, len);
+	};
 
-			if ((char)char2AfterLt == ' ')
-				return invalidTag;
+private:
+	ScintillaEditView *_pEditView;
+};
 
-			tagsPos.tagCloseStart = ltPos;
-			tagsPos.tagCloseEnd = gtPosOnR + 1;
-			return tagClose;
-		}
-		else
-		{
-			// it's sure for not being a tagClose
-			// So we determinate if it's tagSingle or tagOpen
-			tagsPos.tagOpenStart = ltPos;
-			tagsPos.tagOpenEnd = gtPosOnR + 1;
-
-			int charBeforeLt = _pEditView->execute(SCI_GETCHARAT, gtPosOnR-1);
-			if ((char)charBeforeLt == '/')
-				return inSingleTag;
-
-			return tagOpen;
-		}
-	}
-
-	return outOfTag;
-}
-
-bool XmlMatchedTagsHighlighter::getMatchedTagPos(int searchStart, int searchEnd, const char *tag2find, const char *oppositeTag2find, std::vector<int> oppositeTagFound, XmlMatchedTagsPos & tagsPos)
+bool XmlMatchedTagsHighlighter::isInNonHTMLZone(int pos) const
 {
-	const bool search2Left = false;
-	const bool search2Right = true;
-
-	bool direction = searchEnd > searchStart;
-
-	std::pair<int, int> foundPos;
-	int ltPosOnR = getFirstTokenPosFrom(searchStart, searchEnd, tag2find, foundPos);
-	if (ltPosOnR == -1)
-		return false;
-
-	// if the tag is found in non html zone, we skip it
 	const NppGUI & nppGUI = (NppParameters::getInstance())->getNppGUI();
-	int idStyle = _pEditView->execute(SCI_GETSTYLEAT, ltPosOnR);
-	if (!nppGUI._enableHiliteNonHTMLZone && (idStyle >= SCE_HJ_START || idStyle == SCE_H_COMMENT))
-	{
-		int start = (direction == search2Left)?foundPos.first:foundPos.second;
-		int end = searchEnd;
-		return getMatchedTagPos(start, end, tag2find, oppositeTag2find, oppositeTagFound, tagsPos);
-	}
-
-	TagCateg tc = outOfTag;
-	if (direction == search2Left)
-	{
-		tc = getTagCategory(tagsPos, ltPosOnR+2);
-
-		if (tc != tagOpen && tc != inSingleTag)
-			return false;
-		if (tc == inSingleTag)
-		{
-			int start = foundPos.first;
-			int end = searchEnd;
-			return getMatchedTagPos(start, end, tag2find, oppositeTag2find, oppositeTagFound, tagsPos);
-		}
-	}
-
-	std::pair<int, int> oppositeTagPos;
-	int s = foundPos.first;
-	int e = tagsPos.tagOpenEnd;
-	if (direction == search2Left)
-	{
-		s = foundPos.second;
-		e = tagsPos.tagCloseStart;
-	}
-
-	int ltTag = getFirstTokenPosFrom(s, e, oppositeTag2find, oppositeTagPos);
-
-	if (ltTag == -1)
-	{
-		if (direction == search2Left)
-		{
-			return true;
-		}
-		else
-		{
-			tagsPos.tagCloseStart = foundPos.first;
-			tagsPos.tagCloseEnd = foundPos.second;
-			return true;
-		}
-	}
-	else
-	{
-		// RegExpr is "<tagName[ 	>]", found tag could be a openTag or singleTag
-		// so we should make sure if it's a singleTag
-		XmlMatchedTagsPos pos;
-		if (direction == search2Right && getTagCategory(pos,ltTag+1) == inSingleTag)
-		{
-			for(;;)
-			{
-				ltTag = getFirstTokenPosFrom(ltTag, e, oppositeTag2find, oppositeTagPos);
-
-				if (ltTag == -1)
-				{
-					tagsPos.tagCloseStart = foundPos.first;
-					tagsPos.tagCloseEnd = foundPos.second;
-					return true;
-				}
-				else
-				{
-					if (getTagCategory(pos,ltTag+1) == inSingleTag)
-					{
-						continue;
-					}
-
-					if (!isInList(ltTag, oppositeTagFound))
-					{
-						oppositeTagFound.push_back(ltTag);
-						break;
-					}
-				}
-			}
-			return getMatchedTagPos(foundPos.second, searchEnd, tag2find, oppositeTag2find, oppositeTagFound, tagsPos);
-		}
-
-
-		if (isInList(ltTag, oppositeTagFound))
-		{
-			for(;;)
-			{
-				ltTag = getFirstTokenPosFrom(ltTag, e, oppositeTag2find, oppositeTagPos);
-				if (ltTag == -1)
-				{
-					if (direction == search2Left)
-					{
-						return true;
-					}
-					else
-					{
-						tagsPos.tagCloseStart = foundPos.first;
-						tagsPos.tagCloseEnd = foundPos.second;
-					}
-					return true;
-				}
-				else if (!isInList(ltTag, oppositeTagFound))
-				{
-					oppositeTagFound.push_back(ltTag);
-					break;
-				}
-				else
-				{
-					if (direction == search2Left)
-					{
-						XmlMatchedTagsPos tmpTagsPos;
-						getTagCategory(tmpTagsPos, ltTag+1);
-						ltTag = tmpTagsPos.tagCloseEnd;
-					}
-				}
-			}
-		}
-		else
-		{
-			oppositeTagFound.push_back(ltTag);
-		}
-	}
-	int start, end;
-	if (direction == search2Left)
-	{
-		start = foundPos.first;
-		end = searchEnd;
-	}
-	else
-	{
-		start = foundPos.second;
-		end = searchEnd;
-	}
-
-	return getMatchedTagPos(start, end, tag2find, oppositeTag2find, oppositeTagFound, tagsPos);
+	if (nppGUI._enableHiliteNonHTMLZone)
+		return false;
+	int idStyle = _pEditView->execute(SCI_GETSTYLEAT, pos);
+	return (idStyle >= SCE_HJ_START || idStyle == SCE_H_COMMENT);
 }
 
-
 bool XmlMatchedTagsHighlighter::getXmlMatchedTagsPos(XmlMatchedTagsPos & tagsPos)
 {
 	// get word where caret is on
 	int caretPos = _pEditView->execute(SCI_GETCURRENTPOS);
 
 	// if the tag is found in non html zone (include comment zone), then quit
-	const NppGUI & nppGUI = (NppParameters::getInstance())->getNppGUI();
-	int idStyle = _pEditView->execute(SCI_GETSTYLEAT, caretPos);
-	if (!nppGUI._enableHiliteNonHTMLZone && (idStyle >= SCE_HJ_START || idStyle == SCE_H_COMMENT))
+	if (isInNonHTMLZone(caretPos))
 		return false;
 
-	int docLen = _pEditView->getCurrentDocLen();
-
-	// determinate the nature of current word : tagOpen, tagClose or outOfTag
-	TagCateg tagCateg = getTagCategory(tagsPos, caretPos);
+	XmlTagIndex & tagIndex = _pEditView->getCurrentBuffer()->getXmlTagIndex();
+	ScintillaTextSource text(_pEditView);
+	tagIndex.sync(text);
 
-	static const char tagNameChars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.-_:";
+	int index = tagIndex.findTag(caretPos);
+	if (index == -1)
+		return false;
 
-	switch (tagCateg)
+	const XmlTagIndex::Tag & tag = tagIndex.tagAt(index);
+	if (tag._kind == XmlTagIndex::singleTag)
 	{
-		case tagOpen : // if tagOpen search right
-		{
-			_pEditView->execute(SCI_SETWORDCHARS, 0, (LPARAM)tagNameChars);
-			int startPos = _pEditView->execute(SCI_WORDSTARTPOSITION, tagsPos.tagOpenStart+1, true);
-			int endPos = _pEditView->execute(SCI_WORDENDPOSITION, tagsPos.tagOpenStart+1, true);
-			tagsPos.tagNameEnd = endPos;
-
-			_pEditView->execute(SCI_SETCHARSDEFAULT);
-			char * tagName = new char[endPos-startPos+1];
-
-			_pEditView->getText(tagName, startPos, endPos);
-
-			std::basic_string<char> closeTag = "</";
-			closeTag += tagName;
-			closeTag += "[ 	]*>";
-
-			std::basic_string<char> openTag = "<";
-			openTag += tagName;
-			openTag += "[ 	>]";
+		tagsPos.tagOpenStart = tag._start;
+		tagsPos.tagNameEnd = tag._nameEnd;
+		tagsPos.tagOpenEnd = tag._end;
+		tagsPos.tagCloseStart = -1;
+		tagsPos.tagCloseEnd = -1;
+		return true;
+	}
 
-			delete [] tagName;
+	// Tags of the same name only: an open tag is searched to the right, a close tag to the left,
+	// skipping the pairs nested in between.
+	const std::vector<int> & sameName = tagIndex.tagsNamed(tag._nameId);
+	bool isOpen = (tag._kind == XmlTagIndex::openTag);
+	int step = isOpen?1:-1;
+	int depth = 0;
+	for (int i = tagIndex.rankInName(index) + step ; i >= 0 && i < int(sameName.size()) ; i += step)
+	{
+		const XmlTagIndex::Tag & other = tagIndex.tagAt(sameName[i]);
+		if (other._kind == XmlTagIndex::singleTag || isInNonHTMLZone(other._start))
+			continue;
 
-			std::vector<int> passedTagList;
-			return getMatchedTagPos(tagsPos.tagOpenEnd, docLen, closeTag.c_str(), openTag.c_str(), passedTagList, tagsPos);
+		if (other._kind == tag._kind)
+		{
+			depth++;
 		}
-
-		case tagClose : // if tagClose search left
+		else if (depth)
 		{
-			_pEditView->execute(SCI_SETWORDCHARS, 0, (LPARAM)tagNameChars);
-			int startPos = _pEditView->execute(SCI_WORDSTARTPOSITION, tagsPos.tagCloseStart+2, true);
-			int endPos = _pEditView->execute(SCI_WORDENDPOSITION, tagsPos.tagCloseStart+2, true);
-
-			_pEditView->execute(SCI_SETCHARSDEFAULT);
-			char * tagName = new char[endPos-startPos+1];
-			_pEditView->getText(tagName, startPos, endPos);
-
-			std::basic_string<char> openTag = "<";
-			openTag += tagName;
-			openTag += "[ 	>]";
-
-			std::basic_string<char> closeTag = "</";
-			closeTag += tagName;
-			closeTag += "[ 	]*>";
-
-			delete [] tagName;
-
-			std::vector<int> passedTagList;
-			bool isFound = getMatchedTagPos(tagsPos.tagCloseStart, 0, openTag.c_str(), closeTag.c_str(), passedTagList, tagsPos);
-			if (isFound)
-				tagsPos.tagNameEnd = tagsPos.tagOpenStart + 1 + (endPos - startPos);
-
-			return isFound;
+			depth--;
 		}
-
-		case inSingleTag : // if in single tag
+		else
 		{
-			_pEditView->execute(SCI_SETWORDCHARS, 0, (LPARAM)tagNameChars);
-			int endPos = _pEditView->execute(SCI_WORDENDPOSITION, tagsPos.tagOpenStart+1, true);
-			tagsPos.tagNameEnd = endPos;
-			_pEditView->execute(SCI_SETCHARSDEFAULT);
-
-			tagsPos.tagCloseStart = -1;
-			tagsPos.tagCloseEnd = -1;
+			const XmlTagIndex::Tag & openTag = isOpen?tag:other;
+			const XmlTagIndex::Tag & closeTag = isOpen?other:tag;
+			tagsPos.tagOpenStart = openTag._start;
+			tagsPos.tagNameEnd = openTag._nameEnd;
+			tagsPos.tagOpenEnd = openTag._end;
+			tagsPos.tagCloseStart = closeTag._start;
+			tagsPos.tagCloseEnd = closeTag._end;
 			return true;
 		}
-		default: // if outOfTag, just quit
-			return false;
-
 	}
+	return false;
 }
 
 std::vector< std::pair<int, int> > XmlMatchedTagsHighlighter::getAttributesPos(int start, int end)
 {
 	std::vector< std::pair<int, int> > attributes;
 
-	int bufLen = end - start + 1;
-	char *buf = new char[bufLen+1];
-	_pEditView->getText(buf, start, end);
+	// The whole range is in the tag which was just looked up, no need to copy it
+	int len = end - start;
+	const char *text = (const char *)_pEditView->execute(SCI_GETRANGEPOINTER, start, len);
 
 	enum {\
 		attr_invalid,\
@@ -369,9 +132,10 @@ std::vector< std::pair<int, int> > XmlMatchedTagsHighlighter::getAttributesPos(i
 	int startPos = -1;
 	int oneMoreChar = 1;
 	int i = 0;
-	for (; i < bufLen ; i++)
+	// One more turn for the terminating character getText used to give
+	for (; i < len + 1 ; i++)
 	{
-		switch (buf[i])
+		switch ((i < len)?text[i]:'\0')
 		{
 			case ' ':
 			case '\t':
@@ -434,7 +198,6 @@ std::vector< std::pair<int, int> > XmlMatchedTagsHighlighter::getAttributesPos(i
 	if (state == attr_value)
 		attributes.push_back(std::pair<int, int>(start+startPos, start+i-1));
 
-	delete [] buf;
 	return attributes;
 }
 
@@ -452,11 +215,6 @@ void XmlMatchedTagsHighlighter::tagMatch(bool doHiliteAttr)
 	if (lang != L_XML && lang != L_HTML && lang != L_PHP && lang != L_ASP && lang != L_JSP)
 		return;
 
-	// Get the original targets and search options to restore after tag matching operation
-	int originalStartPos = _pEditView->execute(SCI_GETTARGETSTART);
-	int originalEndPos = _pEditView->execute(SCI_GETTARGETEND);
-	int originalSearchFlags = _pEditView->execute(SCI_GETSEARCHFLAGS);
-
 	XmlMatchedTagsPos xmlTags;
 
     // Detect if it's a xml/html tag. If yes, Colour it!
@@ -482,11 +240,13 @@ void XmlMatchedTagsHighlighter::tagMatch(bool doHiliteAttr)
         if (doHiliteAttr)
 		{
 			std::vector< std::pair<int, int> > attributes = getAttributesPos(xmlTags.tagNameEnd, xmlTags.tagOpenEnd - openTagTailLen);
-			_pEditView->execute(SCI_SETINDICATORCURRENT,  SCE_UNIVERSAL_TAGATTR);
+			std::vector<int> ranges;
 			for (size_t i = 0 ; i < attributes.size() ; i++)
 			{
-				_pEditView->execute(SCI_INDICATORFILLRANGE,  attributes[i].first, attributes[i].second - attributes[i].first);
+				ranges.push_back(attributes[i].first);
+				ranges.push_back(attributes[i].second - attributes[i].first);
 			}
+			_pEditView->fillIndicatorRanges(SCE_UNIVERSAL_TAGATTR, ranges);
         }
 
         // Colourising indent guide line position
@@ -505,9 +265,4 @@ void XmlMatchedTagsHighlighter::tagMatch(bool doHiliteAttr)
 			}
 		}
 	}
-
-	// restore the original targets and search options to avoid the conflit with search/replace function
-	_pEditView->execute(SCI_SETTARGETSTART, originalStartPos);
-	_pEditView->execute(SCI_SETTARGETEND, originalEndPos);
-	_pEditView->execute(SCI_SETSEARCHFLAGS, originalSearchFlags);
 }
@@ -20,8 +20,6 @@
 
 class ScintillaEditView;
 
-enum TagCateg {tagOpen, tagClose, inSingleTag, outOfTag, invalidTag, unknownPb};
-
 class XmlMatchedTagsHighlighter {
 public:
 	XmlMatchedTagsHighlighter(ScintillaEditView *pEditView):_pEditView(pEditView){};
@@ -39,17 +37,9 @@ private:
 
 	ScintillaEditView *_pEditView;
 
-	int getFirstTokenPosFrom(int targetStart, int targetEnd, const char *token, std::pair<int, int> & foundPos);
-	TagCateg getTagCategory(XmlMatchedTagsPos & tagsPos, int curPos);
-	bool getMatchedTagPos(int searchStart, int searchEnd, const char *tag2find, const char *oppositeTag2find, std::vector<int> oppositeTagFound, XmlMatchedTagsPos & tagsPos);
+	bool isInNonHTMLZone(int pos) const;
 	bool getXmlMatchedTagsPos(XmlMatchedTagsPos & tagsPos);
 	std::vector< std::pair<int, int> > getAttributesPos(int start, int end);
-	bool isInList(int element, std::vector<int> elementList) {
-		for (size_t i = 0 ; i < elementList.size() ; i++)
-			if (element == elementList[i])
-				return true;
-		return false;
-	};
 };
 
 #endif //SCINTILLACOMPONENT_XMLMATCHEDTAGSHIGHLIGHTER_H
@@ -26,6 +26,218 @@ distribution.
 
 bool TiXmlBase::condenseWhiteSpace = true;
 
+#pragma push_macro("new")
+#undef new
+
+// Storage behind TiXmlBase::operator new: slots are handed out from blocks of blockSize
+// bytes, and deleted slots are chained by size until an object of that size needs one.
+// Bigger objects go to the heap. No constructor, so that it is zeroed before any static
+// constructor runs; once destroyed, deleting a slot does nothing, its block is already gone.
+class TiXmlPool
+{
+public:
+	~TiXmlPool();
+	void* Allocate( size_t size );
+	void Free( void* p, size_t size );
+
+private:
+	enum
+	{
+		granularity = 8,
+		maxSlotSize = 256,
+		blockSize = 64 * 1024
+	};
+	struct Slot
+	{
+		Slot* next;
+	};
+
+	Slot* freeSlots[ maxSlotSize / granularity + 1 ];
+	Slot* blocks;
+	char* blockCurrent;
+	char* blockEnd;
+	bool released;
+};
+
+static TiXmlPool pool;
+
+TiXmlPool::~TiXmlPool()
+{
+	while ( blocks )
+	{
+		Slot* block = blocks;
+		blocks = blocks->next;
+		::operator delete( block );
+	}
+	// Objects allocated after this get a block of their own, never freed
+	for ( size_t i = 0; i < sizeof( freeSlots ) / sizeof( freeSlots[0] ); i++ )
+		freeSlots[i] = NULL;
+	blockCurrent = NULL;
+	blockEnd = NULL;
+	released = true;
+}
+
+void* TiXmlPool::Allocate( size_t size )
+{
+	if ( size > maxSlotSize )
+		return ::operator new( size );
+
+	size_t index = ( size + granularity - 1 ) / granularity;
+	if ( freeSlots[index] )
+	{
+		Slot* slot = freeSlots[index];
+		freeSlots[index] = slot->next;
+		return slot;
+	}
+
+	size_t slotSize = index * granularity;
+	if ( blockCurrent + slotSize > blockEnd )
+	{
+		// The end of the previous block is lost, at most maxSlotSize bytes
+		Slot* block = static_cast<Slot*>( ::operator new( blockSize ) );
+		block->next = blocks;
+		blocks = block;
+		blockCurrent = reinterpret_cast<char*>( block ) + granularity;
+		blockEnd = reinterpret_cast<char*>( block ) + blockSize;
+	}
+	void* p = blockCurrent;
+	blockCurrent += slotSize;
+	return p;
+}
+
+void TiXmlPool::Free( void* p, size_t size )
+{
+	if ( !p )
+		return;
+	if ( size > maxSlotSize )
+	{
+		::operator delete( p );
+		return;
+	}
+	if ( released )
+		return;
+
+	size_t index = ( size + granularity - 1 ) / granularity;
+	Slot* slot = static_cast<Slot*>( p );
+	slot->next = freeSlots[index];
+	freeSlots[index] = slot;
+}
+
+void* TiXmlBase::operator new( size_t size )
+{
+	return pool.Allocate( size );
+}
+
+void TiXmlBase::operator delete( void* p, size_t size )
+{
+	pool.Free( p, size );
+}
+
+void* TiXmlBase::operator new( size_t size, int, const char*, int )
+{
+	return pool.Allocate( size );
+}
+
+// Only called when a constructor throws, which TinyXml's do not. The size is not known
+// here, so the slot is left out of the pool rather than chained under the wrong size.
+void TiXmlBase::operator delete( void*, int, const char*, int )
+{
+}
+
+#pragma pop_macro("new")
+
+// Set of the names interned by TiXmlBase::InternName: open addressing over a power of two
+// table, each name allocated once and freed at exit.
+class TiXmlNameTable
+{
+public:
+	TiXmlNameTable() : count( 0 ) {}
+	~TiXmlNameTable();
+	const TCHAR* Find( const TCHAR* name, size_t length ) const;
+	const TCHAR* Intern( const TCHAR* name, size_t length );
+
+private:
+	std::vector<const TCHAR*> slots;
+	size_t count;
+
+	static size_t Hash( const TCHAR* name, size_t length );
+	size_t SlotOf( const TCHAR* name, size_t length ) const;
+};
+
+// Built on first use, as documents may be parsed from other static constructors
+static TiXmlNameTable& NameTable()
+{
+	static TiXmlNameTable nameTable;
+	return nameTable;
+}
+
+TiXmlNameTable::~TiXmlNameTable()
+{
+	for ( size_t i = 0; i < slots.size(); i++ )
+		delete [] slots[i];
+}
+
+size_t TiXmlNameTable::Hash( const TCHAR* name, size_t length )
+{
+	size_t hash = 2166136261U;
+	for ( size_t i = 0; i < length; i++ )
+		hash = ( hash ^ size_t( name[i] ) ) * 16777619U;
+	return hash;
+}
+
+// Slot holding name, or the empty slot where it would go
+size_t TiXmlNameTable::SlotOf( const TCHAR* name, size_t length ) const
+{
+	size_t mask = slots.size() - 1;
+	size_t i = Hash( name, length ) & mask;
+	while ( slots[i] && ( generic_strncmp( slots[i], name, length ) != 0 || slots[i][length] != 0 ) )
+		i = ( i + 1 ) & mask;
+	return i;
+}
+
+const TCHAR* TiXmlNameTable::Find( const TCHAR* name, size_t length ) const
+{
+	if ( slots.empty() )
+		return 0;
+	return slots[ SlotOf( name, length ) ];
+}
+
+const TCHAR* TiXmlNameTable::Intern( const TCHAR* name, size_t length )
+{
+	// Kept at most half full, so that the probes stay short
+	if ( ( count + 1 ) * 2 > slots.size() )
+	{
+		std::vector<const TCHAR*> oldSlots( slots.empty() ? 256 : slots.size() * 2, (const TCHAR*)0 );
+		oldSlots.swap( slots );
+		for ( size_t i = 0; i < oldSlots.size(); i++ )
+		{
+			if ( oldSlots[i] )
+				slots[ SlotOf( oldSlots[i], lstrlen( oldSlots[i] ) ) ] = oldSlots[i];
+		}
+	}
+
+	size_t i = SlotOf( name, length );
+	if ( !slots[i] )
+	{
+		TCHAR* atom = new TCHAR[ length + 1 ];
+		memcpy( atom, name, length * sizeof( TCHAR ) );
+		atom[length] = 0;
+		slots[i] = atom;
+		count++;
+	}
+	return slots[i];
+}
+
+const TCHAR* TiXmlBase::InternName( const TCHAR* name, size_t length )
+{
+	return NameTable().Intern( name, length );
+}
+
+const TCHAR* TiXmlBase::FindName( const TCHAR* name )
+{
+	return NameTable().Find( name, lstrlen( name ) );
+}
+
 void TiXmlBase::PutString( const TIXML_STRING& str, TIXML_OSTREAM* stream )
 {
 	TIXML_STRING buffer;
@@ -128,6 +340,7 @@ TiXmlNode::TiXmlNode( NodeType _type )
 	prev = 0;
 	next = 0;
 	userData = 0;
+	name = 0;
 }
 
 
@@ -294,9 +507,10 @@ bool TiXmlNode::RemoveChild( TiXmlNode* removeThis )
 TiXmlNode* TiXmlNode::FirstChild( const TCHAR * _value ) const
 {
 	TiXmlNode* node;
+	const TCHAR* atom = FindName( _value );
 	for ( node = firstChild; node; node = node->next )
 	{
-		if ( node->SValue() == TIXML_STRING( _value ))
+		if ( node->HasValue( atom, _value ) )
 			return node;
 	}
 	return 0;
@@ -305,9 +519,10 @@ TiXmlNode* TiXmlNode::FirstChild( const TCHAR * _value ) const
 TiXmlNode* TiXmlNode::LastChild( const TCHAR * _value ) const
 {
 	TiXmlNode* node;
+	const TCHAR* atom = FindName( _value );
 	for ( node = lastChild; node; node = node->prev )
 	{
-		if ( node->SValue() == TIXML_STRING (_value))
+		if ( node->HasValue( atom, _value ) )
 			return node;
 	}
 	return 0;
@@ -342,9 +557,10 @@ TiXmlNode* TiXmlNode::IterateChildren( const TCHAR * val, TiXmlNode* previous )
 TiXmlNode* TiXmlNode::NextSibling( const TCHAR * _value ) const
 {
 	TiXmlNode* node;
+	const TCHAR* atom = FindName( _value );
 	for ( node = next; node; node = node->next )
 	{
-		if ( node->SValue() == TIXML_STRING (_value))
+		if ( node->HasValue( atom, _value ) )
 			return node;
 	}
 	return 0;
@@ -354,9 +570,10 @@ TiXmlNode* TiXmlNode::NextSibling( const TCHAR * _value ) const
 TiXmlNode* TiXmlNode::PreviousSibling( const TCHAR * _value ) const
 {
 	TiXmlNode* node;
+	const TCHAR* atom = FindName( _value );
 	for ( node = prev; node; node = node->prev )
 	{
-		if ( node->SValue() == TIXML_STRING (_value))
+		if ( node->HasValue( atom, _value ) )
 			return node;
 	}
 	return 0;
@@ -448,7 +665,7 @@ TiXmlElement::TiXmlElement (const TCHAR * _value)
 : TiXmlNode( TiXmlNode::ELEMENT )
 {
 	firstChild = lastChild = 0;
-	value = _value;
+	name = InternName( _value );
 }
 
 TiXmlElement::~TiXmlElement()
@@ -557,7 +774,7 @@ void TiXmlElement::Print( FILE* cfile, int depth ) const
 		generic_fprintf( cfile, TEXT("    ") );
 	}
 
-	generic_fprintf( cfile, TEXT("<%s"), value.c_str() );
+	generic_fprintf( cfile, TEXT("<%s"), name );
 
 	TiXmlAttribute* attrib;
 	for ( attrib = attributeSet.First(); attrib; attrib = attrib->Next() )
@@ -579,7 +796,7 @@ void TiXmlElement::Print( FILE* cfile, int depth ) const
 	{
 		generic_fprintf( cfile, TEXT(">") );
 		firstChild->Print( cfile, depth + 1 );
-		generic_fprintf( cfile, TEXT("</%s>"), value.c_str() );
+		generic_fprintf( cfile, TEXT("</%s>"), name );
 	}
 	else
 	{
@@ -596,13 +813,13 @@ void TiXmlElement::Print( FILE* cfile, int depth ) const
 		generic_fprintf( cfile, TEXT("\n") );
 		for( i=0; i<depth; ++i )
 		generic_fprintf( cfile, TEXT("    ") );
-		generic_fprintf( cfile, TEXT("</%s>"), value.c_str() );
+		generic_fprintf( cfile, TEXT("</%s>"), name );
 	}
 }
 
 void TiXmlElement::StreamOut( TIXML_OSTREAM * stream ) const
 {
-	(*stream) << TEXT("<") << value;
+	(*stream) << TEXT("<") << name;
 
 	TiXmlAttribute* attrib;
 	for ( attrib = attributeSet.First(); attrib; attrib = attrib->Next() )
@@ -622,7 +839,7 @@ void TiXmlElement::StreamOut( TIXML_OSTREAM * stream ) const
 		{
 			node->StreamOut( stream );
 		}
-		(*stream) << TEXT("</") << value << TEXT(">");
+		(*stream) << TEXT("</") << name << TEXT(">");
 	}
 	else
 	{
@@ -707,7 +924,7 @@ bool TiXmlDocument::LoadFile( const TCHAR* filename )
 	value = filename;
 
 	FILE* file = NULL;
-	generic_fopen( file, value.c_str (), TEXT("r") );
+	generic_fopen( file, value.c_str (), TEXT("rb") );
 
 	if ( file )
 	{
@@ -725,17 +942,24 @@ bool TiXmlDocument::LoadFile( const TCHAR* filename )
 
 		// If we have a file, assume it is all one big XML file, and read it in.
 		// The document parser may decide the document ends sooner than the entire file, however.
-		TIXML_STRING data;
-		data.reserve( length );
-
-		const int BUF_SIZE = 2048;
-		TCHAR buf[BUF_SIZE];
+		std::vector<char> bytes( length );
+		size_t lenRead = fread( &bytes[0], 1, length, file );
+		fclose( file );
 
-		while( generic_fgets( buf, BUF_SIZE, file ) )
+		// Done in one pass over the whole file, as the text mode reads used to: \r\n becomes \n,
+		// ^Z ends the file, and each byte becomes one TCHAR.
+		TIXML_STRING data;
+		data.resize( lenRead );
+		size_t lenData = 0;
+		for ( size_t i = 0; i < lenRead; ++i )
 		{
-			data += buf;
+			if ( bytes[i] == 0x1A )
+				break;
+			if ( bytes[i] == '\r' && i + 1 < lenRead && bytes[i + 1] == '\n' )
+				continue;
+			data[lenData++] = (TCHAR)(unsigned char)bytes[i];
 		}
-		fclose( file );
+		data.resize( lenData );
 
 		Parse( data.c_str(), 0 );
 
@@ -810,8 +1034,8 @@ void TiXmlDocument::StreamOut( TIXML_OSTREAM * out ) const
 TiXmlAttribute* TiXmlAttribute::Next() const
 {
 	// We are using knowledge of the sentinel. The sentinel
-	// have a value or name.
-	if ( next->value.empty() && next->name.empty() )
+	// has no name.
+	if ( !next->name )
 		return 0;
 	return next;
 }
@@ -820,8 +1044,8 @@ TiXmlAttribute* TiXmlAttribute::Next() const
 TiXmlAttribute* TiXmlAttribute::Previous() const
 {
 	// We are using knowledge of the sentinel. The sentinel
-	// have a value or name.
-	if ( prev->value.empty() && prev->name.empty() )
+	// has no name.
+	if ( !prev->name )
 		return 0;
 	return prev;
 }
@@ -845,14 +1069,14 @@ void TiXmlAttribute::StreamOut( TIXML_OSTREAM * stream ) const
 {
 	if (value.find( '\"' ) != TIXML_STRING::npos)
 	{
-		PutString( name, stream );
+		PutString( Name(), stream );
 		(*stream) << TEXT("=") << TEXT("'");
 		PutString( value, stream );
 		(*stream) << TEXT("'");
 	}
 	else
 	{
-		PutString( name, stream );
+		PutString( Name(), stream );
 		(*stream) << TEXT("=") << TEXT("\"");
 		PutString( value, stream );
 		(*stream) << TEXT("\"");
@@ -1086,9 +1310,14 @@ TiXmlAttribute*	TiXmlAttributeSet::Find( const TCHAR * name ) const
 {
 	TiXmlAttribute* node;
 
+	// No attribute can have a name that was never interned
+	const TCHAR* atom = TiXmlBase::FindName( name );
+	if ( !atom )
+		return 0;
+
 	for( node = sentinel.next; node != &sentinel; node = node->next )
 	{
-		if ( node->name == name )
+		if ( node->name == atom )
 			return node;
 	}
 	return 0;
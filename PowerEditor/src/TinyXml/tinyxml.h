@@ -115,6 +115,27 @@ public:
 	TiXmlBase()								{}
 	virtual ~TiXmlBase()					{}
 
+	/**	Nodes and attributes are small and numerous: they are carved out of big
+		blocks, and the deleted ones are recycled by size, instead of going
+		through the heap one by one. Not thread safe, as the rest of TinyXml.
+		The debug builds define new as DEBUG_NEW, whose form is declared too.
+	*/
+#pragma push_macro("new")
+#undef new
+	static void* operator new( size_t size );
+	static void operator delete( void* p, size_t size );
+	static void* operator new( size_t size, int blockUse, const char* fileName, int line );
+	static void operator delete( void* p, int blockUse, const char* fileName, int line );
+#pragma pop_macro("new")
+
+	/**	Names of elements and attributes are interned: equal names share one buffer,
+		that lives as long as the program, so that they can be compared by address.
+		FindName returns 0 if the name was never interned, then nothing has it.
+	*/
+	static const TCHAR* InternName( const TCHAR* name, size_t length );
+	static const TCHAR* InternName( const TCHAR* name )	{ return InternName( name, lstrlen( name ) ); }
+	static const TCHAR* FindName( const TCHAR* name );
+
 	/**	All TinyXml classes can print themselves to a filestream.
 		This is a formatted print, and will insert tabs and newlines.
 
@@ -175,11 +196,11 @@ protected:
 	    static bool StreamTo( TIXML_ISTREAM * in, TCHAR character, TIXML_STRING * tag );
 	#endif
 
-	/*	Reads an XML name into the std::basic_string<TCHAR> provided. Returns
+	/*	Reads an XML name and interns it. Returns
 		a pointer just past the last character of the name,
 		or 0 if the function has an error.
 	*/
-	static const TCHAR* ReadName( const TCHAR* p, TIXML_STRING* name );
+	static const TCHAR* ReadName( const TCHAR* p, const TCHAR** name );
 
 	/*	Reads text. Returns a pointer past the given end tag.
 		Wickedly complex options, but it keeps the (sensitive) code in one place.
@@ -336,7 +357,7 @@ public:
 
 		The subclasses will wrap this function.
 	*/
-	const TCHAR * Value() const { return value.c_str (); }
+	const TCHAR * Value() const { return name ? name : value.c_str (); }
 
 	/** Changes the value of the node. Defined as:
 		@verbatim
@@ -347,7 +368,13 @@ public:
 		Text:		the text std::basic_string<TCHAR>
 		@endverbatim
 	*/
-	void SetValue(const TCHAR * _value) { value = _value;}
+	void SetValue(const TCHAR * _value)
+	{
+		if ( type == ELEMENT )
+			name = InternName( _value );
+		else
+			value = _value;
+	}
 
     #ifdef TIXML_USE_STL
 	/// STL std::basic_string<TCHAR> form.
@@ -514,11 +541,15 @@ protected:
 
 	// Figure out what is at *p, and parse it. Returns null if it is not an xml node.
 	TiXmlNode* Identify( const TCHAR* start );
-	void CopyToClone( TiXmlNode* target ) const	{ target->SetValue (value.c_str() );
+	void CopyToClone( TiXmlNode* target ) const	{ target->SetValue (Value() );
 												  target->userData = userData; }
 
 	// Internal Value function returning a TIXML_STRING
-	TIXML_STRING SValue() const	{ return value ; }
+	TIXML_STRING SValue() const	{ return Value() ; }
+
+	// Whether the value of this node is _value. atom is FindName( _value ), elements
+	// only have to compare it with their name.
+	bool HasValue( const TCHAR* atom, const TCHAR* _value ) const	{ return name ? name == atom : value == _value; }
 
 	TiXmlNode*		parent;
 	NodeType		type;
@@ -526,7 +557,8 @@ protected:
 	TiXmlNode*		firstChild;
 	TiXmlNode*		lastChild;
 
-	TIXML_STRING	value;
+	TIXML_STRING	value;			// empty for elements, see name
+	const TCHAR*	name;			// interned value of elements, 0 for the other nodes
 
 	TiXmlNode*		prev;
 	TiXmlNode*		next;
@@ -549,6 +581,7 @@ public:
 	/// Construct an empty attribute.
 	TiXmlAttribute()
 	{
+		name = 0;
 		document = 0;
 		prev = next = 0;
 	}
@@ -557,7 +590,7 @@ public:
 	/// std::basic_string<TCHAR> constructor.
 	TiXmlAttribute( const std::basic_string<TCHAR>& _name, const std::basic_string<TCHAR>& _value )
 	{
-		name = _name;
+		name = InternName( _name.c_str(), _name.length() );
 		value = _value;
 		document = 0;
 		prev = next = 0;
@@ -567,13 +600,13 @@ public:
 	/// Construct an attribute with a name and value.
 	TiXmlAttribute( const TCHAR * _name, const TCHAR * _value )
 	{
-		name = _name;
+		name = InternName( _name );
 		value = _value;
 		document = 0;
 		prev = next = 0;
 	}
 
-	const TCHAR*		Name()  const		{ return name.c_str (); }		///< Return the name of this attribute.
+	const TCHAR*		Name()  const		{ return name ? name : TEXT(""); }		///< Return the name of this attribute.
 	const TCHAR*		Value() const		{ return value.c_str (); }		///< Return the value of this attribute.
 	const int       IntValue() const;									///< Return the value of this attribute, converted to an integer.
 	const double	DoubleValue() const;								///< Return the value of this attribute, converted to a double.
@@ -591,7 +624,7 @@ public:
 	/// QueryDoubleValue examines the value std::basic_string<TCHAR>. See QueryIntValue().
 	int QueryDoubleValue( double* value ) const;
 
-	void SetName( const TCHAR* _name )	{ name = _name; }				///< Set the name of this attribute.
+	void SetName( const TCHAR* _name )	{ name = InternName( _name ); }	///< Set the name of this attribute.
 	void SetValue( const TCHAR* _value )	{ value = _value; }				///< Set the value.
 
 	void SetIntValue( int value );										///< Set the value from an integer.
@@ -618,8 +651,8 @@ public:
 	TiXmlAttribute* Previous() const;
 
 	bool operator==( const TiXmlAttribute& rhs ) const { return rhs.name == name; }
-	bool operator<( const TiXmlAttribute& rhs )	 const { return name < rhs.name; }
-	bool operator>( const TiXmlAttribute& rhs )  const { return name > rhs.name; }
+	bool operator<( const TiXmlAttribute& rhs )	 const { return lstrcmp( Name(), rhs.Name() ) < 0; }
+	bool operator>( const TiXmlAttribute& rhs )  const { return lstrcmp( Name(), rhs.Name() ) > 0; }
 
 	/*	[internal use]
 		Attribtue parsing starts: first letter of the name
@@ -637,7 +670,7 @@ public:
 
 private:
 	TiXmlDocument*	document;	// A pointer back to a document, for error reporting.
-	TIXML_STRING name;
+	const TCHAR* name;			// interned, 0 only for the sentinel of TiXmlAttributeSet
 	TIXML_STRING value;
 	TiXmlAttribute*	prev;
 	TiXmlAttribute*	next;
@@ -689,7 +722,7 @@ public:
 	TiXmlElement( const std::basic_string<TCHAR>& _value ) : 	TiXmlNode( TiXmlNode::ELEMENT )
 	{
 		firstChild = lastChild = 0;
-		value = _value;
+		name = InternName( _value.c_str(), _value.length() );
 	}
 	#endif
 
@@ -193,9 +193,9 @@ const TCHAR* TiXmlBase::SkipWhiteSpace( const TCHAR* p )
 }
 #endif
 
-const TCHAR* TiXmlBase::ReadName( const TCHAR* p, TIXML_STRING * name )
+const TCHAR* TiXmlBase::ReadName( const TCHAR* p, const TCHAR** name )
 {
-	*name = TEXT("");
+	*name = 0;
 	assert( p );
 
 	// Names start with letters or underscores.
@@ -205,6 +205,7 @@ const TCHAR* TiXmlBase::ReadName( const TCHAR* p, TIXML_STRING * name )
 	if (    p && *p
 		 && ( isalpha( (UCHAR) *p ) || *p == '_' ) )
 	{
+		const TCHAR* start = p;
 		while(		p && *p
 				&&	(		isalnum( (UCHAR ) *p )
 						 || *p == '_'
@@ -212,9 +213,9 @@ const TCHAR* TiXmlBase::ReadName( const TCHAR* p, TIXML_STRING * name )
 						 || *p == '.'
 						 || *p == ':' ) )
 		{
-			(*name) += *p;
 			++p;
 		}
+		*name = InternName( start, p - start );
 		return p;
 	}
 	return 0;
@@ -309,6 +310,11 @@ const TCHAR* TiXmlBase::ReadText(	const TCHAR* p,
 									bool caseInsensitive )
 {
     *text = TEXT("");
+
+	// Text ending on a single character (quotes of attribute values, '<' after the text of
+	// an element) is copied by runs of plain characters rather than one by one.
+	const TCHAR endChar = ( endTag[0] && !endTag[1] && !isalpha( endTag[0] ) ) ? endTag[0] : 0;
+
 	if (    !trimWhiteSpace			// certain tags always keep whitespace
 		 || !condenseWhiteSpace )	// if true, whitespace is always kept
 	{
@@ -317,6 +323,17 @@ const TCHAR* TiXmlBase::ReadText(	const TCHAR* p,
 				&& !StringEqual( p, endTag, caseInsensitive )
 			  )
 		{
+			if ( endChar )
+			{
+				const TCHAR* run = p;
+				while ( *p && *p != endChar && *p != '&' )
+					++p;
+				if ( p > run )
+				{
+					text->append( run, p - run );
+					continue;
+				}
+			}
 			TCHAR c;
 			p = GetChar( p, &c );
             (* text) += c;
@@ -350,6 +367,14 @@ const TCHAR* TiXmlBase::ReadText(	const TCHAR* p,
                (* text) += ' ';
 					whitespace = false;
 				}
+				if ( endChar && *p != endChar && *p != '&' )
+				{
+					const TCHAR* run = p;
+					while ( *p && *p != endChar && *p != '&' && !IsWhiteSpace( *p ) )
+						++p;
+					text->append( run, p - run );
+					continue;
+				}
 				TCHAR c;
 				p = GetChar( p, &c );
             (* text) += c;
@@ -701,17 +726,13 @@ const TCHAR* TiXmlElement::Parse( const TCHAR* p, TiXmlParsingData* data )
 	// Read the name.
 	const TCHAR* pErr = p;
 
-    p = ReadName( p, &value );
+    p = ReadName( p, &name );
 	if ( !p || !*p )
 	{
 		if ( document )	document->SetError( TIXML_ERROR_FAILED_TO_READ_ELEMENT_NAME, pErr, data );
 		return 0;
 	}
 
-    TIXML_STRING endTag (TEXT("</"));
-	endTag += value;
-	endTag += TEXT(">");
-
 	// Check for and read attributes. Also look for an empty
 	// tag or an end tag.
 	while ( p && *p )
@@ -745,6 +766,9 @@ const TCHAR* TiXmlElement::Parse( const TCHAR* p, TiXmlParsingData* data )
 				return 0;
 
 			// We should find the end tag now
+			TIXML_STRING endTag (TEXT("</"));
+			endTag += name;
+			endTag += TEXT(">");
 			if ( StringEqual( p, endTag.c_str(), false ) )
 			{
 				p += endTag.length();
@@ -19,6 +19,11 @@
 #include "precompiled_headers.h"
 #include "Utf8_16.h"
 
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define UTF816_USE_SSE2
+#endif
+
 const Utf8_16::utf8 Utf8_16::k_Boms[][3] = {
 	{0x00, 0x00, 0x00},  // Unknown
 	{0xEF, 0xBB, 0xBF},  // UTF8
@@ -26,6 +31,360 @@ const Utf8_16::utf8 Utf8_16::k_Boms[][3] = {
 	{0xFF, 0xFE, 0x00},  // Little endian
 };
 
+#ifdef UTF816_USE_SSE2
+#ifdef _M_X64
+static const bool isSse2Available = true;	// part of the x64 baseline
+#else
+static const bool isSse2Available = ::IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != FALSE;
+#endif
+#endif
+
+size_t Utf8_16::asciiLength(const ubyte* buf, size_t len, bool stopAtNul)
+{
+	size_t i = 0;
+#ifdef UTF816_USE_SSE2
+	if (isSse2Available)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= len ; i += 16)
+		{
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+			int stopMask = _mm_movemask_epi8(chunk);
+			if (stopAtNul)
+				stopMask |= _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+			if (stopMask)
+				break;	// the loop below finds which byte it is
+		}
+	}
+#endif
+	for (; i < len ; ++i)
+	{
+		if (buf[i] >= 0x80 || (stopAtNul && !buf[i]))
+			break;
+	}
+	return i;
+}
+
+// Checks the UTF-8 sequence starting at s, following the table 3-7 of the Unicode standard
+// (no overlong forms, nothing above U+10FFFF). Surrogates (ED A0..ED BF) are refused unless
+// allowSurrogates is true.
+// *pCharLen receives the length the sequence should have (1 if the lead byte is invalid).
+// Returns how many bytes of it are valid: *pCharLen if the sequence is complete, len if it
+// is cut by the end of the buffer, less if it is invalid.
+static size_t validUtf8Prefix(const Utf8_16::ubyte* s, size_t len, bool allowSurrogates, size_t* pCharLen)
+{
+	Utf8_16::ubyte lead = s[0];
+	Utf8_16::ubyte minByte2 = 0x80;
+	Utf8_16::ubyte maxByte2 = 0xBF;
+
+	*pCharLen = 1;
+	if (lead < 0x80)
+		return 1;
+	if (lead < 0xC2)		// continuation byte, or overlong 2 bytes form
+		return 0;
+
+	if (lead < 0xE0)
+	{
+		*pCharLen = 2;
+	}
+	else if (lead < 0xF0)
+	{
+		*pCharLen = 3;
+		if (lead == 0xE0)
+			minByte2 = 0xA0;
+		else if (lead == 0xED && !allowSurrogates)
+			maxByte2 = 0x9F;
+	}
+	else if (lead < 0xF5)
+	{
+		*pCharLen = 4;
+		if (lead == 0xF0)
+			minByte2 = 0x90;
+		else if (lead == 0xF4)
+			maxByte2 = 0x8F;
+	}
+	else
+		return 0;
+
+	size_t i = 1;
+	if (i < len)
+	{
+		if (s[i] < minByte2 || s[i] > maxByte2)
+			return i;
+		++i;
+	}
+	for (; i < *pCharLen && i < len ; ++i)
+	{
+		if ((s[i] & 0xC0) != 0x80)
+			return i;
+	}
+	return i;
+}
+
+// ==================================================================
+
+void Utf16ToUtf8Transcoder::reset(bool isBigEndian)
+{
+	m_bBigEndian = isBigEndian;
+	m_bHasPendingByte = false;
+	m_nPendingByte = 0;
+	m_nHighSurrogate = 0;
+}
+
+// Any unit but the surrogate pairs, which need the transcoder state
+static size_t encodeBmpUnit(Utf8_16::utf16 unit, Utf8_16::ubyte* dest)
+{
+	if (unit < 0x80)
+	{
+		dest[0] = static_cast<Utf8_16::ubyte>(unit);
+		return 1;
+	}
+	if (unit < 0x800)
+	{
+		dest[0] = static_cast<Utf8_16::ubyte>(0xC0 | (unit >> 6));
+		dest[1] = static_cast<Utf8_16::ubyte>(0x80 | (unit & 0x3F));
+		return 2;
+	}
+	dest[0] = static_cast<Utf8_16::ubyte>(0xE0 | (unit >> 12));
+	dest[1] = static_cast<Utf8_16::ubyte>(0x80 | ((unit >> 6) & 0x3F));
+	dest[2] = static_cast<Utf8_16::ubyte>(0x80 | (unit & 0x3F));
+	return 3;
+}
+
+size_t Utf16ToUtf8Transcoder::encodeUnit(utf16 unit, ubyte* dest)
+{
+	size_t n = 0;
+	if (m_nHighSurrogate)
+	{
+		if (unit >= 0xDC00 && unit <= 0xDFFF)
+		{
+			unsigned long codePoint = 0x10000 + ((unsigned long)(m_nHighSurrogate - 0xD800) << 10) + (unit - 0xDC00);
+			m_nHighSurrogate = 0;
+			dest[0] = static_cast<ubyte>(0xF0 | (codePoint >> 18));
+			dest[1] = static_cast<ubyte>(0x80 | ((codePoint >> 12) & 0x3F));
+			dest[2] = static_cast<ubyte>(0x80 | ((codePoint >> 6) & 0x3F));
+			dest[3] = static_cast<ubyte>(0x80 | (codePoint & 0x3F));
+			return 4;
+		}
+		// Lone high surrogate: written as is, like any other BMP unit
+		n = encodeBmpUnit(m_nHighSurrogate, dest);
+		m_nHighSurrogate = 0;
+	}
+
+	if (unit >= 0xD800 && unit <= 0xDBFF)
+		m_nHighSurrogate = unit;
+	else
+		n += encodeBmpUnit(unit, dest + n);
+	return n;
+}
+
+size_t Utf16ToUtf8Transcoder::convert(const ubyte* src, size_t len, ubyte* dest)
+{
+	const ubyte* pEnd = src + len;
+	ubyte* pCur = dest;
+
+	if (m_bHasPendingByte && src < pEnd)
+	{
+		utf16 unit = m_bBigEndian?static_cast<utf16>((m_nPendingByte << 8) | *src):static_cast<utf16>((*src << 8) | m_nPendingByte);
+		++src;
+		m_bHasPendingByte = false;
+		pCur += encodeUnit(unit, pCur);
+	}
+
+#ifdef UTF816_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	// Bits that must be 0 in each unit for it to be ASCII, depending on the byte order
+	const __m128i nonAsciiBits = _mm_set1_epi16(short(m_bBigEndian?0x80FF:0xFF80));
+#endif
+
+	while (src < pEnd)
+	{
+#ifdef UTF816_USE_SSE2
+		if (isSse2Available && !m_nHighSurrogate)
+		{
+			// 16 ASCII units at a time: only the low bytes are kept
+			while (pEnd - src >= 32)
+			{
+				__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+				__m128i nonAscii = _mm_and_si128(_mm_or_si128(lo, hi), nonAsciiBits);
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(nonAscii, zero)) != 0xFFFF)
+					break;
+				if (m_bBigEndian)
+				{
+					lo = _mm_srli_epi16(lo, 8);
+					hi = _mm_srli_epi16(hi, 8);
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pCur), _mm_packus_epi16(lo, hi));
+				src += 32;
+				pCur += 16;
+			}
+			if (src >= pEnd)
+				break;
+		}
+#endif
+		if (pEnd - src < 2)
+		{
+			// Odd length block: the other half of the unit comes with the next one
+			m_nPendingByte = *src++;
+			m_bHasPendingByte = true;
+			break;
+		}
+		utf16 unit = m_bBigEndian?static_cast<utf16>((src[0] << 8) | src[1]):static_cast<utf16>((src[1] << 8) | src[0]);
+		src += 2;
+		pCur += encodeUnit(unit, pCur);
+	}
+	return pCur - dest;
+}
+
+size_t Utf16ToUtf8Transcoder::flush(ubyte* dest)
+{
+	size_t n = 0;
+	if (m_nHighSurrogate)
+	{
+		n = encodeBmpUnit(m_nHighSurrogate, dest);
+		m_nHighSurrogate = 0;
+	}
+	// A last odd byte is not a character, it is dropped
+	m_bHasPendingByte = false;
+	return n;
+}
+
+// ==================================================================
+
+void Utf8ToUtf16Transcoder::reset(bool isBigEndian)
+{
+	m_bBigEndian = isBigEndian;
+	m_nPending = 0;
+}
+
+// Returns the number of units written. *pCharLen receives the number of bytes used,
+// or 0 if the character is cut by the end of the buffer (nothing is written then).
+size_t Utf8ToUtf16Transcoder::decodeChar(const ubyte* src, size_t len, utf16* dest, size_t* pCharLen) const
+{
+	size_t charLen = 0;
+	// Surrogates are let through: they come from lone surrogates of UTF-16 files
+	size_t validLen = validUtf8Prefix(src, len, true, &charLen);
+	if (validLen == charLen)
+	{
+		*pCharLen = charLen;
+		unsigned long codePoint;
+		switch (charLen)
+		{
+			case 1:
+				codePoint = src[0];
+				break;
+			case 2:
+				codePoint = ((src[0] & 0x1F) << 6) | (src[1] & 0x3F);
+				break;
+			case 3:
+				codePoint = ((src[0] & 0x0F) << 12) | ((src[1] & 0x3F) << 6) | (src[2] & 0x3F);
+				break;
+			default:
+				codePoint = ((unsigned long)(src[0] & 0x07) << 18) | ((src[1] & 0x3F) << 12) | ((src[2] & 0x3F) << 6) | (src[3] & 0x3F);
+				break;
+		}
+		if (codePoint < 0x10000)
+		{
+			dest[0] = order(static_cast<utf16>(codePoint));
+			return 1;
+		}
+		codePoint -= 0x10000;
+		dest[0] = order(static_cast<utf16>(0xD800 + (codePoint >> 10)));
+		dest[1] = order(static_cast<utf16>(0xDC00 + (codePoint & 0x3FF)));
+		return 2;
+	}
+
+	if (validLen == len)
+	{
+		*pCharLen = 0;
+		return 0;
+	}
+
+	// Invalid: one replacement character for the lead byte and the valid bytes following it
+	*pCharLen = validLen?validLen:1;
+	dest[0] = order(0xFFFD);
+	return 1;
+}
+
+size_t Utf8ToUtf16Transcoder::convert(const ubyte* src, size_t len, utf16* dest)
+{
+	const ubyte* pEnd = src + len;
+	utf16* pCur = dest;
+
+	// Completes the character cut at the end of the previous block
+	while (m_nPending && src < pEnd)
+	{
+		m_pending[m_nPending++] = *src++;
+		size_t charLen = 0;
+		size_t nbUnits = decodeChar(m_pending, m_nPending, pCur, &charLen);
+		if (!charLen)
+			continue;
+		pCur += nbUnits;
+		if (charLen < m_nPending)
+		{
+			// Invalid, and only the byte just added can have made it so: it is read again below
+			--src;
+		}
+		m_nPending = 0;
+	}
+
+#ifdef UTF816_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+#endif
+
+	while (src < pEnd)
+	{
+#ifdef UTF816_USE_SSE2
+		if (isSse2Available)
+		{
+			// 16 ASCII bytes at a time, widened by interleaving them with zeros
+			while (pEnd - src >= 16)
+			{
+				__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				if (_mm_movemask_epi8(chunk))
+					break;
+				__m128i lo = m_bBigEndian?_mm_unpacklo_epi8(zero, chunk):_mm_unpacklo_epi8(chunk, zero);
+				__m128i hi = m_bBigEndian?_mm_unpackhi_epi8(zero, chunk):_mm_unpackhi_epi8(chunk, zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pCur), lo);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pCur + 8), hi);
+				src += 16;
+				pCur += 16;
+			}
+			if (src >= pEnd)
+				break;
+		}
+#endif
+		if (*src < 0x80)
+		{
+			*pCur++ = order(*src++);
+			continue;
+		}
+
+		size_t charLen = 0;
+		size_t nbUnits = decodeChar(src, pEnd - src, pCur, &charLen);
+		if (!charLen)
+		{
+			m_nPending = pEnd - src;
+			memcpy(m_pending, src, m_nPending);
+			break;
+		}
+		pCur += nbUnits;
+		src += charLen;
+	}
+	return pCur - dest;
+}
+
+size_t Utf8ToUtf16Transcoder::flush(utf16* dest)
+{
+	if (!m_nPending)
+		return 0;
+
+	// The text ends in the middle of a character
+	m_nPending = 0;
+	dest[0] = order(0xFFFD);
+	return 1;
+}
 
 // ==================================================================
 
@@ -54,67 +413,38 @@ Utf8_16_Read::~Utf8_16_Read()
 // 2 : 8bits
 u78 Utf8_16_Read::utf8_7bits_8bits()
 {
-	int rv = 1;
-	int ASCII7only = 1;
-	utf8 *sx	= (utf8 *)m_pBuf;
-	utf8 *endx	= sx + m_nLen;
+	bool isASCII7only = true;
+	const utf8 *sx = m_pBuf;
+	const utf8 *endx = sx + m_nLen;
 
-	while (sx<endx)
+	while (sx < endx)
 	{
-		if (!*sx)
-		{											// For detection, we'll say that NUL means not UTF8
-			ASCII7only = 0;
-			rv = 0;
-			break;
-		}
-		else if (*sx < 0x80)
-		{			// 0nnnnnnn If the byte's first hex code begins with 0-7, it is an ASCII character.
-			sx++;
-		}
-		else if (*sx < (0x80 + 0x40))
-		{											  // 10nnnnnn 8 through B cannot be first hex codes
-			ASCII7only=0;
-			rv=0;
+		sx += asciiLength(sx, endx - sx, true);
+		if (sx == endx)
 			break;
-		}
-		else if (*sx < (0x80 + 0x40 + 0x20))
-		{					  // 110xxxvv 10nnnnnn  If it begins with C or D, it is an 11 bit character
-			ASCII7only=0;
-			if (sx>=endx-1)
-				break;
-			if (!(*sx & 0x1F) || (sx[1]&(0x80+0x40)) != 0x80) {
-				rv=0; break;
-			}
-			sx+=2;
-		}
-		else if (*sx < (0x80 + 0x40 + 0x20 + 0x10))
-		{								// 1110qqqq 10xxxxvv 10nnnnnn If it begins with E, it is 16 bit
-			ASCII7only=0;
-			if (sx>=endx-2)
-				break;
-			if (!(*sx & 0xF) || (sx[1]&(0x80+0x40)) != 0x80 || (sx[2]&(0x80+0x40)) != 0x80) {
-				rv=0; break;
-			}
-			sx+=3;
-		}
+
+		isASCII7only = false;
+		if (!*sx)		// For detection, we'll say that NUL means not UTF8
+			return ascii8bits;
+
+		size_t charLen = 0;
+		size_t validLen = validUtf8Prefix(sx, endx - sx, false, &charLen);
+		if (validLen == charLen)
+			sx += charLen;
+		else if (sx + validLen == endx)
+			break;		// cut by the end of the block, what we have of it is fine
 		else
-		{													  // more than 16 bits are not allowed here
-			ASCII7only=0;
-			rv=0;
-			break;
-		}
+			return ascii8bits;
 	}
-	if (ASCII7only)
-		return ascii7bits;
-	if (rv)
-		return utf8NoBOM;
-	return ascii8bits;
+	return isASCII7only?ascii7bits:utf8NoBOM;
 }
 
 size_t Utf8_16_Read::convert(char* buf, size_t len)
 {
 	// bugfix by Jens Lorenz
-	static	size_t nSkip = 0;
+	// The BOM is only skipped in the first block. This used to be a function static,
+	// which is not an option anymore now that files are decoded on several threads.
+	size_t nSkip = 0;
 
     size_t  ret = 0;
 
@@ -126,6 +456,7 @@ size_t Utf8_16_Read::convert(char* buf, size_t len)
 		determineEncoding();
 		nSkip = m_nSkip;
 		m_bFirstRead = false;
+		m_transcoder16.reset(m_eEncoding == uni16BE || m_eEncoding == uni16BE_NoBOM);
 	}
 
     switch (m_eEncoding)
@@ -150,9 +481,9 @@ size_t Utf8_16_Read::convert(char* buf, size_t len)
         case uni16LE_NoBOM:
         case uni16BE:
         case uni16LE: {
-            size_t newSize = len + len / 2 + 1;
+            size_t newSize = Utf16ToUtf8Transcoder::maxOutputSize(len) + 1;
 
-            if (m_nBufSize != newSize)
+            if (m_nBufSize < newSize)
             {
 				if (m_pNewBuf)
 					delete [] m_pNewBuf;
@@ -161,28 +492,21 @@ size_t Utf8_16_Read::convert(char* buf, size_t len)
                 m_nBufSize = newSize;
             }
 
-            ubyte* pCur = m_pNewBuf;
-
-            m_Iter16.set(m_pBuf + nSkip, len - nSkip, m_eEncoding);
-
-            for (; m_Iter16; ++m_Iter16)
-            {
-                *pCur++ = m_Iter16.get();
-            }
-            ret = pCur - m_pNewBuf;
+			// An empty block is the end of the text: outputs what was kept for the next block
+			if (len)
+				ret = m_transcoder16.convert(m_pBuf + nSkip, len - nSkip, m_pNewBuf);
+			else
+				ret = m_transcoder16.flush(m_pNewBuf);
+			m_pNewBuf[ret] = '\0';
             break;
         }
         default:
             break;
     }
 
-	// necessary for second calls and more
-	nSkip = 0;
-
 	return ret;
 }
 
-
 void Utf8_16_Read::determineEncoding()
 {
 	m_eEncoding = uni8Bit;
@@ -261,6 +585,9 @@ UniMode Utf8_16_Read::determineEncoding(const unsigned char *buf, int bufLen)
 
 // ==================================================================
 
+// Input bytes converted at a time by Utf8_16_Write::fwrite
+const size_t writeChunkSize = 64 * 1024;
+
 Utf8_16_Write::Utf8_16_Write()
 {
 	m_eEncoding = uni8Bit;
@@ -310,6 +637,7 @@ size_t Utf8_16_Write::fwrite(const void* p, size_t _size)
                 // nothing to do
                 break;
         }
+		m_transcoder8.reset(isBigEndian());
 		m_bFirstWrite = false;
     }
 
@@ -327,24 +655,21 @@ size_t Utf8_16_Write::fwrite(const void* p, size_t _size)
         case uni16LE_NoBOM:
         case uni16BE:
         case uni16LE: {
-			// JOCE: Nice 64KB static alloc. Can we do otherwise????
-			static const int bufSize = 64*1024;
-			utf16 buf[bufSize];
-
-            Utf8_Iter iter8;
-            iter8.set(static_cast<const ubyte*>(p), _size, m_eEncoding);
-
-            int bufIndex = 0;
-            while (iter8) {
-                if (iter8.canGet()) {
-                    buf[bufIndex++] = iter8.get();
-                }
-				++iter8;
-				if(bufIndex == bufSize || !iter8) {
-					if(!::fwrite(buf, bufIndex*sizeof(utf16), 1, m_pFile)) return 0;
-					bufIndex = 0;
-				}
-            }
+			// Converted by chunks into a buffer kept from one call to the other
+			const ubyte* pCur = static_cast<const ubyte*>(p);
+			const ubyte* pEnd = pCur + _size;
+			while (pCur < pEnd)
+			{
+				size_t chunkSize = min(size_t(pEnd - pCur), writeChunkSize);
+				size_t bufUnits = Utf8ToUtf16Transcoder::maxOutputUnits(chunkSize);
+				if (m_writeBuf.size() < bufUnits)
+					m_writeBuf.resize(bufUnits);
+
+				size_t nbUnits = m_transcoder8.convert(pCur, chunkSize, &m_writeBuf[0]);
+				if (nbUnits && !::fwrite(&m_writeBuf[0], nbUnits * sizeof(utf16), 1, m_pFile))
+					return 0;
+				pCur += chunkSize;
+			}
             ret = 1;
             break;
         }
@@ -385,23 +710,20 @@ size_t Utf8_16_Write::convert(char* p, size_t _size)
         case uni16LE_NoBOM:
         case uni16BE:
         case uni16LE: {
-            m_pNewBuf = (ubyte*)new ubyte[sizeof(utf16) * (_size + 1)];
+            m_pNewBuf = (ubyte*)new ubyte[sizeof(utf16) * (Utf8ToUtf16Transcoder::maxOutputUnits(_size) + 2)];
 
             if (m_eEncoding == uni16BE || m_eEncoding == uni16LE) {
                 // Write the BOM
                 memcpy(m_pNewBuf, k_Boms[m_eEncoding], 2);
             }
 
-            Utf8_Iter iter8;
-            iter8.set(reinterpret_cast<const ubyte*>(p), _size, m_eEncoding);
+            // The whole text is given at once, nothing is left pending
+            Utf8ToUtf16Transcoder transcoder;
+            transcoder.reset(isBigEndian());
 
             utf16* pCur = (utf16*)&m_pNewBuf[2];
-
-            for (; iter8; ++iter8) {
-                if (iter8.canGet()) {
-                    *pCur++ = iter8.get();
-                }
-            }
+            pCur += transcoder.convert(reinterpret_cast<const ubyte*>(p), _size, pCur);
+            pCur += transcoder.flush(pCur);
             m_nBufSize = (const char*)pCur - (const char*)m_pNewBuf;
         }
         break;
@@ -420,158 +742,27 @@ void Utf8_16_Write::setEncoding(UniMode eType)
 }
 
 
-void Utf8_16_Write::fclose()
+bool Utf8_16_Write::fclose()
 {
+	bool isClosed = true;
 	if (m_pNewBuf)
+	{
 		delete [] m_pNewBuf;
-
-	if (m_pFile)
-		::fclose(m_pFile);
-}
-
-
-//=================================================================
-Utf8_Iter::Utf8_Iter()
-{
-	reset();
-}
-
-void Utf8_Iter::reset()
-{
-	m_pBuf = NULL;
-	m_pRead = NULL;
-	m_pEnd = NULL;
-	m_eState = eStart;
-	m_nCur = 0;
-	m_eEncoding = uni8Bit;
-}
-
-void Utf8_Iter::set(const ubyte* pBuf, size_t nLen, UniMode eEncoding)
-{
-	m_pBuf      = pBuf;
-	m_pRead     = pBuf;
-	m_pEnd      = pBuf + nLen;
-	m_eEncoding = eEncoding;
-	operator++();
-	// Note: m_eState, m_nCur not set
-}
-
-// Go to the next byte.
-void Utf8_Iter::operator++()
-{
-	switch (m_eState)
-    {
-        case eStart:
-            if (*m_pRead < 0x80) {
-                m_nCur = *m_pRead;
-                toStart();
-            } else if (*m_pRead < 0xE0) {
-                m_nCur = static_cast<utf16>((0x1F & *m_pRead) << 6);
-                m_eState = e2Bytes_Byte2;
-            } else {
-                m_nCur = static_cast<utf16>((0xF & *m_pRead) << 12);
-                m_eState = e3Bytes_Byte2;
-            }
-            break;
-        case e2Bytes_Byte2:
-        case e3Bytes_Byte3:
-            m_nCur |= static_cast<utf8>(0x3F & *m_pRead);
-            toStart();
-            break;
-        case e3Bytes_Byte2:
-            m_nCur |= static_cast<utf16>((0x3F & *m_pRead) << 6);
-            m_eState = e3Bytes_Byte3;
-            break;
+		m_pNewBuf = NULL;
 	}
-	++m_pRead;
-}
 
-void Utf8_Iter::toStart()
-{
-	m_eState = eStart;
-	if (m_eEncoding == uni16BE || m_eEncoding == uni16BE_NoBOM)
-    {
-		swap();
+	if (m_pFile)
+	{
+		// The text may end with a truncated character
+		if (!m_bFirstWrite && isUtf16())
+		{
+			utf16 lastUnit;
+			if (m_transcoder8.flush(&lastUnit) && !::fwrite(&lastUnit, sizeof(utf16), 1, m_pFile))
+				isClosed = false;
+		}
+		if (::fclose(m_pFile) != 0)
+			isClosed = false;
+		m_pFile = NULL;
 	}
+	return isClosed;
 }
-
-void Utf8_Iter::swap()
-{
-	utf8* p = reinterpret_cast<utf8*>(&m_nCur);
-	utf8 swapbyte = *p;
-	*p = *(p + 1);
-	*(p + 1) = swapbyte;
-}
-
-//==================================================
-Utf16_Iter::Utf16_Iter()
-{
-	reset();
-}
-
-void Utf16_Iter::reset()
-{
-	m_pBuf = NULL;
-	m_pRead = NULL;
-	m_pEnd = NULL;
-	m_eState = eStart;
-	m_nCur = 0;
-	m_nCur16 = 0;
-	m_eEncoding = uni8Bit;
-}
-
-void Utf16_Iter::set(const ubyte* pBuf, size_t nLen, UniMode eEncoding)
-{
-	m_pBuf = pBuf;
-	m_pRead = pBuf;
-	m_pEnd = pBuf + nLen;
-	m_eEncoding = eEncoding;
-	m_eState = eStart;
-	operator++();
-	// Note: m_eState, m_nCur, m_nCur16 not reinitalized.
-}
-
-// Goes to the next byte.
-// Not the next symbol which you might expect.
-// This way we can continue from a partial buffer that doesn't align
-void Utf16_Iter::operator++()
-{
-	switch (m_eState)
-    {
-        case eStart:
-            if (m_eEncoding == uni16LE || m_eEncoding == uni16LE_NoBOM)
-            {
-                m_nCur16 = *m_pRead++;
-                m_nCur16 |= static_cast<utf16>(*m_pRead << 8);
-            }
-            else //(m_eEncoding == uni16BE || m_eEncoding == uni16BE_NoBOM)
-            {
-                m_nCur16 = static_cast<utf16>(*m_pRead++ << 8);
-                m_nCur16 |= *m_pRead;
-            }
-            ++m_pRead;
-
-            if (m_nCur16 < 0x80) {
-                m_nCur = static_cast<ubyte>(m_nCur16 & 0xFF);
-                m_eState = eStart;
-            } else if (m_nCur16 < 0x800) {
-                m_nCur = static_cast<ubyte>(0xC0 | m_nCur16 >> 6);
-                m_eState = e2Bytes2;
-            } else {
-                m_nCur = static_cast<ubyte>(0xE0 | m_nCur16 >> 12);
-                m_eState = e3Bytes2;
-            }
-            break;
-        case e2Bytes2:
-        case e3Bytes3:
-            m_nCur = static_cast<ubyte>(0x80 | m_nCur16 & 0x3F);
-            m_eState = eStart;
-            break;
-        case e3Bytes2:
-            m_nCur = static_cast<ubyte>(0x80 | ((m_nCur16 >> 6) & 0x3F));
-            m_eState = e3Bytes3;
-            break;
-    }
-}
-
-
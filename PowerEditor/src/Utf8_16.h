@@ -32,71 +32,59 @@ public:
 	typedef UCHAR utf8; // 8 bits
 	typedef UCHAR ubyte;
 	static const utf8 k_Boms[uniEnd][3];
+
+	// Length of the run of 7 bits characters at the start of buf (SSE2 when available).
+	// If stopAtNul is true, a NUL byte ends the run too.
+	static size_t asciiLength(const ubyte* buf, size_t len, bool stopAtNul = false);
 };
 
-// Reads UTF-16 and outputs UTF-8
-class Utf16_Iter : public Utf8_16 {
+// Converts UTF-16 to UTF-8 block by block. Surrogate pairs give 4 bytes sequences,
+// lone surrogates are kept as 3 bytes sequences so that they survive a round trip.
+// An odd byte or a high surrogate at the end of a block is kept for the next one.
+class Utf16ToUtf8Transcoder : public Utf8_16 {
 public:
-	enum eState {
-	    eStart,
-	    e2Bytes2,
-	    e3Bytes2,
-	    e3Bytes3
-	};
-
-	Utf16_Iter();
-	void reset();
-	void set(const ubyte* pBuf, size_t nLen, UniMode eEncoding);
-	utf8 get() const { return m_nCur; };
-	void operator++();
-	eState getState() { return m_eState; };
-	operator bool() { return m_pRead <= m_pEnd; };
+	Utf16ToUtf8Transcoder() { reset(false); };
+	void reset(bool isBigEndian);
 
-protected:
-	void toStart(); // Put to start state, swap bytes if necessary
+	// Size of the output buffer convert() needs for len bytes of input.
+	static size_t maxOutputSize(size_t len) { return (len / 2 + 2) * 3; };
 
-protected:
-	UniMode m_eEncoding;
-	eState m_eState;
-	utf8 m_nCur;
-	utf16 m_nCur16;
-	const ubyte* m_pBuf;
-	const ubyte* m_pRead;
-	const ubyte* m_pEnd;
+	// Returns the number of bytes written in dest.
+	size_t convert(const ubyte* src, size_t len, ubyte* dest);
+	// Outputs what is still pending at the end of the text.
+	size_t flush(ubyte* dest);
+
+private:
+	bool m_bBigEndian;
+	bool m_bHasPendingByte;
+	ubyte m_nPendingByte;
+	utf16 m_nHighSurrogate;	// 0 if none
+
+	size_t encodeUnit(utf16 unit, ubyte* dest);
 };
 
-// Reads UTF-8 and outputs UTF-16
-class Utf8_Iter : public Utf8_16 {
+// Converts UTF-8 to UTF-16 block by block. 4 bytes sequences give surrogate pairs,
+// invalid bytes give U+FFFD. A character cut at the end of a block is kept for the next one.
+class Utf8ToUtf16Transcoder : public Utf8_16 {
 public:
-	Utf8_Iter();
-	void reset();
-	void set(const ubyte* pBuf, size_t nLen, UniMode eEncoding);
-	utf16 get() const {
-#ifdef _DEBUG
-		assert(m_eState == eStart);
-#endif
-		return m_nCur;
-	}
-	bool canGet() const { return m_eState == eStart; }
-	void operator++();
-	operator bool() { return m_pRead <= m_pEnd; }
+	Utf8ToUtf16Transcoder() { reset(false); };
+	void reset(bool isBigEndian);
 
-protected:
-	void swap();
-	void toStart(); // Put to start state, swap bytes if necessary
-	enum eState {
-	    eStart,
-	    e2Bytes_Byte2,
-	    e3Bytes_Byte2,
-	    e3Bytes_Byte3
-	};
-protected:
-	UniMode m_eEncoding;
-	eState m_eState;
-	utf16 m_nCur;
-	const ubyte* m_pBuf;
-	const ubyte* m_pRead;
-	const ubyte* m_pEnd;
+	// Number of UTF-16 units convert() may write for len bytes of input.
+	static size_t maxOutputUnits(size_t len) { return len + 4; };
+
+	// Returns the number of UTF-16 units written in dest, already in the right byte order.
+	size_t convert(const ubyte* src, size_t len, utf16* dest);
+	// Outputs what is still pending at the end of the text.
+	size_t flush(utf16* dest);
+
+private:
+	bool m_bBigEndian;
+	ubyte m_pending[4];
+	size_t m_nPending;
+
+	utf16 order(utf16 unit) const { return m_bBigEndian?static_cast<utf16>((unit >> 8) | (unit << 8)):unit; };
+	size_t decodeChar(const ubyte* src, size_t len, utf16* dest, size_t* pCharLen) const;
 };
 
 // Reads UTF16 and outputs UTF8
@@ -125,7 +113,7 @@ private:
 	size_t			m_nSkip;
 	bool            m_bFirstRead;
 	size_t          m_nLen;
-	Utf16_Iter      m_Iter16;
+	Utf16ToUtf8Transcoder m_transcoder16;
 };
 
 // Read in a UTF-8 buffer and write out to UTF-16 or UTF-8
@@ -138,7 +126,7 @@ public:
 
 	FILE * fopen(const TCHAR *_name, const TCHAR *_type);
 	size_t fwrite(const void* p, size_t _size);
-	void   fclose();
+	bool   fclose();	// false if some data could not be written
 
 	size_t convert(char* p, size_t _size);
 	char* getNewBuf() { return reinterpret_cast<char*>(m_pNewBuf); }
@@ -150,6 +138,11 @@ protected:
 	ubyte* m_pNewBuf;
 	size_t m_nBufSize;
 	bool m_bFirstWrite;
+	Utf8ToUtf16Transcoder m_transcoder8;
+	std::vector<utf16> m_writeBuf;
+
+	bool isUtf16() const { return m_eEncoding == uni16BE || m_eEncoding == uni16LE || m_eEncoding == uni16BE_NoBOM || m_eEncoding == uni16LE_NoBOM; };
+	bool isBigEndian() const { return m_eEncoding == uni16BE || m_eEncoding == uni16BE_NoBOM; };
 };
 
 #endif // UTF816_H
@@ -232,6 +232,7 @@
     #define    IDM_VIEW_LOAD_IN_NEW_INSTANCE     10004
 
     #define    IDM_VIEW_SWITCHTO_OTHER_VIEW       (IDM_VIEW + 72)
+    #define    IDM_VIEW_MONITORING                (IDM_VIEW + 73)
 
 #define    IDM_FORMAT    (IDM + 5000)
     #define    IDM_FORMAT_TODOS             (IDM_FORMAT + 1)
@@ -330,6 +330,7 @@
 	#define NPPM_INTERNAL_DOCORDERCHANGED			(NOTEPADPLUS_USER_INTERNAL + 32)
 	#define NPPM_INTERNAL_SETMULTISELCTION          (NOTEPADPLUS_USER_INTERNAL + 33)
 	#define	NPPM_INTERNAL_SCINTILLAFINFEROPENALL 	(NOTEPADPLUS_USER_INTERNAL + 34)
+	#define	NPPM_INTERNAL_FILESCHANGED				(NOTEPADPLUS_USER_INTERNAL + 35)
 
 	//wParam: 0
 	//lParam: document new index
@@ -168,6 +168,7 @@ int getNumberFromParam(char paramName, ParamVector & params, bool & isParamePres
 
 #ifndef SHIPPING
 	#define FLAG_RUN_UNITTESTS TEXT("-unittests") // "Secret" option
+	#define FLAG_STARTUP_TRACE TEXT("-startuptrace") // "Secret" option, saves the startup phases in %TEMP%\nppStartupTrace.json
 #endif
 
 #ifdef _DEBUG
@@ -243,6 +244,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR /*cmdLineAnsi*/, int /*
 	bool isLeakDetect = isInList(FLAG_LEAK_DETECT, params);
 #endif
 
+#ifndef SHIPPING
+	bool isStartupTrace = isInList(FLAG_STARTUP_TRACE, params);
+#endif
+
 	CmdLineParams cmdLineParams;
 	cmdLineParams._isNoTab = isInList(FLAG_NOTABBAR, params);
 	cmdLineParams._isNoPlugin = isInList(FLAG_NO_PLUGIN, params);
@@ -412,6 +417,27 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR /*cmdLineAnsi*/, int /*
 		while (going)
 		{
 			going = (unicodeSupported?(::GetMessageW(&msg, NULL, 0, 0)):(::GetMessageA(&msg, NULL, 0, 0))) != 0;
+#ifndef SHIPPING
+			// The startup is over once the first paint is done: that's what the user waits for
+			if (isStartupTrace && going && msg.message == WM_PAINT)
+			{
+				{
+					profile_scope("first paint");
+					if (unicodeSupported)
+						::DispatchMessageW(&msg);
+					else
+						::DispatchMessage(&msg);
+				}
+				isStartupTrace = false;
+
+				TCHAR tmpDir[MAX_PATH];
+				::GetTempPath(MAX_PATH, tmpDir);
+				generic_string tracePath = tmpDir;
+				PathAppend(tracePath, TEXT("nppStartupTrace.json"));
+				NppDebug::g_profileTrace->writeChromeTrace(tracePath.c_str());
+				continue;
+			}
+#endif
 			if (going)
 			{
 				// if the message doesn't belong to the notepad_plus_plus's dialog
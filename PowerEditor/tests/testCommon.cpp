@@ -26,6 +26,8 @@
 // - PathRemoveFileSpecTest
 // - PathCanonicalizeTest
 // - CompareNoCaseTest
+// - WcharMbcsConvertorTest
+// - MbcsStreamConvertorTest
 //
 //////////////////////////////////////////////////////////////////////////
 
@@ -826,4 +828,66 @@ TEST(WcharMbcsConvertorTest, TestStringBufferDeleteAfterEmptyAndSizeTo)
 	ASSERT_NO_THROW(delete strBuffer);
 }
 
+TEST(WcharMbcsConvertorTest, OwnedConvertorsDontShareResults)
+{
+	WcharMbcsConvertor first;
+	WcharMbcsConvertor second;
+	const wchar_t *firstResult = first.char2wchar("first", CP_ACP);
+	const wchar_t *secondResult = second.char2wchar("second", CP_ACP);
+	EXPECT_STREQ(L"first", firstResult);
+	EXPECT_STREQ(L"second", secondResult);
+}
+
+TEST(WcharMbcsConvertorTest, TestStringBufferGrowsGeometrically)
+{
+	WcharMbcsConvertor::StringBuffer<char> strBuffer;
+	strBuffer.sizeTo(2000);
+	strBuffer.sizeTo(2001);
+	char *grownAlloc = strBuffer;
+	strBuffer.sizeTo(3000);
+	// Growing by one byte left enough room for the next request
+	EXPECT_EQ(grownAlloc, (char *)strBuffer);
+}
+
+//////////////////////////////////////////////////////////////////////////
+//
+// MbcsStreamConvertorTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+TEST(MbcsStreamConvertorTest, Utf8CharacterCutBetweenBlocks)
+{
+	MbcsStreamConvertor convertor(CP_UTF8, NPP_CP_WIN_1252);
+	int len = 0;
+	const char *converted = convertor.convert("caf\xC3", 4, &len);
+	EXPECT_EQ(3, len);
+	EXPECT_EQ(0, strncmp("caf", converted, len));
+	EXPECT_EQ(1, convertor.pendingBytes());
+
+	converted = convertor.convert("\xA9!", 2, &len);
+	EXPECT_EQ(2, len);
+	EXPECT_EQ(0, strncmp("\xE9!", converted, len));
+	EXPECT_EQ(0, convertor.pendingBytes());
+}
+
+TEST(MbcsStreamConvertorTest, BlockMadeOfATruncatedCharacter)
+{
+	MbcsStreamConvertor convertor(CP_UTF8, NPP_CP_WIN_1252);
+	int len = 0;
+	convertor.convert("\xC3", 1, &len);
+	EXPECT_EQ(0, len);
+	const char *converted = convertor.convert("\xA9", 1, &len);
+	EXPECT_EQ(1, len);
+	EXPECT_EQ('\xE9', converted[0]);
+}
+
+TEST(MbcsStreamConvertorTest, FlushWithNothingPending)
+{
+	MbcsStreamConvertor convertor(CP_UTF8, NPP_CP_WIN_1252);
+	int len = 0;
+	convertor.convert("abc", 3, &len);
+	convertor.flush(&len);
+	EXPECT_EQ(0, len);
+}
+
 #endif
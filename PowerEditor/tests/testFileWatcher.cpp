@@ -0,0 +1,148 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+
+#ifndef SHIPPING
+#include "ScintillaComponent/FileWatcher.h"
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Table of Content:
+// - FileWatcherTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// FileWatcherTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+class FileWatcherTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		TCHAR tempPath[MAX_PATH];
+		::GetTempPath(MAX_PATH, tempPath);
+		TCHAR name[64];
+		wsprintf(name, TEXT("NppFileWatcherTest%u"), ::GetCurrentProcessId());
+		_directory = tempPath;
+		PathAppend(_directory, name);
+		::CreateDirectory(_directory.c_str(), NULL);
+		_pWatcher = FileWatcher::create(NULL, 0);
+	}
+
+	virtual void TearDown()
+	{
+		delete _pWatcher;
+		::DeleteFile(path(TEXT("Changed.txt")).c_str());
+		::DeleteFile(path(TEXT("Other.txt")).c_str());
+		::RemoveDirectory(_directory.c_str());
+	}
+
+	generic_string path(const TCHAR *name) const
+	{
+		generic_string result = _directory;
+		PathAppend(result, name);
+		return result;
+	}
+
+	void writeFile(const TCHAR *name)
+	{
+		FILE *f = NULL;
+		generic_fopen(f, path(name).c_str(), TEXT("ab"));
+		ASSERT_TRUE(f != NULL);
+		fputs("text", f);
+		fclose(f);
+	}
+
+	// Changes arrive from the worker thread, give it a few seconds
+	bool waitForChanges(DirectoryChangesMap & changes)
+	{
+		for (int i = 0; i < 100; i++)
+		{
+			_pWatcher->takeChanges(changes);
+			if (!changes.empty())
+				return true;
+			::Sleep(50);
+		}
+		return false;
+	}
+
+	generic_string _directory;
+	FileWatcher *_pWatcher;
+};
+
+TEST_F(FileWatcherTest, reportsChangedFileInLowerCase)
+{
+	ASSERT_TRUE(_pWatcher->addDirectory(_directory.c_str()));
+	ASSERT_TRUE(_pWatcher->isWatching(_directory.c_str()));
+	writeFile(TEXT("Changed.txt"));
+
+	DirectoryChangesMap changes;
+	ASSERT_TRUE(waitForChanges(changes));
+	DirectoryChangesMap::const_iterator it = changes.find(FileWatcher::directoryKey(_directory.c_str()));
+	ASSERT_TRUE(it != changes.end());
+	const std::vector<generic_string> & names = it->second._fileNames;
+	ASSERT_TRUE(it->second._allFiles || std::find(names.begin(), names.end(), generic_string(TEXT("changed.txt"))) != names.end());
+}
+
+TEST_F(FileWatcherTest, coalescesRepeatedChanges)
+{
+	ASSERT_TRUE(_pWatcher->addDirectory(_directory.c_str()));
+	for (int i = 0; i < 10; i++)
+		writeFile(TEXT("Changed.txt"));
+	writeFile(TEXT("Other.txt"));
+	::Sleep(500);
+
+	DirectoryChangesMap changes;
+	ASSERT_TRUE(waitForChanges(changes));
+	ASSERT_EQ(1u, changes.size());
+	if (!changes.begin()->second._allFiles)
+		ASSERT_EQ(2u, changes.begin()->second._fileNames.size());
+}
+
+TEST_F(FileWatcherTest, removedDirectoryIsNotWatched)
+{
+	ASSERT_TRUE(_pWatcher->addDirectory(_directory.c_str()));
+	ASSERT_TRUE(_pWatcher->addDirectory(_directory.c_str()));
+	_pWatcher->removeDirectory(_directory.c_str());
+	ASSERT_TRUE(_pWatcher->isWatching(_directory.c_str()));
+	_pWatcher->removeDirectory(_directory.c_str());
+	ASSERT_FALSE(_pWatcher->isWatching(_directory.c_str()));
+}
+
+TEST_F(FileWatcherTest, missingDirectoryCannotBeWatched)
+{
+	generic_string missing = path(TEXT("missing"));
+	ASSERT_FALSE(_pWatcher->addDirectory(missing.c_str()));
+	ASSERT_FALSE(_pWatcher->isWatching(missing.c_str()));
+	_pWatcher->removeDirectory(missing.c_str());
+}
+
+TEST(FileWatcherKeyTest, directoryKey)
+{
+	ASSERT_EQ(generic_string(TEXT("c:\\dir\\sub")), FileWatcher::directoryKey(TEXT("C:\\Dir\\Sub\\")));
+	ASSERT_EQ(generic_string(TEXT("c:\\")), FileWatcher::directoryKey(TEXT("C:\\")));
+}
+
+#endif
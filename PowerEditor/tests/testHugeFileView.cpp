@@ -0,0 +1,208 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+
+#ifndef SHIPPING
+#include "ScintillaComponent/HugeFileView.h"
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Table of Content:
+// - HugeFileViewTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// HugeFileViewTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+// The views are given small windows, the files are a few thousand lines long so that
+// the index has several checkpoints and the searches cross their blocks.
+class HugeFileViewTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		TCHAR tempPath[MAX_PATH];
+		::GetTempPath(MAX_PATH, tempPath);
+		TCHAR name[64];
+		wsprintf(name, TEXT("NppHugeFileViewTest%u.txt"), ::GetCurrentProcessId());
+		_path = tempPath;
+		PathAppend(_path, name);
+	}
+
+	virtual void TearDown()
+	{
+		::DeleteFile(_path.c_str());
+	}
+
+	// "line 0\n", "line 1\n"... with the start of each line in _lineStarts
+	void writeLines(int nbLines, const char *bom = "")
+	{
+		std::string text;
+		_lineStarts.clear();
+		for (int i = 0 ; i < nbLines ; i++)
+		{
+			_lineStarts.push_back(text.length());
+			char line[32];
+			sprintf(line, "line %d\n", i);
+			text += line;
+		}
+		writeFile(std::string(bom) + text);
+	}
+
+	void writeFile(const std::string & content)
+	{
+		FILE *f = NULL;
+		generic_fopen(f, _path.c_str(), TEXT("wb"));
+		ASSERT_TRUE(f != NULL);
+		fwrite(content.c_str(), 1, content.length(), f);
+		fclose(f);
+	}
+
+	// The index is built in the background
+	bool waitForIndex(HugeFileView & view)
+	{
+		for (int i = 0 ; i < 100 ; i++)
+		{
+			if (view.isIndexComplete())
+				return true;
+			::Sleep(50);
+		}
+		return false;
+	}
+
+	generic_string _path;
+	std::vector<__int64> _lineStarts;
+};
+
+// Keeps what findAll reports
+class MatchRecorder : public HugeFileSearchHandler
+{
+public:
+	virtual bool onMatch(const HugeFileMatch & match) {
+		matches.push_back(match);
+		return true;
+	};
+	std::vector<HugeFileMatch> matches;
+};
+
+TEST_F(HugeFileViewTest, indexesLines)
+{
+	writeLines(5000);
+	HugeFileView view(_path.c_str(), 1000);
+	ASSERT_TRUE(view.open());
+	ASSERT_EQ(int(UNIX_FORMAT), view.getFormat());
+	ASSERT_TRUE(waitForIndex(view));
+
+	// The empty line after the last EOL counts, as in Scintilla
+	ASSERT_EQ(5001, view.getLineCount());
+	ASSERT_EQ(_lineStarts[2500], view.positionFromLine(2500));
+	ASSERT_EQ(_lineStarts[1024], view.positionFromLine(1024));
+	ASSERT_EQ(2500, view.lineFromPosition(_lineStarts[2500]));
+	ASSERT_EQ(2500, view.lineFromPosition(_lineStarts[2500] + 3));
+	ASSERT_EQ(1023, view.lineFromPosition(_lineStarts[1024] - 1));
+	ASSERT_EQ(-1, view.positionFromLine(5001));
+}
+
+TEST_F(HugeFileViewTest, windowIsCutAtLines)
+{
+	writeLines(5000);
+	HugeFileView view(_path.c_str(), 1000);
+	ASSERT_TRUE(view.open());
+
+	std::string text;
+	ASSERT_TRUE(view.readWindow(20000, text));
+	ASSERT_TRUE(text.length() <= 1000);
+	ASSERT_EQ(__int64(text.length()), view.getWindowEnd() - view.getWindowStart());
+	ASSERT_TRUE(view.getWindowStart() <= 20000 && 20000 <= view.getWindowEnd());
+	ASSERT_TRUE(std::find(_lineStarts.begin(), _lineStarts.end(), view.getWindowStart()) != _lineStarts.end());
+	ASSERT_EQ('\n', text[text.length() - 1]);
+
+	// Near the end, the window still gets its full size
+	ASSERT_TRUE(view.readWindow(view.getTextLength(), text));
+	ASSERT_EQ(view.getTextLength(), view.getWindowEnd());
+	ASSERT_TRUE(text.length() > 900);
+}
+
+TEST_F(HugeFileViewTest, skipsUtf8Bom)
+{
+	writeLines(10, "\xEF\xBB\xBF");
+	HugeFileView view(_path.c_str(), 1000);
+	ASSERT_TRUE(view.open());
+	ASSERT_EQ(uniUTF8, view.getUnicodeMode());
+
+	std::string text;
+	ASSERT_TRUE(view.readWindow(0, text));
+	ASSERT_EQ(std::string("line 0\n"), text.substr(0, 7));
+	ASSERT_EQ(0, view.find(HugeFileSearch("line 0", 6, true, false), 0, true));
+}
+
+TEST_F(HugeFileViewTest, utf16CannotBeViewed)
+{
+	writeFile(std::string("\xFF\xFEl\0i\0n\0e\0", 10));
+	HugeFileView view(_path.c_str(), 1000);
+	ASSERT_FALSE(view.open());
+}
+
+TEST_F(HugeFileViewTest, findsInBothDirections)
+{
+	writeLines(200000);
+	HugeFileView view(_path.c_str(), 1000);
+	ASSERT_TRUE(view.open());
+
+	// Whole word: "line 432" is not found in "line 4321"
+	HugeFileSearch wholeWord("line 432", 8, true, true);
+	ASSERT_EQ(_lineStarts[432], view.find(wholeWord, 0, true));
+	ASSERT_EQ(-1, view.find(wholeWord, _lineStarts[432] + 1, true));
+	ASSERT_EQ(_lineStarts[432], view.find(wholeWord, view.getTextLength(), false));
+	// Upwards, the match has to end before the starting point
+	ASSERT_EQ(-1, view.find(wholeWord, _lineStarts[432] + 7, false));
+
+	// Far enough to cross a search block
+	HugeFileSearch caseFolded("LINE 199999", 11, false, false);
+	ASSERT_EQ(_lineStarts[199999], view.find(caseFolded, 0, true));
+	ASSERT_EQ(-1, view.find(HugeFileSearch("LINE 199999", 11, true, false), 0, true));
+}
+
+TEST_F(HugeFileViewTest, findAllReportsLines)
+{
+	writeLines(5000);
+	HugeFileView view(_path.c_str(), 1000);
+	ASSERT_TRUE(view.open());
+
+	MatchRecorder recorder;
+	ASSERT_EQ(111, view.findAll(HugeFileSearch("line 12", 7, true, false), recorder));
+	ASSERT_EQ(111u, recorder.matches.size());
+	ASSERT_EQ(12, recorder.matches[0]._line);
+	ASSERT_EQ(std::string("line 12"), recorder.matches[0]._lineText);
+	ASSERT_EQ(0, recorder.matches[0]._startInLine);
+	ASSERT_EQ(1299, recorder.matches.back()._line);
+	ASSERT_EQ(_lineStarts[1299], recorder.matches.back()._position);
+
+	MatchRecorder words;
+	ASSERT_EQ(1, view.findAll(HugeFileSearch("12", 2, true, true), words));
+	ASSERT_EQ(5, words.matches[0]._startInLine);
+}
+
+#endif
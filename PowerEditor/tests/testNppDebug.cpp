@@ -26,6 +26,7 @@
 // Table of Content:
 // - DebugOutputtTest
 // - FuncGuardTest
+// - ProfileTraceTest
 //
 //////////////////////////////////////////////////////////////////////////
 
@@ -446,4 +447,93 @@ TEST_F(FuncGuardTest, guardFuncDisabledDebugCategoryCommentEnabled)
 	ASSERT_EQ(expected, s_testDebugOutputStr);
 }
 
+//////////////////////////////////////////////////////////////////////////
+//
+// ProfileTraceTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+class ProfileTraceTest : public ::testing::Test
+{
+public:
+	ProfileTraceTest() :
+		m_originalTrace(NppDebug::g_profileTrace),
+		m_trace(new NppDebug::ProfileTrace())
+	{
+		NppDebug::g_profileTrace = m_trace;
+	}
+
+	~ProfileTraceTest()
+	{
+		NppDebug::g_profileTrace = m_originalTrace;
+		delete m_trace;
+	}
+
+	NppDebug::ProfileTrace* m_originalTrace;
+	NppDebug::ProfileTrace* m_trace;
+};
+
+TEST_F(ProfileTraceTest, timerNested)
+{
+	{
+		profile_scope("outer");
+		{
+			profile_scope("inner");
+			::Sleep(1);
+		}
+	}
+	ASSERT_EQ(2, m_trace->size());
+	const NppDebug::ProfileTrace::Event & inner = m_trace->at(0);
+	const NppDebug::ProfileTrace::Event & outer = m_trace->at(1);
+	EXPECT_EQ(generic_string(TEXT("inner")), inner.name);
+	EXPECT_EQ(generic_string(TEXT("outer")), outer.name);
+	EXPECT_LE(outer.start, inner.start);
+	EXPECT_GE(outer.start + outer.duration, inner.start + inner.duration);
+	EXPECT_GT(inner.duration, 0);
+}
+
+TEST_F(ProfileTraceTest, phasesFollowEachOther)
+{
+	{
+		profile_phases("one");
+		::Sleep(1);
+		profile_next_phase("two");
+		::Sleep(1);
+	}
+	ASSERT_EQ(2, m_trace->size());
+	EXPECT_EQ(generic_string(TEXT("one")), m_trace->at(0).name);
+	EXPECT_EQ(generic_string(TEXT("two")), m_trace->at(1).name);
+	EXPECT_EQ(m_trace->at(0).start + m_trace->at(0).duration, m_trace->at(1).start);
+}
+
+TEST_F(ProfileTraceTest, markHasNoDuration)
+{
+	profile_mark("ready");
+	ASSERT_EQ(1, m_trace->size());
+	EXPECT_LT(m_trace->at(0).duration, 0);
+}
+
+TEST_F(ProfileTraceTest, keepsLastEvents)
+{
+	for (int i = 0 ; i < MAX_PROFILE_EVENTS + 10 ; i++)
+		m_trace->record(TEXT("event"), i, i + 1);
+	ASSERT_EQ(MAX_PROFILE_EVENTS, m_trace->size());
+	EXPECT_EQ(10, m_trace->at(0).start);
+	EXPECT_EQ(MAX_PROFILE_EVENTS + 9, m_trace->at(MAX_PROFILE_EVENTS - 1).start);
+
+	m_trace->clear();
+	ASSERT_EQ(0, m_trace->size());
+}
+
+TEST_F(ProfileTraceTest, chromeTrace)
+{
+	m_trace->record(TEXT("load \"langs.xml\""), 10, 25);
+	m_trace->mark(TEXT("ready"));
+	std::string json = m_trace->toChromeTrace();
+	EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+	EXPECT_NE(std::string::npos, json.find("{\"name\":\"load \\\"langs.xml\\\"\",\"cat\":\"npp\",\"ph\":\"X\",\"ts\":10,\"dur\":15,"));
+	EXPECT_NE(std::string::npos, json.find("{\"name\":\"ready\",\"cat\":\"npp\",\"ph\":\"i\",\"s\":\"p\","));
+	EXPECT_NE(std::string::npos, json.find("],\"displayTimeUnit\":\"ms\"}"));
+}
+
 #endif // SHIPPING
@@ -0,0 +1,193 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+
+#ifndef SHIPPING
+#include "Parameters.h"
+#include "MISC/Common/npp_session.h"
+#include "ScintillaComponent/FileLoader.h"
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Table of Content:
+// - StartupBenchmark
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// StartupBenchmark
+//
+// Replays the part of the startup that does not need a window: loading
+// the configuration files shipped with Notepad++, then restoring a session
+// of generated files. The phases of the last test are saved in
+// %TEMP%\nppStartupBenchmark.json, to be compared in chrome://tracing.
+//
+//////////////////////////////////////////////////////////////////////////
+
+const int benchmarkRuns = 5;
+const int sessionFileCount = 40;
+const int sessionFileLines = 2000;
+
+class StartupBenchmark : public ::testing::Test
+{
+public:
+	StartupBenchmark() :
+		m_originalTrace(NppDebug::g_profileTrace),
+		m_trace(new NppDebug::ProfileTrace())
+	{
+		NppDebug::g_profileTrace = m_trace;
+
+		TCHAR tmpDir[MAX_PATH];
+		::GetTempPath(MAX_PATH, tmpDir);
+		m_fixtureDir = tmpDir;
+		PathAppend(m_fixtureDir, TEXT("nppStartupBenchmark"));
+		::CreateDirectory(m_fixtureDir.c_str(), NULL);
+	}
+
+	~StartupBenchmark()
+	{
+		generic_string tracePath = m_fixtureDir + TEXT(".json");
+		m_trace->writeChromeTrace(tracePath.c_str());
+
+		for (size_t i = 0 ; i < m_fixtureFiles.size() ; i++)
+			::DeleteFile(m_fixtureFiles[i].c_str());
+		::RemoveDirectory(m_fixtureDir.c_str());
+
+		NppDebug::g_profileTrace = m_originalTrace;
+		delete m_trace;
+	}
+
+protected:
+	generic_string fixturePath(const TCHAR *fileName)
+	{
+		generic_string path = m_fixtureDir;
+		PathAppend(path, fileName);
+		m_fixtureFiles.push_back(path);
+		return path;
+	}
+
+	// Source-like files, a mix of ANSI and UTF-8 as found in a real session
+	void writeSessionFixture(Session & session, generic_string & sessionPath)
+	{
+		session._activeView = 0;
+		session._activeMainIndex = 0;
+		session._activeSubIndex = 0;
+		for (int i = 0 ; i < sessionFileCount ; i++)
+		{
+			TCHAR fileName[32];
+			wsprintf(fileName, TEXT("file%d.cpp"), i);
+			generic_string filePath = fixturePath(fileName);
+
+			FILE *fp = NULL;
+			generic_fopen(fp, filePath.c_str(), TEXT("wb"));
+			ASSERT_TRUE(fp != NULL);
+			for (int line = 0 ; line < sessionFileLines ; line++)
+			{
+				if (i % 2)
+					fprintf(fp, "\tint value%d = compute(%d); // caf\xC3\xA9\r\n", line, line * i);
+				else
+					fprintf(fp, "\tint value%d = compute(%d);\r\n", line, line * i);
+			}
+			fclose(fp);
+
+			session._mainViewFiles.push_back(sessionFileInfo(filePath, -1, Position()));
+		}
+
+		sessionPath = fixturePath(TEXT("session.xml"));
+		NppParameters::getInstance()->writeSession(&session, sessionPath.c_str());
+	}
+
+	NppDebug::ProfileTrace* m_originalTrace;
+	NppDebug::ProfileTrace* m_trace;
+	generic_string m_fixtureDir;
+	std::vector<generic_string> m_fixtureFiles;
+};
+
+TEST_F(StartupBenchmark, ConfigFiles)
+{
+	generic_string nppPath = NppParameters::getInstance()->getNppPath();
+	const TCHAR *configFiles[] = {
+		TEXT("langs.model.xml"),
+		TEXT("config.model.xml"),
+		TEXT("shortcuts.xml"),
+		TEXT("contextMenu.xml")
+	};
+
+	for (int run = 0 ; run < benchmarkRuns ; run++)
+	{
+		profile_scope("config files");
+		for (size_t i = 0 ; i < sizeof(configFiles) / sizeof(configFiles[0]) ; i++)
+		{
+			generic_string path = nppPath;
+			PathAppend(path, configFiles[i]);
+			if (!::PathFileExists(path.c_str()))
+				continue;
+
+			profile_scope("TiXmlDocument::LoadFile");
+			TiXmlDocument doc(path);
+			ASSERT_TRUE(doc.LoadFile());
+		}
+
+		// Goes through feedStylerArray like the first load
+		generic_string stylersPath = nppPath;
+		PathAppend(stylersPath, TEXT("stylers.model.xml"));
+		if (::PathFileExists(stylersPath.c_str()))
+		{
+			TCHAR stylers[MAX_PATH];
+			lstrcpy(stylers, stylersPath.c_str());
+			profile_scope("NppParameters::reloadStylers");
+			ASSERT_TRUE(NppParameters::getInstance()->reloadStylers(stylers));
+		}
+	}
+}
+
+TEST_F(StartupBenchmark, SessionRestore)
+{
+	Session writtenSession;
+	generic_string sessionPath;
+	writeSessionFixture(writtenSession, sessionPath);
+
+	for (int run = 0 ; run < benchmarkRuns ; run++)
+	{
+		profile_scope("session restore");
+
+		Session session;
+		{
+			profile_scope("NppParameters::loadSession");
+			ASSERT_TRUE(NppParameters::getInstance()->loadSession(&session, sessionPath.c_str()));
+		}
+		ASSERT_EQ(sessionFileCount, session.nbMainFiles());
+
+		{
+			profile_scope("FileLoaderPool::loadAndDecode");
+			for (size_t i = 0 ; i < session.nbMainFiles() ; i++)
+			{
+				LoadedFileData data;
+				ASSERT_TRUE(FileLoaderPool::loadAndDecode(session._mainViewFiles[i]._fileName.c_str(), session._mainViewFiles[i]._encoding, data));
+				ASSERT_EQ(WIN_FORMAT, data._format);
+				ASSERT_FALSE(data._text.empty());
+			}
+		}
+	}
+}
+
+#endif
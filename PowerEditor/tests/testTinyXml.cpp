@@ -0,0 +1,151 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+
+#ifndef SHIPPING
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Table of Content:
+// - TinyXmlNameTest
+// - TinyXmlLoadTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// TinyXmlNameTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+static const TCHAR *sampleXml = TEXT("<NotepadPlus>\n")
+	TEXT("  <GUIConfigs>\n")
+	TEXT("    <GUIConfig name=\"ToolBar\" visible=\"yes\">standard &amp; big</GUIConfig>\n")
+	TEXT("    <GUIConfig name=\"StatusBar\">  show   it  </GUIConfig>\n")
+	TEXT("  </GUIConfigs>\n")
+	TEXT("  <Empty />\n")
+	TEXT("</NotepadPlus>\n");
+
+TEST(TinyXmlNameTest, InternedNamesAreShared)
+{
+	const TCHAR *name = TiXmlBase::InternName(TEXT("GUIConfig"));
+	ASSERT_EQ(name, TiXmlBase::InternName(TEXT("GUIConfigs"), 9));
+	ASSERT_EQ(name, TiXmlBase::FindName(TEXT("GUIConfig")));
+	ASSERT_EQ(0, lstrcmp(name, TEXT("GUIConfig")));
+	ASSERT_TRUE(TiXmlBase::FindName(TEXT("neverUsedAsAName")) == NULL);
+}
+
+TEST(TinyXmlNameTest, LookupByName)
+{
+	TiXmlDocument doc;
+	doc.Parse(sampleXml);
+	ASSERT_FALSE(doc.Error());
+
+	TiXmlNode *root = doc.FirstChild(TEXT("NotepadPlus"));
+	ASSERT_TRUE(root != NULL);
+	ASSERT_TRUE(root->FirstChild(TEXT("noSuchElement")) == NULL);
+	ASSERT_TRUE(root->LastChild(TEXT("Empty")) != NULL);
+
+	TiXmlElement *toolBar = root->FirstChildElement(TEXT("GUIConfigs"))->FirstChildElement(TEXT("GUIConfig"));
+	ASSERT_TRUE(toolBar != NULL);
+	ASSERT_EQ(0, lstrcmp(toolBar->Attribute(TEXT("name")), TEXT("ToolBar")));
+	ASSERT_TRUE(toolBar->Attribute(TEXT("noSuchAttribute")) == NULL);
+	ASSERT_EQ(0, lstrcmp(toolBar->FirstChild()->Value(), TEXT("standard & big")));
+
+	TiXmlElement *statusBar = toolBar->NextSiblingElement(TEXT("GUIConfig"));
+	ASSERT_TRUE(statusBar != NULL);
+	ASSERT_EQ(0, lstrcmp(statusBar->FirstChild()->Value(), TEXT("show it")));
+	ASSERT_TRUE(statusBar->NextSiblingElement(TEXT("GUIConfig")) == NULL);
+}
+
+TEST(TinyXmlNameTest, RenameAndModify)
+{
+	TiXmlDocument doc;
+	doc.Parse(sampleXml);
+	TiXmlNode *root = doc.FirstChild(TEXT("NotepadPlus"));
+
+	TiXmlElement *added = new TiXmlElement(TEXT("Added"));
+	root->LinkEndChild(added);
+	ASSERT_EQ(added, root->LastChild(TEXT("Added")));
+	added->SetValue(TEXT("Renamed"));
+	ASSERT_EQ(added, root->LastChild(TEXT("Renamed")));
+	ASSERT_TRUE(root->LastChild(TEXT("Added")) == NULL);
+
+	added->SetAttribute(TEXT("freshAttribute"), TEXT("1"));
+	ASSERT_EQ(0, lstrcmp(added->Attribute(TEXT("freshAttribute")), TEXT("1")));
+	added->RemoveAttribute(TEXT("freshAttribute"));
+	ASSERT_TRUE(added->Attribute(TEXT("freshAttribute")) == NULL);
+}
+
+TEST(TinyXmlNameTest, CloneAndPrint)
+{
+	TiXmlDocument doc;
+	doc.Parse(sampleXml);
+
+	TiXmlNode *root = doc.FirstChild(TEXT("NotepadPlus"));
+	TiXmlNode *clone = root->Clone();
+	generic_string original, cloned;
+	original << *root;
+	cloned << *clone;
+	delete clone;
+	ASSERT_EQ(original, cloned);
+
+	TiXmlDocument reparsed;
+	reparsed.Parse(original.c_str());
+	generic_string printed;
+	printed << reparsed;
+	ASSERT_EQ(original, printed);
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// TinyXmlLoadTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+TEST(TinyXmlLoadTest, NormalizesLineEnds)
+{
+	TCHAR tempDir[MAX_PATH];
+	TCHAR tempFile[MAX_PATH];
+	::GetTempPath(MAX_PATH, tempDir);
+	::GetTempFileName(tempDir, TEXT("txl"), 0, tempFile);
+
+	FILE *fp = NULL;
+	generic_fopen(fp, tempFile, TEXT("wb"));
+	ASSERT_TRUE(fp != NULL);
+	fputs("<a x=\"1\">\r\nline\r\n<b />\r\n</a>\r\n\x1A trailing garbage", fp);
+	fclose(fp);
+
+	TiXmlDocument doc(tempFile);
+	bool isLoaded = doc.LoadFile();
+	::DeleteFile(tempFile);
+	ASSERT_TRUE(isLoaded);
+
+	TiXmlElement *a = doc.FirstChildElement(TEXT("a"));
+	ASSERT_TRUE(a != NULL);
+	ASSERT_EQ(0, lstrcmp(a->Attribute(TEXT("x")), TEXT("1")));
+	ASSERT_EQ(0, lstrcmp(a->FirstChild()->Value(), TEXT("line")));
+	ASSERT_TRUE(a->FirstChildElement(TEXT("b")) != NULL);
+}
+
+#endif
@@ -0,0 +1,147 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "precompiled_headers.h"
+
+#ifndef SHIPPING
+#include "Utf8_16.h"
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Table of Content:
+// - Utf8DetectionTest
+// - TranscoderTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Utf8DetectionTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+static UniMode detect(const char *text, size_t len)
+{
+	std::vector<char> buf(text, text + len);
+	Utf8_16_Read reader;
+	reader.convert(&buf[0], len);
+	return reader.getEncoding();
+}
+
+TEST(Utf8DetectionTest, LongAsciiTextIs7Bits)
+{
+	std::string text(1000, 'a');
+	ASSERT_EQ(uni7Bit, detect(text.c_str(), text.size()));
+}
+
+TEST(Utf8DetectionTest, FourBytesSequenceIsUtf8)
+{
+	const char text[] = "smile \xF0\x9F\x98\x80 please, this needs to be longer than 16 bytes";
+	ASSERT_EQ(uniCookie, detect(text, sizeof(text) - 1));
+}
+
+TEST(Utf8DetectionTest, InvalidSequencesAre8Bits)
+{
+	const char overlong[] = "0123456789abcdef\xC0\x80";
+	ASSERT_EQ(uni8Bit, detect(overlong, sizeof(overlong) - 1));
+	const char surrogate[] = "\xED\xA0\x80";
+	ASSERT_EQ(uni8Bit, detect(surrogate, sizeof(surrogate) - 1));
+	const char aboveUnicode[] = "\xF4\x90\x80\x80";
+	ASSERT_EQ(uni8Bit, detect(aboveUnicode, sizeof(aboveUnicode) - 1));
+	const char latin1[] = "caf\xE9 au lait";
+	ASSERT_EQ(uni8Bit, detect(latin1, sizeof(latin1) - 1));
+}
+
+TEST(Utf8DetectionTest, CharacterCutAtEndOfBlockIsUtf8)
+{
+	const char text[] = "0123456789abcdef\xE2\x82";
+	ASSERT_EQ(uniCookie, detect(text, sizeof(text) - 1));
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// TranscoderTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+TEST(TranscoderTest, RoundTripByOneByteBlocks)
+{
+	// ASCII long enough for the vectorized paths, then 2, 3 and 4 bytes characters
+	std::string utf8(40, 'x');
+	utf8 += "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+	const Utf8_16::ubyte *src = reinterpret_cast<const Utf8_16::ubyte *>(utf8.c_str());
+
+	for (int isBigEndian = 0 ; isBigEndian < 2 ; isBigEndian++)
+	{
+		Utf8ToUtf16Transcoder toUtf16;
+		toUtf16.reset(isBigEndian != 0);
+		std::vector<Utf8_16::utf16> utf16(Utf8ToUtf16Transcoder::maxOutputUnits(utf8.size()));
+		size_t nbUnits = toUtf16.convert(src, utf8.size(), &utf16[0]);
+		nbUnits += toUtf16.flush(&utf16[nbUnits]);
+		ASSERT_EQ(44, nbUnits);	// 40 + 1 + 1 + a surrogate pair
+
+		Utf16ToUtf8Transcoder toUtf8;
+		toUtf8.reset(isBigEndian != 0);
+		std::string result;
+		const Utf8_16::ubyte *units = reinterpret_cast<const Utf8_16::ubyte *>(&utf16[0]);
+		Utf8_16::ubyte out[16];	// more than maxOutputSize(1)
+		for (size_t i = 0 ; i < nbUnits * 2 ; i++)
+		{
+			size_t len = toUtf8.convert(units + i, 1, out);
+			result.append(reinterpret_cast<char *>(out), len);
+		}
+		size_t len = toUtf8.flush(out);
+		result.append(reinterpret_cast<char *>(out), len);
+		ASSERT_EQ(utf8, result);
+	}
+}
+
+TEST(TranscoderTest, InvalidUtf8GivesReplacementCharacters)
+{
+	const char text[] = "a\xC0" "b\xE2\x82";
+	Utf8ToUtf16Transcoder toUtf16;
+	Utf8_16::utf16 utf16[16];
+	size_t nbUnits = toUtf16.convert(reinterpret_cast<const Utf8_16::ubyte *>(text), sizeof(text) - 1, utf16);
+	ASSERT_EQ(3, nbUnits);	// the cut character is kept for the next block
+	nbUnits += toUtf16.flush(utf16 + nbUnits);
+	ASSERT_EQ(4, nbUnits);
+	ASSERT_EQ(0xFFFD, utf16[1]);
+	ASSERT_EQ('b', utf16[2]);
+	ASSERT_EQ(0xFFFD, utf16[3]);
+}
+
+TEST(TranscoderTest, LoneSurrogateSurvivesRoundTrip)
+{
+	const Utf8_16::utf16 utf16[] = {'a', 0xD800, 'b'};
+	Utf16ToUtf8Transcoder toUtf8;
+	Utf8_16::ubyte utf8[16];
+	size_t len = toUtf8.convert(reinterpret_cast<const Utf8_16::ubyte *>(utf16), sizeof(utf16), utf8);
+	len += toUtf8.flush(utf8 + len);
+	ASSERT_EQ(5, len);
+
+	Utf8ToUtf16Transcoder toUtf16;
+	Utf8_16::utf16 back[8];
+	size_t nbUnits = toUtf16.convert(utf8, len, back);
+	ASSERT_EQ(3, nbUnits);
+	ASSERT_EQ(0xD800, back[1]);
+}
+
+#endif
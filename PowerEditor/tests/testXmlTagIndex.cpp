@@ -0,0 +1,190 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+
+#ifndef SHIPPING
+#include "ScintillaComponent/XmlTagIndex.h"
+
+//////////////////////////////////////////////////////////////////////////
+//
+// Table of Content:
+// - XmlTagIndexTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+
+
+//////////////////////////////////////////////////////////////////////////
+//
+// XmlTagIndexTest
+//
+//////////////////////////////////////////////////////////////////////////
+
+class StringTextSource : public XmlTagIndex::TextSource
+{
+public:
+	StringTextSource(const char *text) : _text(text) {};
+
+	int length() {
+		return int(_text.size());
+	};
+
+	const char * rangePointer(int start, int) {
+		return _text.c_str() + start;
+	};
+
+	void insert(XmlTagIndex & index, int pos, const char *text) {
+		_text.insert(pos, text);
+		index.textModified(pos, int(strlen(text)), true, length());
+	};
+
+	void erase(XmlTagIndex & index, int pos, int len) {
+		_text.erase(pos, len);
+		index.textModified(pos, len, false, length());
+	};
+
+private:
+	std::string _text;
+};
+
+static bool sameTags(const XmlTagIndex & index, const XmlTagIndex & expected)
+{
+	if (index.nbTags() != expected.nbTags())
+		return false;
+	for (int i = 0 ; i < index.nbTags() ; i++)
+	{
+		const XmlTagIndex::Tag & tag = index.tagAt(i);
+		const XmlTagIndex::Tag & expectedTag = expected.tagAt(i);
+		if (tag._start != expectedTag._start || tag._nameEnd != expectedTag._nameEnd || tag._end != expectedTag._end || tag._kind != expectedTag._kind)
+			return false;
+	}
+	return true;
+}
+
+TEST(XmlTagIndexTest, RecognizesTagKinds)
+{
+	StringTextSource text("<a x=\"1\"><br/></A> < b> <c <d>");
+	XmlTagIndex index;
+	index.sync(text);
+
+	ASSERT_EQ(4, index.nbTags());
+	ASSERT_EQ(XmlTagIndex::openTag, index.tagAt(0)._kind);
+	ASSERT_EQ(2, index.tagAt(0)._nameEnd);
+	ASSERT_EQ(9, index.tagAt(0)._end);
+	ASSERT_EQ(XmlTagIndex::singleTag, index.tagAt(1)._kind);
+	ASSERT_EQ(XmlTagIndex::closeTag, index.tagAt(2)._kind);
+	// Names are case insensitive
+	ASSERT_EQ(index.tagAt(0)._nameId, index.tagAt(2)._nameId);
+	// "< b>" has no name, "<c " is cut by the next '<'
+	ASSERT_EQ(27, index.tagAt(3)._start);
+}
+
+TEST(XmlTagIndexTest, FindsTagAroundPosition)
+{
+	StringTextSource text("ab<x>cd</x>");
+	XmlTagIndex index;
+	index.sync(text);
+
+	ASSERT_EQ(-1, index.findTag(2));
+	ASSERT_EQ(0, index.findTag(3));
+	ASSERT_EQ(0, index.findTag(4));
+	ASSERT_EQ(-1, index.findTag(5));
+	ASSERT_EQ(1, index.findTag(10));
+	ASSERT_EQ(-1, index.findTag(11));
+}
+
+TEST(XmlTagIndexTest, GroupsTagsByName)
+{
+	StringTextSource text("<p><q></q><p/></p>");
+	XmlTagIndex index;
+	index.sync(text);
+
+	const std::vector<int> & named = index.tagsNamed(index.tagAt(0)._nameId);
+	ASSERT_EQ(3, int(named.size()));
+	ASSERT_EQ(3, named[1]);
+	ASSERT_EQ(2, index.rankInName(4));
+}
+
+TEST(XmlTagIndexTest, SyncKeepsNamesOfTagsMoved)
+{
+	StringTextSource text("<p><q></q><p/></p>");
+	XmlTagIndex index;
+	index.sync(text);
+	int p = index.tagAt(0)._nameId;
+	int q = index.tagAt(1)._nameId;
+
+	// A new tag shifts the indexes of the following ones, whatever their names
+	text.insert(index, 3, "<r/>");
+	index.sync(text);
+	ASSERT_EQ(6, index.nbTags());
+	ASSERT_EQ(5, index.tagsNamed(p)[2]);
+	ASSERT_EQ(2, index.rankInName(5));
+	ASSERT_EQ(2, index.tagsNamed(q)[0]);
+	ASSERT_EQ(1, index.rankInName(3));
+	int r = index.tagAt(1)._nameId;
+	ASSERT_EQ(1, int(index.tagsNamed(r).size()));
+
+	text.erase(index, 3, 4);
+	index.sync(text);
+	ASSERT_EQ(5, index.nbTags());
+	ASSERT_EQ(4, index.tagsNamed(p)[2]);
+	ASSERT_EQ(1, index.tagsNamed(q)[0]);
+	ASSERT_TRUE(index.tagsNamed(r).empty());
+}
+
+TEST(XmlTagIndexTest, SyncAfterEditsGivesSameTagsAsRebuild)
+{
+	StringTextSource text("<root>\n<item id=\"1\">one</item>\n<item id=\"2\">two</item>\n<empty/>\n</root>\n");
+	XmlTagIndex index;
+	index.sync(text);
+
+	// Cuts a tag, then makes a new one spanning the cut
+	text.erase(index, 9, 3);
+	text.insert(index, 30, "<new>");
+	text.insert(index, 7, "<x");
+	index.sync(text);
+
+	XmlTagIndex rebuilt;
+	rebuilt.sync(text);
+	ASSERT_TRUE(sameTags(index, rebuilt));
+
+	text.insert(index, 0, "</");
+	text.erase(index, text.length() - 3, 3);
+	index.sync(text);
+
+	XmlTagIndex rebuiltAgain;
+	rebuiltAgain.sync(text);
+	ASSERT_TRUE(sameTags(index, rebuiltAgain));
+}
+
+TEST(XmlTagIndexTest, ModificationsAreReportedOncePerView)
+{
+	StringTextSource text("<a></a>");
+	XmlTagIndex index;
+	index.sync(text);
+
+	text.insert(index, 3, "<b>");
+	index.textModified(3, 3, true, text.length());
+	index.sync(text);
+
+	ASSERT_EQ(3, index.nbTags());
+	ASSERT_EQ(6, index.tagAt(2)._start);
+}
+
+#endif
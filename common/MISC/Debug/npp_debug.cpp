@@ -187,6 +187,158 @@ TCHAR* FuncGuard::getIndent()
 	return TEXT("");
 }
 
+ProfileTrace defaultProfileTrace;
+ProfileTrace* g_profileTrace = &defaultProfileTrace;
+
+ProfileTrace::ProfileTrace()
+{
+	::QueryPerformanceFrequency(&_frequency);
+	::QueryPerformanceCounter(&_origin);
+	clear();
+}
+
+__int64 ProfileTrace::now() const
+{
+	LARGE_INTEGER counter;
+	::QueryPerformanceCounter(&counter);
+	__int64 ticks = counter.QuadPart - _origin.QuadPart;
+	// Split to not overflow with a high frequency counter
+	return (ticks / _frequency.QuadPart) * 1000000 + ((ticks % _frequency.QuadPart) * 1000000) / _frequency.QuadPart;
+}
+
+void ProfileTrace::record(const TCHAR* name, __int64 start, __int64 end)
+{
+	// Each caller gets its own slot, phases can be recorded from any thread
+	LONG index = ::InterlockedIncrement(&_nbRecorded) - 1;
+	Event & event = _events[index % MAX_PROFILE_EVENTS];
+	event.name = name;
+	event.start = start;
+	event.duration = end - start;
+	event.threadId = ::GetCurrentThreadId();
+}
+
+void ProfileTrace::mark(const TCHAR* name)
+{
+	__int64 time = now();
+	record(name, time, time - 1);	// a negative duration tells it is a mark
+}
+
+void ProfileTrace::clear()
+{
+	_nbRecorded = 0;
+}
+
+size_t ProfileTrace::size() const
+{
+	return min(size_t(_nbRecorded), size_t(MAX_PROFILE_EVENTS));
+}
+
+const ProfileTrace::Event& ProfileTrace::at(size_t i) const
+{
+	size_t first = size_t(_nbRecorded) - size();
+	return _events[(first + i) % MAX_PROFILE_EVENTS];
+}
+
+static void appendJsonString(std::string & json, const TCHAR* str)
+{
+#ifdef UNICODE
+	int len = ::WideCharToMultiByte(CP_UTF8, 0, str, -1, NULL, 0, NULL, NULL);
+	std::vector<char> utf8(len > 0 ? len : 1, '\0');
+	::WideCharToMultiByte(CP_UTF8, 0, str, -1, &utf8[0], len, NULL, NULL);
+	const char* p = &utf8[0];
+#else
+	const char* p = str;
+#endif
+	json += '"';
+	for (; *p; p++)
+	{
+		if (*p == '"' || *p == '\\')
+		{
+			json += '\\';
+			json += *p;
+		}
+		else if ((unsigned char)*p < 0x20)
+		{
+			char escaped[8];
+			sprintf_s(escaped, 8, "\\u%04x", (unsigned char)*p);
+			json += escaped;
+		}
+		else
+		{
+			json += *p;
+		}
+	}
+	json += '"';
+}
+
+std::string ProfileTrace::toChromeTrace() const
+{
+	DWORD processId = ::GetCurrentProcessId();
+	std::string json("{\"traceEvents\":[");
+	for (size_t i = 0 ; i < size() ; i++)
+	{
+		const Event & event = at(i);
+		char fields[128];
+		if (event.duration < 0)
+			sprintf_s(fields, 128, "\"ph\":\"i\",\"s\":\"p\",\"ts\":%I64d", event.start);
+		else
+			sprintf_s(fields, 128, "\"ph\":\"X\",\"ts\":%I64d,\"dur\":%I64d", event.start, event.duration);
+
+		json += i ? ",\n{\"name\":" : "\n{\"name\":";
+		appendJsonString(json, event.name);
+		json += ",\"cat\":\"npp\",";
+		json += fields;
+
+		sprintf_s(fields, 128, ",\"pid\":%lu,\"tid\":%lu}", processId, event.threadId);
+		json += fields;
+	}
+	json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return json;
+}
+
+bool ProfileTrace::writeChromeTrace(const TCHAR* filePath) const
+{
+	FILE *fp = NULL;
+	generic_fopen(fp, filePath, TEXT("wb"));
+	if (!fp)
+		return false;
+
+	std::string json = toChromeTrace();
+	bool isWritten = fwrite(json.c_str(), 1, json.length(), fp) == json.length();
+	fclose(fp);
+	return isWritten;
+}
+
+ProfileTimer::ProfileTimer(const TCHAR* name) :
+	_name(name),
+	_start(g_profileTrace->now())
+{
+}
+
+ProfileTimer::~ProfileTimer()
+{
+	g_profileTrace->record(_name, _start, g_profileTrace->now());
+}
+
+ProfilePhases::ProfilePhases(const TCHAR* firstPhase) :
+	_name(firstPhase),
+	_start(g_profileTrace->now())
+{
+}
+
+ProfilePhases::~ProfilePhases()
+{
+	g_profileTrace->record(_name, _start, g_profileTrace->now());
+}
+
+void ProfilePhases::next(const TCHAR* phase)
+{
+	__int64 time = g_profileTrace->now();
+	g_profileTrace->record(_name, _start, time);
+	_name = phase;
+	_start = time;
+}
+
 } // namespace Debug
 
 #endif // #ifndef SHIPPING
@@ -22,6 +22,7 @@
 
 #define MAX_DEBUG_INDENT 32
 #define MAX_DEBUG_STR 1024
+#define MAX_PROFILE_EVENTS 4096
 namespace NppDebug
 {
 	class DebugOutput
@@ -69,6 +70,73 @@ namespace NppDebug
 		static TCHAR _indent[MAX_DEBUG_INDENT];
 	};
 
+	// Keeps the last MAX_PROFILE_EVENTS timed phases, older ones are overwritten.
+	// Names are not copied, they have to stay valid as long as the trace: use literals.
+	class ProfileTrace
+	{
+	public:
+		struct Event
+		{
+			const TCHAR* name;
+			__int64 start;		// microseconds since the trace was created
+			__int64 duration;	// microseconds, -1 for a mark (a point in time)
+			DWORD threadId;
+		};
+
+		ProfileTrace();
+
+		__int64 now() const;
+		void record(const TCHAR* name, __int64 start, __int64 end);
+		void mark(const TCHAR* name);
+		void clear();
+
+		// Kept events, 0 being the oldest one
+		size_t size() const;
+		const Event& at(size_t i) const;
+
+		// Trace Event Format, as loaded by chrome://tracing (and other viewers).
+		std::string toChromeTrace() const;
+		bool writeChromeTrace(const TCHAR* filePath) const;
+
+	private:
+		LARGE_INTEGER _frequency;
+		LARGE_INTEGER _origin;
+		Event _events[MAX_PROFILE_EVENTS];
+		volatile LONG _nbRecorded;	// may be more than MAX_PROFILE_EVENTS
+
+		ProfileTrace(const ProfileTrace&);
+		const ProfileTrace& operator= (const ProfileTrace&);
+	};
+
+	extern ProfileTrace* g_profileTrace;
+
+	// Records the time spent in its scope into g_profileTrace.
+	class ProfileTimer
+	{
+	public:
+		ProfileTimer(const TCHAR* name);
+		~ProfileTimer();
+
+	private:
+		const TCHAR* _name;
+		__int64 _start;
+	};
+
+	// Records consecutive phases of a function, without having to give each its own scope:
+	// next() ends the current phase and starts the following one, the last one ends with the object.
+	class ProfilePhases
+	{
+	public:
+		ProfilePhases(const TCHAR* firstPhase);
+		~ProfilePhases();
+
+		void next(const TCHAR* phase);
+
+	private:
+		const TCHAR* _name;
+		__int64 _start;
+	};
+
 } // namespace NppDebug
 
 // debugf() works just at printf(), except that it outputs to the debug console in MSVC
@@ -201,6 +269,46 @@ namespace NppDebug
 #define guard_debugf_cat(cat, format, ...) \
 	__npp_func_guard__.printf(__func_guard_category_##cat, format, __VA_ARGS__)
 
+//
+//  Profile Timers
+// ================
+//
+// Where the debug guards tell which path the code takes, the profile timers tell how long it takes.
+// They are always on and cheap (two QueryPerformanceCounter calls and a ring buffer slot), so they
+// can stay in the code, in the startup path for instance. Every timed phase goes to
+// NppDebug::g_profileTrace, which can be saved with writeChromeTrace() and opened in chrome://tracing:
+// phases of the same thread nest in the viewer as they nest in the code.
+//
+// For example:
+//
+// void FooTwo()
+// {
+//     profile_scope("FooTwo");	// measures the whole function
+//     FooOne();
+// }
+//
+// bool Load()
+// {
+//     profile_phases("langs.xml");	// measures the loading of langs.xml...
+//     loadLangs();
+//     profile_next_phase("config.xml");	// ...then the loading of config.xml, until the function returns
+//     loadConfig();
+// }
+//
+// profile_mark("ready") records a point in time instead of a duration.
+//
+// There can be only one profile_scope() and one profile_phases() per scope.
+// As the guards, they are compiled out in SHIPPING mode.
+
+#define profile_scope(name) \
+	NppDebug::ProfileTimer __npp_profile_timer__(TEXT(name))
+#define profile_phases(firstPhase) \
+	NppDebug::ProfilePhases __npp_profile_phases__(TEXT(firstPhase))
+#define profile_next_phase(phase) \
+	__npp_profile_phases__.next(TEXT(phase))
+#define profile_mark(name) \
+	NppDebug::g_profileTrace->mark(TEXT(name))
+
 #else // if !SHIPPING
 
 #define debugf(format, ...) void(0)
@@ -215,6 +323,11 @@ namespace NppDebug
 #define guard_debugf(format, ...) void(0)
 #define guard_debugf_cat(cat, format, ...) void(0)
 
+#define profile_scope(name) void(0)
+#define profile_phases(firstPhase) void(0)
+#define profile_next_phase(phase) void(0)
+#define profile_mark(name) void(0)
+
 #endif // SHIPPING
 
 #ifdef _DEBUG
@@ -18,7 +18,7 @@ namespace Scintilla {
 	#define SCI_METHOD
 #endif
 
-enum { dvOriginal=0 };
+enum { dvOriginal=0, dvRangePointer=1 };
 
 class IDocument {
 public:
@@ -45,6 +45,15 @@ public:
 	virtual int SCI_METHOD GetLineIndentation(int line) = 0;
 };
 
+/** Documents with a Version() of dvRangePointer or more also give direct access to their text.
+ * The text is in two contiguous parts, before and after GapPosition(); RangePointer does not
+ * move anything for a range inside one of them and the pointer stays valid until the text changes. */
+class IDocumentWithRangePointer : public IDocument {
+public:
+	virtual const char * SCI_METHOD RangePointer(int position, int rangeLength) = 0;
+	virtual int SCI_METHOD GapPosition() const = 0;
+};
+
 enum { lvOriginal=0 };
 
 class ILexer {
@@ -144,6 +144,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_MARKERGET 2046
 #define SCI_MARKERNEXT 2047
 #define SCI_MARKERPREVIOUS 2048
+#define SCI_MARKERGETLINES 2645
 #define SCI_MARKERDEFINEPIXMAP 2049
 #define SCI_MARKERADDSET 2466
 #define SCI_MARKERSETALPHA 2476
@@ -389,6 +390,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_SETTARGETEND 2192
 #define SCI_GETTARGETEND 2193
 #define SCI_REPLACETARGET 2194
+#define SCI_REPLACERANGES 2649
 #define SCI_REPLACETARGETRE 2195
 #define SCI_SEARCHINTARGET 2197
 #define SCI_SETSEARCHFLAGS 2198
@@ -695,14 +697,21 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_GETINDICATORVALUE 2503
 #define SCI_INDICATORFILLRANGE 2504
 #define SCI_INDICATORCLEARRANGE 2505
+#define SCI_INDICATORFILLRANGES 2646
 #define SCI_INDICATORALLONFOR 2506
 #define SCI_INDICATORVALUEAT 2507
 #define SCI_INDICATORSTART 2508
 #define SCI_INDICATOREND 2509
+#define SC_INDICSTORAGE_DEFAULT 0
+#define SC_INDICSTORAGE_TREE 1
+#define SCI_SETINDICATORSTORAGE 2647
+#define SCI_GETINDICATORSTORAGE 2648
 #define SCI_SETPOSITIONCACHE 2514
 #define SCI_GETPOSITIONCACHE 2515
 #define SCI_COPYALLOWLINE 2519
 #define SCI_GETCHARACTERPOINTER 2520
+#define SCI_GETRANGEPOINTER 2643
+#define SCI_GETGAPPOSITION 2644
 #define SCI_SETKEYSUNICODE 2521
 #define SCI_GETKEYSUNICODE 2522
 #define SCI_INDICSETALPHA 2523
@@ -838,6 +847,8 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SC_MOD_CONTAINER 0x40000
 #define SC_MOD_LEXERSTATE 0x80000
 #define SC_MODEVENTMASKALL 0xFFFFF
+#define SC_MULTIRANGEEDIT 0x1000000
+#define SC_LASTSTEPINMULTIRANGEEDIT 0x2000000
 #define SC_SEARCHRESULT_LINEBUFFERMAXLENGTH 1024
 #define SCEN_CHANGE 768
 #define SCEN_SETFOCUS 512
@@ -920,6 +931,15 @@ struct Sci_TextToFind {
 	struct Sci_CharacterRange chrgText;
 };
 
+/* One edit of SCI_REPLACERANGES: lengthDelete bytes at position are replaced
+ * by the lengthText bytes of text, positions being those before any edit. */
+struct Sci_RangeReplacement {
+	long position;
+	long lengthDelete;
+	const char *text;
+	long lengthText;
+};
+
 #define CharacterRange Sci_CharacterRange
 #define TextRange Sci_TextRange
 #define TextToFind Sci_TextToFind
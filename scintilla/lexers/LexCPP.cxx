@@ -132,6 +132,9 @@ class LinePPState {
 public:
 	LinePPState() : state(0), ifTaken(0), level(-1) {
 	}
+	bool operator==(const LinePPState &other) const {
+		return state == other.state && ifTaken == other.ifTaken && level == other.level;
+	}
 	bool IsInactive() const {
 		return state != 0;
 	}
@@ -166,20 +169,88 @@ public:
 };
 
 // Hold the preprocessor state for each line seen.
-// Currently one entry per line but could become sparse with just one entry per preprocessor line.
+// The state only changes after preprocessor lines, so only the lines where it differs
+// from the line before are stored, ordered by line.
 class PPStates {
-	std::vector<LinePPState> vlls;
+	struct LineState {
+		int line;
+		LinePPState state;
+		LineState(int line_, const LinePPState &state_) : line(line_), state(state_) {
+		}
+	};
+	std::vector<LineState> changes;
+	// Index of the first change after line
+	size_t ChangeAfter(int line) const {
+		size_t lower = 0;
+		size_t upper = changes.size();
+		while (lower < upper) {
+			size_t middle = (lower + upper) / 2;
+			if (changes[middle].line <= line)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+		return lower;
+	}
 public:
-	LinePPState ForLine(int line) {
-		if ((line > 0) && (vlls.size() > static_cast<size_t>(line))) {
-			return vlls[line];
+	LinePPState ForLine(int line) const {
+		size_t after = ChangeAfter(line);
+		if ((line > 0) && (after > 0)) {
+			return changes[after - 1].state;
 		} else {
 			return LinePPState();
 		}
 	}
+	// Lines after line are forgotten: they were lexed with a state that may not hold any more.
 	void Add(int line, LinePPState lls) {
-		vlls.resize(line+1);
-		vlls[line] = lls;
+		if (!changes.empty() && changes.back().line >= line) {
+			changes.erase(changes.begin() + ChangeAfter(line - 1), changes.end());
+		}
+		LinePPState previous = changes.empty() ? LinePPState() : changes.back().state;
+		if (!(previous == lls)) {
+			changes.push_back(LineState(line, lls));
+		}
+	}
+};
+
+// Preprocessor definitions for the line being lexed: the ones set through the
+// "Preprocessor definitions" word list, overridden by the #define met so far.
+// Each #define pushes a new version of its key, so going back to an earlier line
+// only pops the versions defined after it instead of replaying every #define.
+class PPDefinitionTable {
+	std::map<std::string, std::string> start;
+	std::vector<PPDefinition> history;	// in line order
+	std::map<std::string, std::vector<size_t> > versions;	// indexes in history, latest last
+public:
+	void SetStart(const std::map<std::string, std::string> &start_) {
+		start = start_;
+	}
+	void Define(int line, const std::string &key, const std::string &value) {
+		versions[key].push_back(history.size());
+		history.push_back(PPDefinition(line, key, value));
+	}
+	// Forgets the definitions made after line, returns true if there were any.
+	bool RollBack(int line) {
+		bool changed = false;
+		while (!history.empty() && history.back().line > line) {
+			std::map<std::string, std::vector<size_t> >::iterator it = versions.find(history.back().key);
+			it->second.pop_back();
+			if (it->second.empty())
+				versions.erase(it);
+			history.pop_back();
+			changed = true;
+		}
+		return changed;
+	}
+	// Current value of key, or 0 if not defined
+	const std::string *Find(const std::string &key) const {
+		std::map<std::string, std::vector<size_t> >::const_iterator it = versions.find(key);
+		if (it != versions.end())
+			return &history[it->second.back()].value;
+		std::map<std::string, std::string>::const_iterator itStart = start.find(key);
+		if (itStart != start.end())
+			return &itStart->second;
+		return 0;
 	}
 };
 
@@ -267,14 +338,13 @@ class LexerCPP : public ILexer {
 	CharacterSet setRelOp;
 	CharacterSet setLogicalOp;
 	PPStates vlls;
-	std::vector<PPDefinition> ppDefineHistory;
+	PPDefinitionTable preprocessorDefinitions;
 	PropSetSimple props;
 	WordList keywords;
 	WordList keywords2;
 	WordList keywords3;
 	WordList keywords4;
 	WordList ppDefinitions;
-	std::map<std::string, std::string> preprocessorDefinitionsStart;
 	OptionsCPP options;
 	OptionSetCPP osCPP;
 public:
@@ -323,7 +393,7 @@ public:
 	}
 
 	void EvaluateTokens(std::vector<std::string> &tokens);
-	bool EvaluateExpression(const std::string &expr, const std::map<std::string, std::string> &preprocessorDefinitions);
+	bool EvaluateExpression(const std::string &expr);
 };
 
 int SCI_METHOD LexerCPP::PropertySet(const char *key, const char *val) {
@@ -361,7 +431,7 @@ int SCI_METHOD LexerCPP::WordListSet(int n, const char *wl) {
 			firstModification = 0;
 			if (n == 4) {
 				// Rebuild preprocessorDefinitions
-				preprocessorDefinitionsStart.clear();
+				std::map<std::string, std::string> preprocessorDefinitionsStart;
 				for (int nDefinition = 0; nDefinition < ppDefinitions.len; nDefinition++) {
 					char *cpDefinition = ppDefinitions.words[nDefinition];
 					char *cpEquals = strchr(cpDefinition, '=');
@@ -375,21 +445,13 @@ int SCI_METHOD LexerCPP::WordListSet(int n, const char *wl) {
 						preprocessorDefinitionsStart[name] = val;
 					}
 				}
+				preprocessorDefinitions.SetStart(preprocessorDefinitionsStart);
 			}
 		}
 	}
 	return firstModification;
 }
 
-// Functor used to truncate history
-struct After {
-	int line;
-	After(int line_) : line(line_) {}
-	bool operator() (PPDefinition &p) const {
-		return p.line > line;
-	}
-};
-
 void SCI_METHOD LexerCPP::Lex(unsigned int startPos, int length, int initStyle, IDocument *pAccess) {
 	LexAccessor styler(pAccess);
 
@@ -442,23 +504,12 @@ void SCI_METHOD LexerCPP::Lex(unsigned int startPos, int length, int initStyle,
 	StyleContext sc(startPos, length, initStyle, styler, 0x7f);
 	LinePPState preproc = vlls.ForLine(lineCurrent);
 
-	bool definitionsChanged = false;
-
-	// Truncate ppDefineHistory before current line
+	// Go back to the definitions as they were before the current line
 
 	if (!options.updatePreprocessor)
-		ppDefineHistory.clear();
+		preprocessorDefinitions.RollBack(-1);
 
-	std::vector<PPDefinition>::iterator itInvalid = std::find_if(ppDefineHistory.begin(), ppDefineHistory.end(), After(lineCurrent-1));
-	if (itInvalid != ppDefineHistory.end()) {
-		ppDefineHistory.erase(itInvalid, ppDefineHistory.end());
-		definitionsChanged = true;
-	}
-
-	std::map<std::string, std::string> preprocessorDefinitions = preprocessorDefinitionsStart;
-	for (std::vector<PPDefinition>::iterator itDef = ppDefineHistory.begin(); itDef != ppDefineHistory.end(); ++itDef) {
-		preprocessorDefinitions[itDef->key] = itDef->value;
-	}
+	bool definitionsChanged = preprocessorDefinitions.RollBack(lineCurrent-1);
 
 	const int maskActivity = 0x3F;
 
@@ -731,11 +782,11 @@ void SCI_METHOD LexerCPP::Lex(unsigned int startPos, int length, int initStyle,
 							bool isIfDef = sc.Match("ifdef");
 							int i = isIfDef ? 5 : 6;
 							std::string restOfLine = GetRestOfLine(styler, sc.currentPos + i + 1, false);
-							bool foundDef = preprocessorDefinitions.find(restOfLine) != preprocessorDefinitions.end();
+							bool foundDef = preprocessorDefinitions.Find(restOfLine) != 0;
 							preproc.StartSection(isIfDef == foundDef);
 						} else if (sc.Match("if")) {
 							std::string restOfLine = GetRestOfLine(styler, sc.currentPos + 2, true);
-							bool ifGood = EvaluateExpression(restOfLine, preprocessorDefinitions);
+							bool ifGood = EvaluateExpression(restOfLine);
 							preproc.StartSection(ifGood);
 						} else if (sc.Match("else")) {
 							if (!preproc.CurrentIfTaken()) {
@@ -754,7 +805,7 @@ void SCI_METHOD LexerCPP::Lex(unsigned int startPos, int length, int initStyle,
 							if (!preproc.CurrentIfTaken()) {
 								// Similar to #if
 								std::string restOfLine = GetRestOfLine(styler, sc.currentPos + 2, true);
-								bool ifGood = EvaluateExpression(restOfLine, preprocessorDefinitions);
+								bool ifGood = EvaluateExpression(restOfLine);
 								if (ifGood) {
 									preproc.InvertCurrentLevel();
 									activitySet = preproc.IsInactive() ? 0x40 : 0;
@@ -783,8 +834,7 @@ void SCI_METHOD LexerCPP::Lex(unsigned int startPos, int length, int initStyle,
 										if (tokens.size() >= 2) {
 											value = tokens[1];
 										}
-										preprocessorDefinitions[key] = value;
-										ppDefineHistory.push_back(PPDefinition(lineCurrent, key, value));
+										preprocessorDefinitions.Define(lineCurrent, key, value);
 										definitionsChanged = true;
 									}
 								}
@@ -1011,7 +1061,7 @@ void LexerCPP::EvaluateTokens(std::vector<std::string> &tokens) {
 	}
 }
 
-bool LexerCPP::EvaluateExpression(const std::string &expr, const std::map<std::string, std::string> &preprocessorDefinitions) {
+bool LexerCPP::EvaluateExpression(const std::string &expr) {
 	// Break into tokens, replacing with definitions
 	std::string word;
 	std::vector<std::string> tokens;
@@ -1020,9 +1070,9 @@ bool LexerCPP::EvaluateExpression(const std::string &expr, const std::map<std::s
 		if (setWord.Contains(*cp)) {
 			word += *cp;
 		} else {
-			std::map<std::string, std::string>::const_iterator it = preprocessorDefinitions.find(word);
-			if (it != preprocessorDefinitions.end()) {
-				tokens.push_back(it->second);
+			const std::string *value = preprocessorDefinitions.Find(word);
+			if (value) {
+				tokens.push_back(*value);
 			} else if (!word.empty() && ((word[0] >= '0' && word[0] <= '9') || (word == "defined"))) {
 				tokens.push_back(word);
 			}
@@ -107,7 +107,7 @@ static void ColouriseMMIXALDoc(unsigned int startPos, int length, int initStyle,
 				char s[100];
 				sc.GetCurrent(s, sizeof(s));
 				if (*s == ':') {	// ignore base prefix for match
-					for (size_t i = 0; i != sizeof(s); ++i) {
+					for (size_t i = 0; i + 1 != sizeof(s); ++i) {
 						*(s+i) = *(s+i+1);
 					}
 				}
@@ -71,123 +71,12 @@ static bool isInOpList(WordList & opList, char op)
 
 static bool isInList(WordList & list, const char *s, bool specialMode, bool ignoreCase)
 {
-	if (!list.words)
-		return false;
-
-	unsigned char firstChar = s[0];
-	int j = list.starts[firstChar];
-
-	if (j >= 0)
-	{
-		while ((ignoreCase?toupper(list.words[j][0]):list.words[j][0]) == (ignoreCase?toupper(s[0]):s[0]))
-		{
-			if (!list.words[j][1])
-			{
-				if (specialMode)
-				{
-					return true;
-				}
-				else
-				{
-					if (!s[1])
-						return true;
-				}
-			}
-			int a1 = ignoreCase?toupper(list.words[j][1]):list.words[j][1];
-			int b1 = ignoreCase?toupper(s[1]):s[1];
-			if (a1 == b1)
-			{
-
-				const char *a = list.words[j] + 1;
-				int An = ignoreCase?toupper((int)*a):(int)*a;
-
-				const char *b = s + 1;
-				int Bn = ignoreCase?toupper((int)*b):(int)*b;
-
-
-				while (An && (An == Bn))
-				{
-					a++;
-					An = ignoreCase?toupper((int)*a):(int)*a;
-					b++;
-					Bn = ignoreCase?toupper((int)*b):(int)*b;
-				}
-				if (specialMode)
-				{
-					if (!An)
-						return true;
-				}
-				else
-				{
-					if (!An && !Bn)
-						return true;
-				}
-			}
-			j++;
-		}
-	}
-
-	if (ignoreCase)
-	{
-		// if the 1st char is not a letter, no need to test one more time
-		if (!isalpha(s[0]))
-			return false;
-
-		// NPPSTART Joce 06/16/09 Scintilla_clean_precomp
-		firstChar = (unsigned char)(isupper(s[0])?tolower(s[0]):toupper(s[0]));
-		// NPPEND
-		j = list.starts[firstChar];
-		if (j >= 0)
-		{
-			while (toupper(list.words[j][0]) == toupper(s[0]))
-			{
-				if (!list.words[j][1])
-				{
-					if (specialMode)
-					{
-						return true;
-					}
-					else
-					{
-						if (!s[1])
-							return true;
-					}
-				}
-				int a1 = toupper(list.words[j][1]);
-				int b1 = toupper(s[1]);
-				if (a1 == b1)
-				{
-					const char *a = list.words[j] + 1;
-					int An = toupper((int)*a);
-
-					const char *b = s + 1;
-					int Bn = toupper((int)*b);
-
-					while (An && (An == Bn))
-					{
-						a++;
-						An = toupper((int)*a);
-						b++;
-						Bn = toupper((int)*b);
-					}
-					if (specialMode)
-					{
-						if (!*a)
-							return true;
-					}
-					else
-					{
-						if (!*a && !*b)
-							return true;
-					}
-				}
-				j++;
-			}
-		}
-	}
-
-	return false;
+	// In special mode a keyword only has to start the word
+	if (specialMode)
+		return list.InListPrefix(s, ignoreCase);
+	return list.InListExact(s, ignoreCase);
 }
+
 /*
 static void getRange(unsigned int start, unsigned int end, Accessor &styler, char *s, unsigned int len)
 {
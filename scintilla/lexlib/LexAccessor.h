@@ -15,26 +15,51 @@ namespace Scintilla {
 class LexAccessor {
 private:
 	IDocument *pAccess;
+	/// Set when the document lets its text be read in place, then buf is only used as a fallback
+	IDocumentWithRangePointer *pDirect;
 	enum {extremePosition=0x7FFFFFFF};
 	/** @a bufferSize is a trade off between time taken to copy the characters
 	 * and retrieval overhead.
 	 * @a slopSize positions the buffer before the desired position
-	 * in case there is some backtracking. */
-	enum {bufferSize=4000, slopSize=bufferSize/8};
+	 * in case there is some backtracking.
+	 * @a maxStyleBufferSize is how far the style buffer grows from bufferSize
+	 * when a long range is styled without being flushed. */
+	enum {bufferSize=4000, slopSize=bufferSize/8, maxStyleBufferSize=256*1024};
 	char buf[bufferSize+1];
+	const char *text;	///< characters from startPos to endPos, in buf or in the document
 	int startPos;
 	int endPos;
 	int codePage;
 	int lenDoc;
 	int mask;
-	char styleBuf[bufferSize];
+	char styleBufFixed[bufferSize];
+	char *styleBuf;
+	int styleBufSize;
 	int validLen;
 	char chFlags;
 	char chWhile;
 	unsigned int startSeg;
 	int startPosStyling;
 
+	// Not copyable: styleBuf may be owned
+	LexAccessor(const LexAccessor &);
+	LexAccessor &operator=(const LexAccessor &);
+
 	void Fill(int position) {
+		if (pDirect && position >= 0 && position < lenDoc) {
+			// The whole part of the text on the same side of the gap, without copying it
+			int gap = pDirect->GapPosition();
+			if (position < gap) {
+				startPos = 0;
+				endPos = gap;
+			} else {
+				startPos = gap;
+				endPos = lenDoc;
+			}
+			text = pDirect->RangePointer(startPos, endPos - startPos);
+			return;
+		}
+		text = buf;
 		startPos = position - slopSize;
 		if (startPos + bufferSize > lenDoc)
 			startPos = lenDoc - bufferSize;
@@ -48,18 +73,43 @@ private:
 		buf[endPos-startPos] = '\0';
 	}
 
+	/** Styles are sent to the document in fewer, larger, calls when a lexer
+	 * goes a long way without flushing. */
+	void GrowStyleBuffer(unsigned int needed) {
+		if (styleBufSize >= maxStyleBufferSize)
+			return;
+		int newSize = styleBufSize;
+		while (newSize < maxStyleBufferSize && static_cast<unsigned int>(newSize) <= needed)
+			newSize *= 2;
+		if (newSize > maxStyleBufferSize)
+			newSize = maxStyleBufferSize;
+		char *newBuf = new char[newSize];
+		memcpy(newBuf, styleBuf, validLen);
+		if (styleBuf != styleBufFixed)
+			delete []styleBuf;
+		styleBuf = newBuf;
+		styleBufSize = newSize;
+	}
+
 public:
 	LexAccessor(IDocument *pAccess_) :
-		pAccess(pAccess_), startPos(extremePosition), endPos(0),
+		pAccess(pAccess_), pDirect(0), text(buf), startPos(extremePosition), endPos(0),
 		codePage(pAccess->CodePage()), lenDoc(pAccess->Length()),
-		mask(127), validLen(0), chFlags(0), chWhile(0),
+		mask(127), styleBuf(styleBufFixed), styleBufSize(bufferSize),
+		validLen(0), chFlags(0), chWhile(0),
 		startSeg(0), startPosStyling(0) {
+		if (pAccess->Version() >= dvRangePointer)
+			pDirect = static_cast<IDocumentWithRangePointer *>(pAccess);
+	}
+	~LexAccessor() {
+		if (styleBuf != styleBufFixed)
+			delete []styleBuf;
 	}
 	char operator[](int position) {
 		if (position < startPos || position >= endPos) {
 			Fill(position);
 		}
-		return buf[position - startPos];
+		return text[position - startPos];
 	}
 	/** Safe version of operator[], returning a defined value for invalid position. */
 	char SafeGetCharAt(int position, char chDefault=' ') {
@@ -70,7 +120,7 @@ public:
 				return chDefault;
 			}
 		}
-		return buf[position - startPos];
+		return text[position - startPos];
 	}
 	bool IsLeadByte(char ch) {
 		return pAccess->IsDBCSLeadByte(ch);
@@ -84,7 +134,11 @@ public:
 		}
 		return true;
 	}
+	/** Styles set since the last flush are seen too. */
 	char StyleAt(int position) {
+		int index = position - startPosStyling;
+		if (index >= 0 && index < validLen)
+			return static_cast<char>(styleBuf[index] & mask);
 		return static_cast<char>(pAccess->StyleAt(position) & mask);
 	}
 	int GetLine(int position) {
@@ -138,11 +192,14 @@ public:
 				return;
 			}
 
-			if (validLen + (pos - startSeg + 1) >= bufferSize)
+			if (validLen + (pos - startSeg + 1) >= static_cast<unsigned int>(styleBufSize))
+				GrowStyleBuffer(validLen + (pos - startSeg + 1));
+			if (validLen + (pos - startSeg + 1) >= static_cast<unsigned int>(styleBufSize))
 				Flush();
-			if (validLen + (pos - startSeg + 1) >= bufferSize) {
+			if (validLen + (pos - startSeg + 1) >= static_cast<unsigned int>(styleBufSize)) {
 				// Too big for buffer so send directly
 				pAccess->SetStyleFor(pos - startSeg + 1, static_cast<char>(chAttr));
+				startPosStyling += pos - startSeg + 1;
 			} else {
 				if (chAttr != chWhile)
 					chFlags = 0;
@@ -87,6 +87,15 @@ void WordList::Clear() {
 	words = 0;
 	list = 0;
 	len = 0;
+	delete []folded;
+	delete []exactSlots;
+	delete []foldedSlots;
+	folded = 0;
+	exactSlots = 0;
+	foldedSlots = 0;
+	slotMask = 0;
+	exactLengths = 0;
+	foldedLengths = 0;
 }
 
 extern "C" int cmpString(const void *a1, const void *a2) {
@@ -111,29 +120,140 @@ void WordList::Set(const char *s) {
 		unsigned char indexChar = words[l][0];
 		starts[indexChar] = l;
 	}
+	Compile();
 }
 
-bool WordList::InList(const char *s) const {
+// Case folding is ASCII only, as toupper is in the "C" locale lexers run in.
+static inline unsigned char FoldCase(unsigned char ch) {
+	return (ch >= 'a' && ch <= 'z') ? static_cast<unsigned char>(ch - 'a' + 'A') : ch;
+}
+
+// FNV-1a, fed one character at a time so that every prefix of a word gets its hash on the way.
+static const unsigned int hashBasis = 2166136261u;
+
+static inline unsigned int HashStep(unsigned int hash, unsigned char ch) {
+	return (hash ^ ch) * 16777619u;
+}
+
+static inline unsigned int LengthBit(int length) {
+	return 1u << ((length < 32) ? (length - 1) : 31);
+}
+
+void WordList::Compile() {
+	if (len == 0)
+		return;
+	size_t listLen = words[len] - list;
+	folded = new char[listLen + 1];
+	for (size_t i = 0; i <= listLen; i++)
+		folded[i] = FoldCase(list[i]);
+
+	// At most half full, so that probe sequences stay short
+	unsigned int slots = 16;
+	while (slots < static_cast<unsigned int>(len) * 2)
+		slots *= 2;
+	slotMask = slots - 1;
+	exactSlots = new int[slots];
+	foldedSlots = new int[slots];
+	for (unsigned int k = 0; k < slots; k++) {
+		exactSlots[k] = 0;
+		foldedSlots[k] = 0;
+	}
+
+	for (int w = 0; w < len; w++) {
+		const char *word = words[w];
+		const char *foldedWord = folded + (word - list);
+		unsigned int hash = hashBasis;
+		unsigned int foldedHash = hashBasis;
+		int length = 0;
+		for (; word[length]; length++) {
+			hash = HashStep(hash, word[length]);
+			foldedHash = HashStep(foldedHash, foldedWord[length]);
+		}
+		// Duplicates keep their first entry, later ones would never be reached anyway
+		if (Find(exactSlots, hash, word, length, false) < 0) {
+			unsigned int slot = hash & slotMask;
+			while (exactSlots[slot])
+				slot = (slot + 1) & slotMask;
+			exactSlots[slot] = w + 1;
+			exactLengths |= LengthBit(length);
+		}
+		if (Find(foldedSlots, foldedHash, foldedWord, length, true) < 0) {
+			unsigned int slot = foldedHash & slotMask;
+			while (foldedSlots[slot])
+				slot = (slot + 1) & slotMask;
+			foldedSlots[slot] = w + 1;
+			foldedLengths |= LengthBit(length);
+		}
+	}
+}
+
+/**
+ * Index in words of the word equal to the first length characters of s, or -1.
+ * With ignoreCase, the word is compared upper cased to s upper cased.
+ */
+int WordList::Find(const int *slots, unsigned int hash, const char *s, int length, bool ignoreCase) const {
+	for (unsigned int slot = hash & slotMask; slots[slot]; slot = (slot + 1) & slotMask) {
+		int w = slots[slot] - 1;
+		const char *word = ignoreCase ? folded + (words[w] - list) : words[w];
+		int i = 0;
+		if (ignoreCase) {
+			while (i < length && word[i] == static_cast<char>(FoldCase(s[i])))
+				i++;
+		} else {
+			while (i < length && word[i] == s[i])
+				i++;
+		}
+		if (i == length && !word[length])
+			return w;
+	}
+	return -1;
+}
+
+/**
+ * Whether s is one of the words, upper and lower case being the same with ignoreCase.
+ * Unlike InList, words starting with '^' are not taken as prefixes.
+ */
+bool WordList::InListExact(const char *s, bool ignoreCase) const {
+	if (0 == words || !*s)
+		return false;
+	unsigned int hash = hashBasis;
+	int length = 0;
+	if (ignoreCase) {
+		for (; s[length]; length++)
+			hash = HashStep(hash, FoldCase(s[length]));
+	} else {
+		for (; s[length]; length++)
+			hash = HashStep(hash, s[length]);
+	}
+	if (!((ignoreCase ? foldedLengths : exactLengths) & LengthBit(length)))
+		return false;
+	return Find(ignoreCase ? foldedSlots : exactSlots, hash, s, length, ignoreCase) >= 0;
+}
+
+/**
+ * Whether one of the words is s or the start of s, upper and lower case being
+ * the same with ignoreCase.
+ */
+bool WordList::InListPrefix(const char *s, bool ignoreCase) const {
 	if (0 == words)
 		return false;
-	unsigned char firstChar = s[0];
-	int j = starts[firstChar];
-	if (j >= 0) {
-		while ((unsigned char)words[j][0] == firstChar) {
-			if (s[1] == words[j][1]) {
-				const char *a = words[j] + 1;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					b++;
-				}
-				if (!*a && !*b)
-					return true;
-			}
-			j++;
-		}
+	const int *slots = ignoreCase ? foldedSlots : exactSlots;
+	unsigned int lengths = ignoreCase ? foldedLengths : exactLengths;
+	unsigned int hash = hashBasis;
+	for (int length = 1; s[length - 1]; length++) {
+		hash = HashStep(hash, ignoreCase ? FoldCase(s[length - 1]) : s[length - 1]);
+		if ((lengths & LengthBit(length)) && Find(slots, hash, s, length, ignoreCase) >= 0)
+			return true;
 	}
-	j = starts['^'];
+	return false;
+}
+
+bool WordList::InList(const char *s) const {
+	if (0 == words)
+		return false;
+	if (InListExact(s, false))
+		return true;
+	int j = starts['^'];
 	if (j >= 0) {
 		while (words[j][0] == '^') {
 			const char *a = words[j] + 1;
@@ -23,7 +23,8 @@ public:
 	bool onlyLineEnds;	///< Delimited by any white space or only line ends
 	int starts[256];
 	WordList(bool onlyLineEnds_ = false) :
-		words(0), list(0), len(0), onlyLineEnds(onlyLineEnds_)
+		words(0), list(0), len(0), onlyLineEnds(onlyLineEnds_),
+		folded(0), exactSlots(0), foldedSlots(0), slotMask(0), exactLengths(0), foldedLengths(0)
 		{}
 	~WordList() { Clear(); }
 	operator bool() const { return len ? true : false; }
@@ -32,6 +33,19 @@ public:
 	void Set(const char *s);
 	bool InList(const char *s) const;
 	bool InListAbbreviated(const char *s, const char marker) const;
+	bool InListExact(const char *s, bool ignoreCase) const;
+	bool InListPrefix(const char *s, bool ignoreCase) const;
+private:
+	// Compiled by Set: open addressed hash tables of the words, as they are and
+	// upper cased, so that a lookup costs one hash of the word looked for.
+	char *folded;			///< list with every word upper cased
+	int *exactSlots;		///< 1 + index in words, 0 for an empty slot
+	int *foldedSlots;
+	unsigned int slotMask;
+	unsigned int exactLengths;	///< bit n-1 set when a word of n characters exists, bit 31 for longer ones
+	unsigned int foldedLengths;
+	void Compile();
+	int Find(const int *slots, unsigned int hash, const char *s, int length, bool ignoreCase) const;
 };
 
 #ifdef SCI_NAMESPACE
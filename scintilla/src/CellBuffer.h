@@ -152,6 +152,8 @@ public:
 	void GetCharRange(char *buffer, int position, int lengthRetrieve) const;
 	char StyleAt(int position) const;
 	const char *BufferPointer();
+	const char *RangePointer(int position, int rangeLength);
+	int GapPosition() const;
 
 	int Length() const;
 	void Allocate(int newSize);
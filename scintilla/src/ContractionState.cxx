@@ -14,7 +14,7 @@
 
 #include "SplitVector.h"
 #include "Partitioning.h"
-#include "RunStyles.h"
+#include "RunStylesTree.h"
 #include "ContractionState.h"
 
 #ifdef SCI_NAMESPACE
@@ -31,14 +31,56 @@ ContractionState::~ContractionState() {
 
 void ContractionState::EnsureData() {
 	if (OneToOne()) {
-		visible = new RunStyles();
-		expanded = new RunStyles();
-		heights = new RunStyles();
+		visible = new RunStylesTree();
+		expanded = new RunStylesTree();
+		heights = new RunStylesTree();
 		displayLines = new Partitioning(4);
 		InsertLines(0, linesInDocument);
 	}
 }
 
+static bool AllOnes(RunStylesTree *rs) {
+	return (rs->Runs() == 1) && (rs->ValueAt(0) == 1);
+}
+
+static void FillLines(RunStylesTree *rs, int lineDoc, int lineCount, int value) {
+	rs->FillRange(lineDoc, value, lineCount);
+}
+
+// Once every line is shown, expanded and one display line high, there is nothing to track
+// any more. Return true if the data has been dropped.
+bool ContractionState::ResetIfOneToOne() {
+	if (!OneToOne() && AllOnes(visible) && AllOnes(expanded) && AllOnes(heights)) {
+		ShowAll();
+		return true;
+	}
+	return false;
+}
+
+// Recompute the display lines of the lines after lineDocStart up to lineDocEnd from the
+// visibility and heights, a run of lines at a time, then move all the following lines by
+// the difference in one step.
+void ContractionState::UpdateDisplayLines(int lineDocStart, int lineDocEnd) {
+	// Setting partition positions only moves the step forward, so it has to start before the lines
+	displayLines->InsertText(lineDocStart, 0);
+	int lineDisplay = displayLines->PositionFromPartition(lineDocStart);
+	int line = lineDocStart;
+	while (line <= lineDocEnd) {
+		int lineRunEnd = Platform::Minimum(visible->EndRun(line), heights->EndRun(line));
+		lineRunEnd = Platform::Minimum(lineRunEnd, lineDocEnd + 1);
+		int height = (visible->ValueAt(line) == 1) ? heights->ValueAt(line) : 0;
+		for (; line < lineRunEnd; line++) {
+			lineDisplay += height;
+			if (line < lineDocEnd)
+				displayLines->SetPartitionStartPosition(line + 1, lineDisplay);
+		}
+	}
+	int delta = lineDisplay - displayLines->PositionFromPartition(lineDocEnd + 1);
+	if (delta != 0) {
+		displayLines->InsertText(lineDocEnd, delta);
+	}
+}
+
 void ContractionState::Clear() {
 	delete visible;
 	visible = 0;
@@ -94,45 +136,51 @@ int ContractionState::DocFromDisplay(int lineDisplay) const {
 }
 
 void ContractionState::InsertLine(int lineDoc) {
-	if (OneToOne()) {
-		linesInDocument++;
-	} else {
-		visible->InsertSpace(lineDoc, 1);
-		visible->SetValueAt(lineDoc, 1);
-		expanded->InsertSpace(lineDoc, 1);
-		expanded->SetValueAt(lineDoc, 1);
-		heights->InsertSpace(lineDoc, 1);
-		heights->SetValueAt(lineDoc, 1);
-		int lineDisplay = DisplayFromDoc(lineDoc);
-		displayLines->InsertPartition(lineDoc, lineDisplay);
-		displayLines->InsertText(lineDoc, 1);
-	}
+	InsertLines(lineDoc, 1);
 }
 
+// New lines are shown, expanded and one display line high.
 void ContractionState::InsertLines(int lineDoc, int lineCount) {
-	for (int l = 0; l < lineCount; l++) {
-		InsertLine(lineDoc + l);
+	if (lineCount <= 0)
+		return;
+	if (OneToOne()) {
+		linesInDocument += lineCount;
+	} else {
+		visible->InsertSpace(lineDoc, lineCount);
+		FillLines(visible, lineDoc, lineCount, 1);
+		expanded->InsertSpace(lineDoc, lineCount);
+		FillLines(expanded, lineDoc, lineCount, 1);
+		heights->InsertSpace(lineDoc, lineCount);
+		FillLines(heights, lineDoc, lineCount, 1);
+		int lineDisplay = DisplayFromDoc(lineDoc);
+		for (int l = 0; l < lineCount; l++) {
+			displayLines->InsertPartition(lineDoc + l, lineDisplay + l);
+		}
+		displayLines->InsertText(lineDoc + lineCount - 1, lineCount);
 	}
 	Check();
 }
 
 void ContractionState::DeleteLine(int lineDoc) {
-	if (OneToOne()) {
-		linesInDocument--;
-	} else {
-		if (GetVisible(lineDoc)) {
-			displayLines->InsertText(lineDoc, -heights->ValueAt(lineDoc));
-		}
-		displayLines->RemovePartition(lineDoc);
-		visible->DeleteRange(lineDoc, 1);
-		expanded->DeleteRange(lineDoc, 1);
-		heights->DeleteRange(lineDoc, 1);
-	}
+	DeleteLines(lineDoc, 1);
 }
 
 void ContractionState::DeleteLines(int lineDoc, int lineCount) {
-	for (int l = 0; l < lineCount; l++) {
-		DeleteLine(lineDoc);
+	if (lineCount <= 0)
+		return;
+	if (OneToOne()) {
+		linesInDocument -= lineCount;
+	} else {
+		int linesDisplayDeleted = DisplayFromDoc(lineDoc + lineCount) - DisplayFromDoc(lineDoc);
+		if (linesDisplayDeleted != 0) {
+			displayLines->InsertText(lineDoc, -linesDisplayDeleted);
+		}
+		for (int l = 0; l < lineCount; l++) {
+			displayLines->RemovePartition(lineDoc);
+		}
+		visible->DeleteRange(lineDoc, lineCount);
+		expanded->DeleteRange(lineDoc, lineCount);
+		heights->DeleteRange(lineDoc, lineCount);
 	}
 	Check();
 }
@@ -155,14 +203,16 @@ bool ContractionState::SetVisible(int lineDocStart, int lineDocEnd, bool visible
 		int delta = 0;
 		Check();
 		if ((lineDocStart <= lineDocEnd) && (lineDocStart >= 0) && (lineDocEnd < LinesInDoc())) {
-			for (int line = lineDocStart; line <= lineDocEnd; line++) {
-				if (GetVisible(line) != visible_) {
-					int difference = visible_ ? heights->ValueAt(line) : -heights->ValueAt(line);
-					visible->SetValueAt(line, visible_ ? 1 : 0);
-					displayLines->InsertText(line, difference);
-					delta += difference;
+			int linesDisplayed = LinesDisplayed();
+			// The range is trimmed to the lines which change
+			int lineDoc = lineDocStart;
+			int lineCount = lineDocEnd - lineDocStart + 1;
+			if (visible->FillRange(lineDoc, visible_ ? 1 : 0, lineCount) && (lineCount > 0)) {
+				if (!ResetIfOneToOne()) {
+					UpdateDisplayLines(lineDoc, lineDoc + lineCount - 1);
 				}
 			}
+			delta = LinesDisplayed() - linesDisplayed;
 		} else {
 			return false;
 		}
@@ -187,6 +237,9 @@ bool ContractionState::SetExpanded(int lineDoc, bool expanded_) {
 		EnsureData();
 		if (expanded_ != (expanded->ValueAt(lineDoc) == 1)) {
 			expanded->SetValueAt(lineDoc, expanded_ ? 1 : 0);
+			if (expanded_) {
+				ResetIfOneToOne();
+			}
 			Check();
 			return true;
 		} else {
@@ -216,6 +269,9 @@ bool ContractionState::SetHeight(int lineDoc, int height) {
 				displayLines->InsertText(lineDoc, height - GetHeight(lineDoc));
 			}
 			heights->SetValueAt(lineDoc, height);
+			if (height == 1) {
+				ResetIfOneToOne();
+			}
 			Check();
 			return true;
 		} else {
@@ -225,6 +281,39 @@ bool ContractionState::SetHeight(int lineDoc, int height) {
 	}
 }
 
+// Set the number of display lines needed for lineCount lines from an array,
+// as when wrapping a block of lines. Return true if this is a change.
+bool ContractionState::SetHeights(int lineDocStart, int lineCount, const int *heights_) {
+	if ((lineDocStart < 0) || (lineCount <= 0) || (lineDocStart + lineCount > LinesInDoc()))
+		return false;
+	if (OneToOne()) {
+		int line = 0;
+		while ((line < lineCount) && (heights_[line] == 1))
+			line++;
+		if (line == lineCount)
+			return false;
+	}
+	EnsureData();
+	bool changed = false;
+	int line = 0;
+	while (line < lineCount) {
+		// Each run of equal heights is filled at once
+		int lineRunEnd = line + 1;
+		while ((lineRunEnd < lineCount) && (heights_[lineRunEnd] == heights_[line]))
+			lineRunEnd++;
+		int lineDoc = lineDocStart + line;
+		int runLength = lineRunEnd - line;
+		if (heights->FillRange(lineDoc, heights_[line], runLength) && (runLength > 0))
+			changed = true;
+		line = lineRunEnd;
+	}
+	if (changed && !ResetIfOneToOne()) {
+		UpdateDisplayLines(lineDocStart, lineDocStart + lineCount - 1);
+	}
+	Check();
+	return changed;
+}
+
 void ContractionState::ShowAll() {
 	int lines = LinesInDoc();
 	Clear();
@@ -12,17 +12,22 @@
 namespace Scintilla {
 #endif
 
+class RunStylesTree;
+
 /**
  */
 class ContractionState {
 	// These contain 1 element for every document line.
-	RunStyles *visible;
-	RunStyles *expanded;
-	RunStyles *heights;
+	// Kept as trees of runs so that filling a range of lines is logarithmic wherever it is.
+	RunStylesTree *visible;
+	RunStylesTree *expanded;
+	RunStylesTree *heights;
 	Partitioning *displayLines;
 	int linesInDocument;
 
 	void EnsureData();
+	bool ResetIfOneToOne();
+	void UpdateDisplayLines(int lineDocStart, int lineDocEnd);
 
 	bool OneToOne() const {
 		// True when each document line is exactly one display line so need for
@@ -54,6 +59,7 @@ public:
 
 	int GetHeight(int lineDoc) const;
 	bool SetHeight(int lineDoc, int height);
+	bool SetHeights(int lineDocStart, int lineCount, const int *heights_);
 
 	void ShowAll();
 	void Check() const;
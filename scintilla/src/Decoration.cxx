@@ -20,95 +20,159 @@
 #include "SplitVector.h"
 #include "Partitioning.h"
 #include "RunStyles.h"
+#include "RunStylesTree.h"
 #include "Decoration.h"
 
 #ifdef SCI_NAMESPACE
 using namespace Scintilla;
 #endif
 
-Decoration::Decoration(int indicator_) : next(0), indicator(indicator_) {
+// Compacting is only worth it once there are many more states than when it was last done
+static const int minStatesToCompact = 64;
+
+Decoration::Decoration() : mask(0) {
+	for (int i = 0; i <= INDIC_MAX; i++)
+		values[i] = 0;
+}
+
+void Decoration::SetValue(int indicator, int value) {
+	values[indicator] = value;
+	if (value)
+		mask |= 1 << indicator;
+	else
+		mask &= ~(1 << indicator);
 }
 
-Decoration::~Decoration() {
+bool Decoration::operator<(const Decoration &other) const {
+	for (int i = 0; i <= INDIC_MAX; i++) {
+		if (values[i] != other.values[i])
+			return values[i] < other.values[i];
+	}
+	return false;
 }
 
-bool Decoration::Empty() {
-	return rs.starts->Partitions() == 1;
+/// Forwards to one of the classes storing runs, they have the same interface
+template <typename Runs>
+class DecorationRunsOf : public DecorationRuns {
+	Runs runs;
+public:
+	int Length() const {
+		return runs.Length();
+	}
+	int ValueAt(int position) const {
+		return runs.ValueAt(position);
+	}
+	int StartRun(int position) {
+		return runs.StartRun(position);
+	}
+	int EndRun(int position) {
+		return runs.EndRun(position);
+	}
+	bool FillRange(int &position, int value, int &fillLength) {
+		return runs.FillRange(position, value, fillLength);
+	}
+	void SetRunValue(int position, int value) {
+		runs.SetRunValue(position, value);
+	}
+	void InsertSpace(int position, int insertLength) {
+		runs.InsertSpace(position, insertLength);
+	}
+	void DeleteRange(int position, int deleteLength) {
+		runs.DeleteRange(position, deleteLength);
+	}
+};
+
+static DecorationRuns *NewDecorationRuns(int storage) {
+	if (storage == SC_INDICSTORAGE_TREE)
+		return new DecorationRunsOf<RunStylesTree>();
+	else
+		return new DecorationRunsOf<RunStyles>();
 }
 
-DecorationList::DecorationList() : currentIndicator(0), currentValue(1), current(0),
-	lengthDocument(0), root(0), clickNotified(false) {
+DecorationList::DecorationList() : currentIndicator(0), currentValue(1),
+	runs(NewDecorationRuns(SC_INDICSTORAGE_DEFAULT)), storage(SC_INDICSTORAGE_DEFAULT),
+	statesCompacted(1), maskInUse(0), clickNotified(false) {
+	states.push_back(Decoration());
+	stateIds[states[0]] = 0;
 }
 
 DecorationList::~DecorationList() {
-	Decoration *deco = root;
-	while (deco) {
-		Decoration *decoNext = deco->next;
-		delete deco;
-		deco = decoNext;
-	}
-	root = 0;
-	current = 0;
+	delete runs;
+	runs = 0;
 }
 
-Decoration *DecorationList::DecorationFromIndicator(int indicator) {
-	for (Decoration *deco=root; deco; deco = deco->next) {
-		if (deco->indicator == indicator) {
-			return deco;
-		}
-	}
-	return 0;
+// Runs past the end of the document may still hold states dropped by CompactStates
+int DecorationList::StateAt(int position) const {
+	if (position < 0 || position >= runs->Length())
+		return 0;
+	return runs->ValueAt(position);
 }
 
-Decoration *DecorationList::Create(int indicator, int length) {
-	currentIndicator = indicator;
-	Decoration *decoNew = new Decoration(indicator);
-	decoNew->rs.InsertSpace(0, length);
+int DecorationList::StateId(const Decoration &state) {
+	std::map<Decoration, int>::const_iterator it = stateIds.find(state);
+	if (it != stateIds.end())
+		return it->second;
+	int id = static_cast<int>(states.size());
+	states.push_back(state);
+	stateIds[state] = id;
+	return id;
+}
 
-	Decoration *decoPrev = 0;
-	Decoration *deco = root;
+int DecorationList::StateWithValue(int id, int indicator, int value) {
+	if (states[id].values[indicator] == value)
+		return id;
+	Decoration state = states[id];
+	state.SetValue(indicator, value);
+	return StateId(state);
+}
 
-	while (deco && (deco->indicator < indicator)) {
-		decoPrev = deco;
-		deco = deco->next;
-	}
-	if (decoPrev == 0) {
-		decoNew->next = root;
-		root = decoNew;
-	} else {
-		decoNew->next = deco;
-		decoPrev->next = decoNew;
+// Text inserted at the boundary of two runs gets, for each indicator, the value before it
+// if the indicator is also set after it, and nothing otherwise: that is what happened when
+// each indicator had its own runs. There is nothing after the end of the document, so text
+// appended there gets no indicator.
+int DecorationList::StateForInsertion(int position) {
+	if (position >= runs->Length())
+		return 0;
+	int idAfter = StateAt(position);
+	if (runs->StartRun(position) != position)
+		return idAfter;
+	if (position == 0 || idAfter == 0)
+		return 0;
+	const Decoration &after = states[idAfter];
+	const Decoration &before = states[StateAt(position - 1)];
+	Decoration state;
+	for (int i = 0; i <= INDIC_MAX; i++) {
+		if (after.values[i])
+			state.SetValue(i, before.values[i]);
 	}
-	return decoNew;
+	return StateId(state);
 }
 
-void DecorationList::Delete(int indicator) {
-	Decoration *decoToDelete = 0;
-	if (root) {
-		if (root->indicator == indicator) {
-			decoToDelete = root;
-			root = root->next;
-		} else {
-			Decoration *deco=root;
-			while (deco->next && !decoToDelete) {
-				if (deco->next && deco->next->indicator == indicator) {
-					decoToDelete = deco->next;
-					deco->next = decoToDelete->next;
-				} else {
-					deco = deco->next;
-				}
-			}
+// States are never released as runs change, so drop the ones no run uses any more
+void DecorationList::CompactStates() {
+	std::vector<int> newIds(states.size(), -1);
+	std::vector<Decoration> newStates;
+	newIds[0] = 0;
+	newStates.push_back(states[0]);
+	int lengthDocument = runs->Length();
+	for (int pos = 0; pos < lengthDocument; pos = runs->EndRun(pos)) {
+		int id = runs->ValueAt(pos);
+		if (newIds[id] == -1) {
+			newIds[id] = static_cast<int>(newStates.size());
+			newStates.push_back(states[id]);
 		}
+		// Ids are remapped one to one, so neighbouring runs stay different
+		runs->SetRunValue(pos, newIds[id]);
 	}
-	if (decoToDelete) {
-		delete decoToDelete;
-		current = 0;
-	}
+	states.swap(newStates);
+	stateIds.clear();
+	for (size_t i = 0; i < states.size(); i++)
+		stateIds[states[i]] = static_cast<int>(i);
+	statesCompacted = static_cast<int>(states.size());
 }
 
 void DecorationList::SetCurrentIndicator(int indicator) {
 	currentIndicator = indicator;
-	current = DecorationFromIndicator(indicator);
 	currentValue = 1;
 }
 
@@ -116,78 +180,195 @@ void DecorationList::SetCurrentValue(int value) {
 	currentValue = value ? value : 1;
 }
 
-bool DecorationList::FillRange(int &position, int value, int &fillLength) {
-	if (!current) {
-		current = DecorationFromIndicator(currentIndicator);
-		if (!current) {
-			current = Create(currentIndicator, lengthDocument);
-		}
+void DecorationList::SetStorage(int storage_) {
+	if (storage_ != SC_INDICSTORAGE_TREE)
+		storage_ = SC_INDICSTORAGE_DEFAULT;
+	if (storage_ == storage)
+		return;
+	DecorationRuns *newRuns = NewDecorationRuns(storage_);
+	int lengthDocument = runs->Length();
+	newRuns->InsertSpace(0, lengthDocument);
+	for (int pos = 0; pos < lengthDocument;) {
+		int runEnd = runs->EndRun(pos);
+		int fillPos = pos;
+		int fillLen = runEnd - pos;
+		newRuns->FillRange(fillPos, runs->ValueAt(pos), fillLen);
+		pos = runEnd;
 	}
-	bool changed = current->rs.FillRange(position, value, fillLength);
-	if (current->Empty()) {
-		Delete(currentIndicator);
-	}
-	return changed;
+	delete runs;
+	runs = newRuns;
+	storage = storage_;
 }
 
-void DecorationList::InsertSpace(int position, int insertLength) {
-	lengthDocument += insertLength;
-	for (Decoration *deco=root; deco; deco = deco->next) {
-		deco->rs.InsertSpace(position, insertLength);
+// Sets the value of the current indicator over [start, end), run by run, extending
+// [changedStart, changedEnd) over the runs which changed.
+void DecorationList::FillRun(int start, int end, int value, int &changedStart, int &changedEnd) {
+	for (int pos = start; pos < end;) {
+		int runEnd = runs->EndRun(pos);
+		if (runEnd > end)
+			runEnd = end;
+		int id = runs->ValueAt(pos);
+		int newId = StateWithValue(id, currentIndicator, value);
+		if (newId != id) {
+			int fillPos = pos;
+			int fillLen = runEnd - pos;
+			runs->FillRange(fillPos, newId, fillLen);
+			if (changedStart == -1)
+				changedStart = pos;
+			changedEnd = runEnd;
+		}
+		pos = runEnd;
 	}
 }
 
-void DecorationList::DeleteRange(int position, int deleteLength) {
-	lengthDocument -= deleteLength;
-	Decoration *deco;
-	for (deco=root; deco; deco = deco->next) {
-		deco->rs.DeleteRange(position, deleteLength);
-	}
-	DeleteAnyEmpty();
+bool DecorationList::EndFill(int value, int changedStart, int changedEnd) {
+	if (changedStart == -1)
+		return false;
+	if (value == 0)
+		maskInUse = -1;
+	else if (maskInUse != -1)
+		maskInUse |= 1 << currentIndicator;
+	if (static_cast<int>(states.size()) >= minStatesToCompact && static_cast<int>(states.size()) >= 2 * statesCompacted)
+		CompactStates();
+	return true;
 }
 
-void DecorationList::DeleteAnyEmpty() {
-	Decoration *deco = root;
-	while (deco) {
-		if (deco->Empty()) {
-			Delete(deco->indicator);
-			deco = root;
+bool DecorationList::FillRange(int &position, int value, int &fillLength) {
+	if (currentIndicator < 0 || currentIndicator > INDIC_MAX)
+		return false;
+	int lengthDocument = runs->Length();
+	int end = position + fillLength;
+	if (position < 0)
+		position = 0;
+	if (end > lengthDocument)
+		end = lengthDocument;
+
+	// Only the part between the first and the last run changed is reported
+	int changedStart = -1;
+	int changedEnd = -1;
+	FillRun(position, end, value, changedStart, changedEnd);
+	if (!EndFill(value, changedStart, changedEnd))
+		return false;
+	position = changedStart;
+	fillLength = changedEnd - changedStart;
+	return true;
+}
+
+// Orders ranges given as (position, length) pairs by position
+class RangeStartLess {
+	const int *ranges;
+public:
+	RangeStartLess(const int *ranges_) : ranges(ranges_) {
+	}
+	bool operator()(int a, int b) const {
+		return ranges[2 * a] < ranges[2 * b];
+	}
+};
+
+bool DecorationList::FillRanges(const int *ranges, int count, int value, int &position, int &fillLength) {
+	if (currentIndicator < 0 || currentIndicator > INDIC_MAX || count <= 0)
+		return false;
+	int lengthDocument = runs->Length();
+
+	// Search results usually come in order, then there is nothing to sort
+	std::vector<int> order(count);
+	bool isSorted = true;
+	for (int i = 0; i < count; i++) {
+		order[i] = i;
+		if (i > 0 && ranges[2 * i] < ranges[2 * (i - 1)])
+			isSorted = false;
+	}
+	if (!isSorted)
+		std::sort(order.begin(), order.end(), RangeStartLess(ranges));
+
+	// Overlapping and touching ranges are merged, so that the runs are walked once from left to right
+	int changedStart = -1;
+	int changedEnd = -1;
+	int mergedStart = -1;
+	int mergedEnd = -1;
+	for (int i = 0; i < count; i++) {
+		int start = ranges[2 * order[i]];
+		int end = start + ranges[2 * order[i] + 1];
+		if (start < 0)
+			start = 0;
+		if (end > lengthDocument)
+			end = lengthDocument;
+		if (start >= end)
+			continue;
+		if (mergedStart != -1 && start <= mergedEnd) {
+			if (end > mergedEnd)
+				mergedEnd = end;
 		} else {
-			deco = deco->next;
+			if (mergedStart != -1)
+				FillRun(mergedStart, mergedEnd, value, changedStart, changedEnd);
+			mergedStart = start;
+			mergedEnd = end;
 		}
 	}
+	if (mergedStart != -1)
+		FillRun(mergedStart, mergedEnd, value, changedStart, changedEnd);
+
+	if (!EndFill(value, changedStart, changedEnd))
+		return false;
+	position = changedStart;
+	fillLength = changedEnd - changedStart;
+	return true;
+}
+
+void DecorationList::InsertSpace(int position, int insertLength) {
+	int id = StateForInsertion(position);
+	runs->InsertSpace(position, insertLength);
+	int fillPos = position;
+	int fillLen = insertLength;
+	runs->FillRange(fillPos, id, fillLen);
+}
+
+void DecorationList::DeleteRange(int position, int deleteLength) {
+	runs->DeleteRange(position, deleteLength);
+	maskInUse = -1;
 }
 
 int DecorationList::AllOnFor(int position) {
-	int mask = 0;
-	for (Decoration *deco=root; deco; deco = deco->next) {
-		if (deco->rs.ValueAt(position)) {
-			mask |= 1 << deco->indicator;
-		}
+	return states[StateAt(position)].mask;
+}
+
+int DecorationList::EndAllOn(int position) {
+	return runs->EndRun(position);
+}
+
+int DecorationList::AllInUse() {
+	if (maskInUse == -1) {
+		maskInUse = 0;
+		int lengthDocument = runs->Length();
+		for (int pos = 0; pos < lengthDocument; pos = runs->EndRun(pos))
+			maskInUse |= states[runs->ValueAt(pos)].mask;
 	}
-	return mask;
+	return maskInUse;
 }
 
 int DecorationList::ValueAt(int indicator, int position) {
-	Decoration *deco = DecorationFromIndicator(indicator);
-	if (deco) {
-		return deco->rs.ValueAt(position);
-	}
-	return 0;
+	if (indicator < 0 || indicator > INDIC_MAX)
+		return 0;
+	return states[StateAt(position)].values[indicator];
 }
 
 int DecorationList::Start(int indicator, int position) {
-	Decoration *deco = DecorationFromIndicator(indicator);
-	if (deco) {
-		return deco->rs.StartRun(position);
-	}
-	return 0;
+	if (indicator < 0 || indicator > INDIC_MAX || !(AllInUse() & (1 << indicator)))
+		return 0;
+	int value = ValueAt(indicator, position);
+	int start = runs->StartRun(position);
+	while ((start > 0) && (ValueAt(indicator, start - 1) == value))
+		start = runs->StartRun(start - 1);
+	return start;
 }
 
 int DecorationList::End(int indicator, int position) {
-	Decoration *deco = DecorationFromIndicator(indicator);
-	if (deco) {
-		return deco->rs.EndRun(position);
-	}
-	return 0;
+	if (indicator < 0 || indicator > INDIC_MAX || !(AllInUse() & (1 << indicator)))
+		return 0;
+	int value = ValueAt(indicator, position);
+	int lengthDocument = runs->Length();
+	int end = runs->EndRun(position);
+	while ((end < lengthDocument) && (ValueAt(indicator, end) == value))
+		end = runs->EndRun(end);
+	return end;
 }
@@ -11,29 +11,61 @@
 namespace Scintilla {
 #endif
 
+/// Values of all the indicators over a run of text.
 class Decoration {
 public:
-	Decoration *next;
-	RunStyles rs;
-	int indicator;
+	int mask;
+	int values[INDIC_MAX+1];
 
-	Decoration(int indicator_);
-	~Decoration();
+	Decoration();
 
-	bool Empty();
+	void SetValue(int indicator, int value);
+	bool operator<(const Decoration &other) const;
 };
 
+/// The runs of a DecorationList, kept in a RunStyles or in a RunStylesTree
+class DecorationRuns {
+public:
+	virtual ~DecorationRuns() {}
+	virtual int Length() const = 0;
+	virtual int ValueAt(int position) const = 0;
+	virtual int StartRun(int position) = 0;
+	virtual int EndRun(int position) = 0;
+	virtual bool FillRange(int &position, int value, int &fillLength) = 0;
+	virtual void SetRunValue(int position, int value) = 0;
+	virtual void InsertSpace(int position, int insertLength) = 0;
+	virtual void DeleteRange(int position, int deleteLength) = 0;
+};
+
+/// All the indicators of a document in a single set of runs, so that an edit updates
+/// one structure whatever the number of indicators in use, and a range of text is
+/// drawn by walking its runs once.
 class DecorationList {
 	int currentIndicator;
 	int currentValue;
-	Decoration *current;
-	int lengthDocument;
-	Decoration *DecorationFromIndicator(int indicator);
-	Decoration *Create(int indicator, int length);
-	void Delete(int indicator);
-	void DeleteAnyEmpty();
+	/// Runs of text having the same indicators, each valued by the index of its state
+	DecorationRuns *runs;
+	int storage;
+	/// Interned states, states[0] being the one without any indicator
+	std::vector<Decoration> states;
+	std::map<Decoration, int> stateIds;
+	/// Number of states when they were last compacted
+	int statesCompacted;
+	/// Indicators set somewhere in the document, or -1 if it has to be computed again
+	int maskInUse;
+
+	int StateAt(int position) const;
+	int StateId(const Decoration &state);
+	int StateWithValue(int id, int indicator, int value);
+	int StateForInsertion(int position);
+	void CompactStates();
+	void FillRun(int start, int end, int value, int &changedStart, int &changedEnd);
+	bool EndFill(int value, int changedStart, int changedEnd);
+
+	// Private so DecorationList objects can not be copied
+	DecorationList(const DecorationList &);
+	const DecorationList &operator=(const DecorationList &);
 public:
-	Decoration *root;
 	bool clickNotified;
 
 	DecorationList();
@@ -45,13 +77,24 @@ public:
 	void SetCurrentValue(int value);
 	int GetCurrentValue() const { return currentValue; }
 
+	/// SC_INDICSTORAGE_DEFAULT or SC_INDICSTORAGE_TREE, the runs are moved to the new storage
+	void SetStorage(int storage_);
+	int GetStorage() const { return storage; }
+
 	// Returns true if some values may have changed
 	bool FillRange(int &position, int value, int &fillLength);
+	/// Fills count ranges, given as (position, length) pairs in any order, then sets position
+	/// and fillLength to the span which changed. Returns true if some values may have changed.
+	bool FillRanges(const int *ranges, int count, int value, int &position, int &fillLength);
 
 	void InsertSpace(int position, int insertLength);
 	void DeleteRange(int position, int deleteLength);
 
 	int AllOnFor(int position);
+	/// End of the run containing position along which no indicator value changes
+	int EndAllOn(int position);
+	/// Indicators set somewhere in the document
+	int AllInUse();
 	int ValueAt(int indicator, int position);
 	int Start(int indicator, int position);
 	int End(int indicator, int position);
@@ -70,7 +70,6 @@ static inline bool IsUpperCase(char ch) {
 }
 
 void LexInterface::Colourise(int start, int end) {
-	ElapsedTime et;
 	if (pdoc && instance && !performingStyle) {
 		// Protect against reentrance, which may occur, for example, when
 		// fold points are discovered while performing styling and the folding
@@ -114,6 +113,7 @@ Document::Document() {
 	enteredModification = 0;
 	enteredStyling = 0;
 	enteredReadOnlyCount = 0;
+	multiRangeFlags = 0;
 	tabInChars = 8;
 	indentInChars = 0;
 	actualIndentInChars = 8;
@@ -234,12 +234,7 @@ void Document::DeleteMarkFromHandle(int markerHandle) {
 }
 
 void Document::DeleteAllMarks(int markerNum) {
-	bool someChanges = false;
-	for (int line = 0; line < LinesTotal(); line++) {
-		if (static_cast<LineMarkers *>(perLineData[ldMarkers])->DeleteMark(line, markerNum, true))
-			someChanges = true;
-	}
-	if (someChanges) {
+	if (static_cast<LineMarkers *>(perLineData[ldMarkers])->DeleteAllMarks(markerNum)) {
 		DocModification mh(SC_MOD_CHANGEMARKER, 0, 0, 0, 0);
 		mh.line = -1;
 		NotifyModified(mh);
@@ -250,6 +245,18 @@ int Document::LineFromHandle(int markerHandle) {
 	return static_cast<LineMarkers *>(perLineData[ldMarkers])->LineFromHandle(markerHandle);
 }
 
+int Document::MarkerNext(int lineStart, int mask) const {
+	return static_cast<LineMarkers *>(perLineData[ldMarkers])->MarkerNext(lineStart, mask);
+}
+
+int Document::MarkerPrevious(int lineStart, int mask) const {
+	return static_cast<LineMarkers *>(perLineData[ldMarkers])->MarkerPrevious(lineStart, mask);
+}
+
+int Document::LinesWithMarkers(int mask, int *lines) const {
+	return static_cast<LineMarkers *>(perLineData[ldMarkers])->LinesWithMarkers(mask, lines);
+}
+
 int SCI_METHOD Document::LineStart(int line) const {
 	return cb.LineStart(line);
 }
@@ -663,7 +670,7 @@ bool Document::DeleteChars(int pos, int len) {
 				ModifiedAt(pos-1);
 			NotifyModified(
 			    DocModification(
-			        SC_MOD_DELETETEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0),
+			        SC_MOD_DELETETEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0) | multiRangeFlags,
 			        pos, len,
 			        LinesTotal() - prevLinesTotal, text));
 		}
@@ -699,7 +706,7 @@ bool Document::InsertString(int position, const char *s, int insertLength) {
 			ModifiedAt(position);
 			NotifyModified(
 			    DocModification(
-			        SC_MOD_INSERTTEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0),
+			        SC_MOD_INSERTTEXT | SC_PERFORMED_USER | (startSequence?SC_STARTACTION:0) | multiRangeFlags,
 			        position, insertLength,
 			        LinesTotal() - prevLinesTotal, text));
 		}
@@ -708,6 +715,53 @@ bool Document::InsertString(int position, const char *s, int insertLength) {
 	return !cb.IsReadOnly();
 }
 
+/**
+ * Replace many ranges in a single undo action. The ranges are sorted by position, do not
+ * overlap and their positions are those before any of them is replaced.
+ * They are applied from the last one so that the positions of the others stay valid.
+ * When several ranges change, watchers see each edit marked SC_MULTIRANGEEDIT and the final
+ * one also marked SC_LASTSTEPINMULTIRANGEEDIT, so the work that only depends on the end result
+ * can wait for it. A single range is not flagged: it is handled as any other edit.
+ */
+bool Document::ReplaceRanges(const RangeReplacement *ranges, int count) {
+	int endPrevious = 0;
+	int first = -1;	// The first range that changes anything is the last one applied
+	int steps = 0;
+	int rangesChanged = 0;
+	for (int i = 0; i < count; i++) {
+		if ((ranges[i].position < endPrevious) || (ranges[i].lengthDelete < 0) || (ranges[i].lengthInsert < 0))
+			return false;
+		endPrevious = ranges[i].position + ranges[i].lengthDelete;
+		if (ranges[i].lengthDelete || ranges[i].lengthInsert) {
+			if (first < 0)
+				first = i;
+			rangesChanged++;
+		}
+		steps += (ranges[i].lengthDelete ? 1 : 0) + (ranges[i].lengthInsert ? 1 : 0);
+	}
+	if (endPrevious > Length())
+		return false;
+	CheckReadOnly();
+	if ((enteredModification != 0) || cb.IsReadOnly())
+		return false;
+	if (first < 0)
+		return true;
+
+	// A single insertion may still coalesce with the previous typing
+	UndoGroup ug(this, steps > 1);
+	const int batchFlag = (rangesChanged > 1) ? SC_MULTIRANGEEDIT : 0;
+	for (int i = count - 1; i >= first; i--) {
+		const RangeReplacement &range = ranges[i];
+		const int lastStep = ((i == first) && batchFlag) ? SC_LASTSTEPINMULTIRANGEEDIT : 0;
+		multiRangeFlags = batchFlag | (range.lengthInsert ? 0 : lastStep);
+		DeleteChars(range.position, range.lengthDelete);
+		multiRangeFlags = batchFlag | lastStep;
+		InsertString(range.position, range.insertion, range.lengthInsert);
+	}
+	multiRangeFlags = 0;
+	return true;
+}
+
 int Document::Undo() {
 	int newPos = -1;
 	CheckReadOnly();
@@ -1657,6 +1711,16 @@ void SCI_METHOD Document::DecorationFillRange(int position, int value, int fillL
 	}
 }
 
+void Document::DecorationFillRanges(const int *ranges, int count, int value) {
+	int position = 0;
+	int fillLength = 0;
+	if (decorations.FillRanges(ranges, count, value, position, fillLength)) {
+		DocModification mh(SC_MOD_CHANGEINDICATOR | SC_PERFORMED_USER,
+							position, fillLength);
+		NotifyModified(mh);
+	}
+}
+
 bool Document::AddWatcher(DocWatcher *watcher, void *userData) {
 	for (int i = 0; i < lenWatchers; i++) {
 		if ((watchers[i].watcher == watcher) &&
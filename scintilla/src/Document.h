@@ -76,6 +76,22 @@ class DocWatcher;
 class DocModification;
 class Document;
 
+/**
+ * One edit of Document::ReplaceRanges: lengthDelete bytes at position are replaced
+ * by the lengthInsert bytes of insertion.
+ */
+class RangeReplacement {
+public:
+	int position;
+	int lengthDelete;
+	const char *insertion;
+	int lengthInsert;
+
+	RangeReplacement(int position_=0, int lengthDelete_=0, const char *insertion_=0, int lengthInsert_=0) :
+		position(position_), lengthDelete(lengthDelete_), insertion(insertion_), lengthInsert(lengthInsert_) {
+	}
+};
+
 /**
  * Interface class for regular expression searching
  */
@@ -153,7 +169,7 @@ public:
 
 /**
  */
-class Document : PerLine, public IDocument {
+class Document : PerLine, public IDocumentWithRangePointer {
 
 public:
 	/** Used to pair watcher pointer with user data. */
@@ -178,6 +194,7 @@ private:
 	int enteredModification;
 	int enteredStyling;
 	int enteredReadOnlyCount;
+	int multiRangeFlags;
 
 	WatcherWithUserData *watchers;
 	int lenWatchers;
@@ -219,7 +236,7 @@ public:
 	virtual void RemoveLine(int line);
 
 	int SCI_METHOD Version() const {
-		return dvOriginal;
+		return dvRangePointer;
 	}
 
 	void SCI_METHOD SetErrorStatus(int status);
@@ -240,6 +257,7 @@ public:
 	void CheckReadOnly();
 	bool DeleteChars(int pos, int len);
 	bool InsertString(int position, const char *s, int insertLength);
+	bool ReplaceRanges(const RangeReplacement *ranges, int count);
 	int Undo();
 	int Redo();
 	bool CanUndo() { return cb.CanUndo(); }
@@ -255,6 +273,8 @@ public:
 	void SetSavePoint();
 	bool IsSavePoint() { return cb.IsSavePoint(); }
 	const char * SCI_METHOD BufferPointer() { return cb.BufferPointer(); }
+	const char * SCI_METHOD RangePointer(int position, int rangeLength) { return cb.RangePointer(position, rangeLength); }
+	int SCI_METHOD GapPosition() const { return cb.GapPosition(); }
 
 	int SCI_METHOD GetLineIndentation(int line);
 	void SetLineIndentation(int line, int indent);
@@ -285,6 +305,9 @@ public:
 	void DeleteMarkFromHandle(int markerHandle);
 	void DeleteAllMarks(int markerNum);
 	int LineFromHandle(int markerHandle);
+	int MarkerNext(int lineStart, int mask) const;
+	int MarkerPrevious(int lineStart, int mask) const;
+	int LinesWithMarkers(int mask, int *lines) const;
 	int SCI_METHOD LineStart(int line) const;
 	int LineEnd(int line) const;
 	int LineEndPosition(int position) const;
@@ -327,6 +350,7 @@ public:
 		decorations.SetCurrentIndicator(indicator);
 	}
 	void SCI_METHOD DecorationFillRange(int position, int value, int fillLength);
+	void DecorationFillRanges(const int *ranges, int count, int value);
 
 	int SCI_METHOD SetLineState(int line, int state);
 	int SCI_METHOD GetLineState(int line) const;
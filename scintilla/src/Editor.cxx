@@ -61,6 +61,8 @@ using namespace Scintilla;
 static bool CanDeferToLastStep(const DocModification &mh) {
 	if (mh.modificationType & (SC_MOD_BEFOREINSERT | SC_MOD_BEFOREDELETE))
 		return true;	// CAN skip
+	if ((mh.modificationType & SC_MULTIRANGEEDIT) && !(mh.modificationType & SC_LASTSTEPINMULTIRANGEEDIT))
+		return true;	// CAN skip
 	if (!(mh.modificationType & (SC_PERFORMED_UNDO | SC_PERFORMED_REDO)))
 		return false;	// MUST do
 	if (mh.modificationType & SC_MULTISTEPUNDOREDO)
@@ -79,10 +81,22 @@ static bool CanEliminate(const DocModification &mh) {
 */
 static bool IsLastStep(const DocModification &mh) {
 	return
-	    (mh.modificationType & (SC_PERFORMED_UNDO | SC_PERFORMED_REDO)) != 0
+	    ((mh.modificationType & (SC_PERFORMED_UNDO | SC_PERFORMED_REDO)) != 0
 	    && (mh.modificationType & SC_MULTISTEPUNDOREDO) != 0
 	    && (mh.modificationType & SC_LASTSTEPINUNDOREDO) != 0
-	    && (mh.modificationType & SC_MULTILINEUNDOREDO) != 0;
+	    && (mh.modificationType & SC_MULTILINEUNDOREDO) != 0)
+	    || ((mh.modificationType & SC_MULTIRANGEEDIT) != 0
+	    && (mh.modificationType & SC_LASTSTEPINMULTIRANGEEDIT) != 0);
+}
+
+/*
+	return whether this modification is one of the steps of a multi range
+	edit that the final step will redraw
+*/
+static bool IsDeferredRangeEdit(const DocModification &mh) {
+	return
+	    (mh.modificationType & SC_MULTIRANGEEDIT) != 0
+	    && (mh.modificationType & SC_LASTSTEPINMULTIRANGEEDIT) == 0;
 }
 
 Caret::Caret() :
@@ -165,6 +179,7 @@ Editor::Editor() {
 	caretSticky = SC_CARETSTICKY_OFF;
 	multipleSelection = false;
 	additionalSelectionTyping = false;
+	multiRangeEditing = false;
 	multiPasteMode = SC_MULTIPASTE_ONCE;
 	additionalCaretsBlink = true;
 	additionalCaretsVisible = true;
@@ -1410,10 +1425,7 @@ bool Editor::WrapLines(bool fullWrap, int priorityWrapLineStart) {
 		if (wrapState == eWrapNone) {
 			if (wrapWidth != LineLayout::wrapWidthInfinite) {
 				wrapWidth = LineLayout::wrapWidthInfinite;
-				for (int lineDoc = 0; lineDoc < pdoc->LinesTotal(); lineDoc++) {
-					cs.SetHeight(lineDoc, 1 +
-						(vs.annotationVisible ? pdoc->AnnotationLines(lineDoc) : 0));
-				}
+				SetLineHeights(0, pdoc->LinesTotal());
 				wrapOccurred = true;
 			}
 			wrapStart = wrapLineLarge;
@@ -2471,6 +2483,20 @@ void Editor::DrawEOL(Surface *surface, ViewStyle &vsDraw, PRectangle rcLine, Lin
 	}
 }
 
+// Part of a line covered by one value of an indicator
+class IndicatorSegment {
+public:
+	int indicator;
+	int start;
+	int end;
+	IndicatorSegment(int indicator_, int start_, int end_) : indicator(indicator_), start(start_), end(end_) {
+	}
+	// Segments are drawn by indicator
+	bool operator<(const IndicatorSegment &other) const {
+		return indicator < other.indicator;
+	}
+};
+
 void Editor::DrawIndicators(Surface *surface, ViewStyle &vsDraw, int line, int xStart,
         PRectangle rcLine, LineLayout *ll, int subLine, int lineEnd, bool under) {
 	// Draw decorators
@@ -2516,25 +2542,53 @@ void Editor::DrawIndicators(Surface *surface, ViewStyle &vsDraw, int line, int x
 		}
 	}
 
-	for (Decoration *deco = pdoc->decorations.root; deco; deco = deco->next) {
-		if (under == vsDraw.indicators[deco->indicator].under) {
-			int startPos = posLineStart + lineStart;
-			if (!deco->rs.ValueAt(startPos)) {
-				startPos = deco->rs.EndRun(startPos);
+	// All the indicators are followed at once along the runs of the line, then each one is
+	// drawn in turn so that overlapping indicators are painted in the same order as before.
+	int maskUnder = 0;
+	for (int indic = 0; indic <= INDIC_MAX; indic++) {
+		if (under == vsDraw.indicators[indic].under)
+			maskUnder |= 1 << indic;
+	}
+	if (!(pdoc->decorations.AllInUse() & maskUnder))
+		return;
+
+	std::vector<IndicatorSegment> segments;
+	int runStarts[INDIC_MAX+1];
+	int runValues[INDIC_MAX+1];
+	int maskOpen = 0;
+	int pos = posLineStart + lineStart;
+	while (pos < posLineEnd) {
+		int maskOn = pdoc->decorations.AllOnFor(pos) & maskUnder;
+		for (int indic = 0; indic <= INDIC_MAX; indic++) {
+			int bit = 1 << indic;
+			if (!((maskOn | maskOpen) & bit))
+				continue;
+			int value = (maskOn & bit) ? pdoc->decorations.ValueAt(indic, pos) : 0;
+			if ((maskOpen & bit) && (value != runValues[indic])) {
+				segments.push_back(IndicatorSegment(indic, runStarts[indic], pos));
+				maskOpen &= ~bit;
 			}
-			while ((startPos < posLineEnd) && (deco->rs.ValueAt(startPos))) {
-				int endPos = deco->rs.EndRun(startPos);
-				if (endPos > posLineEnd)
-					endPos = posLineEnd;
-				PRectangle rcIndic(
-				    ll->positions[startPos - posLineStart] + xStart - subLineStart,
-				    rcLine.top + vsDraw.maxAscent,
-				    ll->positions[endPos - posLineStart] + xStart - subLineStart,
-				    rcLine.top + vsDraw.maxAscent + 3);
-				vsDraw.indicators[deco->indicator].Draw(surface, rcIndic, rcLine);
-				startPos = deco->rs.EndRun(endPos);
+			if (value && !(maskOpen & bit)) {
+				runStarts[indic] = pos;
+				runValues[indic] = value;
+				maskOpen |= bit;
 			}
 		}
+		pos = pdoc->decorations.EndAllOn(pos);
+	}
+	for (int indic = 0; indic <= INDIC_MAX; indic++) {
+		if (maskOpen & (1 << indic))
+			segments.push_back(IndicatorSegment(indic, runStarts[indic], posLineEnd));
+	}
+
+	std::stable_sort(segments.begin(), segments.end());
+	for (size_t i = 0; i < segments.size(); i++) {
+		PRectangle rcIndic(
+		    ll->positions[segments[i].start - posLineStart] + xStart - subLineStart,
+		    rcLine.top + vsDraw.maxAscent,
+		    ll->positions[segments[i].end - posLineStart] + xStart - subLineStart,
+		    rcLine.top + vsDraw.maxAscent + 3);
+		vsDraw.indicators[segments[i].indicator].Draw(surface, rcIndic, rcLine);
 	}
 }
 
@@ -3786,49 +3840,150 @@ void Editor::FilterSelections() {
 	}
 }
 
+// Where a position goes when the edits, sorted by position, are applied by Document::ReplaceRanges.
+// Same as moving it for the deletion then the insertion of each edit in turn, except that a
+// position in a deleted range goes to the start of its replacement even when edits touch.
+// shifts[i] is the change of length made by the edits before i.
+static int MovePositionForReplacements(int position, const std::vector<RangeReplacement> &edits,
+	const std::vector<int> &shifts) {
+	// Number of edits starting before the position
+	size_t before = 0;
+	size_t after = edits.size();
+	while (before < after) {
+		size_t middle = (before + after) / 2;
+		if (edits[middle].position < position)
+			before = middle + 1;
+		else
+			after = middle;
+	}
+	if (before == 0)
+		return position;
+	const RangeReplacement &edit = edits[before - 1];
+	if (position > edit.position + edit.lengthDelete)
+		return position + shifts[before];
+	// Within the deleted text so goes to where it was, before the insertion
+	return edit.position + shifts[before - 1];
+}
+
+static void ShiftsOfReplacements(const std::vector<RangeReplacement> &edits, std::vector<int> &shifts) {
+	shifts.resize(edits.size() + 1);
+	shifts[0] = 0;
+	for (size_t i = 0; i < edits.size(); i++)
+		shifts[i + 1] = shifts[i] + edits[i].lengthInsert - edits[i].lengthDelete;
+}
+
+// Applies the edits, sorted by position, as one batch of the document then moves the selection
+// once for all of them instead of for each edit.
+bool Editor::ReplaceRanges(const std::vector<RangeReplacement> &edits) {
+	if (edits.empty())
+		return true;
+	multiRangeEditing = true;
+	bool replaced = pdoc->ReplaceRanges(&edits[0], static_cast<int>(edits.size()));
+	multiRangeEditing = false;
+	if (replaced) {
+		std::vector<int> shifts;
+		ShiftsOfReplacements(edits, shifts);
+		for (size_t r=0; r<sel.Count(); r++) {
+			SelectionRange &range = sel.Range(r);
+			range.caret = SelectionPosition(MovePositionForReplacements(range.caret.Position(), edits, shifts),
+				range.caret.VirtualSpace());
+			range.anchor = SelectionPosition(MovePositionForReplacements(range.anchor.Position(), edits, shifts),
+				range.anchor.VirtualSpace());
+		}
+	}
+	return replaced;
+}
+
+// Orders the indices of the ranges of a selection by where the ranges start
+class SelectionStartLess {
+	Selection &sel;
+public:
+	explicit SelectionStartLess(Selection &sel_) : sel(sel_) {
+	}
+	bool operator()(size_t a, size_t b) const {
+		return sel.Range(a).Start() < sel.Range(b).Start();
+	}
+};
+
 // AddCharUTF inserts an array of bytes which may or may not be in UTF-8.
+// The text goes into every selection as one batch of edits of the document.
 void Editor::AddCharUTF(char *s, unsigned int len, bool treatAsDBCS) {
 	FilterSelections();
 	{
 		UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty() || inOverstrike);
-		for (size_t r=0; r<sel.Count(); r++) {
-			if (!RangeContainsProtected(sel.Range(r).Start().Position(),
-				sel.Range(r).End().Position())) {
-				int positionInsert = sel.Range(r).Start().Position();
-				if (!sel.Range(r).Empty()) {
-					if (sel.Range(r).Length()) {
-						pdoc->DeleteChars(positionInsert, sel.Range(r).Length());
-						sel.Range(r).ClearVirtualSpace();
-					} else {
-						// Range is all virtual so collapse to start of virtual space
-						sel.Range(r).MinimizeVirtualSpace();
-					}
-				} else if (inOverstrike) {
-					if (positionInsert < pdoc->Length()) {
-						if (!IsEOLChar(pdoc->CharAt(positionInsert))) {
-							pdoc->DelChar(positionInsert);
-							sel.Range(r).ClearVirtualSpace();
-						}
-					}
-				}
-				positionInsert = InsertSpace(positionInsert, sel.Range(r).caret.VirtualSpace());
-				if (pdoc->InsertString(positionInsert, s, len)) {
-					sel.Range(r).caret.SetPosition(positionInsert + len);
-					sel.Range(r).anchor.SetPosition(positionInsert + len);
+		std::vector<size_t> order(sel.Count());
+		for (size_t r=0; r<sel.Count(); r++)
+			order[r] = r;
+		std::sort(order.begin(), order.end(), SelectionStartLess(sel));
+
+		std::vector<RangeReplacement> edits;
+		std::vector<size_t> editedRanges;
+		std::vector<std::string> virtualInsertions(sel.Count());
+		edits.reserve(sel.Count());
+		editedRanges.reserve(sel.Count());
+		int endPrevious = 0;
+		for (size_t o=0; o<order.size(); o++) {
+			const size_t r = order[o];
+			SelectionRange &range = sel.Range(r);
+			if (RangeContainsProtected(range.Start().Position(), range.End().Position()) ||
+				(range.Start().Position() < endPrevious)) {
+				continue;
+			}
+			RangeReplacement edit(range.Start().Position());
+			if (!range.Empty()) {
+				if (range.Length()) {
+					edit.lengthDelete = range.Length();
+					range.ClearVirtualSpace();
+				} else {
+					// Range is all virtual so collapse to start of virtual space
+					range.MinimizeVirtualSpace();
 				}
-				sel.Range(r).ClearVirtualSpace();
-				// If in wrap mode rewrap current line so EnsureCaretVisible has accurate information
-				if (wrapState != eWrapNone) {
-					AutoSurface surface(this);
-					if (surface) {
-						if (WrapOneLine(surface, pdoc->LineFromPosition(positionInsert))) {
-							SetScrollBars();
-							SetVerticalScrollPos();
-							Redraw();
-						}
+			} else if (inOverstrike) {
+				if (edit.position < pdoc->Length()) {
+					if (!IsEOLChar(pdoc->CharAt(edit.position))) {
+						edit.lengthDelete = pdoc->LenChar(edit.position);
+						range.ClearVirtualSpace();
 					}
 				}
 			}
+			if (range.caret.VirtualSpace() > 0) {
+				virtualInsertions[r] = std::string(range.caret.VirtualSpace(), ' ');
+				virtualInsertions[r].append(s, len);
+				edit.insertion = virtualInsertions[r].c_str();
+				edit.lengthInsert = static_cast<int>(virtualInsertions[r].length());
+			} else {
+				edit.insertion = s;
+				edit.lengthInsert = len;
+			}
+			endPrevious = edit.position + edit.lengthDelete;
+			edits.push_back(edit);
+			editedRanges.push_back(r);
+		}
+
+		if (ReplaceRanges(edits)) {
+			// The carets go after their own insertion
+			int shift = 0;
+			for (size_t e=0; e<edits.size(); e++) {
+				SelectionRange &range = sel.Range(editedRanges[e]);
+				const int positionAfter = edits[e].position + shift + edits[e].lengthInsert;
+				range.caret.SetPosition(positionAfter);
+				range.anchor.SetPosition(positionAfter);
+				shift += edits[e].lengthInsert - edits[e].lengthDelete;
+			}
+		}
+		for (size_t e=0; e<editedRanges.size(); e++)
+			sel.Range(editedRanges[e]).ClearVirtualSpace();
+
+		// If in wrap mode rewrap current line so EnsureCaretVisible has accurate information
+		if (wrapState != eWrapNone) {
+			AutoSurface surface(this);
+			if (surface) {
+				if (WrapOneLine(surface, pdoc->LineFromPosition(sel.MainCaret()))) {
+					SetScrollBars();
+					SetVerticalScrollPos();
+					Redraw();
+				}
+			}
 		}
 	}
 	if (wrapState != eWrapNone) {
@@ -3956,15 +4111,12 @@ void Editor::ClearAll() {
 }
 
 void Editor::ClearDocumentStyle() {
-	Decoration *deco = pdoc->decorations.root;
-	while (deco) {
-		// Save next in case deco deleted
-		Decoration *decoNext = deco->next;
-		if (deco->indicator < INDIC_CONTAINER) {
-			pdoc->decorations.SetCurrentIndicator(deco->indicator);
+	int maskInUse = pdoc->decorations.AllInUse();
+	for (int indic = 0; indic < INDIC_CONTAINER; indic++) {
+		if (maskInUse & (1 << indic)) {
+			pdoc->decorations.SetCurrentIndicator(indic);
 			pdoc->DecorationFillRange(0, 0, pdoc->Length());
 		}
-		deco = decoNext;
 	}
 	pdoc->StartStyling(0, '\377');
 	pdoc->SetStyleFor(pdoc->Length(), 0);
@@ -4370,12 +4522,15 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		}
 	} else {
 		// Move selection and brace highlights
+		// A multi range edit made by this view moves the selection once at its end
 		if (mh.modificationType & SC_MOD_INSERTTEXT) {
-			sel.MovePositions(true, mh.position, mh.length);
+			if (!multiRangeEditing)
+				sel.MovePositions(true, mh.position, mh.length);
 			braces[0] = MovePositionForInsertion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForInsertion(braces[1], mh.position, mh.length);
 		} else if (mh.modificationType & SC_MOD_DELETETEXT) {
-			sel.MovePositions(false, mh.position, mh.length);
+			if (!multiRangeEditing)
+				sel.MovePositions(false, mh.position, mh.length);
 			braces[0] = MovePositionForDeletion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForDeletion(braces[1], mh.position, mh.length);
 		}
@@ -4417,7 +4572,7 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		CheckModificationForWrap(mh);
 		if (mh.linesAdded != 0) {
 			// Avoid scrolling of display if change before current display
-			if (mh.position < posTopLine && !CanDeferToLastStep(mh)) {
+			if (mh.position < posTopLine && (!CanDeferToLastStep(mh) || IsDeferredRangeEdit(mh))) {
 				int newTop = Platform::Clamp(topLine + mh.linesAdded, 0, MaxScrollPos());
 				if (newTop != topLine) {
 					SetTopLine(newTop);
@@ -4431,13 +4586,16 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			if (paintState == notPainting && !CanDeferToLastStep(mh)) {
 				QueueStyling(pdoc->Length());
 				Redraw();
+			} else if (IsDeferredRangeEdit(mh)) {
+				QueueStyling(pdoc->Length());
 			}
 		} else {
 			//Platform::DebugPrintf("** %x Line Changed %d .. %d\n", this,
 			//	mh.position, mh.position + mh.length);
 			if (paintState == notPainting && mh.length && !CanEliminate(mh)) {
 				QueueStyling(mh.position + mh.length);
-				InvalidateRange(mh.position, mh.position + mh.length);
+				if (!IsDeferredRangeEdit(mh))
+					InvalidateRange(mh.position, mh.position + mh.length);
 			}
 		}
 	}
@@ -6380,11 +6538,26 @@ void Editor::SetBraceHighlight(Position pos0, Position pos1, int matchStyle) {
 	}
 }
 
+/**
+ * Set the lines from start to end to one display line each plus their annotations,
+ * a block of lines at a time.
+ */
+void Editor::SetLineHeights(int start, int end) {
+	const int blockLines = 1024;
+	int heights[blockLines];
+	end = Platform::Minimum(end, pdoc->LinesTotal());
+	for (int lineBlock = start; lineBlock < end; lineBlock += blockLines) {
+		int lineCount = Platform::Minimum(blockLines, end - lineBlock);
+		for (int line = 0; line < lineCount; line++) {
+			heights[line] = 1 + (vs.annotationVisible ? pdoc->AnnotationLines(lineBlock + line) : 0);
+		}
+		cs.SetHeights(lineBlock, lineCount, heights);
+	}
+}
+
 void Editor::SetAnnotationHeights(int start, int end) {
 	if (vs.annotationVisible) {
-		for (int line=start; line<end; line++) {
-			cs.SetHeight(line, pdoc->AnnotationLines(line) + 1);
-		}
+		SetLineHeights(start, end);
 	}
 }
 
@@ -6437,25 +6610,27 @@ void Editor::SetAnnotationVisible(int visible) {
 }
 
 /**
- * Recursively expand a fold, making lines visible except where they have an unexpanded parent.
+ * Expand a fold, making lines visible except where they have an unexpanded parent.
+ * The whole fold is shown at once, then the children of each contracted header are hidden again.
  */
 void Editor::Expand(int &line, bool doExpand) {
 	int lineMaxSubord = pdoc->GetLastChild(line);
 	line++;
-	while (line <= lineMaxSubord) {
-		if (doExpand)
-			cs.SetVisible(line, line, true);
-		int level = pdoc->GetLevel(line);
-		if (level & SC_FOLDLEVELHEADERFLAG) {
-			if (doExpand && cs.GetExpanded(line)) {
-				Expand(line, true);
+	if (doExpand && (line <= lineMaxSubord)) {
+		cs.SetVisible(line, lineMaxSubord, true);
+		while (line <= lineMaxSubord) {
+			int level = pdoc->GetLevel(line);
+			if ((level & SC_FOLDLEVELHEADERFLAG) && !cs.GetExpanded(line)) {
+				int lineLastChild = Platform::Minimum(pdoc->GetLastChild(line), lineMaxSubord);
+				if (lineLastChild > line)
+					cs.SetVisible(line + 1, lineLastChild, false);
+				line = Platform::Maximum(lineLastChild, line) + 1;
 			} else {
-				Expand(line, false);
+				line++;
 			}
-		} else {
-			line++;
 		}
 	}
+	line = Platform::Maximum(line, lineMaxSubord + 1);
 }
 
 void Editor::ToggleContraction(int line) {
@@ -6933,6 +7108,21 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		PLATFORM_ASSERT(lParam);
 		return ReplaceTarget(true, CharPtrFromSPtr(lParam), wParam);
 
+	case SCI_REPLACERANGES: {
+			if (lParam == 0)
+				return wParam ? -1 : 0;
+			const Sci_RangeReplacement *ranges = reinterpret_cast<const Sci_RangeReplacement *>(lParam);
+			std::vector<RangeReplacement> edits(wParam);
+			int lengthChange = 0;
+			for (size_t i = 0; i < edits.size(); i++) {
+				edits[i] = RangeReplacement(ranges[i].position, ranges[i].lengthDelete, ranges[i].text, ranges[i].lengthText);
+				lengthChange += ranges[i].lengthText - ranges[i].lengthDelete;
+			}
+			if (!ReplaceRanges(edits))
+				return -1;
+			return lengthChange;
+		}
+
 	case SCI_SEARCHINTARGET:
 		PLATFORM_ASSERT(lParam);
 		return SearchInTarget(CharPtrFromSPtr(lParam), wParam);
@@ -7665,22 +7855,14 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_MARKERGET:
 		return pdoc->GetMark(wParam);
 
-	case SCI_MARKERNEXT: {
-			int lt = pdoc->LinesTotal();
-			for (int iLine = wParam; iLine < lt; iLine++) {
-				if ((pdoc->GetMark(iLine) & lParam) != 0)
-					return iLine;
-			}
-		}
-		return -1;
+	case SCI_MARKERNEXT:
+		return pdoc->MarkerNext(wParam, lParam);
 
-	case SCI_MARKERPREVIOUS: {
-			for (int iLine = wParam; iLine >= 0; iLine--) {
-				if ((pdoc->GetMark(iLine) & lParam) != 0)
-					return iLine;
-			}
-		}
-		return -1;
+	case SCI_MARKERPREVIOUS:
+		return pdoc->MarkerPrevious(wParam, lParam);
+
+	case SCI_MARKERGETLINES:
+		return pdoc->LinesWithMarkers(wParam, reinterpret_cast<int *>(lParam));
 
 	case SCI_MARKERDEFINEPIXMAP:
 		if (wParam <= MARKER_MAX) {
@@ -8073,6 +8255,10 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->DecorationFillRange(wParam, 0, lParam);
 		break;
 
+	case SCI_INDICATORFILLRANGES:
+		pdoc->DecorationFillRanges(reinterpret_cast<const int *>(lParam), wParam, pdoc->decorations.GetCurrentValue());
+		break;
+
 	case SCI_INDICATORALLONFOR:
 		return pdoc->decorations.AllOnFor(wParam);
 
@@ -8085,6 +8271,13 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_INDICATOREND:
 		return pdoc->decorations.End(wParam, lParam);
 
+	case SCI_SETINDICATORSTORAGE:
+		pdoc->decorations.SetStorage(wParam);
+		break;
+
+	case SCI_GETINDICATORSTORAGE:
+		return pdoc->decorations.GetStorage();
+
 	case SCI_LINEDOWN:
 	case SCI_LINEDOWNEXTEND:
 	case SCI_PARADOWN:
@@ -8442,6 +8635,12 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETCHARACTERPOINTER:
 		return reinterpret_cast<sptr_t>(pdoc->BufferPointer());
 
+	case SCI_GETRANGEPOINTER:
+		return reinterpret_cast<sptr_t>(pdoc->RangePointer(wParam, lParam));
+
+	case SCI_GETGAPPOSITION:
+		return pdoc->GapPosition();
+
 	case SCI_SETEXTRAASCENT:
 		vs.extraAscent = wParam;
 		InvalidateStyleRedraw();
@@ -164,6 +164,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	int caretSticky;
 	bool multipleSelection;
 	bool additionalSelectionTyping;
+	bool multiRangeEditing;
 	int multiPasteMode;
 	bool additionalCaretsBlink;
 	bool additionalCaretsVisible;
@@ -392,6 +393,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	void FilterSelections();
 	int InsertSpace(int position, unsigned int spaces);
+	bool ReplaceRanges(const std::vector<RangeReplacement> &edits);
 	void AddChar(char ch);
 	virtual void AddCharUTF(char *s, unsigned int len, bool treatAsDBCS=false);
 	void InsertPaste(SelectionPosition selStart, const char *text, int len);
@@ -508,6 +510,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void CheckForChangeOutsidePaint(Range r);
 	void SetBraceHighlight(Position pos0, Position pos1, int matchStyle);
 
+	void SetLineHeights(int start, int end);
 	void SetAnnotationHeights(int start, int end);
 	void SetDocPointer(Document *document);
 
@@ -129,6 +129,53 @@ void MarkerHandleSet::CombineWith(MarkerHandleSet *other) {
 	other->root = 0;
 }
 
+int MarkerLineIndex::Length() const {
+	return lines.Length();
+}
+
+int MarkerLineIndex::LineAt(int index) const {
+	return lines.ValueAt(index);
+}
+
+int MarkerLineIndex::IndexFromLine(int line) const {
+	int lower = 0;
+	int upper = lines.Length();
+	while (lower < upper) {
+		int middle = (lower + upper) / 2;
+		if (lines.ValueAt(middle) < line)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
+}
+
+bool MarkerLineIndex::Contains(int line) const {
+	int index = IndexFromLine(line);
+	return (index < lines.Length()) && (lines.ValueAt(index) == line);
+}
+
+void MarkerLineIndex::Add(int line) {
+	int index = IndexFromLine(line);
+	if ((index == lines.Length()) || (lines.ValueAt(index) != line))
+		lines.Insert(index, line);
+}
+
+void MarkerLineIndex::Remove(int line) {
+	int index = IndexFromLine(line);
+	if ((index < lines.Length()) && (lines.ValueAt(index) == line))
+		lines.Delete(index);
+}
+
+void MarkerLineIndex::InsertLine(int line) {
+	lines.RangeAddDelta(IndexFromLine(line), lines.Length(), 1);
+}
+
+void MarkerLineIndex::RemoveLine(int line) {
+	Remove(line);
+	lines.RangeAddDelta(IndexFromLine(line), lines.Length(), -1);
+}
+
 LineMarkers::~LineMarkers() {
 	Init();
 }
@@ -139,11 +186,19 @@ void LineMarkers::Init() {
 		markers[line] = 0;
 	}
 	markers.DeleteAll();
+	for (int i = 0; i <= MARKER_MAX; i++) {
+		delete lineIndex[i];
+		lineIndex[i] = 0;
+	}
 }
 
 void LineMarkers::InsertLine(int line) {
 	if (markers.Length()) {
 		markers.Insert(line, 0);
+		for (int i = 0; i <= MARKER_MAX; i++) {
+			if (lineIndex[i])
+				lineIndex[i]->InsertLine(line);
+		}
 	}
 }
 
@@ -154,6 +209,10 @@ void LineMarkers::RemoveLine(int line) {
 			MergeMarkers(line - 1);
 		}
 		markers.Delete(line);
+		for (int i = 0; i <= MARKER_MAX; i++) {
+			if (lineIndex[i])
+				lineIndex[i]->RemoveLine(line);
+		}
 	}
 }
 
@@ -170,8 +229,23 @@ int LineMarkers::LineFromHandle(int markerHandle) {
 	return -1;
 }
 
+void LineMarkers::IndexRemoveMarkSet(int line, int valueSet) {
+	unsigned int m = valueSet;
+	for (int i = 0; m; i++, m >>= 1) {
+		if ((m & 1) && lineIndex[i])
+			lineIndex[i]->Remove(line);
+	}
+}
+
 void LineMarkers::MergeMarkers(int pos) {
 	if (markers[pos + 1] != NULL) {
+		unsigned int m = markers[pos + 1]->MarkValue();
+		for (int i = 0; m; i++, m >>= 1) {
+			if ((m & 1) && lineIndex[i]) {
+				lineIndex[i]->Remove(pos + 1);
+				lineIndex[i]->Add(pos);
+			}
+		}
 		if (markers[pos] == NULL)
 			markers[pos] = new MarkerHandleSet;
 		markers[pos]->CombineWith(markers[pos + 1]);
@@ -189,6 +263,10 @@ int LineMarkers::MarkValue(int line) {
 
 int LineMarkers::AddMark(int line, int markerNum, int lines) {
 	handleCurrent++;
+	if ((markerNum < 0) || (markerNum > MARKER_MAX)) {
+		// Could not be reported by MarkValue anyway
+		return -1;
+	}
 	if (!markers.Length()) {
 		// No existing markers so allocate one element per line
 		markers.InsertValue(0, lines, 0);
@@ -203,6 +281,9 @@ int LineMarkers::AddMark(int line, int markerNum, int lines) {
 			return -1;
 	}
 	markers[line]->InsertHandle(handleCurrent, markerNum);
+	if (!lineIndex[markerNum])
+		lineIndex[markerNum] = new MarkerLineIndex();
+	lineIndex[markerNum]->Add(line);
 
 	return handleCurrent;
 }
@@ -212,6 +293,7 @@ bool LineMarkers::DeleteMark(int line, int markerNum, bool all) {
 	if (markers.Length() && (line >= 0) && (line < markers.Length()) && markers[line]) {
 		if (markerNum == -1) {
 			someChanges = true;
+			IndexRemoveMarkSet(line, markers[line]->MarkValue());
 			delete markers[line];
 			markers[line] = NULL;
 		} else {
@@ -225,6 +307,9 @@ bool LineMarkers::DeleteMark(int line, int markerNum, bool all) {
 				delete markers[line];
 				markers[line] = NULL;
 			}
+			// Without all, only one of several identical markers may have been removed
+			if (someChanges && (markerNum <= MARKER_MAX) && ((MarkValue(line) & (1 << markerNum)) == 0))
+				IndexRemoveMarkSet(line, 1 << markerNum);
 		}
 	}
 	return someChanges;
@@ -233,11 +318,94 @@ bool LineMarkers::DeleteMark(int line, int markerNum, bool all) {
 void LineMarkers::DeleteMarkFromHandle(int markerHandle) {
 	int line = LineFromHandle(markerHandle);
 	if (line >= 0) {
+		int markerNum = markers[line]->NumberFromHandle(markerHandle);
 		markers[line]->RemoveHandle(markerHandle);
 		if (markers[line]->Length() == 0) {
 			delete markers[line];
 			markers[line] = NULL;
 		}
+		if ((MarkValue(line) & (1 << markerNum)) == 0)
+			IndexRemoveMarkSet(line, 1 << markerNum);
+	}
+}
+
+bool LineMarkers::DeleteAllMarks(int markerNum) {
+	bool someChanges = false;
+	for (int i = 0; i <= MARKER_MAX; i++) {
+		if (lineIndex[i] && ((markerNum == -1) || (markerNum == i))) {
+			// Only visit the lines known to hold the marker, from the end as DeleteMark updates the index
+			while (lineIndex[i]->Length()) {
+				int line = lineIndex[i]->LineAt(lineIndex[i]->Length() - 1);
+				if (DeleteMark(line, markerNum, true))
+					someChanges = true;
+				lineIndex[i]->Remove(line);
+			}
+		}
+	}
+	return someChanges;
+}
+
+int LineMarkers::MarkerNext(int lineStart, int mask) const {
+	int lineFound = -1;
+	unsigned int m = mask;
+	for (int i = 0; m; i++, m >>= 1) {
+		if ((m & 1) && lineIndex[i]) {
+			int index = lineIndex[i]->IndexFromLine(lineStart);
+			if (index < lineIndex[i]->Length()) {
+				int line = lineIndex[i]->LineAt(index);
+				if ((lineFound == -1) || (line < lineFound))
+					lineFound = line;
+			}
+		}
+	}
+	return lineFound;
+}
+
+int LineMarkers::MarkerPrevious(int lineStart, int mask) const {
+	int lineFound = -1;
+	if (lineStart < 0)
+		return lineFound;
+	unsigned int m = mask;
+	for (int i = 0; m; i++, m >>= 1) {
+		if ((m & 1) && lineIndex[i]) {
+			int index = lineIndex[i]->IndexFromLine(lineStart + 1) - 1;
+			if (index >= 0) {
+				int line = lineIndex[i]->LineAt(index);
+				if (line > lineFound)
+					lineFound = line;
+			}
+		}
+	}
+	return lineFound;
+}
+
+int LineMarkers::LinesWithMarkers(int mask, int *lines) const {
+	// Merge the sorted lists of the requested marker numbers, reporting each line once
+	int positions[MARKER_MAX+1];
+	for (int i = 0; i <= MARKER_MAX; i++)
+		positions[i] = 0;
+	int count = 0;
+	for (;;) {
+		int lineFound = -1;
+		unsigned int m = mask;
+		for (int i = 0; m; i++, m >>= 1) {
+			if ((m & 1) && lineIndex[i] && (positions[i] < lineIndex[i]->Length())) {
+				int line = lineIndex[i]->LineAt(positions[i]);
+				if ((lineFound == -1) || (line < lineFound))
+					lineFound = line;
+			}
+		}
+		if (lineFound == -1)
+			return count;
+		m = mask;
+		for (int i = 0; m; i++, m >>= 1) {
+			if ((m & 1) && lineIndex[i] && (positions[i] < lineIndex[i]->Length()) &&
+				(lineIndex[i]->LineAt(positions[i]) == lineFound))
+				positions[i]++;
+		}
+		if (lines)
+			lines[count] = lineFound;
+		count++;
 	}
 }
 
@@ -41,12 +41,38 @@ public:
 	void CombineWith(MarkerHandleSet *other);
 };
 
+/**
+ * Sorted list of the lines holding a given marker number, so that searching for
+ * markers does not have to look at every line of the document.
+ * Inserting or removing a line shifts the entries after it, which only costs
+ * as much as the number of marked lines that follow.
+ */
+class MarkerLineIndex {
+	SplitVectorWithRangeAdd lines;
+public:
+	MarkerLineIndex() : lines(8) {
+	}
+	int Length() const;
+	int LineAt(int index) const;
+	int IndexFromLine(int line) const;	///< Index of the first entry at or after line.
+	bool Contains(int line) const;
+	void Add(int line);
+	void Remove(int line);
+	void InsertLine(int line);
+	void RemoveLine(int line);
+};
+
 class LineMarkers : public PerLine {
 	SplitVector<MarkerHandleSet *> markers;
+	/// Lines holding each marker number, allocated the first time the number is used.
+	MarkerLineIndex *lineIndex[MARKER_MAX+1];
 	/// Handles are allocated sequentially and should never have to be reused as 32 bit ints are very big.
 	int handleCurrent;
+	void IndexRemoveMarkSet(int line, int valueSet);
 public:
 	LineMarkers() : handleCurrent(0) {
+		for (int i = 0; i <= MARKER_MAX; i++)
+			lineIndex[i] = 0;
 	}
 	virtual ~LineMarkers();
 	virtual void Init();
@@ -58,7 +84,11 @@ public:
 	void MergeMarkers(int pos);
 	bool DeleteMark(int line, int markerNum, bool all);
 	void DeleteMarkFromHandle(int markerHandle);
+	bool DeleteAllMarks(int markerNum);
 	int LineFromHandle(int markerHandle);
+	int MarkerNext(int lineStart, int mask) const;
+	int MarkerPrevious(int lineStart, int mask) const;
+	int LinesWithMarkers(int mask, int *lines) const;
 };
 
 class LineLevels : public PerLine {
@@ -161,6 +161,11 @@ void RunStyles::SetValueAt(int position, int value) {
 	FillRange(position, value, len);
 }
 
+// Changes the value of the whole run containing position; the caller makes sure it stays different from its neighbours
+void RunStyles::SetRunValue(int position, int value) {
+	styles->SetValueAt(RunFromPosition(position), value);
+}
+
 void RunStyles::InsertSpace(int position, int insertLength) {
 	int runStart = RunFromPosition(position);
 	if (starts->PositionFromPartition(runStart) == position) {
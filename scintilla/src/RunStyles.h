@@ -34,6 +34,7 @@ public:
 	// Returns true if some values may have changed
 	bool FillRange(int &position, int value, int &fillLength);
 	void SetValueAt(int position, int value);
+	void SetRunValue(int position, int value);
 	void InsertSpace(int position, int insertLength);
 	void DeleteAll();
 	void DeleteRange(int position, int deleteLength);
@@ -0,0 +1,321 @@
+/** @file RunStylesTree.cxx
+ ** Data structure used to store sparse styles in a balanced tree.
+ **/
+// Copyright 2010 by The Notepad++ Team
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include "precompiled_headers.h"
+
+#include "Platform.h"
+
+#include "RunStylesTree.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+void RunStylesTree::Update(Node *node) {
+	node->sum = Sum(node->left) + node->length + Sum(node->right);
+}
+
+RunStylesTree::Node *RunStylesTree::Merge(Node *first, Node *second) {
+	if (!first)
+		return second;
+	if (!second)
+		return first;
+	if (first->priority > second->priority) {
+		first->right = Merge(first->right, second);
+		Update(first);
+		return first;
+	} else {
+		second->left = Merge(first, second->left);
+		Update(second);
+		return second;
+	}
+}
+
+// position has to be the start of a run
+void RunStylesTree::Split(Node *node, int position, Node *&first, Node *&second) {
+	if (!node) {
+		first = 0;
+		second = 0;
+	} else if (position <= Sum(node->left)) {
+		Split(node->left, position, first, node->left);
+		Update(node);
+		second = node;
+	} else {
+		Split(node->right, position - Sum(node->left) - node->length, node->right, second);
+		Update(node);
+		first = node;
+	}
+}
+
+RunStylesTree::Node *RunStylesTree::NewNode(int length, int value) {
+	// xorshift, priorities only have to be spread
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	runs++;
+	return new Node(length, value, seed);
+}
+
+void RunStylesTree::DeleteTree(Node *node) {
+	if (node) {
+		DeleteTree(node->left);
+		DeleteTree(node->right);
+		delete node;
+		runs--;
+	}
+}
+
+// Run containing position, clamped to the document
+RunStylesTree::Node *RunStylesTree::Find(int position, int &runStart) const {
+	runStart = 0;
+	if (!root)
+		return 0;
+	if (position < 0)
+		position = 0;
+	if (position >= root->sum)
+		position = root->sum - 1;
+	Node *node = root;
+	int base = 0;
+	for (;;) {
+		int leftSum = Sum(node->left);
+		if (position < base + leftSum) {
+			node = node->left;
+		} else if (position < base + leftSum + node->length) {
+			runStart = base + leftSum;
+			return node;
+		} else {
+			base += leftSum + node->length;
+			node = node->right;
+		}
+	}
+}
+
+// Lengthens or shortens the run containing position
+void RunStylesTree::Grow(int position, int delta) {
+	Node *node = root;
+	int base = 0;
+	for (;;) {
+		node->sum += delta;
+		int leftSum = Sum(node->left);
+		if (position < base + leftSum) {
+			node = node->left;
+		} else if (position < base + leftSum + node->length) {
+			node->length += delta;
+			return;
+		} else {
+			base += leftSum + node->length;
+			node = node->right;
+		}
+	}
+}
+
+// If there is no run boundary at position, cut the run there in two with the same value
+void RunStylesTree::SplitRun(int position) {
+	if (position <= 0 || position >= Length())
+		return;
+	int runStart;
+	Node *run = Find(position, runStart);
+	if (runStart == position)
+		return;
+	int runLength = run->length;
+	int value = run->value;
+	Node *before;
+	Node *rest;
+	Node *after;
+	Split(root, runStart, before, rest);
+	Split(rest, runLength, run, after);
+	run->length = position - runStart;
+	Update(run);
+	root = Merge(Merge(before, run), Merge(NewNode(runStart + runLength - position, value), after));
+}
+
+// Joins the runs on each side of position if they have the same value
+void RunStylesTree::MergeRuns(int position) {
+	if (position <= 0 || position >= Length())
+		return;
+	int startBefore;
+	Node *runBefore = Find(position - 1, startBefore);
+	int startAfter;
+	Node *runAfter = Find(position, startAfter);
+	if (runBefore == runAfter || runBefore->value != runAfter->value)
+		return;
+	int lengthBoth = runBefore->length + runAfter->length;
+	int value = runBefore->value;
+	Node *before;
+	Node *rest;
+	Node *both;
+	Node *after;
+	Split(root, startBefore, before, rest);
+	Split(rest, lengthBoth, both, after);
+	DeleteTree(both);
+	root = Merge(Merge(before, NewNode(lengthBoth, value)), after);
+}
+
+void RunStylesTree::ReplaceRuns(int start, int end, int value) {
+	SplitRun(start);
+	SplitRun(end);
+	Node *before;
+	Node *rest;
+	Node *middle;
+	Node *after;
+	Split(root, start, before, rest);
+	Split(rest, end - start, middle, after);
+	DeleteTree(middle);
+	root = Merge(Merge(before, NewNode(end - start, value)), after);
+	MergeRuns(end);
+	MergeRuns(start);
+}
+
+RunStylesTree::RunStylesTree() : root(0), runs(0), seed(2463534242U) {
+}
+
+RunStylesTree::~RunStylesTree() {
+	DeleteTree(root);
+	root = 0;
+}
+
+int RunStylesTree::Length() const {
+	return Sum(root);
+}
+
+int RunStylesTree::Runs() const {
+	return runs;
+}
+
+int RunStylesTree::ValueAt(int position) const {
+	int runStart;
+	Node *run = Find(position, runStart);
+	return run ? run->value : 0;
+}
+
+int RunStylesTree::FindNextChange(int position, int end) {
+	if (position >= 0 && position < Length())
+		return EndRun(position);
+	else if (position < end)
+		return end;
+	else
+		return end + 1;
+}
+
+int RunStylesTree::StartRun(int position) {
+	int runStart;
+	Find(position, runStart);
+	return runStart;
+}
+
+int RunStylesTree::EndRun(int position) {
+	int runStart;
+	Node *run = Find(position, runStart);
+	return run ? runStart + run->length : 0;
+}
+
+// Trims the range the way RunStyles::FillRange does. The reported range always covers what
+// changed, but can be shorter than the one of RunStyles, which also counts its empty runs, and
+// nothing is reported when the range already has the value.
+bool RunStylesTree::FillRange(int &position, int value, int &fillLength) {
+	int lengthDocument = Length();
+	int end = position + fillLength;
+	if (position < 0)
+		position = 0;
+	if (end > lengthDocument)
+		end = lengthDocument;
+	if (position >= end)
+		return false;
+	int runStart;
+	Node *runEnd = Find(end, runStart);
+	if ((end == lengthDocument || runStart < end) && runEnd->value == value) {
+		// End already has value so trim range.
+		end = runStart;
+		if (position >= end) {
+			// Whole range is already same as value so no action
+			return false;
+		}
+		fillLength = end - position;
+	}
+	Node *runBegin = Find(position, runStart);
+	if (runBegin->value == value) {
+		// Start is in expected value so trim range.
+		position = runStart + runBegin->length;
+		fillLength = end - position;
+	}
+	if (position < end)
+		ReplaceRuns(position, end, value);
+	return true;
+}
+
+void RunStylesTree::SetValueAt(int position, int value) {
+	int len = 1;
+	FillRange(position, value, len);
+}
+
+// Changes the value of the whole run containing position; the caller makes sure it stays different from its neighbours
+void RunStylesTree::SetRunValue(int position, int value) {
+	int runStart;
+	Node *run = Find(position, runStart);
+	if (run)
+		run->value = value;
+}
+
+void RunStylesTree::InsertSpace(int position, int insertLength) {
+	if (insertLength <= 0)
+		return;
+	if (!root) {
+		root = NewNode(insertLength, 0);
+		return;
+	}
+	int lengthDocument = Length();
+	if (position >= lengthDocument) {
+		Grow(lengthDocument - 1, insertLength);
+		return;
+	}
+	int runStart;
+	Node *run = Find(position, runStart);
+	if (runStart == position && run->value) {
+		if (position <= 0) {
+			// Inserting at start of document so ensure 0
+			root = Merge(NewNode(insertLength, 0), root);
+		} else {
+			// Inserting at start of run so make previous longer
+			Grow(position - 1, insertLength);
+		}
+	} else {
+		Grow(position, insertLength);
+	}
+}
+
+void RunStylesTree::DeleteAll() {
+	DeleteTree(root);
+	root = 0;
+}
+
+void RunStylesTree::DeleteRange(int position, int deleteLength) {
+	int lengthDocument = Length();
+	int end = position + deleteLength;
+	if (position < 0)
+		position = 0;
+	if (end > lengthDocument)
+		end = lengthDocument;
+	if (position >= end)
+		return;
+	int runStart;
+	Node *run = Find(position, runStart);
+	if ((end < runStart + run->length) || ((runStart < position) && (end == runStart + run->length))) {
+		// Deleting from inside one run
+		Grow(position, position - end);
+		return;
+	}
+	SplitRun(position);
+	SplitRun(end);
+	Node *before;
+	Node *rest;
+	Node *middle;
+	Node *after;
+	Split(root, position, before, rest);
+	Split(rest, end - position, middle, after);
+	DeleteTree(middle);
+	root = Merge(before, after);
+	MergeRuns(position);
+}
@@ -0,0 +1,78 @@
+/** @file RunStylesTree.h
+ ** Data structure used to store sparse styles in a balanced tree.
+ **/
+// Copyright 2010 by The Notepad++ Team
+// The License.txt file describes the conditions under which this software may be distributed.
+
+/// Same as RunStyles, but with the runs in a treap ordered by position, each node knowing
+/// the length of its subtree: finding, splitting and merging runs is logarithmic wherever
+/// they are, instead of moving the gap of RunStyles' vectors. Worth it with many runs and
+/// edits spread over the document.
+/// Text appended at the end of the document extends the last run, where RunStyles depends
+/// on runs left empty at the end by earlier edits.
+
+#ifndef RUNSTYLESTREE_H
+#define RUNSTYLESTREE_H
+
+#ifdef SCI_NAMESPACE
+namespace Scintilla {
+#endif
+
+class RunStylesTree {
+	class Node {
+	public:
+		int length;
+		int value;
+		int sum;			// length of the subtree
+		unsigned int priority;
+		Node *left;
+		Node *right;
+		Node(int length_, int value_, unsigned int priority_) :
+			length(length_), value(value_), sum(length_), priority(priority_), left(0), right(0) {
+		}
+	};
+
+	Node *root;
+	int runs;
+	unsigned int seed;
+
+	static int Sum(const Node *node) {
+		return node ? node->sum : 0;
+	}
+	static void Update(Node *node);
+	static Node *Merge(Node *first, Node *second);
+	static void Split(Node *node, int position, Node *&first, Node *&second);
+	Node *NewNode(int length, int value);
+	void DeleteTree(Node *node);
+	Node *Find(int position, int &runStart) const;
+	void Grow(int position, int delta);
+	void SplitRun(int position);
+	void MergeRuns(int position);
+	void ReplaceRuns(int start, int end, int value);
+
+	// Private so RunStylesTree objects can not be copied
+	RunStylesTree(const RunStylesTree &);
+	const RunStylesTree &operator=(const RunStylesTree &);
+public:
+	RunStylesTree();
+	~RunStylesTree();
+	int Length() const;
+	int Runs() const;
+	int ValueAt(int position) const;
+	int FindNextChange(int position, int end);
+	int StartRun(int position);
+	int EndRun(int position);
+	// Returns true if some values may have changed
+	bool FillRange(int &position, int value, int &fillLength);
+	void SetValueAt(int position, int value);
+	void SetRunValue(int position, int value);
+	void InsertSpace(int position, int insertLength);
+	void DeleteAll();
+	void DeleteRange(int position, int deleteLength);
+};
+
+#ifdef SCI_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#ifndef TESTDOCUMENT_H
+#define TESTDOCUMENT_H
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+// Just enough of a document for a lexer: text, styles and line states, no undo nor notifications.
+// The text is contiguous but, like a Document, it says it is split at a gap, so that
+// LexAccessor reads it in two parts; or it can hide its RangePointer to be read by copies.
+class TestDocument : public IDocumentWithRangePointer {
+	std::string text;
+	std::string styles;
+	std::vector<int> lineStarts;
+	std::vector<int> levels;
+	std::vector<int> lineStates;
+	int endStyled;
+	int stylingPosition;
+	char stylingMask;
+	int gapPosition;
+	bool directAccess;
+
+	void FindLines() {
+		lineStarts.assign(1, 0);
+		for (size_t i = 0; i < text.size(); i++) {
+			if (text[i] == '\n')
+				lineStarts.push_back(int(i) + 1);
+		}
+		levels.resize(lineStarts.size() + 1, SC_FOLDLEVELBASE);
+		lineStates.resize(lineStarts.size() + 1, 0);
+	}
+public:
+	int getCharRangeCalls;
+	int setStylesCalls;
+
+	TestDocument(const std::string &text_) : text(text_), styles(text_.size(), 0), endStyled(0), stylingPosition(0), stylingMask(0),
+		gapPosition(int(text_.size()) / 2), directAccess(true), getCharRangeCalls(0), setStylesCalls(0) {
+		FindLines();
+	}
+	virtual ~TestDocument() {
+	}
+	int EndStyled() const {
+		return endStyled;
+	}
+	void SetGap(int position) {
+		gapPosition = position;
+	}
+	void SetDirectAccess(bool direct) {
+		directAccess = direct;
+	}
+	// Replaces a range, leaving the gap after it: everything after it has to be styled again
+	void Replace(int position, int deleteLength, const std::string &insertion) {
+		bool linesChanged = (insertion.find('\n') != std::string::npos) ||
+			(std::find(text.begin() + position, text.begin() + position + deleteLength, '\n') != text.begin() + position + deleteLength);
+		text.replace(position, deleteLength, insertion);
+		styles.replace(position, deleteLength, insertion.size(), 0);
+		if (linesChanged) {
+			FindLines();
+		} else {
+			for (int line = LineFromPosition(position) + 1; line < int(lineStarts.size()); line++)
+				lineStarts[line] += int(insertion.size()) - deleteLength;
+		}
+		endStyled = std::min(endStyled, LineStart(LineFromPosition(position)));
+		gapPosition = position + int(insertion.size());
+	}
+	// Styles from the start of the line of endStyled to end, as Scintilla does
+	void Colourise(ILexer *lexer, int end) {
+		int start = LineStart(LineFromPosition(endStyled));
+		int initStyle = start > 0 ? static_cast<unsigned char>(styles[start - 1]) : 0;
+		lexer->Lex(start, end - start, initStyle, this);
+	}
+	void ColouriseAll(ILexer *lexer) {
+		Colourise(lexer, Length());
+	}
+	int StyleOf(const char *sub) const {
+		return static_cast<unsigned char>(styles[text.find(sub)]);
+	}
+	const std::string &Styles() const {
+		return styles;
+	}
+
+	int SCI_METHOD Version() const {
+		return directAccess ? dvRangePointer : dvOriginal;
+	}
+	void SCI_METHOD SetErrorStatus(int) {
+	}
+	int SCI_METHOD Length() const {
+		return int(text.size());
+	}
+	void SCI_METHOD GetCharRange(char *buffer, int position, int lengthRetrieve) const {
+		const_cast<TestDocument *>(this)->getCharRangeCalls++;
+		memcpy(buffer, text.c_str() + position, lengthRetrieve);
+	}
+	char SCI_METHOD StyleAt(int position) const {
+		return (position >= 0 && position < Length()) ? styles[position] : 0;
+	}
+	int SCI_METHOD LineFromPosition(int position) const {
+		return int(std::upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin()) - 1;
+	}
+	int SCI_METHOD LineStart(int line) const {
+		if (line < 0)
+			return 0;
+		return line < int(lineStarts.size()) ? lineStarts[line] : Length();
+	}
+	int SCI_METHOD GetLevel(int line) const {
+		return line < int(levels.size()) ? levels[line] : SC_FOLDLEVELBASE;
+	}
+	int SCI_METHOD SetLevel(int line, int level) {
+		// Lines before the first one are ignored, as Document does
+		if (line < 0)
+			return 0;
+		if (line >= int(levels.size()))
+			levels.resize(line + 1, SC_FOLDLEVELBASE);
+		levels[line] = level;
+		return level;
+	}
+	int SCI_METHOD GetLineState(int line) const {
+		return line < int(lineStates.size()) ? lineStates[line] : 0;
+	}
+	int SCI_METHOD SetLineState(int line, int state) {
+		if (line < 0)
+			return 0;
+		if (line >= int(lineStates.size()))
+			lineStates.resize(line + 1, 0);
+		lineStates[line] = state;
+		return state;
+	}
+	void SCI_METHOD StartStyling(int position, char mask) {
+		stylingPosition = position;
+		stylingMask = mask;
+	}
+	bool SCI_METHOD SetStyleFor(int length, char style) {
+		for (int i = 0; i < length; i++, stylingPosition++)
+			styles[stylingPosition] = static_cast<char>((styles[stylingPosition] & ~stylingMask) | (style & stylingMask));
+		endStyled = stylingPosition;
+		return true;
+	}
+	bool SCI_METHOD SetStyles(int length, const char *styles_) {
+		setStylesCalls++;
+		for (int i = 0; i < length; i++, stylingPosition++)
+			styles[stylingPosition] = static_cast<char>((styles[stylingPosition] & ~stylingMask) | (styles_[i] & stylingMask));
+		endStyled = stylingPosition;
+		return true;
+	}
+	void SCI_METHOD DecorationSetCurrentIndicator(int) {
+	}
+	void SCI_METHOD DecorationFillRange(int, int, int) {
+	}
+	void SCI_METHOD ChangeLexerState(int, int) {
+	}
+	int SCI_METHOD CodePage() const {
+		return 0;
+	}
+	bool SCI_METHOD IsDBCSLeadByte(char) const {
+		return false;
+	}
+	const char * SCI_METHOD BufferPointer() {
+		return text.c_str();
+	}
+	int SCI_METHOD GetLineIndentation(int) {
+		return 0;
+	}
+	const char * SCI_METHOD RangePointer(int position, int rangeLength) {
+		// Reading across the gap would move it in a Document
+		assert(position + rangeLength <= gapPosition || position >= gapPosition);
+		return text.c_str() + position;
+	}
+	int SCI_METHOD GapPosition() const {
+		return gapPosition;
+	}
+};
+
+#endif
@@ -0,0 +1,133 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+
+#include "precompiled_headers.h"
+#include "Platform.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStylesTree.h"
+#include "ContractionState.h"
+
+#ifndef SHIPPING
+
+static const int nbLines = 10;
+
+static void checkDisplayLines(ContractionState & cs) {
+	int lineDisplay = 0;
+	for (int line = 0; line < cs.LinesInDoc(); line++) {
+		ASSERT_EQ(lineDisplay, cs.DisplayFromDoc(line));
+		if (cs.GetVisible(line)) {
+			ASSERT_EQ(line, cs.DocFromDisplay(lineDisplay));
+			lineDisplay += cs.GetHeight(line);
+		}
+	}
+	ASSERT_EQ(lineDisplay, cs.LinesDisplayed());
+}
+
+TEST (testContractionState, SetHeightsFromArray) {
+	ContractionState cs;
+	cs.InsertLines(0, nbLines - 1);
+	int heights[] = {1, 3, 3, 1, 2};
+	ASSERT_TRUE(cs.SetHeights(2, 5, heights));
+	ASSERT_EQ(nbLines + 5, cs.LinesDisplayed());
+	ASSERT_EQ(3, cs.GetHeight(4));
+	ASSERT_EQ(2, cs.GetHeight(6));
+	ASSERT_EQ(8, cs.DocFromDisplay(13));
+	checkDisplayLines(cs);
+	// Setting the same heights again changes nothing
+	ASSERT_FALSE(cs.SetHeights(2, 5, heights));
+	// Past the end of the document
+	ASSERT_FALSE(cs.SetHeights(8, 5, heights));
+}
+
+TEST (testContractionState, HeightsOfHiddenLines) {
+	ContractionState cs;
+	cs.InsertLines(0, nbLines - 1);
+	cs.SetVisible(3, 5, false);
+	int heights[] = {2, 2, 2, 2, 2, 2};
+	ASSERT_TRUE(cs.SetHeights(2, 6, heights));
+	// Lines 3 to 5 stay hidden whatever their height
+	ASSERT_EQ(nbLines - 3 + 3, cs.LinesDisplayed());
+	checkDisplayLines(cs);
+	ASSERT_TRUE(cs.SetVisible(3, 5, true));
+	ASSERT_EQ(nbLines + 6, cs.LinesDisplayed());
+	checkDisplayLines(cs);
+}
+
+TEST (testContractionState, SetVisibleRange) {
+	ContractionState cs;
+	cs.InsertLines(0, nbLines - 1);
+	ASSERT_FALSE(cs.SetVisible(2, 8, true));
+	ASSERT_TRUE(cs.SetVisible(2, 8, false));
+	ASSERT_EQ(3, cs.LinesDisplayed());
+	ASSERT_EQ(9, cs.DocFromDisplay(2));
+	// Overlapping a range already hidden only changes the rest
+	ASSERT_TRUE(cs.SetVisible(1, 8, false));
+	ASSERT_EQ(2, cs.LinesDisplayed());
+	ASSERT_FALSE(cs.SetVisible(3, 6, false));
+	ASSERT_TRUE(cs.SetVisible(4, 5, true));
+	ASSERT_EQ(4, cs.LinesDisplayed());
+	checkDisplayLines(cs);
+	// Out of the document
+	ASSERT_FALSE(cs.SetVisible(5, nbLines, false));
+}
+
+TEST (testContractionState, BackToOneToOne) {
+	ContractionState cs;
+	cs.InsertLines(0, nbLines - 1);
+	int wrapped[] = {2, 2, 2};
+	int unwrapped[] = {1, 1, 1};
+	cs.SetHeights(0, 3, wrapped);
+	cs.SetVisible(5, 6, false);
+	cs.SetExpanded(4, false);
+	cs.SetHeights(0, 3, unwrapped);
+	cs.SetVisible(5, 6, true);
+	ASSERT_EQ(nbLines, cs.LinesDisplayed());
+	cs.SetExpanded(4, true);
+	// Nothing is left to track, lines added later are one to one too
+	cs.InsertLines(nbLines, 5);
+	ASSERT_EQ(nbLines + 5, cs.LinesInDoc());
+	ASSERT_EQ(nbLines + 5, cs.LinesDisplayed());
+	ASSERT_EQ(12, cs.DisplayFromDoc(12));
+	ASSERT_TRUE(cs.GetExpanded(4));
+}
+
+TEST (testContractionState, InsertAndDeleteLines) {
+	ContractionState cs;
+	cs.InsertLines(0, nbLines - 1);
+	int heights[] = {3, 3};
+	cs.SetHeights(4, 2, heights);
+	cs.SetVisible(7, 8, false);
+	// New lines are shown and one display line high, even among hidden lines
+	cs.InsertLines(8, 3);
+	ASSERT_EQ(nbLines + 3, cs.LinesInDoc());
+	ASSERT_TRUE(cs.GetVisible(9));
+	ASSERT_FALSE(cs.GetVisible(11));
+	ASSERT_EQ(nbLines + 4 - 2 + 3, cs.LinesDisplayed());
+	checkDisplayLines(cs);
+	// Removing wrapped, hidden and new lines at once
+	cs.DeleteLines(5, 6);
+	ASSERT_EQ(nbLines - 3, cs.LinesInDoc());
+	ASSERT_EQ(3, cs.GetHeight(4));
+	ASSERT_FALSE(cs.GetVisible(5));
+	ASSERT_EQ(nbLines - 3 + 2 - 1, cs.LinesDisplayed());
+	checkDisplayLines(cs);
+}
+
+#endif
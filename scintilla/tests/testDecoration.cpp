@@ -0,0 +1,148 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include "Platform.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "Decoration.h"
+
+#ifndef SHIPPING
+
+static void fill(DecorationList & dl, int indicator, int value, int position, int length) {
+	dl.SetCurrentIndicator(indicator);
+	dl.FillRange(position, value, length);
+}
+
+TEST (testDecoration, IndicatorsShareRuns) {
+	DecorationList dl;
+	dl.InsertSpace(0, 20);
+	fill(dl, 2, 1, 0, 10);
+	fill(dl, 9, 5, 5, 10);
+	ASSERT_EQ(1 << 2, dl.AllOnFor(0));
+	ASSERT_EQ((1 << 2) | (1 << 9), dl.AllOnFor(7));
+	ASSERT_EQ(1 << 9, dl.AllOnFor(12));
+	ASSERT_EQ(0, dl.AllOnFor(17));
+	ASSERT_EQ(5, dl.ValueAt(9, 7));
+	ASSERT_EQ(10, dl.EndAllOn(7));
+	ASSERT_EQ((1 << 2) | (1 << 9), dl.AllInUse());
+}
+
+TEST (testDecoration, StartAndEndFollowOneIndicator) {
+	DecorationList dl;
+	dl.InsertSpace(0, 20);
+	fill(dl, 2, 1, 0, 10);
+	fill(dl, 9, 1, 5, 10);
+	ASSERT_EQ(0, dl.Start(2, 7));
+	ASSERT_EQ(10, dl.End(2, 7));
+	ASSERT_EQ(5, dl.Start(9, 7));
+	ASSERT_EQ(15, dl.End(9, 7));
+	// Not in use
+	ASSERT_EQ(0, dl.End(3, 7));
+}
+
+TEST (testDecoration, FillRangeReportsWhatChanged) {
+	DecorationList dl;
+	dl.InsertSpace(0, 20);
+	fill(dl, 2, 1, 5, 5);
+	dl.SetCurrentIndicator(2);
+	int position = 0;
+	int length = 8;
+	ASSERT_TRUE(dl.FillRange(position, 1, length));
+	ASSERT_EQ(0, position);
+	ASSERT_EQ(5, length);
+	position = 6;
+	length = 2;
+	ASSERT_FALSE(dl.FillRange(position, 1, length));
+}
+
+TEST (testDecoration, EditsMoveAllIndicators) {
+	DecorationList dl;
+	dl.InsertSpace(0, 20);
+	fill(dl, 2, 1, 5, 5);
+	fill(dl, 9, 1, 12, 3);
+	dl.InsertSpace(0, 4);
+	ASSERT_EQ(9, dl.Start(2, 10));
+	ASSERT_EQ(16, dl.Start(9, 17));
+	dl.DeleteRange(0, 10);
+	ASSERT_EQ(1 << 2, dl.AllOnFor(0));
+	ASSERT_EQ(4, dl.End(2, 0));
+	// Inside a run the inserted text takes its indicators
+	dl.InsertSpace(7, 2);
+	ASSERT_EQ(11, dl.End(9, 6));
+	fill(dl, 2, 0, 0, 4);
+	ASSERT_EQ(1 << 9, dl.AllInUse());
+}
+
+TEST (testDecoration, AppendedTextIsNotIndicated) {
+	const int storages[] = {SC_INDICSTORAGE_DEFAULT, SC_INDICSTORAGE_TREE};
+	for (int i = 0; i < 2; i++) {
+		DecorationList dl;
+		dl.SetStorage(storages[i]);
+		dl.InsertSpace(0, 20);
+		fill(dl, 2, 1, 5, 5);
+		fill(dl, 9, 1, 15, 5);
+		// Typed after an indicator reaching the end of the document
+		dl.InsertSpace(20, 3);
+		ASSERT_EQ(20, dl.End(9, 17));
+		ASSERT_EQ(0, dl.AllOnFor(21));
+		// Same as after an indicator ending in the middle of the document
+		dl.InsertSpace(10, 2);
+		ASSERT_EQ(10, dl.End(2, 7));
+		ASSERT_EQ(0, dl.AllOnFor(11));
+	}
+}
+
+TEST (testDecoration, FillRangesMergesUnsortedRanges) {
+	DecorationList dl;
+	dl.InsertSpace(0, 30);
+	const int ranges[] = {20, 5, 2, 3, 4, 4, 22, 1};
+	dl.SetCurrentIndicator(9);
+	int position = 0;
+	int length = 0;
+	ASSERT_TRUE(dl.FillRanges(ranges, 4, 1, position, length));
+	ASSERT_EQ(2, position);
+	ASSERT_EQ(23, length);
+	ASSERT_EQ(2, dl.Start(9, 5));
+	ASSERT_EQ(8, dl.End(9, 5));
+	ASSERT_EQ(20, dl.Start(9, 22));
+	ASSERT_EQ(25, dl.End(9, 22));
+	ASSERT_FALSE(dl.FillRanges(ranges, 4, 1, position, length));
+}
+
+TEST (testDecoration, StorageKeepsIndicators) {
+	DecorationList dl;
+	dl.InsertSpace(0, 20);
+	fill(dl, 2, 1, 5, 5);
+	fill(dl, 9, 3, 8, 4);
+	dl.SetStorage(SC_INDICSTORAGE_TREE);
+	ASSERT_EQ(SC_INDICSTORAGE_TREE, dl.GetStorage());
+	ASSERT_EQ((1 << 2) | (1 << 9), dl.AllOnFor(9));
+	ASSERT_EQ(3, dl.ValueAt(9, 11));
+	ASSERT_EQ(10, dl.End(2, 5));
+	dl.InsertSpace(6, 2);
+	fill(dl, 2, 0, 0, 9);
+	ASSERT_EQ(9, dl.Start(2, 11));
+	dl.SetStorage(SC_INDICSTORAGE_DEFAULT);
+	ASSERT_EQ(SC_INDICSTORAGE_DEFAULT, dl.GetStorage());
+	ASSERT_EQ(9, dl.Start(2, 11));
+	ASSERT_EQ(14, dl.End(9, 11));
+}
+
+#endif
@@ -0,0 +1,156 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include "Platform.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "Document.h"
+
+#ifndef SHIPPING
+
+// Records the modification flags of the text changes
+class ModificationRecorder : public DocWatcher {
+public:
+	std::vector<int> changes;
+
+	void NotifyModifyAttempt(Document *, void *) {}
+	void NotifySavePoint(Document *, void *, bool) {}
+	void NotifyModified(Document *, DocModification mh, void *) {
+		if (mh.modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT))
+			changes.push_back(mh.modificationType);
+	}
+	void NotifyDeleted(Document *, void *) {}
+	void NotifyStyleNeeded(Document *, void *, int) {}
+	void NotifyLexerChanged(Document *, void *) {}
+	void NotifyErrorOccurred(Document *, void *, int) {}
+};
+
+static std::string Text(Document &doc) {
+	std::string text(doc.Length(), '\0');
+	for (int i = 0; i < doc.Length(); i++)
+		text[i] = doc.CharAt(i);
+	return text;
+}
+
+static Document *NewDocument(const char *text) {
+	Document *doc = new Document();
+	doc->AddRef();
+	doc->InsertCString(0, text);
+	doc->DeleteUndoHistory();
+	return doc;
+}
+
+TEST (testDocument, ReplaceRangesAppliesAllEdits) {
+	Document *doc = NewDocument("one\ntwo\nthree\n");
+	RangeReplacement edits[] = {
+		RangeReplacement(0, 3, "1", 1),
+		RangeReplacement(4, 0, "(", 1),
+		RangeReplacement(7, 0, ")", 1),
+		RangeReplacement(8, 6, "", 0),
+	};
+	ASSERT_TRUE(doc->ReplaceRanges(edits, 4));
+	ASSERT_EQ(std::string("1\n(two)\n"), Text(*doc));
+	ASSERT_EQ(3, doc->LinesTotal());
+
+	// One undo brings everything back
+	doc->Undo();
+	ASSERT_EQ(std::string("one\ntwo\nthree\n"), Text(*doc));
+	ASSERT_FALSE(doc->CanUndo());
+	doc->Release();
+}
+
+TEST (testDocument, ReplaceRangesRejectsInvalidRanges) {
+	Document *doc = NewDocument("abcdef");
+	RangeReplacement overlapping[] = { RangeReplacement(0, 3, "x", 1), RangeReplacement(2, 0, "y", 1) };
+	ASSERT_FALSE(doc->ReplaceRanges(overlapping, 2));
+	RangeReplacement unsorted[] = { RangeReplacement(4, 0, "x", 1), RangeReplacement(1, 0, "y", 1) };
+	ASSERT_FALSE(doc->ReplaceRanges(unsorted, 2));
+	RangeReplacement outside[] = { RangeReplacement(5, 2, "x", 1) };
+	ASSERT_FALSE(doc->ReplaceRanges(outside, 1));
+	ASSERT_EQ(std::string("abcdef"), Text(*doc));
+
+	// Several insertions at the same position keep their order
+	RangeReplacement samePosition[] = { RangeReplacement(3, 0, "x", 1), RangeReplacement(3, 0, "y", 1) };
+	ASSERT_TRUE(doc->ReplaceRanges(samePosition, 2));
+	ASSERT_EQ(std::string("abcxydef"), Text(*doc));
+	doc->Release();
+}
+
+TEST (testDocument, ReplaceRangesFlagsOnlyTheFinalStepAsLast) {
+	Document *doc = NewDocument("a b c");
+	ModificationRecorder recorder;
+	doc->AddWatcher(&recorder, 0);
+	RangeReplacement edits[] = {
+		RangeReplacement(0, 1, "x", 1),
+		RangeReplacement(2, 0, "y", 1),
+		RangeReplacement(4, 1, "", 0),
+	};
+	ASSERT_TRUE(doc->ReplaceRanges(edits, 3));
+	ASSERT_EQ(std::string("x yb "), Text(*doc));
+	ASSERT_EQ(4u, recorder.changes.size());
+	for (size_t i = 0; i < recorder.changes.size(); i++) {
+		ASSERT_TRUE((recorder.changes[i] & SC_MULTIRANGEEDIT) != 0);
+		ASSERT_EQ(i == recorder.changes.size() - 1, (recorder.changes[i] & SC_LASTSTEPINMULTIRANGEEDIT) != 0);
+	}
+	// The last step is the insertion of the first range, applied after all the others
+	ASSERT_TRUE((recorder.changes.back() & SC_MOD_INSERTTEXT) != 0);
+
+	// Edits outside a batch are not flagged
+	recorder.changes.clear();
+	doc->InsertCString(0, "z");
+	ASSERT_EQ(1u, recorder.changes.size());
+	ASSERT_EQ(0, recorder.changes[0] & (SC_MULTIRANGEEDIT | SC_LASTSTEPINMULTIRANGEEDIT));
+	doc->RemoveWatcher(&recorder, 0);
+	doc->Release();
+}
+
+TEST (testDocument, ReplaceRangesDoesNotFlagASingleRange) {
+	Document *doc = NewDocument("abc");
+	ModificationRecorder recorder;
+	doc->AddWatcher(&recorder, 0);
+	// Typing with one caret, then over a selection
+	RangeReplacement typing[] = { RangeReplacement(3, 0, "d", 1) };
+	ASSERT_TRUE(doc->ReplaceRanges(typing, 1));
+	RangeReplacement overtyping[] = { RangeReplacement(0, 2, "x", 1), RangeReplacement(3, 0, "", 0) };
+	ASSERT_TRUE(doc->ReplaceRanges(overtyping, 2));
+	ASSERT_EQ(std::string("xcd"), Text(*doc));
+	ASSERT_EQ(3u, recorder.changes.size());
+	for (size_t i = 0; i < recorder.changes.size(); i++)
+		ASSERT_EQ(0, recorder.changes[i] & (SC_MULTIRANGEEDIT | SC_LASTSTEPINMULTIRANGEEDIT));
+	doc->RemoveWatcher(&recorder, 0);
+	doc->Release();
+}
+
+TEST (testDocument, ReplaceRangesSingleInsertionCoalescesWithTyping) {
+	Document *doc = NewDocument("");
+	RangeReplacement first[] = { RangeReplacement(0, 0, "a", 1) };
+	RangeReplacement second[] = { RangeReplacement(1, 0, "b", 1) };
+	ASSERT_TRUE(doc->ReplaceRanges(first, 1));
+	ASSERT_TRUE(doc->ReplaceRanges(second, 1));
+	doc->Undo();
+	ASSERT_EQ(0, doc->Length());
+	doc->Release();
+}
+
+#endif
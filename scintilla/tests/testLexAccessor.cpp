@@ -0,0 +1,166 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include "TestDocument.h"
+
+#ifndef SHIPPING
+
+extern LexerModule lmCPP;
+extern LexerModule lmHTML;
+extern LexerModule lmSQL;
+extern LexerModule lmPython;
+
+static std::string Alphabet(int length) {
+	std::string text;
+	for (int i = 0; i < length; i++)
+		text += static_cast<char>('a' + i % 26);
+	return text;
+}
+
+static void ReadsEveryCharacter(TestDocument &doc, const std::string &text) {
+	LexAccessor styler(&doc);
+	for (int i = 0; i < int(text.size()); i++)
+		ASSERT_EQ(text[i], styler[i]);
+	// Backward, as lexers do when they look behind
+	for (int i = int(text.size()) - 1; i >= 0; i--)
+		ASSERT_EQ(text[i], styler.SafeGetCharAt(i));
+}
+
+TEST (testLexAccessor, ReadsAroundTheGap) {
+	std::string text = Alphabet(10000);
+	TestDocument doc(text);
+	const int gaps[] = {0, 1, 3999, 5000, 9999, 10000};
+	for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++) {
+		doc.SetGap(gaps[g]);
+		ReadsEveryCharacter(doc, text);
+	}
+	ASSERT_EQ(0, doc.getCharRangeCalls);
+}
+
+TEST (testLexAccessor, OutsideTheDocument) {
+	TestDocument doc(Alphabet(100));
+	LexAccessor styler(&doc);
+	ASSERT_EQ('#', styler.SafeGetCharAt(-1, '#'));
+	ASSERT_EQ('#', styler.SafeGetCharAt(100, '#'));
+	// Lexers peeking one past the end get a terminator, as they always did
+	ASSERT_EQ('\0', styler[100]);
+	ASSERT_EQ('a', styler[0]);
+}
+
+TEST (testLexAccessor, ReadsByCopiesWithoutRangePointer) {
+	std::string text = Alphabet(10000);
+	TestDocument doc(text);
+	doc.SetDirectAccess(false);
+	ReadsEveryCharacter(doc, text);
+	ASSERT_TRUE(doc.getCharRangeCalls > 0);
+}
+
+TEST (testLexAccessor, StyleAtSeesPendingStyles) {
+	TestDocument doc(Alphabet(100));
+	LexAccessor styler(&doc);
+	styler.StartAt(0);
+	styler.StartSegment(0);
+	styler.ColourTo(9, 3);
+	styler.ColourTo(19, 5);
+	ASSERT_EQ(3, styler.StyleAt(9));
+	ASSERT_EQ(5, styler.StyleAt(10));
+	ASSERT_EQ(0, styler.StyleAt(20));
+	ASSERT_EQ(0, doc.StyleAt(10));
+	styler.Flush();
+	ASSERT_EQ(5, doc.StyleAt(10));
+	ASSERT_EQ(5, styler.StyleAt(10));
+}
+
+TEST (testLexAccessor, StyleAtAfterARunTooLongToBuffer) {
+	const int longRun = 300 * 1024;
+	TestDocument doc(Alphabet(longRun + 100));
+	LexAccessor styler(&doc);
+	styler.StartAt(0);
+	styler.StartSegment(0);
+	styler.ColourTo(9, 3);
+	styler.ColourTo(9 + longRun, 5);
+	styler.ColourTo(19 + longRun, 6);
+	ASSERT_EQ(3, styler.StyleAt(9));
+	ASSERT_EQ(5, styler.StyleAt(10));
+	ASSERT_EQ(5, styler.StyleAt(9 + longRun));
+	ASSERT_EQ(6, styler.StyleAt(10 + longRun));
+	ASSERT_EQ(0, doc.StyleAt(10 + longRun));
+	styler.Flush();
+	ASSERT_EQ(6, doc.StyleAt(19 + longRun));
+	ASSERT_EQ(0, doc.StyleAt(20 + longRun));
+}
+
+TEST (testLexAccessor, LongRangesAreStyledInFewCalls) {
+	const int length = 100000;
+	TestDocument doc(Alphabet(length));
+	{
+		LexAccessor styler(&doc);
+		styler.StartAt(0);
+		styler.StartSegment(0);
+		for (int pos = 9; pos < length; pos += 10)
+			styler.ColourTo(pos, (pos / 10) % 8);
+		styler.Flush();
+	}
+	ASSERT_TRUE(doc.setStylesCalls <= 6);
+	for (int pos = 0; pos < length; pos++)
+		ASSERT_EQ((pos / 10) % 8, doc.StyleAt(pos));
+}
+
+// Mixed sample text, lexed by each lexer as if it were its language
+static std::string SampleText(int length) {
+	static const char *lines[] = {
+		"#include <stdio.h>\n",
+		"int main(int argc, char *argv[]) { /* comment */ return 0x1F + argc; }\n",
+		"<div class=\"box\"><a href='#'>link</a> &amp; text</div>\n",
+		"SELECT name, COUNT(*) FROM users WHERE id > 10 -- filter\n",
+		"def f(x):\n    return \"string %d\" % x  # comment\n",
+		"\n",
+	};
+	const size_t nLines = sizeof(lines) / sizeof(lines[0]);
+	std::string text;
+	for (size_t i = 0; int(text.size()) < length; i++)
+		text += lines[i % nLines];
+	return text;
+}
+
+static double LexSeconds(LexerModule &lm, TestDocument &doc) {
+	ILexer *lexer = lm.Create();
+	clock_t start = clock();
+	doc.ColouriseAll(lexer);
+	double seconds = double(clock() - start) / CLOCKS_PER_SEC;
+	lexer->Release();
+	return seconds;
+}
+
+TEST (testLexAccessor, DISABLED_BenchThroughput) {
+	const int length = 32 * 1024 * 1024;
+	LexerModule *lexers[] = {&lmCPP, &lmHTML, &lmSQL, &lmPython};
+	for (size_t l = 0; l < sizeof(lexers) / sizeof(lexers[0]); l++) {
+		TestDocument doc(SampleText(length));
+		double direct = LexSeconds(*lexers[l], doc);
+		TestDocument docCopied(SampleText(length));
+		docCopied.SetDirectAccess(false);
+		double copied = LexSeconds(*lexers[l], docCopied);
+		ASSERT_TRUE(doc.Styles() == docCopied.Styles());
+		printf("%-8s %7.1f MB/s in place, %7.1f MB/s copied\n", lexers[l]->languageName,
+			length / (1024 * 1024) / direct, length / (1024 * 1024) / copied);
+	}
+}
+
+#endif
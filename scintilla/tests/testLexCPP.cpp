@@ -0,0 +1,143 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+
+#include "precompiled_headers.h"
+#include "TestDocument.h"
+
+#ifndef SHIPPING
+
+extern LexerModule lmCPP;
+
+const int inactiveFlag = 0x40;
+
+static bool IsInactive(const TestDocument &doc, const char *sub) {
+	return (doc.StyleOf(sub) & inactiveFlag) != 0;
+}
+
+TEST (testLexCPP, DefineEnablesSection) {
+	TestDocument doc("#define A\n#ifdef A\nint a;\n#else\nint b;\n#endif\nint c;\n");
+	ILexer *lexer = lmCPP.Create();
+	lexer->WordListSet(0, "int");
+	doc.ColouriseAll(lexer);
+	ASSERT_FALSE(IsInactive(doc, "int a"));
+	ASSERT_TRUE(IsInactive(doc, "int b"));
+	ASSERT_FALSE(IsInactive(doc, "int c"));
+	ASSERT_EQ(SCE_C_WORD, doc.StyleOf("int c"));
+	lexer->Release();
+}
+
+TEST (testLexCPP, WordListDefinitions) {
+	TestDocument doc("#if VERSION > 1\nint a;\n#endif\n#if VERSION > 2\nint b;\n#endif\n");
+	ILexer *lexer = lmCPP.Create();
+	lexer->WordListSet(4, "VERSION=2");
+	doc.ColouriseAll(lexer);
+	ASSERT_FALSE(IsInactive(doc, "int a"));
+	ASSERT_TRUE(IsInactive(doc, "int b"));
+	lexer->Release();
+}
+
+TEST (testLexCPP, RelexAfterDefineRemoved) {
+	TestDocument doc("int x;\n#define A\n#ifdef A\nint a;\n#endif\n");
+	ILexer *lexer = lmCPP.Create();
+	doc.ColouriseAll(lexer);
+	ASSERT_FALSE(IsInactive(doc, "int a"));
+
+	// Turn the #define into a comment: the definition must be rolled back
+	doc.Replace(doc.LineStart(1), 0, "//");
+	doc.ColouriseAll(lexer);
+	ASSERT_EQ(SCE_C_COMMENTLINE, doc.StyleOf("//#define"));
+	ASSERT_TRUE(IsInactive(doc, "int a"));
+	lexer->Release();
+}
+
+TEST (testLexCPP, RelexRestoresPreviousValue) {
+	TestDocument doc("#define V 1\n#define V 2\n#if V == 2\nint two;\n#endif\n#if V == 1\nint one;\n#endif\n");
+	ILexer *lexer = lmCPP.Create();
+	doc.ColouriseAll(lexer);
+	ASSERT_FALSE(IsInactive(doc, "int two"));
+	ASSERT_TRUE(IsInactive(doc, "int one"));
+
+	// Only the second #define is rolled back, V goes back to its first value
+	doc.Replace(doc.LineStart(1), 0, "//");
+	doc.ColouriseAll(lexer);
+	ASSERT_TRUE(IsInactive(doc, "int two"));
+	ASSERT_FALSE(IsInactive(doc, "int one"));
+	lexer->Release();
+}
+
+TEST (testLexCPP, RelexInsideInactiveSection) {
+	TestDocument doc("#if 0\nint a;\n\nint b;\n#endif\nint c;\n");
+	ILexer *lexer = lmCPP.Create();
+	doc.ColouriseAll(lexer);
+
+	// Relexing from a line in the middle of the section picks up its state
+	doc.Replace(doc.LineStart(2), 0, "int z;");
+	doc.ColouriseAll(lexer);
+	ASSERT_TRUE(IsInactive(doc, "int z"));
+	ASSERT_TRUE(IsInactive(doc, "int b"));
+	ASSERT_FALSE(IsInactive(doc, "int c"));
+	lexer->Release();
+}
+
+// A header heavy translation unit: guarded headers full of #define and #if
+static std::string HeaderHeavySource(int headers, int definesPerHeader) {
+	std::string source;
+	char line[200];
+	for (int h = 0; h < headers; h++) {
+		sprintf(line, "#ifndef HEADER_%d_H\n#define HEADER_%d_H\n", h, h);
+		source += line;
+		for (int d = 0; d < definesPerHeader; d++) {
+			sprintf(line, "#define OPTION_%d_%d %d\n", h, d, d % 3);
+			source += line;
+			sprintf(line, "#if OPTION_%d_%d > 0 && defined(HEADER_%d_H)\nint value_%d_%d = %d; // active\n#else\nint value_%d_%d; /* inactive */\n#endif\n",
+				h, d, h, h, d, d, h, d);
+			source += line;
+		}
+		source += "#endif\n";
+	}
+	return source;
+}
+
+TEST (testLexCPP, DISABLED_BenchHeaderHeavy) {
+	TestDocument doc(HeaderHeavySource(200, 50));
+	ILexer *lexer = lmCPP.Create();
+
+	clock_t start = clock();
+	doc.ColouriseAll(lexer);
+	double timeFull = double(clock() - start) / CLOCKS_PER_SEC;
+
+	// Typing: each keystroke relexes a screen of lines from the edited line
+	const int keystrokes = 2000;
+	const int screenLines = 60;
+	unsigned int seed = 1;
+	start = clock();
+	for (int k = 0; k < keystrokes; k++) {
+		seed = seed * 1103515245 + 12345;
+		int line = int((seed >> 8) % (doc.LineFromPosition(doc.Length()) - screenLines));
+		doc.Replace(doc.LineStart(line), 0, " ");
+		doc.Colourise(lexer, doc.LineStart(line + screenLines));
+	}
+	double timeTyping = double(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("%d chars, %d lines: full lex %.3fs, %d keystrokes %.3fs\n",
+		doc.Length(), doc.LineFromPosition(doc.Length()), timeFull, keystrokes, timeTyping);
+	lexer->Release();
+}
+
+#endif
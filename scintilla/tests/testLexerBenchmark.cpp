@@ -0,0 +1,221 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include <psapi.h>
+#include "Catalogue.h"
+#include "TestDocument.h"
+
+#ifndef SHIPPING
+
+// Lexes and folds the same text with every lexer of the catalogue, to find the ones
+// that would make a large file unusable. Disabled, run it with
+//   --gtest_also_run_disabled_tests --gtest_filter=testLexerBenchmark.*
+// Configured from the environment:
+//   NPP_LEXBENCH_MB      size of each corpus in MB, 8 by default
+//   NPP_LEXBENCH_CORPUS  directory whose files, repeated up to the size, make one more corpus
+//   NPP_LEXBENCH_LEXERS  comma separated lexer names to run instead of all of them
+// For each lexer and corpus it prints the Lex and Fold throughput, the time to relex
+// a screen after an edit in the middle, and how much more memory the process committed
+// while the lexer went through the whole text.
+
+const int restartScreenLines = 100;
+const double slowMBPerSecond = 2.0;
+const double slowRestartMs = 100.0;
+
+static size_t CommittedBytes() {
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PagefileUsage;
+}
+
+static double Seconds(clock_t start) {
+	return double(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static int CorpusSize() {
+	const char *mb = getenv("NPP_LEXBENCH_MB");
+	int size = mb ? atoi(mb) : 0;
+	return (size > 0 ? size : 8) * 1024 * 1024;
+}
+
+static std::string Repeated(const std::string &sample, int size) {
+	std::string text;
+	if (sample.empty())
+		return text;
+	text.reserve(size + sample.size());
+	while (int(text.size()) < size)
+		text += sample;
+	return text;
+}
+
+// A bit of everything most lexers know about
+static std::string MixedSample() {
+	return
+		"#include <stdio.h>\n"
+		"int main(int argc, char *argv[]) { /* comment */ return 0x1F + argc; }\n"
+		"<div class=\"box\"><a href='#'>link</a> &amp; text</div>\n"
+		"SELECT name, COUNT(*) FROM users WHERE id > 10 -- filter\n"
+		"def f(x):\n    return \"string %d\" % x  # comment\n"
+		"<?php echo $x; ?>\n"
+		"@echo off\nREM batch\n"
+		"  {\n    if (a) b; else c;\n  }\n"
+		"key = value ; ini\n"
+		"\n";
+}
+
+// Generated corpora, the last ones being shapes that lexers tend to handle badly
+static void GeneratedCorpora(std::vector<std::pair<std::string, std::string> > &corpora, int size) {
+	std::string mixed = MixedSample();
+	corpora.push_back(std::make_pair(std::string("mixed"), Repeated(mixed, size)));
+
+	std::string oneLine = mixed;
+	std::replace(oneLine.begin(), oneLine.end(), '\n', ' ');
+	corpora.push_back(std::make_pair(std::string("one line"), Repeated(oneLine, size)));
+
+	// Everything after the first line is in a string or a comment for many lexers
+	corpora.push_back(std::make_pair(std::string("unterminated"), "/* \" ' <!-- <![CDATA[ \"\"\" [[\n" + Repeated(mixed, size)));
+
+	std::string nested;
+	for (int depth = 0; depth < 200; depth++)
+		nested += std::string(depth % 40, ' ') + "{ ( [ <a>\n";
+	for (int depth = 0; depth < 200; depth++)
+		nested += std::string(depth % 40, ' ') + "</a> ] ) }\n";
+	corpora.push_back(std::make_pair(std::string("nested"), Repeated(nested, size)));
+}
+
+static void CorpusFromDirectory(std::vector<std::pair<std::string, std::string> > &corpora, int size) {
+	const char *directory = getenv("NPP_LEXBENCH_CORPUS");
+	if (!directory)
+		return;
+	std::string sample;
+	std::string pattern = std::string(directory) + "\\*";
+	WIN32_FIND_DATAA findData;
+	HANDLE hFind = ::FindFirstFileA(pattern.c_str(), &findData);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+	do {
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+		std::string path = std::string(directory) + "\\" + findData.cFileName;
+		FILE *fp = fopen(path.c_str(), "rb");
+		if (!fp)
+			continue;
+		char block[64 * 1024];
+		size_t lenRead;
+		while ((lenRead = fread(block, 1, sizeof(block), fp)) > 0 && int(sample.size()) < size)
+			sample.append(block, lenRead);
+		fclose(fp);
+	} while (int(sample.size()) < size && ::FindNextFileA(hFind, &findData));
+	::FindClose(hFind);
+	if (!sample.empty())
+		corpora.push_back(std::make_pair(std::string("corpus"), Repeated(sample, size)));
+}
+
+static bool IsSelected(const char *languageName) {
+	const char *selection = getenv("NPP_LEXBENCH_LEXERS");
+	if (!selection)
+		return true;
+	std::string names = std::string(",") + selection + ",";
+	return names.find(std::string(",") + languageName + ",") != std::string::npos;
+}
+
+// Every named lexer once, looked up again by its name as Notepad++ does
+static std::vector<const LexerModule *> SelectedLexers() {
+	std::vector<const LexerModule *> lexers;
+	for (int language = 0; language < SCLEX_AUTOMATIC + 100; language++) {
+		const LexerModule *lm = Catalogue::Find(language);
+		if (!lm || !lm->languageName || !IsSelected(lm->languageName))
+			continue;
+		lm = Catalogue::Find(lm->languageName);
+		if (std::find(lexers.begin(), lexers.end(), lm) == lexers.end())
+			lexers.push_back(lm);
+	}
+	return lexers;
+}
+
+static void Configure(const LexerModule *lm, ILexer *lexer) {
+	lexer->PropertySet("fold", "1");
+	lexer->PropertySet("fold.compact", "1");
+	lexer->PropertySet("fold.comment", "1");
+	lexer->PropertySet("fold.preprocessor", "1");
+	lexer->PropertySet("fold.html", "1");
+	// Cannot run before Notepad++ has given it its settings
+	if (lm->GetLanguage() == SCLEX_USER)
+		lexer->WordListSet(0, "000000");	// no delimiters
+}
+
+struct LexerTimes {
+	double lexMBs;
+	double foldMBs;
+	double restartMs;
+	size_t memoryKB;
+};
+
+static LexerTimes Measure(const LexerModule *lm, const std::string &text) {
+	LexerTimes times;
+	TestDocument doc(text);
+	size_t memoryBefore = CommittedBytes();
+	size_t memoryPeak = memoryBefore;
+	ILexer *lexer = lm->Create();
+	Configure(lm, lexer);
+	double megabytes = double(text.size()) / (1024 * 1024);
+
+	clock_t start = clock();
+	doc.ColouriseAll(lexer);
+	times.lexMBs = megabytes / std::max(Seconds(start), 0.001);
+	memoryPeak = std::max(memoryPeak, CommittedBytes());
+
+	start = clock();
+	lexer->Fold(0, doc.Length(), 0, &doc);
+	times.foldMBs = megabytes / std::max(Seconds(start), 0.001);
+	memoryPeak = std::max(memoryPeak, CommittedBytes());
+	times.memoryKB = (memoryPeak - memoryBefore) / 1024;
+
+	// Typing in the middle: what has to be relexed to show the screen again
+	int line = doc.LineFromPosition(doc.Length() / 2);
+	doc.Replace(doc.LineStart(line), 0, "x");
+	start = clock();
+	doc.Colourise(lexer, doc.LineStart(line + restartScreenLines));
+	times.restartMs = Seconds(start) * 1000;
+
+	lexer->Release();
+	return times;
+}
+
+TEST (testLexerBenchmark, DISABLED_AllLexers) {
+	int size = CorpusSize();
+	std::vector<std::pair<std::string, std::string> > corpora;
+	GeneratedCorpora(corpora, size);
+	CorpusFromDirectory(corpora, size);
+	std::vector<const LexerModule *> lexers = SelectedLexers();
+	ASSERT_FALSE(lexers.empty());
+
+	printf("%-16s %-12s %10s %10s %11s %10s\n", "lexer", "corpus", "lex MB/s", "fold MB/s", "restart ms", "memory KB");
+	for (size_t l = 0; l < lexers.size(); l++) {
+		for (size_t c = 0; c < corpora.size(); c++) {
+			LexerTimes times = Measure(lexers[l], corpora[c].second);
+			bool isSlow = times.lexMBs < slowMBPerSecond || times.foldMBs < slowMBPerSecond || times.restartMs > slowRestartMs;
+			printf("%-16s %-12s %10.1f %10.1f %11.1f %10u%s\n", lexers[l]->languageName, corpora[c].first.c_str(),
+				times.lexMBs, times.foldMBs, times.restartMs, static_cast<unsigned int>(times.memoryKB), isSlow ? "  <- slow" : "");
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,86 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include "Platform.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+
+#ifndef SHIPPING
+
+static const int nbLines = 10;
+
+static void fillMarkers(LineMarkers & lm) {
+	lm.AddMark(2, 0, nbLines);
+	lm.AddMark(5, 1, nbLines);
+	lm.AddMark(5, 0, nbLines);
+	lm.AddMark(8, 1, nbLines);
+}
+
+TEST (testPerLine, MarkerNextAndPrevious) {
+	LineMarkers lm;
+	fillMarkers(lm);
+	ASSERT_EQ(2, lm.MarkerNext(0, 1));
+	ASSERT_EQ(5, lm.MarkerNext(3, 3));
+	ASSERT_EQ(8, lm.MarkerNext(6, 3));
+	ASSERT_EQ(-1, lm.MarkerNext(6, 1));
+	ASSERT_EQ(5, lm.MarkerPrevious(7, 3));
+	ASSERT_EQ(2, lm.MarkerPrevious(4, 1));
+	ASSERT_EQ(-1, lm.MarkerPrevious(4, 2));
+}
+
+TEST (testPerLine, LinesWithMarkersReportsEachLineOnce) {
+	LineMarkers lm;
+	fillMarkers(lm);
+	int lines[nbLines];
+	ASSERT_EQ(3, lm.LinesWithMarkers(3, NULL));
+	ASSERT_EQ(3, lm.LinesWithMarkers(3, lines));
+	ASSERT_EQ(2, lines[0]);
+	ASSERT_EQ(5, lines[1]);
+	ASSERT_EQ(8, lines[2]);
+}
+
+TEST (testPerLine, IndexFollowsLineInsertionAndRemoval) {
+	LineMarkers lm;
+	fillMarkers(lm);
+	lm.InsertLine(3);
+	ASSERT_EQ(6, lm.MarkerNext(3, 1));
+	// Markers of a removed line go to the line before
+	lm.RemoveLine(6);
+	ASSERT_EQ(5, lm.MarkerNext(3, 1));
+	ASSERT_EQ(8, lm.MarkerNext(6, 2));
+	ASSERT_EQ(0, lm.LinesWithMarkers(4, NULL));
+}
+
+TEST (testPerLine, IndexFollowsDeletions) {
+	LineMarkers lm;
+	fillMarkers(lm);
+	int handle = lm.AddMark(8, 0, nbLines);
+	lm.DeleteMarkFromHandle(handle);
+	ASSERT_EQ(5, lm.MarkerPrevious(9, 1));
+	ASSERT_TRUE(lm.DeleteAllMarks(1));
+	ASSERT_EQ(-1, lm.MarkerNext(0, 2));
+	ASSERT_EQ(2, lm.LinesWithMarkers(1, NULL));
+	lm.DeleteMark(5, -1, false);
+	ASSERT_EQ(2, lm.MarkerNext(0, 3));
+	ASSERT_EQ(-1, lm.MarkerNext(3, 3));
+}
+
+#endif
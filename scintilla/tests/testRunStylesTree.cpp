@@ -0,0 +1,183 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+
+#include "precompiled_headers.h"
+#include "Platform.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "RunStylesTree.h"
+
+#ifndef SHIPPING
+
+static int fill(RunStylesTree & rs, int value, int position, int length) {
+	rs.FillRange(position, value, length);
+	return rs.Runs();
+}
+
+TEST (testRunStylesTree, FillMergesNeighbours) {
+	RunStylesTree rs;
+	rs.InsertSpace(0, 20);
+	ASSERT_EQ(1, rs.Runs());
+	ASSERT_EQ(3, fill(rs, 1, 5, 5));
+	ASSERT_EQ(5, fill(rs, 2, 12, 3));
+	ASSERT_EQ(1, rs.ValueAt(9));
+	ASSERT_EQ(10, rs.EndRun(5));
+	ASSERT_EQ(12, rs.StartRun(14));
+	// Filling the gap with the value of the run after joins them
+	ASSERT_EQ(4, fill(rs, 2, 10, 2));
+	ASSERT_EQ(3, fill(rs, 2, 5, 5));
+	ASSERT_EQ(5, rs.StartRun(9));
+	ASSERT_EQ(15, rs.EndRun(9));
+	ASSERT_EQ(1, fill(rs, 0, 0, 20));
+}
+
+TEST (testRunStylesTree, FillReportsWhatChanged) {
+	RunStylesTree rs;
+	rs.InsertSpace(0, 20);
+	fill(rs, 1, 5, 10);
+	int position = 2;
+	int length = 8;
+	ASSERT_TRUE(rs.FillRange(position, 1, length));
+	ASSERT_EQ(2, position);
+	ASSERT_EQ(3, length);
+	position = 6;
+	length = 4;
+	ASSERT_FALSE(rs.FillRange(position, 1, length));
+}
+
+TEST (testRunStylesTree, InsertAtBoundaryExtendsRunBefore) {
+	RunStylesTree rs;
+	rs.InsertSpace(0, 10);
+	fill(rs, 1, 3, 4);
+	// At the start of a valued run, the text goes to the run before
+	rs.InsertSpace(3, 2);
+	ASSERT_EQ(0, rs.ValueAt(4));
+	ASSERT_EQ(5, rs.StartRun(5));
+	// At its end, the text goes to the run after, which has no value
+	rs.InsertSpace(9, 2);
+	ASSERT_EQ(0, rs.ValueAt(9));
+	ASSERT_EQ(9, rs.EndRun(5));
+	// At the start of the document, the text gets no value
+	fill(rs, 1, 0, 2);
+	rs.InsertSpace(0, 1);
+	ASSERT_EQ(0, rs.ValueAt(0));
+	ASSERT_EQ(1, rs.ValueAt(1));
+	// Appended text extends the last run
+	fill(rs, 2, rs.Length() - 1, 1);
+	rs.InsertSpace(rs.Length(), 3);
+	ASSERT_EQ(2, rs.ValueAt(rs.Length() - 1));
+	ASSERT_EQ(18, rs.Length());
+}
+
+TEST (testRunStylesTree, DeleteJoinsRunsWithSameValue) {
+	RunStylesTree rs;
+	rs.InsertSpace(0, 20);
+	fill(rs, 1, 2, 3);
+	fill(rs, 1, 10, 3);
+	ASSERT_EQ(5, rs.Runs());
+	rs.DeleteRange(4, 7);
+	ASSERT_EQ(3, rs.Runs());
+	ASSERT_EQ(2, rs.StartRun(3));
+	ASSERT_EQ(6, rs.EndRun(3));
+	rs.DeleteRange(0, rs.Length());
+	ASSERT_EQ(0, rs.Length());
+	ASSERT_EQ(0, rs.Runs());
+	ASSERT_EQ(0, rs.ValueAt(0));
+}
+
+// Simple generator, so that the runs are the same on every platform
+static unsigned int nextRandom(unsigned int & seed, int range) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) % range;
+}
+
+TEST (testRunStylesTree, SameValuesAsRunStyles) {
+	unsigned int seed = 1;
+	RunStyles rs;
+	RunStylesTree rst;
+	for (int step = 0; step < 2000; step++) {
+		int len = rs.Length();
+		int op = nextRandom(seed, 10);
+		if (op < 3 || len == 0) {
+			int position = len ? nextRandom(seed, len) : 0;
+			int length = 1 + nextRandom(seed, 20);
+			rs.InsertSpace(position, length);
+			rst.InsertSpace(position, length);
+		} else {
+			int position = nextRandom(seed, len);
+			int length = 1 + nextRandom(seed, len - position);
+			if (op < 5) {
+				rs.DeleteRange(position, length);
+				rst.DeleteRange(position, length);
+			} else {
+				int value = nextRandom(seed, 3);
+				int fillPosition = position;
+				int fillLength = length;
+				rs.FillRange(fillPosition, value, fillLength);
+				rst.FillRange(position, value, length);
+			}
+		}
+		ASSERT_EQ(rs.Length(), rst.Length());
+		for (int pos = 0; pos < rs.Length(); pos++) {
+			ASSERT_EQ(rs.ValueAt(pos), rst.ValueAt(pos));
+			ASSERT_EQ(rs.StartRun(pos), rst.StartRun(pos));
+		}
+	}
+}
+
+// Search results marked all over a big file, then edited in random places: each step
+// types, deletes, and marks or unmarks a word somewhere. Run with
+// --gtest_also_run_disabled_tests to compare both classes.
+template <typename Runs>
+static double benchFragmented(Runs & runs, int lengthDocument, int runLength, int steps) {
+	unsigned int seed = 1;
+	runs.InsertSpace(0, lengthDocument);
+	for (int pos = 0; pos + runLength < lengthDocument; pos += 2 * runLength) {
+		int position = pos;
+		int length = runLength;
+		runs.FillRange(position, 1, length);
+	}
+	clock_t start = clock();
+	for (int step = 0; step < steps; step++) {
+		int position = nextRandom(seed, runs.Length() - 10);
+		runs.InsertSpace(position, 1);
+		runs.DeleteRange(nextRandom(seed, runs.Length() - 10), 1);
+		int fillPosition = nextRandom(seed, runs.Length() - 10);
+		int fillLength = 5;
+		runs.FillRange(fillPosition, step & 1, fillLength);
+		runs.ValueAt(nextRandom(seed, runs.Length()));
+	}
+	return double(clock() - start) / CLOCKS_PER_SEC;
+}
+
+TEST (testRunStylesTree, DISABLED_BenchFragmented) {
+	const int lengths[] = {100000, 1000000, 10000000};
+	for (int i = 0; i < 3; i++) {
+		RunStyles rs;
+		RunStylesTree rst;
+		double timeRunStyles = benchFragmented(rs, lengths[i], 5, 20000);
+		double timeTree = benchFragmented(rst, lengths[i], 5, 20000);
+		printf("%d chars, %d runs: RunStyles %.3fs, RunStylesTree %.3fs\n",
+			lengths[i], rst.Runs(), timeRunStyles, timeTree);
+		ASSERT_EQ(rs.Length(), rst.Length());
+	}
+}
+
+#endif
@@ -0,0 +1,53 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+#include "precompiled_headers.h"
+#include "Platform.h"
+#include "SplitVector.h"
+
+#ifndef SHIPPING
+
+// "abcdef" with the gap after "abc"
+static void fillWithGapInMiddle(SplitVector<char> & sv) {
+	sv.InsertFromArray(0, "abcdef", 0, 6);
+	sv.Insert(3, 'x');
+	sv.Delete(3);
+}
+
+TEST (testSplitVector, RangeBeforeGapDoesNotMoveGap) {
+	SplitVector<char> sv;
+	fillWithGapInMiddle(sv);
+	ASSERT_EQ(3, sv.GapPosition());
+	ASSERT_EQ(0, memcmp(sv.RangePointer(0, 3), "abc", 3));
+	ASSERT_EQ(3, sv.GapPosition());
+}
+
+TEST (testSplitVector, RangeAfterGapDoesNotMoveGap) {
+	SplitVector<char> sv;
+	fillWithGapInMiddle(sv);
+	ASSERT_EQ(0, memcmp(sv.RangePointer(3, 3), "def", 3));
+	ASSERT_EQ(3, sv.GapPosition());
+}
+
+TEST (testSplitVector, RangeOverGapMovesGapToItsStart) {
+	SplitVector<char> sv;
+	fillWithGapInMiddle(sv);
+	ASSERT_EQ(0, memcmp(sv.RangePointer(1, 4), "bcde", 4));
+	ASSERT_EQ(1, sv.GapPosition());
+}
+
+#endif
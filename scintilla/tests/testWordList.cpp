@@ -0,0 +1,136 @@
+// This file is part of notepad++
+// Copyright (C)2010 The Notepad++ Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+
+#include "precompiled_headers.h"
+#include "WordList.h"
+
+#ifndef SHIPPING
+
+TEST (testWordList, InList) {
+	WordList wl;
+	wl.Set("while if else int\nunsigned");
+	ASSERT_TRUE(wl.InList("while"));
+	ASSERT_TRUE(wl.InList("unsigned"));
+	ASSERT_TRUE(wl.InList("if"));
+	ASSERT_FALSE(wl.InList("i"));
+	ASSERT_FALSE(wl.InList("iff"));
+	ASSERT_FALSE(wl.InList("While"));
+	ASSERT_FALSE(wl.InList(""));
+	ASSERT_FALSE(wl.InList("for"));
+}
+
+TEST (testWordList, CaretWordsArePrefixes) {
+	WordList wl;
+	wl.Set("^gtk_ int");
+	ASSERT_TRUE(wl.InList("gtk_window_new"));
+	ASSERT_TRUE(wl.InList("int"));
+	ASSERT_FALSE(wl.InList("gtk"));
+	ASSERT_FALSE(wl.InListExact("gtk_window_new", false));
+	ASSERT_TRUE(wl.InListExact("^gtk_", false));
+}
+
+TEST (testWordList, Empty) {
+	WordList wl;
+	ASSERT_FALSE(wl.InList("int"));
+	ASSERT_FALSE(wl.InListExact("int", true));
+	ASSERT_FALSE(wl.InListPrefix("int", true));
+	wl.Set("");
+	ASSERT_FALSE(wl.InList("int"));
+	ASSERT_FALSE(wl.InListPrefix("int", false));
+}
+
+TEST (testWordList, IgnoreCase) {
+	WordList wl;
+	wl.Set("Begin END select_1");
+	ASSERT_TRUE(wl.InListExact("begin", true));
+	ASSERT_TRUE(wl.InListExact("BEGIN", true));
+	ASSERT_TRUE(wl.InListExact("End", true));
+	ASSERT_TRUE(wl.InListExact("SELECT_1", true));
+	ASSERT_FALSE(wl.InListExact("begins", true));
+	ASSERT_FALSE(wl.InListExact("begin", false));
+	ASSERT_TRUE(wl.InListExact("Begin", false));
+}
+
+TEST (testWordList, Prefix) {
+	WordList wl;
+	wl.Set("0x # rem");
+	ASSERT_TRUE(wl.InListPrefix("0x1F", false));
+	ASSERT_TRUE(wl.InListPrefix("#include", false));
+	ASSERT_TRUE(wl.InListPrefix("rem", false));
+	ASSERT_TRUE(wl.InListPrefix("remark", false));
+	ASSERT_FALSE(wl.InListPrefix("REMARK", false));
+	ASSERT_TRUE(wl.InListPrefix("REMARK", true));
+	ASSERT_TRUE(wl.InListPrefix("0X1F", true));
+	ASSERT_FALSE(wl.InListPrefix("re", true));
+	ASSERT_FALSE(wl.InListPrefix("", true));
+}
+
+TEST (testWordList, LongWords) {
+	std::string longWord(40, 'a');
+	std::string longer(45, 'a');
+	WordList wl;
+	wl.Set((longWord + " b").c_str());
+	ASSERT_TRUE(wl.InList(longWord.c_str()));
+	ASSERT_FALSE(wl.InList(longer.c_str()));
+	ASSERT_TRUE(wl.InListPrefix(longer.c_str(), false));
+	ASSERT_FALSE(wl.InList(std::string(39, 'a').c_str()));
+}
+
+TEST (testWordList, ManyWords) {
+	// Enough words to need a large table, all found, none of their variants found
+	std::string list;
+	char word[32];
+	for (int i = 0; i < 5000; i++) {
+		sprintf(word, "kw%dx ", i * 7);
+		list += word;
+	}
+	WordList wl;
+	wl.Set(list.c_str());
+	for (int i = 0; i < 5000; i++) {
+		sprintf(word, "kw%dx", i * 7);
+		ASSERT_TRUE(wl.InList(word));
+		ASSERT_TRUE(wl.InListExact(word, true));
+		sprintf(word, "KW%dX", i * 7);
+		ASSERT_TRUE(wl.InListExact(word, true));
+		ASSERT_FALSE(wl.InList(word));
+		sprintf(word, "kw%dx", i * 7 + 1);
+		ASSERT_FALSE(wl.InList(word));
+	}
+}
+
+TEST (testWordList, DISABLED_BenchManyWords) {
+	std::string list;
+	char word[32];
+	for (int i = 0; i < 3000; i++) {
+		sprintf(word, "s%dk ", i);
+		list += word;
+	}
+	WordList wl;
+	wl.Set(list.c_str());
+	clock_t start = clock();
+	int found = 0;
+	for (int i = 0; i < 1200000; i++) {
+		sprintf(word, "s%dk", i % 6000);
+		if (wl.InList(word))
+			found++;
+	}
+	ASSERT_EQ(600000, found);
+	printf("1200000 lookups in 3000 words: %.3fs\n", double(clock() - start) / CLOCKS_PER_SEC);
+}
+
+#endif
@@ -26,7 +26,7 @@ ContractionState.o: ../src/ContractionState.cxx ../include/Platform.h \
  ../src/ContractionState.h
 Decoration.o: ../src/Decoration.cxx ../include/Platform.h \
  ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
- ../src/RunStyles.h ../src/Decoration.h
+ ../src/RunStyles.h ../src/RunStylesTree.h ../src/Decoration.h
 Document.o: ../src/Document.cxx ../include/Platform.h ../include/ILexer.h \
  ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
  ../src/RunStyles.h ../src/CellBuffer.h ../src/PerLine.h \
@@ -64,6 +64,8 @@ RESearch.o: ../src/RESearch.cxx ../src/CharClassify.h ../src/RESearch.h
 RunStyles.o: ../src/RunStyles.cxx ../include/Platform.h \
  ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
  ../src/RunStyles.h
+RunStylesTree.o: ../src/RunStylesTree.cxx ../include/Platform.h \
+ ../src/RunStylesTree.h
 ScintillaBase.o: ../src/ScintillaBase.cxx ../include/Platform.h \
  ../include/ILexer.h ../include/Scintilla.h ../lexlib/PropSetSimple.h \
  ../src/SplitVector.h ../src/Partitioning.h ../src/RunStyles.h \
@@ -107,6 +107,7 @@ SOBJS=\
 	$(DIR_O)\PropSetSimple.obj \
 	$(DIR_O)\RESearch.obj \
 	$(DIR_O)\RunStyles.obj \
+	$(DIR_O)\RunStylesTree.obj \
 	$(DIR_O)\ScintillaBase.obj \
 	$(DIR_O)\ScintillaWin.obj \
 	$(DIR_O)\Selection.obj \
@@ -225,6 +226,7 @@ LOBJS=\
 	$(DIR_O)\PropSetSimple.obj \
 	$(DIR_O)\RESearch.obj \
 	$(DIR_O)\RunStyles.obj \
+	$(DIR_O)\RunStylesTree.obj \
 	$(DIR_O)\ScintillaBaseL.obj \
 	$(DIR_O)\ScintillaWinL.obj \
 	$(DIR_O)\Selection.obj \
@@ -299,7 +301,7 @@ $(DIR_O)\ContractionState.obj: ../src/ContractionState.cxx ../include/Platform.h
   ../src/ContractionState.h
 $(DIR_O)\Decoration.obj: ../src/Decoration.cxx ../include/Platform.h \
   ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
-  ../src/RunStyles.h ../src/Decoration.h
+  ../src/RunStyles.h ../src/RunStylesTree.h ../src/Decoration.h
 $(DIR_O)\Document.obj: ../src/Document.cxx ../include/Platform.h \
   ../include/Scintilla.h ../src/SVector.h ../src/SplitVector.h \
   ../src/Partitioning.h ../src/RunStyles.h ../src/CellBuffer.h \
@@ -504,6 +506,8 @@ $(DIR_O)\RESearch.obj: ../src/RESearch.cxx ../src/CharClassify.h ../src/RESearch
 $(DIR_O)\RunStyles.obj: ../src/RunStyles.cxx ../include/Platform.h \
   ../include/Scintilla.h ../src/SplitVector.h ../src/Partitioning.h \
   ../src/RunStyles.h
+$(DIR_O)\RunStylesTree.obj: ../src/RunStylesTree.cxx ../include/Platform.h \
+  ../src/RunStylesTree.h
 $(DIR_O)\ScintillaBase.obj: ../src/ScintillaBase.cxx ../include/Platform.h \
   ../include/Scintilla.h \
   ../src/ContractionState.h ../src/SVector.h ../src/SplitVector.h \